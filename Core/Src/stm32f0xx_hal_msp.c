@@ -22,7 +22,7 @@
 /* Includes ------------------------------------------------------------------*/
 #include "main.h"
 /* USER CODE BEGIN Includes */
-
+#include "irq_priorities.h"
 /* USER CODE END Includes */
 extern DMA_HandleTypeDef hdma_i2c1_rx;
 
@@ -156,7 +156,7 @@ void HAL_I2C_MspInit(I2C_HandleTypeDef* hi2c)
     HAL_NVIC_SetPriority(I2C1_IRQn, 0, 0);
     HAL_NVIC_EnableIRQ(I2C1_IRQn);
   /* USER CODE BEGIN I2C1_MspInit 1 */
-
+    HAL_NVIC_SetPriority(I2C1_IRQn, IRQ_PRIORITY_I2C_HID, 0);
   /* USER CODE END I2C1_MspInit 1 */
   }
   else if(hi2c->Instance==I2C2)
@@ -217,7 +217,7 @@ void HAL_I2C_MspInit(I2C_HandleTypeDef* hi2c)
     HAL_NVIC_SetPriority(I2C2_IRQn, 0, 0);
     HAL_NVIC_EnableIRQ(I2C2_IRQn);
   /* USER CODE BEGIN I2C2_MspInit 1 */
-
+    HAL_NVIC_SetPriority(I2C2_IRQn, IRQ_PRIORITY_I2C_HID, 0);
   /* USER CODE END I2C2_MspInit 1 */
   }
 
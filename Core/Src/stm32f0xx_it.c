@@ -23,6 +23,9 @@
 #include "stm32f0xx_it.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "i2c_hid_config.h"
+#include "irq_priorities.h"
+#include "st/dma_irq.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -47,7 +50,11 @@
 
 /* Private function prototypes -----------------------------------------------*/
 /* USER CODE BEGIN PFP */
-
+/* the interrupts of the HID buses are executed from SRAM along with their handling */
+ST_RAMFUNC void DMA1_Channel2_3_IRQHandler(void);
+ST_RAMFUNC void DMA1_Channel4_5_6_7_IRQHandler(void);
+ST_RAMFUNC void I2C1_IRQHandler(void);
+ST_RAMFUNC void I2C2_IRQHandler(void);
 /* USER CODE END PFP */
 
 /* Private user code ---------------------------------------------------------*/
@@ -118,10 +125,11 @@ void SVC_Handler(void)
 void PendSV_Handler(void)
 {
   /* USER CODE BEGIN PendSV_IRQn 0 */
-
+  uint32_t irq_start = irq_profile_enter();
+  i2c_hid_deferred_work();
   /* USER CODE END PendSV_IRQn 0 */
   /* USER CODE BEGIN PendSV_IRQn 1 */
-
+  irq_profile_exit(IRQ_VECTOR_DEFERRED_WORK, irq_start);
   /* USER CODE END PendSV_IRQn 1 */
 }
 
@@ -152,11 +160,11 @@ void SysTick_Handler(void)
 void EXTI0_1_IRQHandler(void)
 {
   /* USER CODE BEGIN EXTI0_1_IRQn 0 */
-
+  uint32_t irq_start = irq_profile_enter();
   /* USER CODE END EXTI0_1_IRQn 0 */
   HAL_GPIO_EXTI_IRQHandler(B1_Pin);
   /* USER CODE BEGIN EXTI0_1_IRQn 1 */
-
+  irq_profile_exit(IRQ_VECTOR_BUTTON, irq_start);
   /* USER CODE END EXTI0_1_IRQn 1 */
 }
 
@@ -166,10 +174,16 @@ void EXTI0_1_IRQHandler(void)
 void DMA1_Channel2_3_IRQHandler(void)
 {
   /* USER CODE BEGIN DMA1_Channel2_3_IRQn 0 */
-
+  uint32_t irq_start = irq_profile_enter();
+#if I2C_HID_LL_SLAVE && (I2C_HID_LOW_POWER || I2C_HID_DUAL_BUS)
+  i2c_hid_slave_dma_irq_handler(&hi2c1);
+#else
+  /* only the channels with pending flags are serviced */
+  static DMA_HandleTypeDef* const dma_channel_2_3[] = {&hdma_i2c1_tx, &hdma_i2c1_rx};
+  dma_shared_irq_handler(dma_channel_2_3, sizeof(dma_channel_2_3) / sizeof(dma_channel_2_3[0]));
+#endif
+  irq_profile_exit(IRQ_VECTOR_I2C_HID_DMA, irq_start);
   /* USER CODE END DMA1_Channel2_3_IRQn 0 */
-  HAL_DMA_IRQHandler(&hdma_i2c1_tx);
-  HAL_DMA_IRQHandler(&hdma_i2c1_rx);
   /* USER CODE BEGIN DMA1_Channel2_3_IRQn 1 */
 
   /* USER CODE END DMA1_Channel2_3_IRQn 1 */
@@ -181,10 +195,17 @@ void DMA1_Channel2_3_IRQHandler(void)
 void DMA1_Channel4_5_6_7_IRQHandler(void)
 {
   /* USER CODE BEGIN DMA1_Channel4_5_6_7_IRQn 0 */
-
+  uint32_t irq_start = irq_profile_enter();
+#if I2C_HID_LL_SLAVE && !I2C_HID_LOW_POWER
+  i2c_hid_slave_dma_irq_handler(&hi2c2);
+#else
+  /* only the channels with pending flags are serviced */
+  static DMA_HandleTypeDef* const dma_channel_4_5_6_7[] = {&hdma_i2c2_tx, &hdma_i2c2_rx};
+  dma_shared_irq_handler(dma_channel_4_5_6_7,
+                         sizeof(dma_channel_4_5_6_7) / sizeof(dma_channel_4_5_6_7[0]));
+#endif
+  irq_profile_exit(IRQ_VECTOR_I2C_HID_DMA, irq_start);
   /* USER CODE END DMA1_Channel4_5_6_7_IRQn 0 */
-  HAL_DMA_IRQHandler(&hdma_i2c2_tx);
-  HAL_DMA_IRQHandler(&hdma_i2c2_rx);
   /* USER CODE BEGIN DMA1_Channel4_5_6_7_IRQn 1 */
 
   /* USER CODE END DMA1_Channel4_5_6_7_IRQn 1 */
@@ -196,13 +217,18 @@ void DMA1_Channel4_5_6_7_IRQHandler(void)
 void I2C1_IRQHandler(void)
 {
   /* USER CODE BEGIN I2C1_IRQn 0 */
-
-  /* USER CODE END I2C1_IRQn 0 */
+  uint32_t irq_start = irq_profile_enter();
+#if I2C_HID_LL_SLAVE && (I2C_HID_LOW_POWER || I2C_HID_DUAL_BUS)
+  i2c_hid_slave_irq_handler(&hi2c1);
+#else
   if (hi2c1.Instance->ISR & (I2C_FLAG_BERR | I2C_FLAG_ARLO | I2C_FLAG_OVR)) {
     HAL_I2C_ER_IRQHandler(&hi2c1);
   } else {
     HAL_I2C_EV_IRQHandler(&hi2c1);
   }
+#endif
+  irq_profile_exit(IRQ_VECTOR_I2C_HID, irq_start);
+  /* USER CODE END I2C1_IRQn 0 */
   /* USER CODE BEGIN I2C1_IRQn 1 */
 
   /* USER CODE END I2C1_IRQn 1 */
@@ -214,13 +240,18 @@ void I2C1_IRQHandler(void)
 void I2C2_IRQHandler(void)
 {
   /* USER CODE BEGIN I2C2_IRQn 0 */
-
-  /* USER CODE END I2C2_IRQn 0 */
+  uint32_t irq_start = irq_profile_enter();
+#if I2C_HID_LL_SLAVE && !I2C_HID_LOW_POWER
+  i2c_hid_slave_irq_handler(&hi2c2);
+#else
   if (hi2c2.Instance->ISR & (I2C_FLAG_BERR | I2C_FLAG_ARLO | I2C_FLAG_OVR)) {
     HAL_I2C_ER_IRQHandler(&hi2c2);
   } else {
     HAL_I2C_EV_IRQHandler(&hi2c2);
   }
+#endif
+  irq_profile_exit(IRQ_VECTOR_I2C_HID, irq_start);
+  /* USER CODE END I2C2_IRQn 0 */
   /* USER CODE BEGIN I2C2_IRQn 1 */
 
   /* USER CODE END I2C2_IRQn 1 */
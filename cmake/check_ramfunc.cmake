@@ -0,0 +1,49 @@
+# Checks that the functions of the interrupt hot path are linked between _sramfunc and _eramfunc,
+# so they are executed from SRAM, and none is left in flash by a missing ST_RAMFUNC.
+# Reports the SRAM taken by the .RamFunc section.
+#
+# cmake -DNM=<nm> -DELF=<firmware.elf> -DFUNCTIONS=<name>,<name>... -P check_ramfunc.cmake
+#
+# The functions are given by their qualified names, without the parameter list.
+
+execute_process(
+    COMMAND ${NM} --demangle --defined-only ${ELF}
+    OUTPUT_VARIABLE SYMBOLS
+    RESULT_VARIABLE RESULT
+)
+if(NOT RESULT EQUAL 0)
+    message(FATAL_ERROR "${NM} can't list the symbols of ${ELF}")
+endif()
+
+string(REPLACE "\n" ";" SYMBOLS "${SYMBOLS}")
+foreach(LINE IN LISTS SYMBOLS)
+    if(LINE MATCHES "^([0-9a-fA-F]+) [A-Za-z] ([^(]+)")
+        math(EXPR ADDRESS "0x${CMAKE_MATCH_1}")
+        set("ADDRESS_${CMAKE_MATCH_2}" ${ADDRESS})
+    endif()
+endforeach()
+
+if(NOT DEFINED ADDRESS__sramfunc OR NOT DEFINED ADDRESS__eramfunc)
+    message(FATAL_ERROR "${ELF} has no .RamFunc section boundaries")
+endif()
+
+string(REPLACE "," ";" FUNCTIONS "${FUNCTIONS}")
+set(MISPLACED)
+foreach(FUNCTION IN LISTS FUNCTIONS)
+    if(NOT DEFINED "ADDRESS_${FUNCTION}")
+        message(FATAL_ERROR "${FUNCTION} isn't linked to ${ELF}")
+    endif()
+    set(ADDRESS ${ADDRESS_${FUNCTION}})
+    if(ADDRESS LESS ADDRESS__sramfunc OR NOT ADDRESS LESS ADDRESS__eramfunc)
+        math(EXPR ADDRESS "${ADDRESS}" OUTPUT_FORMAT HEXADECIMAL)
+        list(APPEND MISPLACED "${FUNCTION} at ${ADDRESS}")
+    endif()
+endforeach()
+
+if(MISPLACED)
+    list(JOIN MISPLACED "\n  " MISPLACED)
+    message(FATAL_ERROR "interrupt hot path functions outside of .RamFunc:\n  ${MISPLACED}")
+endif()
+
+math(EXPR RAMFUNC_BYTES "${ADDRESS__eramfunc} - ${ADDRESS__sramfunc}")
+message(STATUS ".RamFunc: ${RAMFUNC_BYTES} bytes of SRAM")
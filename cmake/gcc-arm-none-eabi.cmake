@@ -16,6 +16,7 @@ set(CMAKE_CXX_COMPILER ${TOOLCHAIN_PREFIX}g++)
 set(CMAKE_LINKER ${TOOLCHAIN_PREFIX}g++)
 set(CMAKE_OBJCOPY ${TOOLCHAIN_PREFIX}objcopy)
 set(CMAKE_SIZE ${TOOLCHAIN_PREFIX}size)
+set(CMAKE_NM ${TOOLCHAIN_PREFIX}nm)
 set(CMAKE_AR ${TOOLCHAIN_PREFIX}ar)
 
 set(CMAKE_EXECUTABLE_SUFFIX_ASM ".elf")
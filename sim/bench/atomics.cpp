@@ -0,0 +1,189 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+/// @brief  Compares the fetch_add libcall of cortex_m0_atomic.cpp with the compare-exchange
+///         retry loop, that the compiler falls back to when only the compare-exchange libcall
+///         is available, for 1, 2 and 4 byte values:
+///         - uncontended, from thread mode
+///         - contended, with an interrupt at the priority of the transport incrementing
+///           the same value, which makes the loop retry when it preempts between the load
+///           and the compare-exchange
+///         The libcalls are the only instrumented calls, so the cycles are those of the calls
+///         and the critical sections. Every increment must be accounted for in the final value.
+#include <cstdio>
+#include <cstdlib>
+#include "irq_priorities.h"
+#include "sim/firmware.hpp"
+#include "st/atomic_ops.hpp"
+
+using namespace sim;
+
+namespace
+{
+constexpr IRQn_Type CONTENDER_IRQ = TIM2_IRQn;
+constexpr picoseconds CONTENTION_INTERVAL = 3 * MICROSECOND;
+constexpr unsigned OPERATIONS = 20'000;
+
+// the libcalls, as the compiler emits calls to them
+template <typename T>
+__attribute__((noinline)) T libcall_fetch_add(volatile void* ptr, T value)
+{
+    return st::atomic_ops<T>::fetch_add(ptr, value);
+}
+template <typename T>
+__attribute__((noinline)) bool libcall_compare_exchange(volatile void* ptr, void* expected,
+                                                        T desired)
+{
+    return st::atomic_ops<T>::compare_exchange(ptr, expected, desired);
+}
+
+// the operations are inlined at the call sites in the firmware, only their libcalls are charged
+
+/// @return the libcalls made
+template <typename T>
+__attribute__((no_instrument_function)) unsigned fetch_add(volatile T& value)
+{
+    libcall_fetch_add<T>(&value, 1);
+    return 1;
+}
+
+/// @return the libcalls made
+template <typename T>
+__attribute__((no_instrument_function)) unsigned cas_loop_fetch_add(volatile T& value)
+{
+    // the load is inlined, as aligned loads are atomic
+    T expected = st::atomic_ops<T>::load(&value);
+    unsigned calls = 1;
+    while (!libcall_compare_exchange<T>(&value, &expected, static_cast<T>(expected + 1)))
+    {
+        calls++;
+    }
+    return calls;
+}
+
+void (*contender)() = nullptr;
+std::uint64_t contender_adds = 0;
+bool contending = false;
+
+void contender_handler()
+{
+    contender();
+    contender_adds++;
+}
+
+void request_contention()
+{
+    if (contending)
+    {
+        trigger_interrupt(CONTENDER_IRQ);
+        schedule(CONTENTION_INTERVAL, request_contention);
+    }
+}
+
+template <typename T>
+struct shared
+{
+    static inline volatile T value{};
+};
+
+struct result
+{
+    double cycles_per_op;
+    double calls_per_op;
+};
+
+template <typename T>
+result measure(const char* type, const char* method, unsigned (*operation)(volatile T&),
+               bool contended)
+{
+    auto& value = shared<T>::value;
+    value = 0;
+    contender = []() { libcall_fetch_add<T>(&shared<T>::value, 1); };
+    contender_adds = 0;
+    clear_handler_cycles();
+    if (contended)
+    {
+        contending = true;
+        schedule(CONTENTION_INTERVAL, request_contention);
+    }
+
+    std::uint64_t calls = 0;
+    auto start = cycles();
+    for (unsigned i = 0; i < OPERATIONS; i++)
+    {
+        calls += operation(value);
+    }
+    // the cycles of the preempting interrupts aren't the operation's
+    auto spent = cycles() - start - handler_cycles(CONTENDER_IRQ).total -
+                 handler_cycles(SysTick_IRQn).total;
+    contending = false;
+    // the pending request ends the contention, before the next measurement starts its own
+    run_for(CONTENTION_INTERVAL);
+    // the wrapped value of the small types is compared
+    auto expected = static_cast<T>(OPERATIONS + contender_adds);
+    auto final_value = static_cast<T>(value);
+
+    result r{static_cast<double>(spent) / OPERATIONS, static_cast<double>(calls) / OPERATIONS};
+    std::printf("%-6s %-10s %-12s %10.2f %10.3f %12llu\n", type, method,
+                contended ? "contended" : "uncontended", r.cycles_per_op, r.calls_per_op,
+                static_cast<unsigned long long>(contender_adds));
+    if (final_value != expected)
+    {
+        fail("%s %s: an increment was lost, %u instead of %u", type, method,
+             static_cast<unsigned>(final_value), static_cast<unsigned>(expected));
+    }
+    return r;
+}
+
+template <typename T>
+void compare(const char* type)
+{
+    for (bool contended : {false, true})
+    {
+        auto libcall = measure<T>(type, "fetch_add", fetch_add<T>, contended);
+        auto cas_loop = measure<T>(type, "CAS loop", cas_loop_fetch_add<T>, contended);
+        if (libcall.cycles_per_op > cas_loop.cycles_per_op)
+        {
+            fail("%s: the fetch_add libcall is slower than the CAS loop", type);
+        }
+        if (contended and (cas_loop.calls_per_op <= 1.0))
+        {
+            fail("%s: the contention didn't make the CAS loop retry", type);
+        }
+    }
+}
+
+class atomics_bench
+{
+  public:
+    void run()
+    {
+        connect_handler(CONTENDER_IRQ, contender_handler);
+        NVIC_SetPriority(CONTENDER_IRQ, IRQ_PRIORITY_I2C_HID);
+        NVIC_EnableIRQ(CONTENDER_IRQ);
+
+        std::printf("core clock %u Hz, an increment from the interrupt every %llu ns\n",
+                    core_clock(),
+                    static_cast<unsigned long long>(CONTENTION_INTERVAL / NANOSECOND));
+        std::printf("%-6s %-10s %-12s %10s %10s %12s\n", "type", "method", "", "cycles/op",
+                    "calls/op", "IRQ adds");
+        compare<std::uint8_t>("u8");
+        compare<std::uint16_t>("u16");
+        compare<std::uint32_t>("u32");
+        std::exit(EXIT_SUCCESS);
+    }
+};
+} // namespace
+
+extern "C" void test_i2c_hid_device()
+{
+    static atomics_bench bench;
+    bench.run();
+}
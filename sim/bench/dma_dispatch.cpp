@@ -0,0 +1,135 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+/// @brief  Compares the cycles of the shared DMA interrupt of the I2C slave, with the channels
+///         dispatched by their pending flags, and with HAL_DMA_IRQHandler() called on every
+///         channel of the vector, as the generated handler did.
+///         The firmware's dispatch is wrapped at link time (--wrap=dma_shared_irq_handler),
+///         while the host reads keyboard reports and writes raw stream frames.
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include "sim/firmware.hpp"
+#include "st/dma_irq.h"
+
+using namespace sim;
+
+extern "C" void __real_dma_shared_irq_handler(DMA_HandleTypeDef* const* handles, unsigned count);
+
+namespace
+{
+using app = hid::demo_app;
+
+constexpr picoseconds MEASUREMENT = 200 * MILLISECOND;
+
+bool all_channels = false;
+
+class dma_dispatch_bench
+{
+  public:
+    dma_dispatch_bench()
+        : bus_(I2C2, 400'000),
+          host_(bus_, DEVICE_ADDRESS, HID_DESCRIPTOR_REGISTER, EXT_RESET_GPIO_Port, EXT_RESET_Pin)
+    {
+        host_.on_input([this](std::span<const std::uint8_t> report) { input(report); });
+    }
+
+    void run()
+    {
+        if (!set_i2c_bus_speed(st::i2c_speed::FAST))
+        {
+            fail("the bus speed can't be set");
+        }
+        host_.connect();
+
+        std::printf("%-14s %10s %14s %14s\n", "dispatch", "DMA IRQs", "avg cycles/IRQ",
+                    "max cycles/IRQ");
+        auto flags = measure("pending flags", false);
+        auto all = measure("all channels", true);
+        if (flags >= all)
+        {
+            fail("the flag driven dispatch isn't cheaper");
+        }
+        std::exit(EXIT_SUCCESS);
+    }
+
+  private:
+    void input(std::span<const std::uint8_t> report)
+    {
+        if ((report[0] == app::keys_report::ID) and measuring_)
+        {
+            // each edge of the button produces a report
+            pressed_ = !pressed_;
+            set_input(B1_GPIO_Port, B1_Pin, pressed_);
+        }
+    }
+
+    /// @return the average cycles of the DMA interrupt
+    double measure(const char* name, bool all)
+    {
+        all_channels = all;
+        clear_handler_cycles();
+        measuring_ = true;
+        pressed_ = !pressed_;
+        set_input(B1_GPIO_Port, B1_Pin, pressed_);
+        // the raw stream frames are received with DMA, and looped back
+        auto end = now() + MEASUREMENT;
+        std::array<std::uint8_t, sizeof(app::raw_out_report)> frame{app::raw_out_report::ID};
+        while (now() < end)
+        {
+            if (!host_.output_report(frame))
+            {
+                fail("the output report isn't accepted");
+            }
+            run_for(MILLISECOND);
+        }
+        // the button stops producing reports, so the bus becomes idle
+        measuring_ = false;
+        auto dma = handler_cycles(DMA1_Channel4_5_6_7_IRQn);
+        if (!run_until([this]() { return bus_.idle(); }, 10 * MILLISECOND))
+        {
+            fail("the bus doesn't become idle");
+        }
+        if (dma.count == 0)
+        {
+            fail("no DMA interrupt was taken");
+        }
+        auto average = static_cast<double>(dma.total) / dma.count;
+        std::printf("%-14s %10llu %14.1f %14llu\n", name,
+                    static_cast<unsigned long long>(dma.count), average,
+                    static_cast<unsigned long long>(dma.max));
+        return average;
+    }
+
+    bus_master bus_;
+    hid_host host_;
+    bool pressed_{};
+    bool measuring_{};
+};
+} // namespace
+
+extern "C" void __wrap_dma_shared_irq_handler(DMA_HandleTypeDef* const* handles, unsigned count)
+{
+    if (!all_channels)
+    {
+        __real_dma_shared_irq_handler(handles, count);
+        return;
+    }
+    for (unsigned i = 0; i < count; i++)
+    {
+        HAL_DMA_IRQHandler(handles[i]);
+    }
+}
+
+extern "C" void test_i2c_hid_device()
+{
+    static dma_dispatch_bench bench;
+    bench.run();
+}
@@ -0,0 +1,143 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+/// @brief  Compares the end-to-end latency and the lost motion of the mouse reports,
+///         with motion events arriving faster than the host reads the reports:
+///         - accumulate: every event is passed to demo_app::mouse_motion(), which merges the
+///           motion while a report is in flight
+///         - send-or-drop: an event is only passed on when the previous report has already
+///           been read, like the reports that used to be dropped on BUSY
+///         The latency is measured from each motion event to the read of the report carrying it.
+///         The longest mouse_motion() call is the one that copies the state to a pool block and
+///         sends the report, its cycles are compared with the latency that the copy would save.
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include "sim/firmware.hpp"
+
+using namespace sim;
+
+namespace
+{
+using app = hid::demo_app;
+
+constexpr picoseconds MEASUREMENT = 500 * MILLISECOND;
+
+struct result
+{
+    std::uint64_t events;
+    std::uint64_t delivered;
+    picoseconds total_latency;
+    picoseconds max_latency;
+    std::uint64_t max_cycles;
+};
+
+class mouse_latency
+{
+  public:
+    mouse_latency()
+        : bus_(I2C2, 400'000),
+          host_(bus_, DEVICE_ADDRESS, HID_DESCRIPTOR_REGISTER, EXT_RESET_GPIO_Port, EXT_RESET_Pin)
+    {
+        host_.on_input([this](std::span<const std::uint8_t> report) { input(report); });
+    }
+
+    void run()
+    {
+        if (!set_i2c_bus_speed(st::i2c_speed::FAST))
+        {
+            fail("the bus speed can't be set");
+        }
+        host_.connect();
+
+        std::printf("%-13s %10s %8s %10s %10s %14s %14s %11s\n", "mode", "event (us)", "events",
+                    "delivered", "lost", "avg lat. (us)", "max lat. (us)", "max cycles");
+        for (auto interval : {2000 * MICROSECOND, 500 * MICROSECOND, 100 * MICROSECOND})
+        {
+            auto accumulated = measure("accumulate", interval, false);
+            if (accumulated.delivered != accumulated.events)
+            {
+                fail("motion was lost while accumulating");
+            }
+            measure("send-or-drop", interval, true);
+        }
+        std::exit(EXIT_SUCCESS);
+    }
+
+  private:
+    void input(std::span<const std::uint8_t> report)
+    {
+        if (report[0] != app::mouse_report::ID)
+        {
+            return;
+        }
+        auto x = static_cast<std::int8_t>(report[2]);
+        auto y = static_cast<std::int8_t>(report[3]);
+        if ((x <= 0) or (y != -x) or (static_cast<std::size_t>(x) > pending_.size()))
+        {
+            fail("unexpected mouse report %d, %d", x, y);
+        }
+        for (int i = 0; i < x; i++)
+        {
+            auto latency = now() - pending_.front();
+            pending_.pop_front();
+            result_.delivered++;
+            result_.total_latency += latency;
+            result_.max_latency = std::max(result_.max_latency, latency);
+        }
+    }
+
+    result measure(const char* mode, picoseconds interval, bool drop_when_busy)
+    {
+        result_ = {};
+        auto end = now() + MEASUREMENT;
+        auto& application = app::instance();
+        while (now() < end)
+        {
+            result_.events++;
+            if (!drop_when_busy or pending_.empty())
+            {
+                pending_.push_back(now());
+                auto start = cycles();
+                at_transport_priority([&]() { application.mouse_motion(1, -1); });
+                result_.max_cycles = std::max(result_.max_cycles, cycles() - start);
+            }
+            run_for(interval);
+        }
+        if (!run_until([this]() { return pending_.empty(); }, 10 * MILLISECOND))
+        {
+            fail("the motion isn't delivered");
+        }
+
+        auto average = result_.delivered ? (result_.total_latency / result_.delivered) : 0;
+        std::printf("%-13s %10llu %8llu %10llu %10llu %14.1f %14.1f %11llu\n", mode,
+                    static_cast<unsigned long long>(interval / MICROSECOND),
+                    static_cast<unsigned long long>(result_.events),
+                    static_cast<unsigned long long>(result_.delivered),
+                    static_cast<unsigned long long>(result_.events - result_.delivered),
+                    static_cast<double>(average) / MICROSECOND,
+                    static_cast<double>(result_.max_latency) / MICROSECOND,
+                    static_cast<unsigned long long>(result_.max_cycles));
+        return result_;
+    }
+
+    bus_master bus_;
+    hid_host host_;
+    std::deque<picoseconds> pending_{};
+    result result_{};
+};
+} // namespace
+
+extern "C" void test_i2c_hid_device()
+{
+    static mouse_latency bench;
+    bench.run();
+}
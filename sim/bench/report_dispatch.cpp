@@ -0,0 +1,96 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+/// @brief  Measures the longest I2C interrupt of a GET_REPORT, for every report type and ID,
+///         including the IDs beyond the last report. The reports without a handler all take
+///         the same path after the lookup, so their cost must not depend on the position
+///         of the selector in the table.
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <optional>
+#include "sim/firmware.hpp"
+
+using namespace sim;
+
+namespace
+{
+using app = hid::demo_app;
+using report_type = hid_host::report_type;
+
+// one beyond the last report ID
+constexpr std::uint8_t LAST_ID = app::latency_report::ID + 1;
+// the feature reports are larger than the input reports
+constexpr std::size_t READ_SIZE = std::max(
+    {sizeof(app::raw_in_report), sizeof(app::counters_report), sizeof(app::latency_report)});
+
+class report_dispatch_bench
+{
+  public:
+    report_dispatch_bench()
+        : bus_(I2C2, 400'000),
+          host_(bus_, DEVICE_ADDRESS, HID_DESCRIPTOR_REGISTER, EXT_RESET_GPIO_Port, EXT_RESET_Pin)
+    {}
+
+    void run()
+    {
+        if (!set_i2c_bus_speed(st::i2c_speed::FAST))
+        {
+            fail("the bus speed can't be set");
+        }
+        host_.connect();
+
+        std::printf("%-8s", "ID");
+        for (const char* name : {"input", "output", "feature"})
+        {
+            std::printf(" %16s", name);
+        }
+        std::printf("\n");
+        std::optional<std::uint64_t> unsupported_cycles{};
+        for (std::uint8_t id = 1; id <= LAST_ID; id++)
+        {
+            std::printf("%-8u", id);
+            for (auto type : {report_type::INPUT, report_type::OUTPUT, report_type::FEATURE})
+            {
+                clear_handler_cycles();
+                auto report = host_.get_report(type, id, READ_SIZE);
+                auto cycles = handler_cycles(I2C2_IRQn).max;
+                std::printf(" %10llu %5s", static_cast<unsigned long long>(cycles),
+                            report.empty() ? "(n/a)" : "");
+                if (!report.empty())
+                {
+                    continue;
+                }
+                if (!unsupported_cycles)
+                {
+                    unsupported_cycles = cycles;
+                }
+                else if (*unsupported_cycles != cycles)
+                {
+                    std::printf("\n");
+                    fail("the lookup of report %u depends on its position", id);
+                }
+            }
+            std::printf("\n");
+        }
+        std::exit(EXIT_SUCCESS);
+    }
+
+  private:
+    bus_master bus_;
+    hid_host host_;
+};
+} // namespace
+
+extern "C" void test_i2c_hid_device()
+{
+    static report_dispatch_bench bench;
+    bench.run();
+}
@@ -0,0 +1,224 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+/// @brief  Measures the raw data stream's payload throughput at 100 kHz, 400 kHz and 1 MHz.
+///         The host keeps up to a window of frames unacknowledged in both directions, the device
+///         loops the data back, and the host checks that it arrives in order.
+///         Before that, it checks that restarting the stream doesn't overwrite the frame that
+///         the host is about to read.
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "sim/firmware.hpp"
+
+using namespace sim;
+
+namespace
+{
+using app = hid::demo_app;
+using header = app::stream::header;
+
+constexpr picoseconds MEASUREMENT = 500 * MILLISECOND;
+constexpr std::size_t PAYLOAD_SIZE = app::stream::RX_PAYLOAD_SIZE;
+static_assert(PAYLOAD_SIZE == app::stream::TX_PAYLOAD_SIZE);
+constexpr std::uint8_t WINDOW = 4;
+
+class stream_bench
+{
+  public:
+    stream_bench()
+        : bus_(I2C2, 100'000),
+          host_(bus_, DEVICE_ADDRESS, HID_DESCRIPTOR_REGISTER, EXT_RESET_GPIO_Port, EXT_RESET_Pin)
+    {
+        host_.on_input([this](std::span<const std::uint8_t> report) { input(report); });
+    }
+
+    void run()
+    {
+        host_.connect();
+        check_reset_in_flight();
+
+        std::printf("%-10s %10s %14s %10s\n", "bus (Hz)", "frames/s", "payload (B/s)",
+                    "line rate");
+        for (auto speed : {st::i2c_speed::STANDARD, st::i2c_speed::FAST, st::i2c_speed::FAST_PLUS})
+        {
+            measure(speed);
+        }
+        std::exit(EXIT_SUCCESS);
+    }
+
+  private:
+    static std::uint8_t pattern(std::uint64_t offset)
+    {
+        return static_cast<std::uint8_t>(offset * 7);
+    }
+
+    void input(std::span<const std::uint8_t> report)
+    {
+        if (report[0] != app::raw_in_report::ID)
+        {
+            return;
+        }
+        header hdr;
+        std::memcpy(&hdr, report.data() + 1, sizeof(hdr));
+        auto payload = report.subspan(1 + sizeof(hdr));
+        last_input_.assign(payload.begin(), payload.begin() + std::min<std::size_t>(
+                                                                 hdr.length, payload.size()));
+        inputs_++;
+        // stale acknowledgements are ignored
+        if (static_cast<std::uint8_t>(hdr.ack - device_ack_) <=
+            static_cast<std::uint8_t>(tx_seq_ - device_ack_))
+        {
+            tx_acked_ += static_cast<std::uint8_t>(hdr.ack - device_ack_);
+            device_ack_ = hdr.ack;
+        }
+        if (!verify_ or (hdr.length == 0) or (hdr.seq != rx_expected_))
+        {
+            return;
+        }
+        for (std::size_t i = 0; i < hdr.length; i++)
+        {
+            if (report[1 + sizeof(hdr) + i] != pattern(rx_bytes_ + i))
+            {
+                fail("the looped back data is corrupted at offset %llu",
+                     static_cast<unsigned long long>(rx_bytes_ + i));
+            }
+        }
+        rx_expected_++;
+        rx_bytes_ += hdr.length;
+    }
+
+    /// @brief Writes a frame, with data from the stream offset, or an acknowledgement only.
+    void send(std::uint8_t seq, std::uint8_t flags, std::size_t length, std::uint64_t offset)
+    {
+        std::array<std::uint8_t, sizeof(app::raw_out_report)> frame{app::raw_out_report::ID};
+        header hdr{seq, rx_expected_, flags, static_cast<std::uint8_t>(length)};
+        std::memcpy(frame.data() + 1, &hdr, sizeof(hdr));
+        for (std::size_t i = 0; i < length; i++)
+        {
+            frame[1 + sizeof(hdr) + i] = pattern(offset + i);
+        }
+        if (!host_.output_report(frame))
+        {
+            fail("the output report isn't accepted");
+        }
+        ack_sent_ = rx_expected_;
+    }
+
+    void restart()
+    {
+        send(0, app::stream::RESET, 0, 0);
+        tx_seq_ = device_ack_ = rx_expected_ = ack_sent_ = 0;
+        tx_acked_ = rx_bytes_ = 0;
+    }
+
+    void check_reset_in_flight()
+    {
+        // the host is slow to read the looped back frame
+        host_.set_response_delay(100 * MILLISECOND);
+        verify_ = false;
+        send(0, 0, PAYLOAD_SIZE, 0);
+        if (!host_.interrupt_asserted())
+        {
+            fail("the frame isn't looped back");
+        }
+        // the restart and new data arrive before the frame in flight is read
+        send(0, app::stream::RESET, 0, 0);
+        send(0, 0, PAYLOAD_SIZE, 1000);
+        auto inputs = inputs_;
+        if (!run_until([&]() { return inputs_ > inputs; }, SECOND))
+        {
+            fail("the frame in flight isn't read");
+        }
+        for (std::size_t i = 0; i < last_input_.size(); i++)
+        {
+            if ((last_input_.size() != PAYLOAD_SIZE) or (last_input_[i] != pattern(i)))
+            {
+                fail("the frame in flight was overwritten after the restart");
+            }
+        }
+        // the reads already scheduled by the slow host finish first
+        run_for(200 * MILLISECOND);
+        host_.set_response_delay(20 * MICROSECOND);
+        verify_ = true;
+    }
+
+    void measure(st::i2c_speed speed)
+    {
+        if (!set_i2c_bus_speed(speed))
+        {
+            fail("the bus speed can't be set");
+        }
+        bus_.set_speed(static_cast<std::uint32_t>(speed));
+        restart();
+        run_for(MILLISECOND);
+        // a frame is given up after the time of a window of frames in both directions
+        auto frame_time = SECOND * 9 * (sizeof(app::raw_in_report) + 4) /
+                          static_cast<std::uint32_t>(speed);
+        auto frames = app::instance().raw_data_stream().stats().frames_sent;
+        auto start = now();
+        auto end = start + MEASUREMENT;
+        while (now() < end)
+        {
+            if (static_cast<std::uint8_t>(tx_seq_ - device_ack_) < WINDOW)
+            {
+                auto index = tx_acked_ + static_cast<std::uint8_t>(tx_seq_ - device_ack_);
+                send(tx_seq_, 0, PAYLOAD_SIZE, index * PAYLOAD_SIZE);
+                tx_seq_++;
+                continue;
+            }
+            if (ack_sent_ != rx_expected_)
+            {
+                send(tx_seq_, 0, 0, 0);
+                continue;
+            }
+            auto inputs = inputs_;
+            if (!run_until([&]() { return inputs_ > inputs; }, 2 * WINDOW * frame_time))
+            {
+                // the device dropped a frame, as its window was full, go back to it
+                tx_seq_ = device_ack_;
+            }
+        }
+        auto duration = now() - start;
+        frames = app::instance().raw_data_stream().stats().frames_sent - frames;
+        if (rx_bytes_ == 0)
+        {
+            fail("no data was looped back");
+        }
+
+        auto per_second = [duration](std::uint64_t count)
+        { return static_cast<double>(count) * SECOND / duration; };
+        // both directions carry the payload, a byte takes 9 clocks on the bus
+        auto line_rate = static_cast<double>(speed) / 9;
+        std::printf("%-10u %10.0f %14.0f %9.1f%%\n", static_cast<unsigned>(speed),
+                    per_second(frames), per_second(rx_bytes_),
+                    100 * 2 * per_second(rx_bytes_) / line_rate);
+    }
+
+    bus_master bus_;
+    hid_host host_;
+    std::vector<std::uint8_t> last_input_{};
+    std::uint64_t inputs_{};
+    std::uint64_t tx_acked_{}; ///< the frames acknowledged by the device
+    std::uint64_t rx_bytes_{};
+    std::uint8_t tx_seq_{};
+    std::uint8_t device_ack_{};
+    std::uint8_t rx_expected_{};
+    std::uint8_t ack_sent_{};
+    bool verify_{};
+};
+} // namespace
+
+extern "C" void test_i2c_hid_device()
+{
+    static stream_bench bench;
+    bench.run();
+}
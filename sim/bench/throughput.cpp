@@ -0,0 +1,210 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+/// @brief  Measures the input report throughput of the device, with the host reading every
+///         report as soon as the interrupt line is asserted, and a new report produced
+///         as soon as the previous one arrives:
+///         - keyboard: the B1 button toggles at each received report
+///         - mouse: motion is reported at each received report
+///         - opaque: the host keeps writing raw stream frames, that the device loops back
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "sim/firmware.hpp"
+#include "sim/hid_host.hpp"
+
+using namespace sim;
+
+namespace
+{
+constexpr std::uint32_t BUS_SPEED = 400'000;
+constexpr picoseconds MEASUREMENT = 200 * MILLISECOND;
+
+using app = hid::demo_app;
+
+struct counters
+{
+    std::uint64_t reports;
+    std::uint64_t bytes;
+    std::uint64_t payload_bytes;
+};
+
+class benchmark
+{
+  public:
+    benchmark()
+        : bus_(I2C2, BUS_SPEED),
+          host_(bus_, DEVICE_ADDRESS, HID_DESCRIPTOR_REGISTER, EXT_RESET_GPIO_Port, EXT_RESET_Pin)
+    {
+        host_.on_input([this](std::span<const std::uint8_t> report) { input(report); });
+    }
+
+    void run()
+    {
+        if (!set_i2c_bus_speed(st::i2c_speed::FAST))
+        {
+            fail("the bus speed can't be set");
+        }
+        host_.connect();
+
+        std::printf("%-10s %10s %10s %10s %14s %12s %12s\n", "report", "reports/s", "bytes/s",
+                    "payload/s", "callbacks/xfer", "IRQs/xfer", "cycles/IRQ");
+        measure("keyboard", app::keys_report::ID, [this]() { keyboard(); });
+        measure("mouse", app::mouse_report::ID, [this]() { mouse(); });
+        measure("opaque", app::raw_out_report::ID, [this]() { opaque(); });
+    }
+
+  private:
+    void input(std::span<const std::uint8_t> report)
+    {
+        if (report[0] != report_id_)
+        {
+            return;
+        }
+        counters_.reports++;
+        counters_.bytes += report.size();
+        if (on_report_)
+        {
+            on_report_(report);
+        }
+    }
+
+    template <typename TDrive>
+    void measure(const char* name, std::uint8_t report_id, TDrive&& drive)
+    {
+        counters_ = {};
+        report_id_ = report_id;
+        get_i2c_slave().reset_stats();
+        clear_handler_cycles();
+        auto start = now();
+        end_ = start + MEASUREMENT;
+
+        drive();
+
+        auto duration = now() - start;
+        auto result = counters_;
+        auto slave = get_i2c_slave().stats();
+        auto i2c = handler_cycles(I2C2_IRQn);
+        auto dma = handler_cycles(DMA1_Channel4_5_6_7_IRQn);
+        on_report_ = nullptr;
+        report_id_ = 0;
+        // let the device deliver the remaining reports, before the next measurement
+        if (!run_until([this]() { return bus_.idle() and !host_.interrupt_asserted(); },
+                       10 * MILLISECOND))
+        {
+            fail("the %s reports don't stop", name);
+        }
+        if (result.reports == 0)
+        {
+            fail("no %s report was received", name);
+        }
+
+        auto per_second = [duration](std::uint64_t count)
+        { return static_cast<double>(count) * SECOND / duration; };
+        auto transfers = slave.read_transfers + slave.write_transfers;
+        auto callbacks = slave.starts + slave.stops + slave.tx_completes + slave.rx_completes;
+        auto irqs = i2c.count + dma.count;
+        std::printf("%-10s %10.0f %10.0f %10.0f %14.2f %12.2f %12.1f\n", name,
+                    per_second(result.reports), per_second(result.bytes),
+                    per_second(result.payload_bytes),
+                    static_cast<double>(callbacks) / transfers,
+                    static_cast<double>(irqs) / transfers,
+                    static_cast<double>(i2c.total + dma.total) / irqs);
+    }
+
+    void keyboard()
+    {
+        // each edge of the button produces a report
+        static bool pressed = false;
+        on_report_ = [](std::span<const std::uint8_t>)
+        {
+            pressed = !pressed;
+            set_input(B1_GPIO_Port, B1_Pin, pressed);
+        };
+        pressed = !pressed;
+        set_input(B1_GPIO_Port, B1_Pin, pressed);
+        run_for(end_ - now());
+    }
+
+    void mouse()
+    {
+        auto& application = app::instance();
+        while (now() < end_)
+        {
+            auto reports = counters_.reports;
+            at_transport_priority([&]() { application.mouse_motion(3, -2); });
+            if (!run_until([&]() { return counters_.reports > reports; }, 10 * MILLISECOND))
+            {
+                fail("the mouse report isn't sent");
+            }
+        }
+    }
+
+    void opaque()
+    {
+        using header = app::stream::header;
+        constexpr std::size_t PAYLOAD_SIZE = app::stream::RX_PAYLOAD_SIZE;
+        // the frames the host writes ahead of the device's acknowledgements
+        constexpr std::uint8_t HOST_WINDOW = 2;
+        std::uint8_t tx_seq = 0;
+        std::uint8_t device_ack = 0;
+        std::uint8_t rx_expected = 0;
+
+        on_report_ = [&](std::span<const std::uint8_t> report)
+        {
+            header hdr;
+            std::memcpy(&hdr, report.data() + 1, sizeof(hdr));
+            device_ack = hdr.ack;
+            if ((hdr.length > 0) and (hdr.seq == rx_expected))
+            {
+                rx_expected++;
+                counters_.payload_bytes += hdr.length;
+            }
+        };
+        while (now() < end_)
+        {
+            if (static_cast<std::uint8_t>(tx_seq - device_ack) >= HOST_WINDOW)
+            {
+                // the device didn't take the frames, as its window was full
+                tx_seq = device_ack;
+            }
+            std::array<std::uint8_t, 1 + app::OPAQUE_REPORT_SIZE> frame{app::raw_out_report::ID};
+            header hdr{tx_seq, rx_expected, 0, static_cast<std::uint8_t>(PAYLOAD_SIZE)};
+            std::memcpy(frame.data() + 1, &hdr, sizeof(hdr));
+            for (std::size_t i = 0; i < PAYLOAD_SIZE; i++)
+            {
+                frame[1 + sizeof(hdr) + i] = static_cast<std::uint8_t>(tx_seq + i);
+            }
+            auto reports = counters_.reports;
+            if (!host_.output_report(frame))
+            {
+                fail("the output report isn't accepted");
+            }
+            tx_seq++;
+            run_until([&]() { return counters_.reports > reports; }, MILLISECOND);
+        }
+    }
+
+    bus_master bus_;
+    hid_host host_;
+    std::function<void(std::span<const std::uint8_t>)> on_report_{};
+    counters counters_{};
+    picoseconds end_{};
+    std::uint8_t report_id_{};
+};
+} // namespace
+
+extern "C" void test_i2c_hid_device()
+{
+    static benchmark bench;
+    bench.run();
+    std::exit(EXIT_SUCCESS);
+}
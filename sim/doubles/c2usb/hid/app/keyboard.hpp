@@ -0,0 +1,108 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+/// @brief  Test double of the hid-rp keyboard application.
+#ifndef __HID_APP_KEYBOARD_HPP_
+#define __HID_APP_KEYBOARD_HPP_
+
+#include <algorithm>
+#include "hid/page.hpp"
+#include "hid/report.hpp"
+
+namespace hid::app::keyboard
+{
+template <std::uint8_t REPORT_ID>
+struct keys_input_report : public report::base<report::type::INPUT, REPORT_ID>
+{
+    std::uint8_t modifiers{};
+    std::uint8_t reserved{};
+    std::array<std::uint8_t, 6> scancodes{};
+
+    void set_key_state(page::keyboard_keypad key, bool pressed)
+    {
+        auto code = static_cast<std::uint8_t>(key);
+        if (code >= static_cast<std::uint8_t>(page::keyboard_keypad::KEYBOARD_LEFT_CONTROL))
+        {
+            auto mask = 1 << (code - static_cast<std::uint8_t>(
+                                         page::keyboard_keypad::KEYBOARD_LEFT_CONTROL));
+            modifiers = pressed ? (modifiers | mask) : (modifiers & ~mask);
+            return;
+        }
+        auto it = std::find(scancodes.begin(), scancodes.end(), code);
+        if (pressed and (it == scancodes.end()))
+        {
+            it = std::find(scancodes.begin(), scancodes.end(), 0);
+            if (it != scancodes.end())
+            {
+                *it = code;
+            }
+        }
+        else if (!pressed and (it != scancodes.end()))
+        {
+            *it = 0;
+        }
+    }
+};
+
+template <std::uint8_t REPORT_ID>
+struct output_report : public report::base<report::type::OUTPUT, REPORT_ID>
+{
+    struct
+    {
+        std::uint8_t bits{};
+
+        constexpr bool test(page::leds led) const
+        {
+            return bits & (1 << (static_cast<std::uint8_t>(led) - 1));
+        }
+    } leds;
+};
+
+template <std::uint8_t REPORT_ID>
+constexpr auto app_report_descriptor()
+{
+    using namespace hid::rdf;
+    using namespace hid::page;
+    // clang-format off
+    return descriptor(
+        usage_page<generic_desktop>(),
+        usage(generic_desktop::KEYBOARD),
+        collection::application(
+            report_id(REPORT_ID),
+            // modifier bits
+            usage_page<keyboard_keypad>(),
+            usage_limits(keyboard_keypad::KEYBOARD_LEFT_CONTROL,
+                         keyboard_keypad::KEYBOARD_RIGHT_GUI),
+            logical_limits(0, 1),
+            report_size(1),
+            report_count(8),
+            input::absolute_variable(),
+            input::padding(8),
+            // key codes
+            usage_limits(static_cast<keyboard_keypad>(0), static_cast<keyboard_keypad>(0xff)),
+            logical_limits(0, 0xff),
+            report_size(8),
+            report_count(6),
+            input::array(),
+            // LEDs
+            usage_page<leds>(),
+            usage_limits(leds::NUM_LOCK, leds::KANA),
+            logical_limits(0, 1),
+            report_size(1),
+            report_count(5),
+            output::absolute_variable(),
+            output::padding(3)
+        )
+    );
+    // clang-format on
+}
+} // namespace hid::app::keyboard
+
+#endif // __HID_APP_KEYBOARD_HPP_
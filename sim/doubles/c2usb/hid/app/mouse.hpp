@@ -0,0 +1,70 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+/// @brief  Test double of the hid-rp mouse application.
+#ifndef __HID_APP_MOUSE_HPP_
+#define __HID_APP_MOUSE_HPP_
+
+#include "hid/page.hpp"
+#include "hid/report.hpp"
+
+namespace hid::app::mouse
+{
+template <std::uint8_t REPORT_ID>
+struct report : public hid::report::base<hid::report::type::INPUT, REPORT_ID>
+{
+    std::uint8_t buttons{};
+    std::int8_t x{};
+    std::int8_t y{};
+    std::int8_t wheel_y{};
+    std::int8_t wheel_x{};
+};
+
+template <std::uint8_t REPORT_ID>
+constexpr auto app_report_descriptor()
+{
+    using namespace hid::rdf;
+    using namespace hid::page;
+    // clang-format off
+    return descriptor(
+        usage_page<generic_desktop>(),
+        usage(generic_desktop::MOUSE),
+        collection::application(
+            usage(generic_desktop::POINTER),
+            collection::physical(
+                report_id(REPORT_ID),
+                // buttons
+                usage_page<button>(),
+                usage_limits(button::BUTTON_1, button::BUTTON_3),
+                logical_limits(0, 1),
+                report_size(1),
+                report_count(3),
+                input::absolute_variable(),
+                input::padding(5),
+                // motion
+                usage_page<generic_desktop>(),
+                usage(generic_desktop::X),
+                usage(generic_desktop::Y),
+                usage(generic_desktop::WHEEL),
+                logical_limits(-127, 127),
+                report_size(8),
+                report_count(3),
+                input::relative_variable(),
+                usage_extended(consumer::AC_PAN),
+                report_count(1),
+                input::relative_variable()
+            )
+        )
+    );
+    // clang-format on
+}
+} // namespace hid::app::mouse
+
+#endif // __HID_APP_MOUSE_HPP_
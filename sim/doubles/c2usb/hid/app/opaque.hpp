@@ -0,0 +1,42 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+/// @brief  Test double of the hid-rp opaque (vendor defined raw data) reports.
+#ifndef __HID_APP_OPAQUE_HPP_
+#define __HID_APP_OPAQUE_HPP_
+
+#include <array>
+#include "hid/page.hpp"
+#include "hid/report.hpp"
+
+namespace hid::app::opaque
+{
+template <std::size_t SIZE, hid::report::type TYPE, std::uint8_t REPORT_ID>
+struct report : public hid::report::base<TYPE, REPORT_ID>
+{
+    static constexpr std::size_t size() { return SIZE; }
+
+    std::array<std::uint8_t, SIZE> data{};
+};
+
+template <typename TReport, typename TUsage>
+constexpr auto report_descriptor(TUsage u)
+{
+    using namespace hid::rdf;
+    constexpr auto tag = (TReport::type() == hid::report::type::INPUT)    ? main::tag::INPUT
+                         : (TReport::type() == hid::report::type::OUTPUT) ? main::tag::OUTPUT
+                                                                          : main::tag::FEATURE;
+    return descriptor(report_id(TReport::ID), usage_extended(u), logical_limits(0, 0xff),
+                      report_size(8), report_count(TReport::size()),
+                      data_field<tag>(main::VARIABLE));
+}
+} // namespace hid::app::opaque
+
+#endif // __HID_APP_OPAQUE_HPP_
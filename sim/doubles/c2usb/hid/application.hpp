@@ -0,0 +1,107 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+/// @brief  Test double of the c2usb HID application interface.
+#ifndef __HID_APPLICATION_HPP_
+#define __HID_APPLICATION_HPP_
+
+#include <span>
+#include "hid/page.hpp"
+#include "hid/report_protocol.hpp"
+
+namespace hid
+{
+enum class result : std::uint8_t
+{
+    OK,
+    INVALID,
+    NO_TRANSPORT,
+    BUSY,
+};
+
+/// @brief The interface of the HID transport (the I2C HID device) towards the application.
+class transport
+{
+  public:
+    virtual result send_report(const std::span<const uint8_t>& data, report::type type) = 0;
+    virtual result receive_report(const std::span<uint8_t>& data, report::type type) = 0;
+};
+
+class application
+{
+  public:
+    constexpr application(const report_protocol& rp) : report_info_(rp) {}
+
+    virtual void start(protocol prot) = 0;
+    virtual void stop() = 0;
+    virtual void set_report(report::type type, const std::span<const uint8_t>& data) = 0;
+    virtual void get_report(report::selector select, const std::span<uint8_t>& buffer) = 0;
+    virtual void in_report_sent([[maybe_unused]] const std::span<const uint8_t>& data) {}
+
+    const report_protocol& report_info() const { return report_info_; }
+
+    /// @brief Called by the transport to start the application.
+    bool setup(transport* tp, protocol prot)
+    {
+        if (transport_ != nullptr)
+        {
+            return false;
+        }
+        transport_ = tp;
+        start(prot);
+        return true;
+    }
+
+    /// @brief Called by the transport to stop the application.
+    bool teardown(transport* tp)
+    {
+        if (transport_ != tp)
+        {
+            return false;
+        }
+        stop();
+        transport_ = nullptr;
+        return true;
+    }
+
+    bool has_transport(const transport* tp) const { return transport_ == tp; }
+
+    result send_report(const std::span<const uint8_t>& data,
+                       report::type type = report::type::INPUT)
+    {
+        return (transport_ != nullptr) ? transport_->send_report(data, type)
+                                       : result::NO_TRANSPORT;
+    }
+    template <typename T>
+    result send_report(const T* report)
+    {
+        return send_report({reinterpret_cast<const uint8_t*>(report), sizeof(*report)},
+                           T::type());
+    }
+
+    result receive_report(const std::span<uint8_t>& data,
+                          report::type type = report::type::OUTPUT)
+    {
+        return (transport_ != nullptr) ? transport_->receive_report(data, type)
+                                       : result::NO_TRANSPORT;
+    }
+    template <typename T>
+    result receive_report(T* report)
+    {
+        return receive_report({reinterpret_cast<uint8_t*>(report), sizeof(*report)}, T::type());
+    }
+
+  private:
+    const report_protocol& report_info_;
+    transport* transport_{};
+};
+} // namespace hid
+
+#endif // __HID_APPLICATION_HPP_
@@ -0,0 +1,82 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+/// @brief  Test double of the hid-rp usage pages, limited to the usages of the demo application.
+#ifndef __HID_PAGE_HPP_
+#define __HID_PAGE_HPP_
+
+#include "hid/rdf/descriptor.hpp"
+
+namespace hid::page
+{
+enum class generic_desktop : usage_id_t
+{
+    POINTER = 0x01,
+    MOUSE = 0x02,
+    KEYBOARD = 0x06,
+    X = 0x30,
+    Y = 0x31,
+    WHEEL = 0x38,
+};
+template <>
+struct info<generic_desktop>
+{
+    constexpr static page_id_t page_id = 0x01;
+};
+
+enum class keyboard_keypad : usage_id_t
+{
+    KEYBOARD_CAPS_LOCK = 0x39,
+    KEYBOARD_LEFT_CONTROL = 0xe0,
+    KEYBOARD_RIGHT_GUI = 0xe7,
+};
+template <>
+struct info<keyboard_keypad>
+{
+    constexpr static page_id_t page_id = 0x07;
+};
+
+enum class leds : usage_id_t
+{
+    NUM_LOCK = 0x01,
+    CAPS_LOCK = 0x02,
+    SCROLL_LOCK = 0x03,
+    COMPOSE = 0x04,
+    KANA = 0x05,
+};
+template <>
+struct info<leds>
+{
+    constexpr static page_id_t page_id = 0x08;
+};
+
+enum class button : usage_id_t
+{
+    BUTTON_1 = 0x01,
+    BUTTON_3 = 0x03,
+};
+template <>
+struct info<button>
+{
+    constexpr static page_id_t page_id = 0x09;
+};
+
+enum class consumer : usage_id_t
+{
+    AC_PAN = 0x238,
+};
+template <>
+struct info<consumer>
+{
+    constexpr static page_id_t page_id = 0x0c;
+};
+} // namespace hid::page
+
+#endif // __HID_PAGE_HPP_
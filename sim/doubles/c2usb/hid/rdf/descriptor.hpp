@@ -0,0 +1,324 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+/// @brief  Test double of the hid-rp report descriptor builder and parser,
+///         limited to the items that the demo application uses.
+#ifndef __HID_RDF_DESCRIPTOR_HPP_
+#define __HID_RDF_DESCRIPTOR_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+namespace hid
+{
+using page_id_t = std::uint16_t;
+using usage_id_t = std::uint16_t;
+
+namespace page
+{
+template <typename T>
+struct info;
+}
+
+namespace rdf
+{
+using byte_type = std::uint8_t;
+
+enum class item_type : byte_type
+{
+    MAIN = 0,
+    GLOBAL = 1,
+    LOCAL = 2,
+};
+
+namespace main
+{
+enum class tag : byte_type
+{
+    INPUT = 0x8,
+    OUTPUT = 0x9,
+    COLLECTION = 0xa,
+    FEATURE = 0xb,
+    END_COLLECTION = 0xc,
+};
+
+enum data_field_flag : byte_type
+{
+    DATA = 0x00,
+    CONSTANT = 0x01,
+    ARRAY = 0x00,
+    VARIABLE = 0x02,
+    ABSOLUTE = 0x00,
+    RELATIVE = 0x04,
+};
+} // namespace main
+
+namespace global
+{
+enum class tag : byte_type
+{
+    USAGE_PAGE = 0x0,
+    LOGICAL_MINIMUM = 0x1,
+    LOGICAL_MAXIMUM = 0x2,
+    REPORT_SIZE = 0x7,
+    REPORT_ID = 0x8,
+    REPORT_COUNT = 0x9,
+    PUSH = 0xa,
+    POP = 0xb,
+};
+} // namespace global
+
+namespace local
+{
+enum class tag : byte_type
+{
+    USAGE = 0x0,
+    USAGE_MINIMUM = 0x1,
+    USAGE_MAXIMUM = 0x2,
+};
+} // namespace local
+
+constexpr item_type type_of(main::tag) { return item_type::MAIN; }
+constexpr item_type type_of(global::tag) { return item_type::GLOBAL; }
+constexpr item_type type_of(local::tag) { return item_type::LOCAL; }
+
+/// @brief A short item with a little endian data of @p DATA_SIZE bytes (0, 1, 2 or 4).
+template <std::size_t DATA_SIZE, typename TTag>
+constexpr std::array<byte_type, 1 + DATA_SIZE> short_item(TTag tag, std::uint32_t value = 0)
+{
+    static_assert((DATA_SIZE <= 2) or (DATA_SIZE == 4));
+    std::array<byte_type, 1 + DATA_SIZE> item{};
+    item[0] = static_cast<byte_type>((static_cast<byte_type>(tag) << 4) |
+                                     (static_cast<byte_type>(type_of(tag)) << 2) |
+                                     ((DATA_SIZE == 4) ? 3 : DATA_SIZE));
+    for (std::size_t i = 0; i < DATA_SIZE; i++)
+    {
+        item[1 + i] = static_cast<byte_type>(value >> (8 * i));
+    }
+    return item;
+}
+
+template <std::size_t... N>
+constexpr auto descriptor(const std::array<byte_type, N>&... items)
+{
+    std::array<byte_type, (N + ... + 0)> desc{};
+    std::size_t offset = 0;
+    (
+        [&]
+        {
+            for (auto b : items)
+            {
+                desc[offset++] = b;
+            }
+        }(),
+        ...);
+    return desc;
+}
+
+/// @brief A parsed short item.
+struct item
+{
+    byte_type prefix{};
+    std::array<byte_type, 4> data{};
+
+    constexpr std::size_t data_size() const
+    {
+        auto code = prefix & 3;
+        return (code == 3) ? 4 : code;
+    }
+    constexpr item_type type() const { return static_cast<item_type>((prefix >> 2) & 3); }
+    constexpr byte_type tag() const { return prefix >> 4; }
+    constexpr std::uint32_t value_unsigned() const
+    {
+        std::uint32_t value = 0;
+        for (std::size_t i = 0; i < data_size(); i++)
+        {
+            value |= static_cast<std::uint32_t>(data[i]) << (8 * i);
+        }
+        return value;
+    }
+    template <typename TTag>
+    constexpr bool has_tag(TTag t) const
+    {
+        return (type() == type_of(t)) and (tag() == static_cast<byte_type>(t));
+    }
+};
+
+/// @brief A non-owning view of a report descriptor.
+class descriptor_view
+{
+  public:
+    constexpr descriptor_view(const byte_type* data, std::size_t size) : data_(data), size_(size)
+    {}
+
+    constexpr const byte_type* data() const { return data_; }
+    constexpr std::size_t size() const { return size_; }
+
+    /// @brief Calls @p fn with each item of the descriptor.
+    template <typename TFunction>
+    constexpr void for_each_item(TFunction fn) const
+    {
+        for (std::size_t offset = 0; offset < size_;)
+        {
+            item it{data_[offset]};
+            for (std::size_t i = 0; i < it.data_size(); i++)
+            {
+                it.data[i] = data_[offset + 1 + i];
+            }
+            offset += 1 + it.data_size();
+            fn(it);
+        }
+    }
+
+    /// @brief Finds the item with the given tag, whose value is preferred by @p compare
+    ///        over all the others.
+    template <typename TTag, typename TCompare>
+    constexpr std::optional<item> tag_value_unsigned_most(TTag t, TCompare compare) const
+    {
+        std::optional<item> most{};
+        for_each_item(
+            [&](const item& it)
+            {
+                if (it.has_tag(t) and
+                    (!most or compare(most->value_unsigned(), it.value_unsigned())))
+                {
+                    most = it;
+                }
+            });
+        return most;
+    }
+
+  private:
+    const byte_type* data_;
+    std::size_t size_;
+};
+
+// the builders of the descriptor items
+
+template <typename TPage>
+constexpr auto usage_page()
+{
+    return short_item<2>(global::tag::USAGE_PAGE, page::info<TPage>::page_id);
+}
+
+template <typename TUsage>
+constexpr auto usage(TUsage u)
+{
+    return short_item<2>(local::tag::USAGE, static_cast<usage_id_t>(u));
+}
+
+/// @brief A usage with its page, independent of the current usage page.
+template <typename TUsage>
+constexpr auto usage_extended(TUsage u)
+{
+    return short_item<4>(local::tag::USAGE, (static_cast<std::uint32_t>(
+                                                 page::info<TUsage>::page_id)
+                                             << 16) |
+                                                static_cast<usage_id_t>(u));
+}
+
+template <typename TUsage>
+constexpr auto usage_limits(TUsage min, TUsage max)
+{
+    return descriptor(short_item<2>(local::tag::USAGE_MINIMUM, static_cast<usage_id_t>(min)),
+                      short_item<2>(local::tag::USAGE_MAXIMUM, static_cast<usage_id_t>(max)));
+}
+
+constexpr auto logical_limits(std::int16_t min, std::int16_t max)
+{
+    return descriptor(
+        short_item<2>(global::tag::LOGICAL_MINIMUM, static_cast<std::uint16_t>(min)),
+        short_item<2>(global::tag::LOGICAL_MAXIMUM, static_cast<std::uint16_t>(max)));
+}
+
+constexpr auto report_size(std::uint8_t bits)
+{
+    return short_item<1>(global::tag::REPORT_SIZE, bits);
+}
+
+constexpr auto report_count(std::uint16_t count)
+{
+    return short_item<2>(global::tag::REPORT_COUNT, count);
+}
+
+constexpr auto report_id(std::uint8_t id)
+{
+    return short_item<1>(global::tag::REPORT_ID, id);
+}
+
+template <main::tag TAG>
+constexpr auto data_field(std::uint8_t flags)
+{
+    return short_item<1>(TAG, flags);
+}
+
+namespace input
+{
+constexpr auto absolute_variable() { return data_field<main::tag::INPUT>(main::VARIABLE); }
+constexpr auto relative_variable()
+{
+    return data_field<main::tag::INPUT>(main::VARIABLE | main::RELATIVE);
+}
+constexpr auto array() { return data_field<main::tag::INPUT>(main::ARRAY); }
+constexpr auto padding(std::uint8_t bits)
+{
+    return descriptor(report_size(bits), report_count(1),
+                      data_field<main::tag::INPUT>(main::CONSTANT));
+}
+} // namespace input
+
+namespace output
+{
+constexpr auto absolute_variable() { return data_field<main::tag::OUTPUT>(main::VARIABLE); }
+constexpr auto padding(std::uint8_t bits)
+{
+    return descriptor(report_size(bits), report_count(1),
+                      data_field<main::tag::OUTPUT>(main::CONSTANT));
+}
+} // namespace output
+
+namespace feature
+{
+constexpr auto absolute_variable() { return data_field<main::tag::FEATURE>(main::VARIABLE); }
+} // namespace feature
+
+namespace collection
+{
+enum class type : byte_type
+{
+    PHYSICAL = 0x00,
+    APPLICATION = 0x01,
+};
+
+template <std::size_t... N>
+constexpr auto make(type t, const std::array<byte_type, N>&... items)
+{
+    return descriptor(short_item<1>(main::tag::COLLECTION, static_cast<byte_type>(t)), items...,
+                      short_item<0>(main::tag::END_COLLECTION));
+}
+
+template <std::size_t... N>
+constexpr auto application(const std::array<byte_type, N>&... items)
+{
+    return make(type::APPLICATION, items...);
+}
+
+template <std::size_t... N>
+constexpr auto physical(const std::array<byte_type, N>&... items)
+{
+    return make(type::PHYSICAL, items...);
+}
+} // namespace collection
+} // namespace rdf
+} // namespace hid
+
+#endif // __HID_RDF_DESCRIPTOR_HPP_
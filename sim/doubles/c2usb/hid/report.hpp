@@ -0,0 +1,68 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+/// @brief  Test double of the hid-rp report definitions.
+#ifndef __HID_REPORT_HPP_
+#define __HID_REPORT_HPP_
+
+#include <cstdint>
+
+namespace hid
+{
+enum class protocol : std::uint8_t
+{
+    BOOT = 0,
+    REPORT = 1,
+};
+
+namespace report
+{
+enum class type : std::uint8_t
+{
+    INPUT = 1,
+    OUTPUT = 2,
+    FEATURE = 3,
+};
+
+struct id
+{
+    using type = std::uint8_t;
+};
+
+class selector
+{
+  public:
+    constexpr selector(report::type t, std::uint8_t i = 0) : type_(t), id_(i) {}
+
+    constexpr report::type type() const { return type_; }
+    constexpr std::uint8_t id() const { return id_; }
+
+    constexpr bool operator==(const selector&) const = default;
+
+  private:
+    report::type type_;
+    std::uint8_t id_;
+};
+
+/// @brief The common part of the report layouts, the report ID is the first byte.
+template <report::type TYPE, std::uint8_t REPORT_ID>
+struct base
+{
+    static_assert(REPORT_ID > 0, "reports without ID are not supported by the test double");
+    static constexpr std::uint8_t ID = REPORT_ID;
+    static constexpr report::type type() { return TYPE; }
+    static constexpr report::selector selector() { return {TYPE, REPORT_ID}; }
+
+    std::uint8_t id{REPORT_ID};
+};
+} // namespace report
+} // namespace hid
+
+#endif // __HID_REPORT_HPP_
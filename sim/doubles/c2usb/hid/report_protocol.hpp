@@ -0,0 +1,108 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+/// @brief  Test double of the hid-rp report protocol, the report sizes are parsed
+///         from the descriptor at compile time.
+#ifndef __HID_REPORT_PROTOCOL_HPP_
+#define __HID_REPORT_PROTOCOL_HPP_
+
+#include <algorithm>
+#include "hid/rdf/descriptor.hpp"
+#include "hid/report.hpp"
+
+namespace hid
+{
+class report_protocol
+{
+  public:
+    using size_type = std::uint16_t;
+
+    template <std::size_t N>
+    constexpr report_protocol(const std::array<rdf::byte_type, N>& desc)
+        : descriptor(desc.data(), N),
+          max_input_size(max_size(descriptor, rdf::main::tag::INPUT)),
+          max_output_size(max_size(descriptor, rdf::main::tag::OUTPUT)),
+          max_feature_size(max_size(descriptor, rdf::main::tag::FEATURE)),
+          max_report_id_(
+              descriptor
+                  .tag_value_unsigned_most(rdf::global::tag::REPORT_ID,
+                                           [](std::uint32_t most, std::uint32_t current)
+                                           { return most < current; })
+                  .value_or(rdf::item{})
+                  .value_unsigned())
+    {}
+
+    constexpr report::id::type max_report_id() const { return max_report_id_; }
+    constexpr bool uses_report_ids() const { return max_report_id_ > 0; }
+
+    rdf::descriptor_view descriptor;
+    size_type max_input_size;
+    size_type max_output_size;
+    size_type max_feature_size;
+
+  private:
+    report::id::type max_report_id_;
+
+    /// @brief The size of the largest report of a type in bytes, including the report ID.
+    static constexpr size_type max_size(const rdf::descriptor_view& desc, rdf::main::tag type)
+    {
+        struct globals
+        {
+            std::uint32_t size;
+            std::uint32_t count;
+            std::uint32_t id;
+        };
+        std::array<globals, 4> stack{};
+        std::size_t depth = 0;
+        std::array<std::uint32_t, 256> bits{};
+        desc.for_each_item(
+            [&](const rdf::item& it)
+            {
+                auto& g = stack[depth];
+                if (it.has_tag(rdf::global::tag::REPORT_SIZE))
+                {
+                    g.size = it.value_unsigned();
+                }
+                else if (it.has_tag(rdf::global::tag::REPORT_COUNT))
+                {
+                    g.count = it.value_unsigned();
+                }
+                else if (it.has_tag(rdf::global::tag::REPORT_ID))
+                {
+                    g.id = it.value_unsigned();
+                }
+                else if (it.has_tag(rdf::global::tag::PUSH))
+                {
+                    stack[depth + 1] = g;
+                    depth++;
+                }
+                else if (it.has_tag(rdf::global::tag::POP))
+                {
+                    depth--;
+                }
+                else if (it.has_tag(type))
+                {
+                    bits[g.id] += g.size * g.count;
+                }
+            });
+        size_type max = 0;
+        for (std::size_t id = 0; id < bits.size(); id++)
+        {
+            if (bits[id] > 0)
+            {
+                max = std::max<size_type>(max, (bits[id] + 7) / 8 + ((id > 0) ? 1 : 0));
+            }
+        }
+        return max;
+    }
+};
+} // namespace hid
+
+#endif // __HID_REPORT_PROTOCOL_HPP_
@@ -0,0 +1,297 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+/// @brief  Test double of the c2usb HID over I2C device, see device.hpp.
+#include "i2c/hid/device.hpp"
+
+namespace i2c::hid
+{
+// the registers following the HID descriptor one
+enum register_offset : std::uint16_t
+{
+    REPORT_DESCRIPTOR = 1,
+    INPUT_REPORT = 2,
+    OUTPUT_REPORT = 3,
+    COMMAND = 4,
+    DATA = 5,
+};
+
+device::device(::hid::application& app, const product_info& pinfo, slave& slv, address addr,
+               std::uint16_t hid_descriptor_reg_address)
+    : app_(app), slave_(slv), hid_descriptor_reg_(hid_descriptor_reg_address)
+{
+    auto& rp = app_.report_info();
+    descriptor_.wReportDescLength = rp.descriptor.size();
+    descriptor_.wReportDescRegister = hid_descriptor_reg_ + REPORT_DESCRIPTOR;
+    descriptor_.wInputRegister = hid_descriptor_reg_ + INPUT_REPORT;
+    descriptor_.wMaxInputLength = sizeof(std::uint16_t) + rp.max_input_size;
+    descriptor_.wOutputRegister = hid_descriptor_reg_ + OUTPUT_REPORT;
+    descriptor_.wMaxOutputLength = sizeof(std::uint16_t) + rp.max_output_size;
+    descriptor_.wCommandRegister = hid_descriptor_reg_ + COMMAND;
+    descriptor_.wDataRegister = hid_descriptor_reg_ + DATA;
+    descriptor_.wVendorID = pinfo.vendor_id;
+    descriptor_.wProductID = pinfo.product_id;
+    descriptor_.wVersionID = pinfo.version;
+
+    slave_.register_module(*this, addr);
+}
+
+void device::update_interrupt()
+{
+    bool asserted = reset_pending_ or !in_report_.empty();
+    if (asserted != interrupt_)
+    {
+        interrupt_ = asserted;
+        slave_.set_pin_interrupt(asserted);
+    }
+}
+
+void device::reset()
+{
+    app_.teardown(this);
+    in_report_ = {};
+    out_buffer_ = {};
+    app_.setup(this, ::hid::protocol::REPORT);
+    // the host is notified of the completion with an empty input report
+    reset_pending_ = true;
+    update_interrupt();
+}
+
+void device::send_length_prefixed(reply r, const std::span<const uint8_t>& data)
+{
+    reply_ = r;
+    reply_size_ = sizeof(length_) + data.size();
+    length_[0] = static_cast<uint8_t>(reply_size_);
+    length_[1] = static_cast<uint8_t>(reply_size_ >> 8);
+    slave_.send(length_, data);
+}
+
+void device::send_input()
+{
+    if (reset_pending_)
+    {
+        length_ = {};
+        reply_ = reply::RESET;
+        reply_size_ = sizeof(length_);
+        slave_.send(length_);
+    }
+    else if (!in_report_.empty())
+    {
+        send_length_prefixed(reply::INPUT, in_report_);
+    }
+    else
+    {
+        // nothing to report, the host reads an empty length
+        length_ = {};
+        reply_ = reply::NONE;
+        slave_.send(length_);
+    }
+}
+
+bool device::get_report(std::size_t written)
+{
+    // the command register, the command, and the data register were written
+    if (written < (sizeof(header_) + sizeof(std::uint16_t)))
+    {
+        return false;
+    }
+    auto type = static_cast<::hid::report::type>((header_[2] >> 4) & 0x3);
+    auto id = static_cast<std::uint8_t>(header_[2] & 0xf);
+    get_response_ = {};
+    get_report_answered_ = false;
+    get_report_pending_ = true;
+    app_.get_report({type, id}, payload_);
+    get_report_pending_ = false;
+    if (!get_report_answered_)
+    {
+        send_length_prefixed(reply::GET_REPORT, {});
+    }
+    return true;
+}
+
+bool device::on_start(direction dir, std::size_t data_length)
+{
+    if (dir == direction::WRITE)
+    {
+        reply_ = reply::NONE;
+        slave_.receive(header_, payload_);
+        return true;
+    }
+    if (data_length == 0)
+    {
+        send_input();
+        return true;
+    }
+    if (data_length < sizeof(std::uint16_t))
+    {
+        return false;
+    }
+    auto reg = register_address();
+    if (reg == hid_descriptor_reg_)
+    {
+        reply_ = reply::DESCRIPTOR;
+        slave_.send({reinterpret_cast<const uint8_t*>(&descriptor_), sizeof(descriptor_)});
+        return true;
+    }
+    switch (reg - hid_descriptor_reg_)
+    {
+    case REPORT_DESCRIPTOR:
+        reply_ = reply::DESCRIPTOR;
+        slave_.send({app_.report_info().descriptor.data(), app_.report_info().descriptor.size()});
+        return true;
+    case INPUT_REPORT:
+        send_input();
+        return true;
+    case COMMAND:
+        if ((header_[3] & 0xf) == static_cast<std::uint8_t>(opcode::GET_REPORT))
+        {
+            return get_report(data_length);
+        }
+        return false;
+    default:
+        return false;
+    }
+}
+
+void device::on_stop(direction dir, std::size_t data_length)
+{
+    if (dir == direction::WRITE)
+    {
+        process_write(data_length);
+        return;
+    }
+    auto r = reply_;
+    reply_ = reply::NONE;
+    switch (r)
+    {
+    case reply::INPUT:
+        // a partial read leaves the report pending
+        if (data_length >= reply_size_)
+        {
+            auto data = in_report_;
+            in_report_ = {};
+            update_interrupt();
+            app_.in_report_sent(data);
+        }
+        break;
+    case reply::RESET:
+        if (data_length >= reply_size_)
+        {
+            reset_pending_ = false;
+            update_interrupt();
+        }
+        break;
+    case reply::GET_REPORT:
+        if (!get_response_.empty())
+        {
+            auto data = get_response_;
+            get_response_ = {};
+            app_.in_report_sent(data);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void device::process_write(std::size_t size)
+{
+    if (size < sizeof(header_))
+    {
+        return;
+    }
+    switch (register_address() - hid_descriptor_reg_)
+    {
+    case OUTPUT_REPORT:
+    {
+        std::size_t length = header_[2] | (header_[3] << 8);
+        if ((length <= sizeof(std::uint16_t)) or (length > (size - sizeof(std::uint16_t))) or
+            out_buffer_.empty())
+        {
+            return;
+        }
+        out_buffer_ = {};
+        app_.set_report(::hid::report::type::OUTPUT,
+                        {payload_.data(), length - sizeof(std::uint16_t)});
+        break;
+    }
+    case COMMAND:
+        process_command(size);
+        break;
+    default:
+        break;
+    }
+}
+
+void device::process_command(std::size_t size)
+{
+    switch (static_cast<opcode>(header_[3] & 0xf))
+    {
+    case opcode::RESET:
+        reset();
+        break;
+    case opcode::SET_POWER:
+        powered_ = (header_[2] & 0x3) == 0;
+        break;
+    case opcode::SET_REPORT:
+    {
+        // the data register and the length precede the report
+        constexpr std::size_t PREFIX = 2 * sizeof(std::uint16_t);
+        if ((size < (sizeof(header_) + PREFIX)) or out_buffer_.empty())
+        {
+            return;
+        }
+        std::size_t length = payload_[2] | (payload_[3] << 8);
+        if ((length <= sizeof(std::uint16_t)) or
+            ((length - sizeof(std::uint16_t)) > (size - sizeof(header_) - PREFIX)))
+        {
+            return;
+        }
+        auto type = static_cast<::hid::report::type>((header_[2] >> 4) & 0x3);
+        out_buffer_ = {};
+        app_.set_report(type, {payload_.data() + PREFIX, length - sizeof(std::uint16_t)});
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+::hid::result device::send_report(const std::span<const uint8_t>& data,
+                                  ::hid::report::type type)
+{
+    if (get_report_pending_)
+    {
+        get_report_answered_ = true;
+        get_response_ = data;
+        send_length_prefixed(reply::GET_REPORT, data);
+        return ::hid::result::OK;
+    }
+    if (type != ::hid::report::type::INPUT)
+    {
+        return ::hid::result::INVALID;
+    }
+    if (reset_pending_ or !in_report_.empty())
+    {
+        return ::hid::result::BUSY;
+    }
+    in_report_ = data;
+    update_interrupt();
+    return ::hid::result::OK;
+}
+
+::hid::result device::receive_report(const std::span<uint8_t>& data,
+                                     [[maybe_unused]] ::hid::report::type type)
+{
+    // the reports are received to the transport's buffer, passed to set_report() from there
+    out_buffer_ = data;
+    return ::hid::result::OK;
+}
+} // namespace i2c::hid
@@ -0,0 +1,123 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+/// @brief  Test double of the c2usb HID over I2C device, implementing the parts of the
+///         protocol that the simulated host uses: the descriptors, input reports with the
+///         interrupt line, output reports, and the RESET, GET_REPORT, SET_REPORT and
+///         SET_POWER commands.
+#ifndef __I2C_HID_DEVICE_HPP_
+#define __I2C_HID_DEVICE_HPP_
+
+#include <array>
+#include "hid/application.hpp"
+#include "i2c/slave.hpp"
+
+namespace i2c::hid
+{
+constexpr std::uint16_t version(std::uint8_t major, std::uint8_t minor)
+{
+    return (major << 8) | minor;
+}
+
+struct product_info
+{
+    std::uint16_t vendor_id;
+    std::uint16_t product_id;
+    std::uint16_t version;
+};
+
+/// @brief The commands of the command register.
+enum class opcode : std::uint8_t
+{
+    RESET = 0x1,
+    GET_REPORT = 0x2,
+    SET_REPORT = 0x3,
+    SET_POWER = 0x8,
+};
+
+/// @brief The HID descriptor, all fields are little endian.
+struct descriptor
+{
+    std::uint16_t wHIDDescLength{sizeof(descriptor)};
+    std::uint16_t bcdVersion{0x0100};
+    std::uint16_t wReportDescLength{};
+    std::uint16_t wReportDescRegister{};
+    std::uint16_t wInputRegister{};
+    std::uint16_t wMaxInputLength{};
+    std::uint16_t wOutputRegister{};
+    std::uint16_t wMaxOutputLength{};
+    std::uint16_t wCommandRegister{};
+    std::uint16_t wDataRegister{};
+    std::uint16_t wVendorID{};
+    std::uint16_t wProductID{};
+    std::uint16_t wVersionID{};
+    std::uint16_t reserved[2]{};
+};
+static_assert(sizeof(descriptor) == 30);
+
+class device : public slave::module, public ::hid::transport
+{
+  public:
+    device(::hid::application& app, const product_info& pinfo, slave& slv, address addr,
+           std::uint16_t hid_descriptor_reg_address);
+
+    bool on_start(direction dir, std::size_t data_length) override;
+    void on_stop(direction dir, std::size_t data_length) override;
+
+    ::hid::result send_report(const std::span<const uint8_t>& data,
+                              ::hid::report::type type) override;
+    ::hid::result receive_report(const std::span<uint8_t>& data,
+                                 ::hid::report::type type) override;
+
+  private:
+    enum class reply : std::uint8_t
+    {
+        NONE,
+        DESCRIPTOR,
+        RESET,
+        INPUT,
+        GET_REPORT,
+    };
+
+    /// @brief The largest write transfer after the register and command bytes:
+    ///        the data register, the length and the report.
+    static constexpr std::size_t MAX_WRITE_PAYLOAD = 4 + 512;
+
+    std::uint16_t register_address() const { return header_[0] | (header_[1] << 8); }
+    void send_length_prefixed(reply r, const std::span<const uint8_t>& data);
+    void send_input();
+    bool get_report(std::size_t written);
+    void process_write(std::size_t size);
+    void process_command(std::size_t size);
+    void reset();
+    void update_interrupt();
+
+    ::hid::application& app_;
+    slave& slave_;
+    descriptor descriptor_{};
+    const std::uint16_t hid_descriptor_reg_;
+    // the register address, and either the command or the output report length
+    std::array<uint8_t, 4> header_{};
+    std::array<uint8_t, 2> length_{};
+    std::array<uint8_t, MAX_WRITE_PAYLOAD> payload_{};
+    std::span<uint8_t> out_buffer_{};
+    std::span<const uint8_t> in_report_{};
+    std::span<const uint8_t> get_response_{};
+    std::size_t reply_size_{};
+    reply reply_{};
+    bool get_report_pending_{};
+    bool get_report_answered_{};
+    bool reset_pending_{};
+    bool interrupt_{};
+    bool powered_{true};
+};
+} // namespace i2c::hid
+
+#endif // __I2C_HID_DEVICE_HPP_
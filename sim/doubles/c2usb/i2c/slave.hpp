@@ -0,0 +1,99 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+/// @brief  Test double of the c2usb I2C slave interface.
+#ifndef __I2C_SLAVE_HPP_
+#define __I2C_SLAVE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace i2c
+{
+enum class direction : std::uint8_t
+{
+    WRITE = 0,
+    READ = 1,
+};
+
+class address
+{
+  public:
+    constexpr explicit address(std::uint16_t code, bool ten_bit = false)
+        : code_(code), ten_bit_(ten_bit)
+    {}
+
+    constexpr std::uint16_t raw() const { return code_; }
+    constexpr bool is_10bit() const { return ten_bit_; }
+
+  private:
+    std::uint16_t code_;
+    bool ten_bit_;
+};
+
+/// @brief The interface of an I2C slave driver towards the protocol (module) on top of it.
+class slave
+{
+  public:
+    /// @brief The protocol layer, served by the slave at its address.
+    class module
+    {
+      public:
+        /// @brief Called at the address match, the module must set up the transfer buffers
+        ///        with @ref slave::send or @ref slave::receive.
+        /// @param dir: the direction of the transfer
+        /// @param data_length: the length of the previous phase, in case of repeated start
+        /// @return false to reject the transfer
+        virtual bool on_start(direction dir, std::size_t data_length) = 0;
+        /// @brief Called at the end of the transfer.
+        /// @param dir: the direction of the last phase
+        /// @param data_length: the number of bytes transferred in the last phase
+        virtual void on_stop(direction dir, std::size_t data_length) = 0;
+    };
+
+    void register_module(module& m, address slave_addr)
+    {
+        module_ = &m;
+        start_listen(slave_addr);
+    }
+
+    void unregister_module(module& m, address slave_addr)
+    {
+        if (module_ == &m)
+        {
+            stop_listen(slave_addr);
+            module_ = nullptr;
+        }
+    }
+
+    virtual void set_pin_interrupt(bool asserted) = 0;
+    virtual void send(const std::span<const uint8_t>& a) = 0;
+    virtual void send(const std::span<const uint8_t>& a, const std::span<const uint8_t>& b) = 0;
+    virtual void receive(const std::span<uint8_t>& a) = 0;
+    virtual void receive(const std::span<uint8_t>& a, const std::span<uint8_t>& b) = 0;
+
+  protected:
+    virtual void start_listen(address slave_addr) = 0;
+    virtual void stop_listen(address slave_addr) = 0;
+
+    bool has_module() const { return module_ != nullptr; }
+    bool on_start(direction dir, std::size_t data_length)
+    {
+        return module_->on_start(dir, data_length);
+    }
+    void on_stop(direction dir, std::size_t data_length) { module_->on_stop(dir, data_length); }
+
+  private:
+    module* module_{};
+};
+} // namespace i2c
+
+#endif // __I2C_SLAVE_HPP_
@@ -0,0 +1,298 @@
+/// @file
+///
+/// @copyright
+///         Copyright (c) 2016 STMicroelectronics. All rights reserved.
+///         Test double of the STM32CubeF0 HAL (stm32f0xx_hal.c, stm32f0xx_hal_rcc.c,
+///         stm32f0xx_hal_gpio.c and stm32f0xx_hal_pwr.c), for the host simulation only,
+///         the firmware is built with the original in Drivers/STM32F0xx_HAL_Driver.
+///         It follows the register accesses of the original, which is licensed under terms
+///         that can be found in the LICENSE file of that driver (BSD-3-Clause).
+///
+/// @brief  The HAL functions of the system, RCC, GPIO and PWR drivers, following the register
+///         accesses of the STM32F0 HAL, so they are charged like the target code.
+#include "model.hpp"
+
+uint32_t SystemCoreClock = HSI_VALUE;
+static volatile uint32_t uwTick;
+static uint32_t uwTickPrio = 1U << __NVIC_PRIO_BITS;
+
+// the HSI48 startup, the PLL lock and the clock switch timeouts of the HAL, in ms
+static constexpr uint32_t HSI48_TIMEOUT_VALUE = 2;
+static constexpr uint32_t PLL_TIMEOUT_VALUE = 2;
+static constexpr uint32_t CLOCKSWITCH_TIMEOUT_VALUE = 5000;
+
+extern "C" HAL_StatusTypeDef HAL_Init(void)
+{
+    HAL_InitTick(TICK_INT_PRIORITY);
+    HAL_MspInit();
+    return HAL_OK;
+}
+
+extern "C" HAL_StatusTypeDef HAL_InitTick(uint32_t TickPriority)
+{
+    sim::charge(8);
+    sim::systick_config(SystemCoreClock / 1000U);
+    if (TickPriority >= (1U << __NVIC_PRIO_BITS))
+    {
+        return HAL_ERROR;
+    }
+    HAL_NVIC_SetPriority(SysTick_IRQn, TickPriority, 0U);
+    uwTickPrio = TickPriority;
+    return HAL_OK;
+}
+
+extern "C" void HAL_IncTick(void)
+{
+    uwTick = uwTick + 1;
+}
+
+extern "C" uint32_t HAL_GetTick(void)
+{
+    return uwTick;
+}
+
+extern "C" void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority,
+                                     [[maybe_unused]] uint32_t SubPriority)
+{
+    NVIC_SetPriority(IRQn, PreemptPriority);
+}
+
+extern "C" void HAL_NVIC_EnableIRQ(IRQn_Type IRQn)
+{
+    NVIC_EnableIRQ(IRQn);
+}
+
+extern "C" void HAL_NVIC_DisableIRQ(IRQn_Type IRQn)
+{
+    NVIC_DisableIRQ(IRQn);
+}
+
+// RCC
+
+extern "C" uint32_t HAL_RCC_GetSysClockFreq(void)
+{
+    switch (RCC->CFGR & RCC_CFGR_SWS)
+    {
+    case RCC_CFGR_SWS_PLL:
+    {
+        uint32_t cfgr = RCC->CFGR;
+        uint32_t mul = ((cfgr & RCC_CFGR_PLLMUL) >> 18) + 2;
+        uint32_t prediv = (RCC->CFGR2 & 0xF) + 1;
+        if ((cfgr & RCC_CFGR_PLLSRC) == 0)
+        {
+            return HSI_VALUE / 2 * mul;
+        }
+        return HSI_VALUE / prediv * mul;
+    }
+    case RCC_CFGR_SWS_HSI48:
+        return HSI48_VALUE;
+    default:
+        return HSI_VALUE;
+    }
+}
+
+extern "C" uint32_t HAL_RCC_GetHCLKFreq(void)
+{
+    return SystemCoreClock;
+}
+
+extern "C" uint32_t HAL_RCC_GetPCLK1Freq(void)
+{
+    // the APB prescaler is always 1
+    return HAL_RCC_GetHCLKFreq();
+}
+
+extern "C" HAL_StatusTypeDef HAL_RCC_OscConfig(RCC_OscInitTypeDef* RCC_OscInitStruct)
+{
+    if ((RCC_OscInitStruct->OscillatorType & RCC_OSCILLATORTYPE_HSI48) and
+        (RCC_OscInitStruct->HSI48State == RCC_HSI48_ON))
+    {
+        RCC->CR2 |= RCC_CR2_HSI48ON;
+        uint32_t tickstart = HAL_GetTick();
+        while ((RCC->CR2 & RCC_CR2_HSI48RDY) == 0)
+        {
+            if ((HAL_GetTick() - tickstart) > HSI48_TIMEOUT_VALUE)
+            {
+                return HAL_TIMEOUT;
+            }
+        }
+    }
+    if (RCC_OscInitStruct->PLL.PLLState != RCC_PLL_ON)
+    {
+        return HAL_OK;
+    }
+    if ((RCC->CFGR & RCC_CFGR_SWS) == RCC_CFGR_SWS_PLL)
+    {
+        return HAL_ERROR;
+    }
+    RCC->CR &= ~RCC_CR_PLLON;
+    uint32_t tickstart = HAL_GetTick();
+    while ((RCC->CR & RCC_CR_PLLRDY) != 0)
+    {
+        if ((HAL_GetTick() - tickstart) > PLL_TIMEOUT_VALUE)
+        {
+            return HAL_TIMEOUT;
+        }
+    }
+    RCC->CFGR2 = RCC_OscInitStruct->PLL.PREDIV;
+    RCC->CFGR = (RCC->CFGR & ~(RCC_CFGR_PLLMUL | RCC_CFGR_PLLSRC)) |
+                RCC_OscInitStruct->PLL.PLLMUL | RCC_OscInitStruct->PLL.PLLSource;
+    RCC->CR |= RCC_CR_PLLON;
+    tickstart = HAL_GetTick();
+    while ((RCC->CR & RCC_CR_PLLRDY) == 0)
+    {
+        if ((HAL_GetTick() - tickstart) > PLL_TIMEOUT_VALUE)
+        {
+            return HAL_TIMEOUT;
+        }
+    }
+    return HAL_OK;
+}
+
+extern "C" HAL_StatusTypeDef HAL_RCC_ClockConfig(RCC_ClkInitTypeDef* RCC_ClkInitStruct,
+                                                 uint32_t FLatency)
+{
+    if (FLatency > (FLASH->ACR & FLASH_ACR_LATENCY))
+    {
+        FLASH->ACR = (FLASH->ACR & ~FLASH_ACR_LATENCY) | FLatency;
+        if ((FLASH->ACR & FLASH_ACR_LATENCY) != FLatency)
+        {
+            return HAL_ERROR;
+        }
+    }
+    if (RCC_ClkInitStruct->ClockType & RCC_CLOCKTYPE_SYSCLK)
+    {
+        uint32_t source = RCC_ClkInitStruct->SYSCLKSource;
+        RCC->CFGR = (RCC->CFGR & ~RCC_CFGR_SW) | source;
+        uint32_t tickstart = HAL_GetTick();
+        while ((RCC->CFGR & RCC_CFGR_SWS) != (source << 2))
+        {
+            if ((HAL_GetTick() - tickstart) > CLOCKSWITCH_TIMEOUT_VALUE)
+            {
+                return HAL_TIMEOUT;
+            }
+        }
+    }
+    if (FLatency < (FLASH->ACR & FLASH_ACR_LATENCY))
+    {
+        FLASH->ACR = (FLASH->ACR & ~FLASH_ACR_LATENCY) | FLatency;
+        if ((FLASH->ACR & FLASH_ACR_LATENCY) != FLatency)
+        {
+            return HAL_ERROR;
+        }
+    }
+    SystemCoreClock = HAL_RCC_GetSysClockFreq();
+    return HAL_InitTick(uwTickPrio);
+}
+
+extern "C" HAL_StatusTypeDef HAL_RCCEx_PeriphCLKConfig(RCC_PeriphCLKInitTypeDef* PeriphClkInit)
+{
+    if (PeriphClkInit->PeriphClockSelection & RCC_PERIPHCLK_I2C1)
+    {
+        // I2C1SW, HSI or SYSCLK
+        RCC->CFGR3 = (RCC->CFGR3 & ~(1U << 4)) | PeriphClkInit->I2c1ClockSelection;
+    }
+    return HAL_OK;
+}
+
+// PWR
+
+extern "C" void HAL_PWR_EnterSTOPMode([[maybe_unused]] uint32_t Regulator,
+                                      [[maybe_unused]] uint8_t STOPEntry)
+{
+    sim::enter_stop();
+}
+
+// GPIO
+
+static constexpr uint32_t GPIO_MODE = 0x3U;
+static constexpr uint32_t GPIO_OUTPUT_TYPE = 0x10U;
+static constexpr uint32_t EXTI_MODE = 0x10000000U;
+static constexpr uint32_t EXTI_IT = 0x10000U;
+static constexpr uint32_t EXTI_EVT = 0x20000U;
+static constexpr uint32_t TRIGGER_RISING = 0x100000U;
+static constexpr uint32_t TRIGGER_FALLING = 0x200000U;
+
+extern "C" void HAL_GPIO_Init(GPIO_TypeDef* GPIOx, GPIO_InitTypeDef* GPIO_Init)
+{
+    for (uint32_t position = 0; position < 16; position++)
+    {
+        uint32_t pin = 1U << position;
+        if ((GPIO_Init->Pin & pin) == 0)
+        {
+            continue;
+        }
+        uint32_t mode = GPIO_Init->Mode & GPIO_MODE;
+        if ((mode == GPIO_MODE_OUTPUT_PP) or (mode == GPIO_MODE_AF_PP))
+        {
+            GPIOx->OSPEEDR =
+                (GPIOx->OSPEEDR & ~(3U << (position * 2))) | (GPIO_Init->Speed << (position * 2));
+            GPIOx->OTYPER = (GPIOx->OTYPER & ~pin) |
+                            (((GPIO_Init->Mode & GPIO_OUTPUT_TYPE) >> 4) << position);
+        }
+        GPIOx->PUPDR =
+            (GPIOx->PUPDR & ~(3U << (position * 2))) | (GPIO_Init->Pull << (position * 2));
+        if (mode == GPIO_MODE_AF_PP)
+        {
+            auto& afr = GPIOx->AFR[position >> 3];
+            afr = (afr & ~(0xFU << ((position & 7) * 4))) |
+                  (GPIO_Init->Alternate << ((position & 7) * 4));
+        }
+        GPIOx->MODER = (GPIOx->MODER & ~(3U << (position * 2))) | (mode << (position * 2));
+
+        if (GPIO_Init->Mode & EXTI_MODE)
+        {
+            sim::exti_select(position, GPIOx);
+            EXTI->IMR = (GPIO_Init->Mode & EXTI_IT) ? (EXTI->IMR | pin) : (EXTI->IMR & ~pin);
+            EXTI->EMR = (GPIO_Init->Mode & EXTI_EVT) ? (EXTI->EMR | pin) : (EXTI->EMR & ~pin);
+            EXTI->RTSR =
+                (GPIO_Init->Mode & TRIGGER_RISING) ? (EXTI->RTSR | pin) : (EXTI->RTSR & ~pin);
+            EXTI->FTSR =
+                (GPIO_Init->Mode & TRIGGER_FALLING) ? (EXTI->FTSR | pin) : (EXTI->FTSR & ~pin);
+        }
+    }
+}
+
+extern "C" void HAL_GPIO_DeInit(GPIO_TypeDef* GPIOx, uint32_t GPIO_Pin)
+{
+    for (uint32_t position = 0; position < 16; position++)
+    {
+        uint32_t pin = 1U << position;
+        if ((GPIO_Pin & pin) == 0)
+        {
+            continue;
+        }
+        GPIOx->MODER = GPIOx->MODER | (3U << (position * 2));
+        GPIOx->PUPDR = GPIOx->PUPDR & ~(3U << (position * 2));
+        EXTI->IMR = EXTI->IMR & ~pin;
+        EXTI->EMR = EXTI->EMR & ~pin;
+    }
+}
+
+extern "C" void HAL_GPIO_WritePin(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState)
+{
+    if (PinState != GPIO_PIN_RESET)
+    {
+        GPIOx->BSRR = GPIO_Pin;
+    }
+    else
+    {
+        GPIOx->BRR = GPIO_Pin;
+    }
+}
+
+extern "C" GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin)
+{
+    return (GPIOx->IDR & GPIO_Pin) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+extern "C" void HAL_GPIO_EXTI_IRQHandler(uint16_t GPIO_Pin)
+{
+    if (EXTI->PR & GPIO_Pin)
+    {
+        EXTI->PR = GPIO_Pin;
+        HAL_GPIO_EXTI_Callback(GPIO_Pin);
+    }
+}
+
+extern "C" __weak void HAL_GPIO_EXTI_Callback([[maybe_unused]] uint16_t GPIO_Pin) {}
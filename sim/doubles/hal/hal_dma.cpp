@@ -0,0 +1,196 @@
+/// @file
+///
+/// @copyright
+///         Copyright (c) 2016 STMicroelectronics. All rights reserved.
+///         Test double of the STM32CubeF0 HAL (stm32f0xx_hal_dma.c), for the host simulation only,
+///         the firmware is built with the original in Drivers/STM32F0xx_HAL_Driver.
+///         It follows the register accesses of the original, which is licensed under terms
+///         that can be found in the LICENSE file of that driver (BSD-3-Clause).
+///
+/// @brief  The DMA driver of the STM32F0 HAL, with the register accesses of the original.
+#include "model.hpp"
+
+#define __HAL_LOCK(__HANDLE__)                                                                     \
+    do                                                                                             \
+    {                                                                                              \
+        if ((__HANDLE__)->Lock == HAL_LOCKED)                                                      \
+        {                                                                                          \
+            return HAL_BUSY;                                                                       \
+        }                                                                                          \
+        (__HANDLE__)->Lock = HAL_LOCKED;                                                           \
+    } while (0)
+#define __HAL_UNLOCK(__HANDLE__) ((__HANDLE__)->Lock = HAL_UNLOCKED)
+
+static void DMA_CalcBaseAndBitshift(DMA_HandleTypeDef* hdma)
+{
+    hdma->ChannelIndex = (hdma->Instance - DMA1_Channel1) * 4U;
+    hdma->DmaBaseAddress = DMA1;
+}
+
+static void DMA_SetConfig(DMA_HandleTypeDef* hdma, uintptr_t SrcAddress, uintptr_t DstAddress,
+                          uint32_t DataLength)
+{
+    hdma->DmaBaseAddress->IFCR = DMA_IFCR_CGIF1 << hdma->ChannelIndex;
+    hdma->Instance->CNDTR = DataLength;
+    if (hdma->Init.Direction == DMA_MEMORY_TO_PERIPH)
+    {
+        hdma->Instance->CPAR = DstAddress;
+        hdma->Instance->CMAR = SrcAddress;
+    }
+    else
+    {
+        hdma->Instance->CPAR = SrcAddress;
+        hdma->Instance->CMAR = DstAddress;
+    }
+}
+
+extern "C" HAL_StatusTypeDef HAL_DMA_Init(DMA_HandleTypeDef* hdma)
+{
+    if (hdma == nullptr)
+    {
+        return HAL_ERROR;
+    }
+    hdma->State = HAL_DMA_STATE_BUSY;
+    uint32_t tmp = hdma->Instance->CCR;
+    tmp &= ~(DMA_CCR_PL | DMA_CCR_MSIZE | DMA_CCR_PSIZE | DMA_CCR_MINC | DMA_CCR_PINC |
+             DMA_CCR_CIRC | DMA_CCR_DIR);
+    tmp |= hdma->Init.Direction | hdma->Init.PeriphInc | hdma->Init.MemInc |
+           hdma->Init.PeriphDataAlignment | hdma->Init.MemDataAlignment | hdma->Init.Mode |
+           hdma->Init.Priority;
+    hdma->Instance->CCR = tmp;
+    DMA_CalcBaseAndBitshift(hdma);
+    hdma->ErrorCode = HAL_DMA_ERROR_NONE;
+    hdma->State = HAL_DMA_STATE_READY;
+    hdma->Lock = HAL_UNLOCKED;
+    return HAL_OK;
+}
+
+extern "C" HAL_StatusTypeDef HAL_DMA_DeInit(DMA_HandleTypeDef* hdma)
+{
+    if (hdma == nullptr)
+    {
+        return HAL_ERROR;
+    }
+    hdma->Instance->CCR &= ~DMA_CCR_EN;
+    hdma->Instance->CCR = 0;
+    hdma->Instance->CNDTR = 0;
+    hdma->Instance->CPAR = 0;
+    hdma->Instance->CMAR = 0;
+    DMA_CalcBaseAndBitshift(hdma);
+    hdma->DmaBaseAddress->IFCR = DMA_IFCR_CGIF1 << hdma->ChannelIndex;
+    hdma->XferCpltCallback = nullptr;
+    hdma->XferHalfCpltCallback = nullptr;
+    hdma->XferErrorCallback = nullptr;
+    hdma->XferAbortCallback = nullptr;
+    hdma->ErrorCode = HAL_DMA_ERROR_NONE;
+    hdma->State = HAL_DMA_STATE_RESET;
+    __HAL_UNLOCK(hdma);
+    return HAL_OK;
+}
+
+extern "C" HAL_StatusTypeDef HAL_DMA_Start_IT(DMA_HandleTypeDef* hdma, uintptr_t SrcAddress,
+                                              uintptr_t DstAddress, uint32_t DataLength)
+{
+    __HAL_LOCK(hdma);
+    if (hdma->State != HAL_DMA_STATE_READY)
+    {
+        __HAL_UNLOCK(hdma);
+        return HAL_BUSY;
+    }
+    hdma->State = HAL_DMA_STATE_BUSY;
+    hdma->ErrorCode = HAL_DMA_ERROR_NONE;
+    hdma->Instance->CCR &= ~DMA_CCR_EN;
+    DMA_SetConfig(hdma, SrcAddress, DstAddress, DataLength);
+    if (hdma->XferHalfCpltCallback != nullptr)
+    {
+        hdma->Instance->CCR |= DMA_IT_TC | DMA_IT_HT | DMA_IT_TE;
+    }
+    else
+    {
+        hdma->Instance->CCR |= DMA_IT_TC | DMA_IT_TE;
+        hdma->Instance->CCR &= ~DMA_IT_HT;
+    }
+    hdma->Instance->CCR |= DMA_CCR_EN;
+    // the handle stays locked until the transfer completes or it's aborted
+    return HAL_OK;
+}
+
+extern "C" HAL_StatusTypeDef HAL_DMA_Abort(DMA_HandleTypeDef* hdma)
+{
+    if (hdma->State != HAL_DMA_STATE_BUSY)
+    {
+        hdma->ErrorCode = HAL_DMA_ERROR_NO_XFER;
+        __HAL_UNLOCK(hdma);
+        return HAL_ERROR;
+    }
+    hdma->Instance->CCR &= ~(DMA_IT_TC | DMA_IT_HT | DMA_IT_TE);
+    hdma->Instance->CCR &= ~DMA_CCR_EN;
+    hdma->DmaBaseAddress->IFCR = DMA_IFCR_CGIF1 << hdma->ChannelIndex;
+    hdma->State = HAL_DMA_STATE_READY;
+    __HAL_UNLOCK(hdma);
+    return HAL_OK;
+}
+
+extern "C" HAL_StatusTypeDef HAL_DMA_Abort_IT(DMA_HandleTypeDef* hdma)
+{
+    if (hdma->State != HAL_DMA_STATE_BUSY)
+    {
+        hdma->ErrorCode = HAL_DMA_ERROR_NO_XFER;
+        return HAL_ERROR;
+    }
+    hdma->Instance->CCR &= ~(DMA_IT_TC | DMA_IT_HT | DMA_IT_TE);
+    hdma->Instance->CCR &= ~DMA_CCR_EN;
+    hdma->DmaBaseAddress->IFCR = DMA_IFCR_CGIF1 << hdma->ChannelIndex;
+    hdma->State = HAL_DMA_STATE_READY;
+    __HAL_UNLOCK(hdma);
+    if (hdma->XferAbortCallback != nullptr)
+    {
+        hdma->XferAbortCallback(hdma);
+    }
+    return HAL_OK;
+}
+
+extern "C" void HAL_DMA_IRQHandler(DMA_HandleTypeDef* hdma)
+{
+    uint32_t flag_it = hdma->DmaBaseAddress->ISR;
+    uint32_t source_it = hdma->Instance->CCR;
+
+    if ((flag_it & (DMA_ISR_HTIF1 << hdma->ChannelIndex)) and (source_it & DMA_IT_HT))
+    {
+        if ((hdma->Instance->CCR & DMA_CCR_CIRC) == 0)
+        {
+            hdma->Instance->CCR &= ~DMA_IT_HT;
+        }
+        hdma->DmaBaseAddress->IFCR = DMA_ISR_HTIF1 << hdma->ChannelIndex;
+        if (hdma->XferHalfCpltCallback != nullptr)
+        {
+            hdma->XferHalfCpltCallback(hdma);
+        }
+    }
+    else if ((flag_it & (DMA_ISR_TCIF1 << hdma->ChannelIndex)) and (source_it & DMA_IT_TC))
+    {
+        if ((hdma->Instance->CCR & DMA_CCR_CIRC) == 0)
+        {
+            hdma->Instance->CCR &= ~(DMA_IT_TC | DMA_IT_TE);
+            hdma->State = HAL_DMA_STATE_READY;
+        }
+        hdma->DmaBaseAddress->IFCR = DMA_ISR_TCIF1 << hdma->ChannelIndex;
+        __HAL_UNLOCK(hdma);
+        if (hdma->XferCpltCallback != nullptr)
+        {
+            hdma->XferCpltCallback(hdma);
+        }
+    }
+    else if ((flag_it & (DMA_ISR_TEIF1 << hdma->ChannelIndex)) and (source_it & DMA_IT_TE))
+    {
+        hdma->Instance->CCR &= ~(DMA_IT_TC | DMA_IT_HT | DMA_IT_TE);
+        hdma->DmaBaseAddress->IFCR = DMA_IFCR_CGIF1 << hdma->ChannelIndex;
+        hdma->ErrorCode = HAL_DMA_ERROR_TE;
+        hdma->State = HAL_DMA_STATE_READY;
+        __HAL_UNLOCK(hdma);
+        if (hdma->XferErrorCallback != nullptr)
+        {
+            hdma->XferErrorCallback(hdma);
+        }
+    }
+}
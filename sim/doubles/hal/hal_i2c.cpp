@@ -0,0 +1,967 @@
+/// @file
+///
+/// @copyright
+///         Copyright (c) 2016 STMicroelectronics. All rights reserved.
+///         Test double of the STM32CubeF0 HAL (stm32f0xx_hal_i2c.c), for the host simulation only,
+///         the firmware is built with the original in Drivers/STM32F0xx_HAL_Driver.
+///         It follows the register accesses of the original, which is licensed under terms
+///         that can be found in the LICENSE file of that driver (BSD-3-Clause).
+///
+/// @brief  The slave side of the STM32F0 HAL I2C driver: the sequential DMA transfers in listen
+///         mode, with the state machine, register accesses and callback sequence of the original,
+///         so the callbacks per transfer and the interrupt cycles match the target.
+#include "model.hpp"
+
+#define __HAL_LOCK(__HANDLE__)                                                                     \
+    do                                                                                             \
+    {                                                                                              \
+        if ((__HANDLE__)->Lock == HAL_LOCKED)                                                      \
+        {                                                                                          \
+            return HAL_BUSY;                                                                       \
+        }                                                                                          \
+        (__HANDLE__)->Lock = HAL_LOCKED;                                                           \
+    } while (0)
+#define __HAL_UNLOCK(__HANDLE__) ((__HANDLE__)->Lock = HAL_UNLOCKED)
+
+static constexpr uint32_t TIMING_CLEAR_MASK = 0xF0FFFFFFU;
+
+static constexpr uint32_t I2C_STATE_MSK = 0x03U;
+static constexpr uint32_t I2C_STATE_NONE = HAL_I2C_MODE_NONE;
+static constexpr uint32_t I2C_STATE_MASTER_BUSY_TX =
+    (HAL_I2C_STATE_BUSY_TX & I2C_STATE_MSK) | HAL_I2C_MODE_MASTER;
+static constexpr uint32_t I2C_STATE_MASTER_BUSY_RX =
+    (HAL_I2C_STATE_BUSY_RX & I2C_STATE_MSK) | HAL_I2C_MODE_MASTER;
+static constexpr uint32_t I2C_STATE_SLAVE_BUSY_TX =
+    (HAL_I2C_STATE_BUSY_TX & I2C_STATE_MSK) | HAL_I2C_MODE_SLAVE;
+static constexpr uint32_t I2C_STATE_SLAVE_BUSY_RX =
+    (HAL_I2C_STATE_BUSY_RX & I2C_STATE_MSK) | HAL_I2C_MODE_SLAVE;
+
+static constexpr uint16_t I2C_XFER_TX_IT = 0x0001U;
+static constexpr uint16_t I2C_XFER_RX_IT = 0x0002U;
+static constexpr uint16_t I2C_XFER_LISTEN_IT = 0x8000U;
+static constexpr uint16_t I2C_XFER_ERROR_IT = 0x0010U;
+static constexpr uint16_t I2C_XFER_CPLT_IT = 0x0020U;
+static constexpr uint16_t I2C_XFER_RELOAD_IT = 0x0040U;
+
+static HAL_StatusTypeDef I2C_Slave_ISR_IT(I2C_HandleTypeDef* hi2c, uint32_t ITFlags,
+                                          uint32_t ITSources);
+static HAL_StatusTypeDef I2C_Slave_ISR_DMA(I2C_HandleTypeDef* hi2c, uint32_t ITFlags,
+                                           uint32_t ITSources);
+static void I2C_ITError(I2C_HandleTypeDef* hi2c, uint32_t ErrorCode);
+
+static uint32_t I2C_GET_DIR(I2C_HandleTypeDef* hi2c)
+{
+    return (hi2c->Instance->ISR & I2C_ISR_DIR) >> 16;
+}
+
+static void I2C_CLEAR_FLAG(I2C_HandleTypeDef* hi2c, uint32_t flag)
+{
+    if (flag == I2C_FLAG_TXE)
+    {
+        hi2c->Instance->ISR |= flag;
+    }
+    else
+    {
+        hi2c->Instance->ICR = flag;
+    }
+}
+
+static void I2C_Flush_TXDR(I2C_HandleTypeDef* hi2c)
+{
+    if (hi2c->Instance->ISR & I2C_FLAG_TXIS)
+    {
+        hi2c->Instance->TXDR = 0x00U;
+    }
+    if ((hi2c->Instance->ISR & I2C_FLAG_TXE) == 0)
+    {
+        I2C_CLEAR_FLAG(hi2c, I2C_FLAG_TXE);
+    }
+}
+
+static void I2C_Enable_IRQ(I2C_HandleTypeDef* hi2c, uint16_t InterruptRequest)
+{
+    uint32_t tmpisr = 0U;
+
+    if (hi2c->XferISR == I2C_Slave_ISR_DMA)
+    {
+        if ((InterruptRequest & I2C_XFER_LISTEN_IT) == I2C_XFER_LISTEN_IT)
+        {
+            tmpisr |= I2C_IT_ADDRI | I2C_IT_STOPI | I2C_IT_NACKI | I2C_IT_ERRI;
+        }
+        if (InterruptRequest == I2C_XFER_ERROR_IT)
+        {
+            tmpisr |= I2C_IT_ERRI | I2C_IT_NACKI;
+        }
+        if (InterruptRequest == I2C_XFER_CPLT_IT)
+        {
+            tmpisr |= I2C_IT_STOPI;
+        }
+        if (InterruptRequest == I2C_XFER_RELOAD_IT)
+        {
+            tmpisr |= I2C_IT_TCI;
+        }
+    }
+    else
+    {
+        if ((InterruptRequest & I2C_XFER_LISTEN_IT) == I2C_XFER_LISTEN_IT)
+        {
+            tmpisr |= I2C_IT_ADDRI | I2C_IT_STOPI | I2C_IT_NACKI | I2C_IT_ERRI;
+        }
+        if ((InterruptRequest & I2C_XFER_TX_IT) == I2C_XFER_TX_IT)
+        {
+            tmpisr |= I2C_IT_ERRI | I2C_IT_TCI | I2C_IT_STOPI | I2C_IT_NACKI | I2C_IT_TXI;
+        }
+        if ((InterruptRequest & I2C_XFER_RX_IT) == I2C_XFER_RX_IT)
+        {
+            tmpisr |= I2C_IT_ERRI | I2C_IT_TCI | I2C_IT_STOPI | I2C_IT_NACKI | I2C_IT_RXI;
+        }
+        if (InterruptRequest == I2C_XFER_ERROR_IT)
+        {
+            tmpisr |= I2C_IT_ERRI | I2C_IT_NACKI;
+        }
+        if (InterruptRequest == I2C_XFER_CPLT_IT)
+        {
+            tmpisr |= I2C_IT_STOPI;
+        }
+    }
+    hi2c->Instance->CR1 |= tmpisr;
+}
+
+static void I2C_Disable_IRQ(I2C_HandleTypeDef* hi2c, uint16_t InterruptRequest)
+{
+    uint32_t tmpisr = 0U;
+
+    if ((InterruptRequest & I2C_XFER_TX_IT) == I2C_XFER_TX_IT)
+    {
+        tmpisr |= I2C_IT_TXI | I2C_IT_TCI;
+        if ((hi2c->State & HAL_I2C_STATE_LISTEN) != HAL_I2C_STATE_LISTEN)
+        {
+            tmpisr |= I2C_IT_STOPI | I2C_IT_NACKI | I2C_IT_ERRI;
+        }
+    }
+    if ((InterruptRequest & I2C_XFER_RX_IT) == I2C_XFER_RX_IT)
+    {
+        tmpisr |= I2C_IT_RXI | I2C_IT_TCI;
+        if ((hi2c->State & HAL_I2C_STATE_LISTEN) != HAL_I2C_STATE_LISTEN)
+        {
+            tmpisr |= I2C_IT_STOPI | I2C_IT_NACKI | I2C_IT_ERRI;
+        }
+    }
+    if ((InterruptRequest & I2C_XFER_LISTEN_IT) == I2C_XFER_LISTEN_IT)
+    {
+        tmpisr |= I2C_IT_ADDRI | I2C_IT_STOPI | I2C_IT_NACKI | I2C_IT_ERRI;
+    }
+    if (InterruptRequest == I2C_XFER_ERROR_IT)
+    {
+        tmpisr |= I2C_IT_ERRI | I2C_IT_NACKI;
+    }
+    if (InterruptRequest == I2C_XFER_CPLT_IT)
+    {
+        tmpisr |= I2C_IT_STOPI;
+    }
+    if (InterruptRequest == I2C_XFER_RELOAD_IT)
+    {
+        tmpisr |= I2C_IT_TCI;
+    }
+    hi2c->Instance->CR1 &= ~tmpisr;
+}
+
+static void I2C_TreatErrorCallback(I2C_HandleTypeDef* hi2c)
+{
+    if (hi2c->State == HAL_I2C_STATE_ABORT)
+    {
+        hi2c->State = HAL_I2C_STATE_READY;
+        hi2c->PreviousState = I2C_STATE_NONE;
+        __HAL_UNLOCK(hi2c);
+        HAL_I2C_AbortCpltCallback(hi2c);
+    }
+    else
+    {
+        hi2c->PreviousState = I2C_STATE_NONE;
+        __HAL_UNLOCK(hi2c);
+        HAL_I2C_ErrorCallback(hi2c);
+    }
+}
+
+static void I2C_DMAAbort(DMA_HandleTypeDef* hdma)
+{
+    auto* hi2c = static_cast<I2C_HandleTypeDef*>(hdma->Parent);
+    if (hi2c->hdmatx != nullptr)
+    {
+        hi2c->hdmatx->XferAbortCallback = nullptr;
+    }
+    if (hi2c->hdmarx != nullptr)
+    {
+        hi2c->hdmarx->XferAbortCallback = nullptr;
+    }
+    I2C_TreatErrorCallback(hi2c);
+}
+
+static void I2C_DMAError(DMA_HandleTypeDef* hdma)
+{
+    auto* hi2c = static_cast<I2C_HandleTypeDef*>(hdma->Parent);
+    hi2c->Instance->CR2 |= I2C_CR2_NACK;
+    I2C_ITError(hi2c, HAL_I2C_ERROR_DMA);
+}
+
+static void I2C_ITAddrCplt(I2C_HandleTypeDef* hi2c, [[maybe_unused]] uint32_t ITFlags)
+{
+    if ((hi2c->State & HAL_I2C_STATE_LISTEN) == HAL_I2C_STATE_LISTEN)
+    {
+        uint8_t transferdirection = I2C_GET_DIR(hi2c);
+        uint16_t slaveaddrcode = (hi2c->Instance->ISR & I2C_ISR_ADDCODE) >> 16;
+        [[maybe_unused]] uint16_t ownadd1code = hi2c->Instance->OAR1 & I2C_OAR1_OA1;
+        [[maybe_unused]] uint16_t ownadd2code = hi2c->Instance->OAR2 & 0xFEU;
+
+        // only the 7-bit addressing mode is used
+        I2C_Disable_IRQ(hi2c, I2C_XFER_LISTEN_IT);
+        __HAL_UNLOCK(hi2c);
+        HAL_I2C_AddrCallback(hi2c, transferdirection, slaveaddrcode);
+    }
+    else
+    {
+        I2C_CLEAR_FLAG(hi2c, I2C_FLAG_ADDR);
+        __HAL_UNLOCK(hi2c);
+    }
+}
+
+static void I2C_ITSlaveSeqCplt(I2C_HandleTypeDef* hi2c)
+{
+    uint32_t tmpcr1value = hi2c->Instance->CR1;
+
+    hi2c->Mode = HAL_I2C_MODE_NONE;
+
+    if (tmpcr1value & I2C_CR1_TXDMAEN)
+    {
+        hi2c->Instance->CR1 &= ~I2C_CR1_TXDMAEN;
+    }
+    else if (tmpcr1value & I2C_CR1_RXDMAEN)
+    {
+        hi2c->Instance->CR1 &= ~I2C_CR1_RXDMAEN;
+    }
+
+    if (hi2c->State == HAL_I2C_STATE_BUSY_TX_LISTEN)
+    {
+        hi2c->State = HAL_I2C_STATE_LISTEN;
+        hi2c->PreviousState = I2C_STATE_SLAVE_BUSY_TX;
+        I2C_Disable_IRQ(hi2c, I2C_XFER_TX_IT);
+        __HAL_UNLOCK(hi2c);
+        HAL_I2C_SlaveTxCpltCallback(hi2c);
+    }
+    else if (hi2c->State == HAL_I2C_STATE_BUSY_RX_LISTEN)
+    {
+        hi2c->State = HAL_I2C_STATE_LISTEN;
+        hi2c->PreviousState = I2C_STATE_SLAVE_BUSY_RX;
+        I2C_Disable_IRQ(hi2c, I2C_XFER_RX_IT);
+        __HAL_UNLOCK(hi2c);
+        HAL_I2C_SlaveRxCpltCallback(hi2c);
+    }
+}
+
+static void I2C_ITListenCplt(I2C_HandleTypeDef* hi2c, uint32_t ITFlags)
+{
+    hi2c->XferOptions = I2C_NO_OPTION_FRAME;
+    hi2c->PreviousState = I2C_STATE_NONE;
+    hi2c->State = HAL_I2C_STATE_READY;
+    hi2c->Mode = HAL_I2C_MODE_NONE;
+    hi2c->XferISR = nullptr;
+
+    if (ITFlags & I2C_FLAG_RXNE)
+    {
+        *hi2c->pBuffPtr = static_cast<uint8_t>(hi2c->Instance->RXDR);
+        hi2c->pBuffPtr++;
+        if (hi2c->XferSize > 0U)
+        {
+            hi2c->XferSize--;
+            hi2c->XferCount--;
+            hi2c->ErrorCode |= HAL_I2C_ERROR_AF;
+        }
+    }
+
+    I2C_Disable_IRQ(hi2c, I2C_XFER_LISTEN_IT | I2C_XFER_RX_IT | I2C_XFER_TX_IT);
+    I2C_CLEAR_FLAG(hi2c, I2C_FLAG_AF);
+    __HAL_UNLOCK(hi2c);
+    HAL_I2C_ListenCpltCallback(hi2c);
+}
+
+static void I2C_ITSlaveCplt(I2C_HandleTypeDef* hi2c, uint32_t ITFlags)
+{
+    uint32_t tmpcr1val = hi2c->Instance->CR1;
+    uint32_t tmpITFlags = ITFlags;
+    HAL_I2C_StateTypeDef tmpstate = hi2c->State;
+
+    I2C_CLEAR_FLAG(hi2c, I2C_FLAG_STOPF);
+
+    if ((tmpstate == HAL_I2C_STATE_BUSY_TX) or (tmpstate == HAL_I2C_STATE_BUSY_TX_LISTEN))
+    {
+        I2C_Disable_IRQ(hi2c, I2C_XFER_LISTEN_IT | I2C_XFER_TX_IT);
+        hi2c->PreviousState = I2C_STATE_SLAVE_BUSY_TX;
+    }
+    else if ((tmpstate == HAL_I2C_STATE_BUSY_RX) or (tmpstate == HAL_I2C_STATE_BUSY_RX_LISTEN))
+    {
+        I2C_Disable_IRQ(hi2c, I2C_XFER_LISTEN_IT | I2C_XFER_RX_IT);
+        hi2c->PreviousState = I2C_STATE_SLAVE_BUSY_RX;
+    }
+    else if (tmpstate == HAL_I2C_STATE_LISTEN)
+    {
+        I2C_Disable_IRQ(hi2c, I2C_XFER_LISTEN_IT | I2C_XFER_TX_IT | I2C_XFER_RX_IT);
+        hi2c->PreviousState = I2C_STATE_NONE;
+    }
+
+    // disable the address acknowledge, and reset CR2
+    hi2c->Instance->CR2 |= I2C_CR2_NACK;
+    hi2c->Instance->CR2 &=
+        ~(I2C_CR2_SADD | I2C_CR2_HEAD10R | I2C_CR2_NBYTES | I2C_CR2_RELOAD | I2C_CR2_RD_WRN);
+
+    I2C_Flush_TXDR(hi2c);
+
+    if (tmpcr1val & I2C_CR1_TXDMAEN)
+    {
+        hi2c->Instance->CR1 &= ~I2C_CR1_TXDMAEN;
+        if (hi2c->hdmatx != nullptr)
+        {
+            hi2c->XferCount = __HAL_DMA_GET_COUNTER(hi2c->hdmatx);
+        }
+    }
+    else if (tmpcr1val & I2C_CR1_RXDMAEN)
+    {
+        hi2c->Instance->CR1 &= ~I2C_CR1_RXDMAEN;
+        if (hi2c->hdmarx != nullptr)
+        {
+            hi2c->XferCount = __HAL_DMA_GET_COUNTER(hi2c->hdmarx);
+        }
+    }
+
+    if (tmpITFlags & I2C_FLAG_RXNE)
+    {
+        tmpITFlags &= ~I2C_FLAG_RXNE;
+        *hi2c->pBuffPtr = static_cast<uint8_t>(hi2c->Instance->RXDR);
+        hi2c->pBuffPtr++;
+        if (hi2c->XferSize > 0U)
+        {
+            hi2c->XferSize--;
+            hi2c->XferCount--;
+        }
+    }
+
+    if (hi2c->XferCount != 0U)
+    {
+        hi2c->ErrorCode |= HAL_I2C_ERROR_AF;
+    }
+
+    hi2c->Mode = HAL_I2C_MODE_NONE;
+    hi2c->XferISR = nullptr;
+
+    if (hi2c->ErrorCode != HAL_I2C_ERROR_NONE)
+    {
+        I2C_ITError(hi2c, hi2c->ErrorCode);
+        if (hi2c->State == HAL_I2C_STATE_LISTEN)
+        {
+            I2C_ITListenCplt(hi2c, tmpITFlags);
+        }
+    }
+    else if (hi2c->XferOptions != I2C_NO_OPTION_FRAME)
+    {
+        I2C_ITSlaveSeqCplt(hi2c);
+        hi2c->XferOptions = I2C_NO_OPTION_FRAME;
+        hi2c->State = HAL_I2C_STATE_READY;
+        hi2c->PreviousState = I2C_STATE_NONE;
+        __HAL_UNLOCK(hi2c);
+        HAL_I2C_ListenCpltCallback(hi2c);
+    }
+    else if (hi2c->State == HAL_I2C_STATE_BUSY_RX)
+    {
+        hi2c->State = HAL_I2C_STATE_READY;
+        hi2c->PreviousState = I2C_STATE_NONE;
+        __HAL_UNLOCK(hi2c);
+        HAL_I2C_SlaveRxCpltCallback(hi2c);
+    }
+    else
+    {
+        hi2c->State = HAL_I2C_STATE_READY;
+        hi2c->PreviousState = I2C_STATE_NONE;
+        __HAL_UNLOCK(hi2c);
+        HAL_I2C_SlaveTxCpltCallback(hi2c);
+    }
+}
+
+static void I2C_ITError(I2C_HandleTypeDef* hi2c, uint32_t ErrorCode)
+{
+    HAL_I2C_StateTypeDef tmpstate = hi2c->State;
+
+    hi2c->Mode = HAL_I2C_MODE_NONE;
+    hi2c->XferOptions = I2C_NO_OPTION_FRAME;
+    hi2c->XferCount = 0U;
+    hi2c->ErrorCode |= ErrorCode;
+
+    if ((tmpstate == HAL_I2C_STATE_LISTEN) or (tmpstate == HAL_I2C_STATE_BUSY_TX_LISTEN) or
+        (tmpstate == HAL_I2C_STATE_BUSY_RX_LISTEN))
+    {
+        // keep listening
+        I2C_Disable_IRQ(hi2c, I2C_XFER_RX_IT | I2C_XFER_TX_IT);
+        hi2c->State = HAL_I2C_STATE_LISTEN;
+        hi2c->XferISR = I2C_Slave_ISR_IT;
+    }
+    else
+    {
+        I2C_Disable_IRQ(hi2c, I2C_XFER_LISTEN_IT | I2C_XFER_RX_IT | I2C_XFER_TX_IT);
+        I2C_Flush_TXDR(hi2c);
+        if (hi2c->State != HAL_I2C_STATE_ABORT)
+        {
+            hi2c->State = HAL_I2C_STATE_READY;
+            if (hi2c->Instance->ISR & I2C_FLAG_STOPF)
+            {
+                if (hi2c->Instance->ISR & I2C_FLAG_AF)
+                {
+                    I2C_CLEAR_FLAG(hi2c, I2C_FLAG_AF);
+                    hi2c->ErrorCode |= HAL_I2C_ERROR_AF;
+                }
+                I2C_CLEAR_FLAG(hi2c, I2C_FLAG_STOPF);
+            }
+        }
+        hi2c->XferISR = nullptr;
+    }
+
+    uint32_t tmppreviousstate = hi2c->PreviousState;
+    if ((hi2c->hdmatx != nullptr) and ((tmppreviousstate == I2C_STATE_MASTER_BUSY_TX) or
+                                       (tmppreviousstate == I2C_STATE_SLAVE_BUSY_TX)))
+    {
+        if (hi2c->Instance->CR1 & I2C_CR1_TXDMAEN)
+        {
+            hi2c->Instance->CR1 &= ~I2C_CR1_TXDMAEN;
+        }
+        if (hi2c->hdmatx->State != HAL_DMA_STATE_READY)
+        {
+            hi2c->hdmatx->XferAbortCallback = I2C_DMAAbort;
+            __HAL_UNLOCK(hi2c);
+            if (HAL_DMA_Abort_IT(hi2c->hdmatx) != HAL_OK)
+            {
+                hi2c->hdmatx->XferAbortCallback(hi2c->hdmatx);
+            }
+        }
+        else
+        {
+            I2C_TreatErrorCallback(hi2c);
+        }
+    }
+    else if ((hi2c->hdmarx != nullptr) and ((tmppreviousstate == I2C_STATE_MASTER_BUSY_RX) or
+                                            (tmppreviousstate == I2C_STATE_SLAVE_BUSY_RX)))
+    {
+        if (hi2c->Instance->CR1 & I2C_CR1_RXDMAEN)
+        {
+            hi2c->Instance->CR1 &= ~I2C_CR1_RXDMAEN;
+        }
+        if (hi2c->hdmarx->State != HAL_DMA_STATE_READY)
+        {
+            hi2c->hdmarx->XferAbortCallback = I2C_DMAAbort;
+            __HAL_UNLOCK(hi2c);
+            if (HAL_DMA_Abort_IT(hi2c->hdmarx) != HAL_OK)
+            {
+                hi2c->hdmarx->XferAbortCallback(hi2c->hdmarx);
+            }
+        }
+        else
+        {
+            I2C_TreatErrorCallback(hi2c);
+        }
+    }
+    else
+    {
+        I2C_TreatErrorCallback(hi2c);
+    }
+}
+
+static void I2C_DMASlaveTransmitCplt(DMA_HandleTypeDef* hdma)
+{
+    auto* hi2c = static_cast<I2C_HandleTypeDef*>(hdma->Parent);
+    uint32_t tmpoptions = hi2c->XferOptions;
+
+    if ((tmpoptions == I2C_NEXT_FRAME) or (tmpoptions == I2C_FIRST_FRAME))
+    {
+        hi2c->Instance->CR1 &= ~I2C_CR1_TXDMAEN;
+        I2C_ITSlaveSeqCplt(hi2c);
+    }
+    // otherwise the STOP condition of the master completes the transfer
+}
+
+static void I2C_DMASlaveReceiveCplt(DMA_HandleTypeDef* hdma)
+{
+    auto* hi2c = static_cast<I2C_HandleTypeDef*>(hdma->Parent);
+    uint32_t tmpoptions = hi2c->XferOptions;
+
+    if ((__HAL_DMA_GET_COUNTER(hi2c->hdmarx) == 0U) and (tmpoptions != I2C_NO_OPTION_FRAME))
+    {
+        hi2c->Instance->CR1 &= ~I2C_CR1_RXDMAEN;
+        I2C_ITSlaveSeqCplt(hi2c);
+    }
+}
+
+static void I2C_Slave_ISR_NACK(I2C_HandleTypeDef* hi2c, uint32_t ITFlags, uint32_t tmpoptions,
+                               bool transfer_finished)
+{
+    if (transfer_finished)
+    {
+        if ((hi2c->State == HAL_I2C_STATE_LISTEN) and (tmpoptions == I2C_FIRST_AND_LAST_FRAME))
+        {
+            I2C_ITListenCplt(hi2c, ITFlags);
+        }
+        else if ((hi2c->State == HAL_I2C_STATE_BUSY_TX_LISTEN) and
+                 (tmpoptions != I2C_NO_OPTION_FRAME))
+        {
+            I2C_CLEAR_FLAG(hi2c, I2C_FLAG_AF);
+            I2C_Flush_TXDR(hi2c);
+            I2C_ITSlaveSeqCplt(hi2c);
+        }
+        else
+        {
+            I2C_CLEAR_FLAG(hi2c, I2C_FLAG_AF);
+        }
+        return;
+    }
+
+    // the master didn't acknowledge the data before the end of the transfer
+    I2C_CLEAR_FLAG(hi2c, I2C_FLAG_AF);
+    hi2c->ErrorCode |= HAL_I2C_ERROR_AF;
+    if ((tmpoptions == I2C_NEXT_FRAME) or (tmpoptions == I2C_FIRST_FRAME))
+    {
+        HAL_I2C_StateTypeDef tmpstate = hi2c->State;
+        if ((tmpstate == HAL_I2C_STATE_BUSY_TX) or (tmpstate == HAL_I2C_STATE_BUSY_TX_LISTEN))
+        {
+            hi2c->PreviousState = I2C_STATE_SLAVE_BUSY_TX;
+        }
+        else if ((tmpstate == HAL_I2C_STATE_BUSY_RX) or
+                 (tmpstate == HAL_I2C_STATE_BUSY_RX_LISTEN))
+        {
+            hi2c->PreviousState = I2C_STATE_SLAVE_BUSY_RX;
+        }
+        I2C_ITError(hi2c, hi2c->ErrorCode);
+    }
+}
+
+static HAL_StatusTypeDef I2C_Slave_ISR_DMA(I2C_HandleTypeDef* hi2c, uint32_t ITFlags,
+                                           uint32_t ITSources)
+{
+    uint32_t tmpoptions = hi2c->XferOptions;
+
+    __HAL_LOCK(hi2c);
+
+    if ((ITFlags & I2C_FLAG_STOPF) and (ITSources & I2C_IT_STOPI))
+    {
+        I2C_ITSlaveCplt(hi2c, ITFlags);
+    }
+
+    if ((ITFlags & I2C_FLAG_AF) and (ITSources & I2C_IT_NACKI))
+    {
+        if (ITSources & (I2C_CR1_TXDMAEN | I2C_CR1_RXDMAEN))
+        {
+            bool treatdmanack = false;
+            if ((hi2c->hdmarx != nullptr) and (ITSources & I2C_CR1_RXDMAEN) and
+                (__HAL_DMA_GET_COUNTER(hi2c->hdmarx) == 0U))
+            {
+                treatdmanack = true;
+            }
+            if ((hi2c->hdmatx != nullptr) and (ITSources & I2C_CR1_TXDMAEN) and
+                (__HAL_DMA_GET_COUNTER(hi2c->hdmatx) == 0U))
+            {
+                treatdmanack = true;
+            }
+            I2C_Slave_ISR_NACK(hi2c, ITFlags, tmpoptions, treatdmanack);
+        }
+        else
+        {
+            // no DMA treatment is pending
+            I2C_CLEAR_FLAG(hi2c, I2C_FLAG_AF);
+        }
+    }
+    else if ((ITFlags & I2C_FLAG_ADDR) and (ITSources & I2C_IT_ADDRI))
+    {
+        I2C_ITAddrCplt(hi2c, ITFlags);
+    }
+
+    __HAL_UNLOCK(hi2c);
+    return HAL_OK;
+}
+
+static HAL_StatusTypeDef I2C_Slave_ISR_IT(I2C_HandleTypeDef* hi2c, uint32_t ITFlags,
+                                          uint32_t ITSources)
+{
+    uint32_t tmpoptions = hi2c->XferOptions;
+
+    __HAL_LOCK(hi2c);
+
+    if ((ITFlags & I2C_FLAG_STOPF) and (ITSources & I2C_IT_STOPI))
+    {
+        I2C_ITSlaveCplt(hi2c, ITFlags);
+    }
+
+    if ((ITFlags & I2C_FLAG_AF) and (ITSources & I2C_IT_NACKI))
+    {
+        I2C_Slave_ISR_NACK(hi2c, ITFlags, tmpoptions, hi2c->XferCount == 0U);
+    }
+    else if ((ITFlags & I2C_FLAG_RXNE) and (ITSources & I2C_IT_RXI))
+    {
+        if (hi2c->XferCount > 0U)
+        {
+            *hi2c->pBuffPtr = static_cast<uint8_t>(hi2c->Instance->RXDR);
+            hi2c->pBuffPtr++;
+            hi2c->XferSize--;
+            hi2c->XferCount--;
+        }
+        if ((hi2c->XferCount == 0U) and (tmpoptions != I2C_NO_OPTION_FRAME))
+        {
+            I2C_ITSlaveSeqCplt(hi2c);
+        }
+    }
+    else if ((ITFlags & I2C_FLAG_ADDR) and (ITSources & I2C_IT_ADDRI))
+    {
+        I2C_ITAddrCplt(hi2c, ITFlags);
+    }
+    else if ((ITFlags & I2C_FLAG_TXIS) and (ITSources & I2C_IT_TXI))
+    {
+        if (hi2c->XferCount > 0U)
+        {
+            hi2c->Instance->TXDR = *hi2c->pBuffPtr;
+            hi2c->pBuffPtr++;
+            hi2c->XferCount--;
+            hi2c->XferSize--;
+        }
+        else if ((tmpoptions == I2C_NEXT_FRAME) or (tmpoptions == I2C_FIRST_FRAME))
+        {
+            I2C_ITSlaveSeqCplt(hi2c);
+        }
+    }
+
+    __HAL_UNLOCK(hi2c);
+    return HAL_OK;
+}
+
+extern "C" HAL_StatusTypeDef HAL_I2C_Init(I2C_HandleTypeDef* hi2c)
+{
+    if (hi2c == nullptr)
+    {
+        return HAL_ERROR;
+    }
+    if (hi2c->State == HAL_I2C_STATE_RESET)
+    {
+        hi2c->Lock = HAL_UNLOCKED;
+        HAL_I2C_MspInit(hi2c);
+    }
+    hi2c->State = HAL_I2C_STATE_BUSY;
+
+    hi2c->Instance->CR1 &= ~I2C_CR1_PE;
+    hi2c->Instance->TIMINGR = hi2c->Init.Timing & TIMING_CLEAR_MASK;
+    hi2c->Instance->OAR1 &= ~I2C_OAR1_OA1EN;
+    if (hi2c->Init.AddressingMode == I2C_ADDRESSINGMODE_7BIT)
+    {
+        hi2c->Instance->OAR1 = I2C_OAR1_OA1EN | hi2c->Init.OwnAddress1;
+    }
+    else
+    {
+        hi2c->Instance->OAR1 = I2C_OAR1_OA1EN | I2C_OAR1_OA1MODE | hi2c->Init.OwnAddress1;
+    }
+    if (hi2c->Init.AddressingMode == I2C_ADDRESSINGMODE_10BIT)
+    {
+        hi2c->Instance->CR2 = I2C_CR2_ADD10;
+    }
+    else
+    {
+        hi2c->Instance->CR2 &= ~I2C_CR2_ADD10;
+    }
+    hi2c->Instance->CR2 |= I2C_CR2_AUTOEND | I2C_CR2_NACK;
+    hi2c->Instance->OAR2 &= ~I2C_DUALADDRESS_ENABLE;
+    hi2c->Instance->OAR2 = hi2c->Init.DualAddressMode | hi2c->Init.OwnAddress2 |
+                           (hi2c->Init.OwnAddress2Masks << 8);
+    hi2c->Instance->CR1 = hi2c->Init.GeneralCallMode | hi2c->Init.NoStretchMode;
+    hi2c->Instance->CR1 |= I2C_CR1_PE;
+
+    hi2c->ErrorCode = HAL_I2C_ERROR_NONE;
+    hi2c->State = HAL_I2C_STATE_READY;
+    hi2c->PreviousState = I2C_STATE_NONE;
+    hi2c->Mode = HAL_I2C_MODE_NONE;
+    return HAL_OK;
+}
+
+extern "C" HAL_StatusTypeDef HAL_I2CEx_ConfigAnalogFilter(I2C_HandleTypeDef* hi2c,
+                                                          uint32_t AnalogFilter)
+{
+    if (hi2c->State != HAL_I2C_STATE_READY)
+    {
+        return HAL_BUSY;
+    }
+    __HAL_LOCK(hi2c);
+    hi2c->State = HAL_I2C_STATE_BUSY;
+    hi2c->Instance->CR1 &= ~I2C_CR1_PE;
+    hi2c->Instance->CR1 &= ~I2C_CR1_ANFOFF;
+    hi2c->Instance->CR1 |= AnalogFilter;
+    hi2c->Instance->CR1 |= I2C_CR1_PE;
+    hi2c->State = HAL_I2C_STATE_READY;
+    __HAL_UNLOCK(hi2c);
+    return HAL_OK;
+}
+
+extern "C" HAL_StatusTypeDef HAL_I2CEx_ConfigDigitalFilter(I2C_HandleTypeDef* hi2c,
+                                                           uint32_t DigitalFilter)
+{
+    if (hi2c->State != HAL_I2C_STATE_READY)
+    {
+        return HAL_BUSY;
+    }
+    __HAL_LOCK(hi2c);
+    hi2c->State = HAL_I2C_STATE_BUSY;
+    hi2c->Instance->CR1 &= ~I2C_CR1_PE;
+    uint32_t tmpreg = hi2c->Instance->CR1;
+    tmpreg &= ~I2C_CR1_DNF;
+    tmpreg |= DigitalFilter << 8U;
+    hi2c->Instance->CR1 = tmpreg;
+    hi2c->Instance->CR1 |= I2C_CR1_PE;
+    hi2c->State = HAL_I2C_STATE_READY;
+    __HAL_UNLOCK(hi2c);
+    return HAL_OK;
+}
+
+extern "C" void HAL_I2CEx_EnableFastModePlus(uint32_t ConfigFastModePlus)
+{
+    SYSCFG->CFGR1 |= ConfigFastModePlus;
+}
+
+extern "C" void HAL_I2CEx_DisableFastModePlus(uint32_t ConfigFastModePlus)
+{
+    SYSCFG->CFGR1 &= ~ConfigFastModePlus;
+}
+
+extern "C" HAL_StatusTypeDef HAL_I2C_EnableListen_IT(I2C_HandleTypeDef* hi2c)
+{
+    if (hi2c->State != HAL_I2C_STATE_READY)
+    {
+        return HAL_BUSY;
+    }
+    hi2c->State = HAL_I2C_STATE_LISTEN;
+    hi2c->XferISR = I2C_Slave_ISR_IT;
+    I2C_Enable_IRQ(hi2c, I2C_XFER_LISTEN_IT);
+    return HAL_OK;
+}
+
+extern "C" HAL_StatusTypeDef HAL_I2C_DisableListen_IT(I2C_HandleTypeDef* hi2c)
+{
+    if (hi2c->State != HAL_I2C_STATE_LISTEN)
+    {
+        return HAL_BUSY;
+    }
+    uint32_t tmp = hi2c->State & I2C_STATE_MSK;
+    hi2c->PreviousState = tmp | hi2c->Mode;
+    hi2c->State = HAL_I2C_STATE_READY;
+    hi2c->Mode = HAL_I2C_MODE_NONE;
+    hi2c->XferISR = nullptr;
+    I2C_Disable_IRQ(hi2c, I2C_XFER_LISTEN_IT);
+    return HAL_OK;
+}
+
+/// @brief Stops the DMA transfer of the other direction, when the master turns the bus around.
+static void I2C_AbortDMA(I2C_HandleTypeDef* hi2c, DMA_HandleTypeDef* hdma, uint32_t dma_request)
+{
+    if ((hi2c->Instance->CR1 & dma_request) and (hdma != nullptr))
+    {
+        hi2c->Instance->CR1 &= ~dma_request;
+        hdma->XferAbortCallback = I2C_DMAAbort;
+        if (HAL_DMA_Abort_IT(hdma) != HAL_OK)
+        {
+            hdma->XferAbortCallback(hdma);
+        }
+    }
+}
+
+extern "C" HAL_StatusTypeDef HAL_I2C_Slave_Seq_Transmit_DMA(I2C_HandleTypeDef* hi2c,
+                                                            uint8_t* pData, uint16_t Size,
+                                                            uint32_t XferOptions)
+{
+    if ((hi2c->State & HAL_I2C_STATE_LISTEN) != HAL_I2C_STATE_LISTEN)
+    {
+        return HAL_ERROR;
+    }
+    if ((pData == nullptr) or (Size == 0U))
+    {
+        return HAL_ERROR;
+    }
+    __HAL_LOCK(hi2c);
+
+    // prevent the preemption during the treatment of multiple calls
+    I2C_Disable_IRQ(hi2c, I2C_XFER_LISTEN_IT | I2C_XFER_TX_IT);
+
+    if (hi2c->State == HAL_I2C_STATE_BUSY_RX_LISTEN)
+    {
+        I2C_Disable_IRQ(hi2c, I2C_XFER_RX_IT);
+        I2C_AbortDMA(hi2c, hi2c->hdmarx, I2C_CR1_RXDMAEN);
+    }
+    else if (hi2c->State == HAL_I2C_STATE_BUSY_TX_LISTEN)
+    {
+        I2C_AbortDMA(hi2c, hi2c->hdmatx, I2C_CR1_TXDMAEN);
+    }
+
+    hi2c->State = HAL_I2C_STATE_BUSY_TX_LISTEN;
+    hi2c->Mode = HAL_I2C_MODE_SLAVE;
+    hi2c->ErrorCode = HAL_I2C_ERROR_NONE;
+    hi2c->Instance->CR2 &= ~I2C_CR2_NACK;
+
+    hi2c->pBuffPtr = pData;
+    hi2c->XferCount = Size;
+    hi2c->XferSize = hi2c->XferCount;
+    hi2c->XferOptions = XferOptions;
+    hi2c->PreviousState = I2C_STATE_NONE;
+    hi2c->XferISR = I2C_Slave_ISR_DMA;
+
+    hi2c->hdmatx->XferCpltCallback = I2C_DMASlaveTransmitCplt;
+    hi2c->hdmatx->XferErrorCallback = I2C_DMAError;
+    hi2c->hdmatx->XferHalfCpltCallback = nullptr;
+    hi2c->hdmatx->XferAbortCallback = nullptr;
+    if (HAL_DMA_Start_IT(hi2c->hdmatx, reinterpret_cast<uintptr_t>(pData),
+                         reinterpret_cast<uintptr_t>(&hi2c->Instance->TXDR),
+                         hi2c->XferSize) != HAL_OK)
+    {
+        hi2c->State = HAL_I2C_STATE_LISTEN;
+        hi2c->Mode = HAL_I2C_MODE_NONE;
+        hi2c->ErrorCode |= HAL_I2C_ERROR_DMA;
+        __HAL_UNLOCK(hi2c);
+        return HAL_ERROR;
+    }
+    hi2c->XferCount -= hi2c->XferSize;
+    hi2c->XferSize = 0;
+
+    if (I2C_GET_DIR(hi2c) == I2C_DIRECTION_RECEIVE)
+    {
+        I2C_CLEAR_FLAG(hi2c, I2C_FLAG_ADDR);
+    }
+
+    // the interrupts are enabled after the unlock, to avoid handling them while locked
+    __HAL_UNLOCK(hi2c);
+    I2C_Enable_IRQ(hi2c, I2C_XFER_LISTEN_IT);
+    hi2c->Instance->CR1 |= I2C_CR1_TXDMAEN;
+    return HAL_OK;
+}
+
+extern "C" HAL_StatusTypeDef HAL_I2C_Slave_Seq_Receive_DMA(I2C_HandleTypeDef* hi2c, uint8_t* pData,
+                                                           uint16_t Size, uint32_t XferOptions)
+{
+    if ((hi2c->State & HAL_I2C_STATE_LISTEN) != HAL_I2C_STATE_LISTEN)
+    {
+        return HAL_ERROR;
+    }
+    if ((pData == nullptr) or (Size == 0U))
+    {
+        return HAL_ERROR;
+    }
+    __HAL_LOCK(hi2c);
+
+    I2C_Disable_IRQ(hi2c, I2C_XFER_LISTEN_IT | I2C_XFER_RX_IT);
+
+    if (hi2c->State == HAL_I2C_STATE_BUSY_TX_LISTEN)
+    {
+        I2C_Disable_IRQ(hi2c, I2C_XFER_TX_IT);
+        I2C_AbortDMA(hi2c, hi2c->hdmatx, I2C_CR1_TXDMAEN);
+    }
+    else if (hi2c->State == HAL_I2C_STATE_BUSY_RX_LISTEN)
+    {
+        I2C_AbortDMA(hi2c, hi2c->hdmarx, I2C_CR1_RXDMAEN);
+    }
+
+    hi2c->State = HAL_I2C_STATE_BUSY_RX_LISTEN;
+    hi2c->Mode = HAL_I2C_MODE_SLAVE;
+    hi2c->ErrorCode = HAL_I2C_ERROR_NONE;
+    hi2c->Instance->CR2 &= ~I2C_CR2_NACK;
+
+    hi2c->pBuffPtr = pData;
+    hi2c->XferCount = Size;
+    hi2c->XferSize = hi2c->XferCount;
+    hi2c->XferOptions = XferOptions;
+    hi2c->PreviousState = I2C_STATE_NONE;
+    hi2c->XferISR = I2C_Slave_ISR_DMA;
+
+    hi2c->hdmarx->XferCpltCallback = I2C_DMASlaveReceiveCplt;
+    hi2c->hdmarx->XferErrorCallback = I2C_DMAError;
+    hi2c->hdmarx->XferHalfCpltCallback = nullptr;
+    hi2c->hdmarx->XferAbortCallback = nullptr;
+    if (HAL_DMA_Start_IT(hi2c->hdmarx, reinterpret_cast<uintptr_t>(&hi2c->Instance->RXDR),
+                         reinterpret_cast<uintptr_t>(pData), hi2c->XferSize) != HAL_OK)
+    {
+        hi2c->State = HAL_I2C_STATE_LISTEN;
+        hi2c->Mode = HAL_I2C_MODE_NONE;
+        hi2c->ErrorCode |= HAL_I2C_ERROR_DMA;
+        __HAL_UNLOCK(hi2c);
+        return HAL_ERROR;
+    }
+    hi2c->XferCount -= hi2c->XferSize;
+    hi2c->XferSize = 0;
+
+    if (I2C_GET_DIR(hi2c) == I2C_DIRECTION_TRANSMIT)
+    {
+        I2C_CLEAR_FLAG(hi2c, I2C_FLAG_ADDR);
+    }
+
+    __HAL_UNLOCK(hi2c);
+    I2C_Enable_IRQ(hi2c, I2C_XFER_LISTEN_IT);
+    hi2c->Instance->CR1 |= I2C_CR1_RXDMAEN;
+    return HAL_OK;
+}
+
+extern "C" void HAL_I2C_EV_IRQHandler(I2C_HandleTypeDef* hi2c)
+{
+    uint32_t itflags = hi2c->Instance->ISR;
+    uint32_t itsources = hi2c->Instance->CR1;
+
+    if (hi2c->XferISR != nullptr)
+    {
+        hi2c->XferISR(hi2c, itflags, itsources);
+    }
+}
+
+extern "C" void HAL_I2C_ER_IRQHandler(I2C_HandleTypeDef* hi2c)
+{
+    uint32_t itflags = hi2c->Instance->ISR;
+    uint32_t itsources = hi2c->Instance->CR1;
+
+    if ((itflags & I2C_FLAG_BERR) and (itsources & I2C_IT_ERRI))
+    {
+        hi2c->ErrorCode |= HAL_I2C_ERROR_BERR;
+        I2C_CLEAR_FLAG(hi2c, I2C_FLAG_BERR);
+    }
+    if ((itflags & I2C_FLAG_OVR) and (itsources & I2C_IT_ERRI))
+    {
+        hi2c->ErrorCode |= HAL_I2C_ERROR_OVR;
+        I2C_CLEAR_FLAG(hi2c, I2C_FLAG_OVR);
+    }
+    if ((itflags & I2C_FLAG_ARLO) and (itsources & I2C_IT_ERRI))
+    {
+        hi2c->ErrorCode |= HAL_I2C_ERROR_ARLO;
+        I2C_CLEAR_FLAG(hi2c, I2C_FLAG_ARLO);
+    }
+
+    uint32_t tmperror = hi2c->ErrorCode;
+    if (tmperror & (HAL_I2C_ERROR_BERR | HAL_I2C_ERROR_OVR | HAL_I2C_ERROR_ARLO))
+    {
+        I2C_ITError(hi2c, tmperror);
+    }
+}
+
+extern "C" uint32_t HAL_I2C_GetError(I2C_HandleTypeDef* hi2c)
+{
+    return hi2c->ErrorCode;
+}
+
+extern "C" HAL_I2C_StateTypeDef HAL_I2C_GetState(I2C_HandleTypeDef* hi2c)
+{
+    return hi2c->State;
+}
+
+extern "C" __weak void HAL_I2C_AddrCallback([[maybe_unused]] I2C_HandleTypeDef* hi2c,
+                                            [[maybe_unused]] uint8_t TransferDirection,
+                                            [[maybe_unused]] uint16_t AddrMatchCode)
+{}
+
+extern "C" __weak void HAL_I2C_ListenCpltCallback([[maybe_unused]] I2C_HandleTypeDef* hi2c) {}
+
+extern "C" __weak void HAL_I2C_SlaveTxCpltCallback([[maybe_unused]] I2C_HandleTypeDef* hi2c) {}
+
+extern "C" __weak void HAL_I2C_SlaveRxCpltCallback([[maybe_unused]] I2C_HandleTypeDef* hi2c) {}
+
+extern "C" __weak void HAL_I2C_ErrorCallback([[maybe_unused]] I2C_HandleTypeDef* hi2c) {}
+
+extern "C" __weak void HAL_I2C_AbortCpltCallback([[maybe_unused]] I2C_HandleTypeDef* hi2c) {}
@@ -0,0 +1,105 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+/// @brief  The I2C bus master of a simulated bus, clocking the slave peripheral of the MCU
+///         bit by bit in time, and waiting while the slave stretches the clock.
+#ifndef __SIM_BUS_MASTER_HPP_
+#define __SIM_BUS_MASTER_HPP_
+
+#include <deque>
+#include <vector>
+#include "sim/sim.hpp"
+
+namespace sim
+{
+class i2c_target;
+
+class bus_master
+{
+  public:
+    /// @brief A write, a read, or a write followed by a read after a repeated START.
+    struct transfer
+    {
+        std::uint8_t address;
+        std::vector<std::uint8_t> write;
+        std::size_t read_size;
+    };
+
+    struct result
+    {
+        bool acknowledged;  ///< the slave acknowledged its address
+        bool aborted;       ///< a bus error ended the transfer, without a STOP condition
+        std::size_t written; ///< the acknowledged bytes of the write
+        std::vector<std::uint8_t> read;
+        picoseconds start;
+        picoseconds end;
+    };
+
+    struct statistics
+    {
+        std::uint64_t transfers;
+        std::uint64_t bytes;
+        std::uint64_t nacks;
+        picoseconds stretched; ///< the time the slave held the clock low
+    };
+
+    /// @param instance: the I2C peripheral of the MCU on the bus
+    /// @param speed: the bus clock in Hz
+    bus_master(I2C_TypeDef* instance, std::uint32_t speed);
+
+    void set_speed(std::uint32_t speed) { bit_time_ = SECOND / speed; }
+
+    /// @brief Queues a transfer, that starts once the bus is free.
+    void submit(transfer t, std::function<void(const result&)> completion);
+
+    /// @brief Submits a transfer, and runs the firmware until it completes.
+    result execute(transfer t, picoseconds timeout = SECOND);
+
+    /// @brief Signals a bus error on the bus, the ongoing transfer is aborted.
+    /// @param flags: the I2C_ISR error flags, that the slave detects
+    void inject_error(std::uint32_t flags);
+
+    bool idle() const { return !active_ and queue_.empty(); }
+    bool stalled() const { return bool(stalled_); }
+    const statistics& stats() const { return stats_; }
+    void clear_stats() { stats_ = {}; }
+
+  private:
+    struct request
+    {
+        transfer t;
+        std::function<void(const result&)> completion;
+    };
+
+    void after(unsigned bits, std::function<void()> next);
+    void when_released(std::function<void()> next);
+    void released();
+    void begin();
+    void send_address(bool read);
+    void write_byte(std::size_t index);
+    void acknowledge_write(std::size_t index);
+    void read_byte(std::size_t index);
+    void stop();
+    void finish();
+
+    i2c_target& target_;
+    picoseconds bit_time_;
+    std::deque<request> queue_{};
+    request current_{};
+    result result_{};
+    statistics stats_{};
+    std::function<void()> stalled_{};
+    picoseconds stall_start_{};
+    unsigned generation_{};
+    bool active_{};
+};
+} // namespace sim
+
+#endif // __SIM_BUS_MASTER_HPP_
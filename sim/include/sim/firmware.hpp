@@ -0,0 +1,90 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+/// @brief  The parts of the firmware that the simulation programs inspect and drive,
+///         the programs define test_i2c_hid_device(), which runs after the device is created.
+#ifndef __SIM_FIRMWARE_HPP_
+#define __SIM_FIRMWARE_HPP_
+
+extern "C"
+{
+#include "main.h"
+}
+#include <array>
+#include <cstring>
+#include "hid/demo_app.hpp"
+#include "sim/hid_host.hpp"
+#include "st/i2c_timing.hpp"
+#if I2C_HID_LL_SLAVE
+#include "st/ll_i2c_slave.hpp"
+using i2c_slave_driver = st::ll_i2c_slave;
+#else
+#include "st/hal_i2c_slave.hpp"
+using i2c_slave_driver = st::hal_i2c_slave;
+#endif
+
+// defined in i2c_hid_config.cpp
+i2c_slave_driver& get_i2c_slave(std::size_t bus = 0);
+bool set_i2c_bus_speed(st::i2c_speed speed, std::size_t bus = 0);
+
+namespace sim
+{
+/// @brief The I2C slave address and the HID descriptor register of the devices.
+constexpr std::uint8_t DEVICE_ADDRESS = 0x0a;
+constexpr std::uint16_t HID_DESCRIPTOR_REGISTER = 0x0001;
+
+/// @brief Calls the application from thread mode, at the priority of the transport.
+template <typename TFunction>
+void at_transport_priority(TFunction&& function)
+{
+    __disable_irq();
+    function();
+    __enable_irq();
+}
+
+/// @brief The performance counters of the device, indexed by perf_counter.
+using counter_values =
+    std::array<std::uint32_t, hid::demo_app::counters::size() / sizeof(std::uint32_t)>;
+
+/// @brief Reads all performance counters of the device with one counters feature report,
+///        so that the reading doesn't count in the values.
+inline counter_values read_counters(hid_host& host)
+{
+    auto report = host.get_report(hid_host::report_type::FEATURE,
+                                  hid::demo_app::counters_report::ID,
+                                  sizeof(hid::demo_app::counters_report));
+    if (report.size() != (1 + hid::demo_app::counters::size()))
+    {
+        fail("the counters report can't be read");
+    }
+    counter_values values;
+    std::memcpy(values.data(), report.data() + 1, sizeof(values));
+    return values;
+}
+
+/// @brief Reads a performance counter of the device with the counters feature report.
+inline std::uint32_t read_counter(hid_host& host, hid::demo_app::perf_counter counter)
+{
+    return read_counters(host)[static_cast<std::size_t>(counter)];
+}
+
+/// @brief Clears the performance counters of the device.
+inline void clear_counters(hid_host& host)
+{
+    std::array<std::uint8_t, 1 + hid::demo_app::counters::size()> report{
+        hid::demo_app::counters_report::ID};
+    if (!host.set_report(hid_host::report_type::FEATURE, report))
+    {
+        fail("the counters can't be cleared");
+    }
+}
+} // namespace sim
+
+#endif // __SIM_FIRMWARE_HPP_
@@ -0,0 +1,124 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+/// @brief  The HID over I2C host of a simulated bus: it reads the input reports while the
+///         device asserts the interrupt line, and executes the class requests synchronously.
+#ifndef __SIM_HID_HOST_HPP_
+#define __SIM_HID_HOST_HPP_
+
+#include <span>
+#include "sim/bus_master.hpp"
+
+namespace sim
+{
+class hid_host
+{
+  public:
+    enum class report_type : std::uint8_t
+    {
+        INPUT = 1,
+        OUTPUT = 2,
+        FEATURE = 3,
+    };
+
+    /// @brief The fields of the HID descriptor.
+    struct descriptor
+    {
+        std::uint16_t wHIDDescLength;
+        std::uint16_t bcdVersion;
+        std::uint16_t wReportDescLength;
+        std::uint16_t wReportDescRegister;
+        std::uint16_t wInputRegister;
+        std::uint16_t wMaxInputLength;
+        std::uint16_t wOutputRegister;
+        std::uint16_t wMaxOutputLength;
+        std::uint16_t wCommandRegister;
+        std::uint16_t wDataRegister;
+        std::uint16_t wVendorID;
+        std::uint16_t wProductID;
+        std::uint16_t wVersionID;
+    };
+
+    struct statistics
+    {
+        std::uint64_t inputs;       ///< the received input reports
+        std::uint64_t input_bytes;  ///< the bytes of the input reports, without the length
+        std::uint64_t empty_reads;  ///< the input reads without a report
+        picoseconds max_response;   ///< the longest time from the interrupt to the report read
+    };
+
+    /// @param bus: the master of the device's bus
+    /// @param address: the 7-bit slave address of the device
+    /// @param hid_descriptor_register: the register of the HID descriptor
+    /// @param interrupt_port, interrupt_pin: the active low interrupt line of the device
+    hid_host(bus_master& bus, std::uint8_t address, std::uint16_t hid_descriptor_register,
+             GPIO_TypeDef* interrupt_port, std::uint16_t interrupt_pin);
+
+    /// @brief Reads the HID descriptor, resets the device, and starts serving the inputs.
+    void connect();
+
+    const descriptor& hid_descriptor() const { return descriptor_; }
+
+    std::vector<std::uint8_t> read_report_descriptor();
+
+    /// @brief Resets the device, and waits for the completion.
+    /// @return true if the device signalled the completion in time
+    bool reset(picoseconds timeout = 100 * MILLISECOND);
+
+    /// @param size: the size of the report with its ID, the input reports' maximum by default
+    /// @return the report without the length, or empty if the request failed
+    std::vector<std::uint8_t> get_report(report_type type, std::uint8_t id, std::size_t size = 0);
+
+    /// @param data: the report, starting with its ID
+    bool set_report(report_type type, std::span<const std::uint8_t> data);
+
+    /// @param data: the report, starting with its ID
+    bool output_report(std::span<const std::uint8_t> data);
+
+    bool set_power(bool on);
+
+    /// @brief Sets the receiver of the input reports, that start with their ID.
+    void on_input(std::function<void(std::span<const std::uint8_t>)> handler)
+    {
+        input_handler_ = std::move(handler);
+    }
+
+    /// @brief Sets the time it takes for the host to start reading after the interrupt.
+    void set_response_delay(picoseconds delay) { response_delay_ = delay; }
+
+    bool interrupt_asserted() const { return !output(interrupt_port_, interrupt_pin_); }
+
+    const statistics& stats() const { return stats_; }
+    void clear_stats() { stats_ = {}; }
+
+  private:
+    std::vector<std::uint8_t> command(std::uint8_t opcode, report_type type, std::uint8_t id);
+    void interrupt_changed(bool level);
+    void read_input();
+    void input_read(const bus_master::result& r);
+
+    bus_master& bus_;
+    const std::uint8_t address_;
+    const std::uint16_t hid_descriptor_register_;
+    GPIO_TypeDef* const interrupt_port_;
+    const std::uint16_t interrupt_pin_;
+    descriptor descriptor_{};
+    std::function<void(std::span<const std::uint8_t>)> input_handler_{};
+    statistics stats_{};
+    // the latency of a threaded interrupt handler
+    picoseconds response_delay_{20 * MICROSECOND};
+    picoseconds asserted_at_{};
+    bool connected_{};
+    bool reading_{};
+    bool reset_done_{};
+};
+} // namespace sim
+
+#endif // __SIM_HID_HOST_HPP_
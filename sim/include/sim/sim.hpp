@@ -0,0 +1,126 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+/// @brief  The host simulation of the STM32F072 running the firmware: a single timeline of
+///         core clock cycles and bus events. The firmware is charged cycles for its function
+///         calls, register accesses and exception entries, the interrupts are taken at the
+///         register accesses and function calls of the interrupted code.
+#ifndef __SIM_SIM_HPP_
+#define __SIM_SIM_HPP_
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include "stm32f0xx_hal.h"
+
+namespace sim
+{
+/// @brief The simulated time in picoseconds.
+using picoseconds = std::uint64_t;
+constexpr picoseconds NANOSECOND = 1'000;
+constexpr picoseconds MICROSECOND = 1'000 * NANOSECOND;
+constexpr picoseconds MILLISECOND = 1'000 * MICROSECOND;
+constexpr picoseconds SECOND = 1'000 * MILLISECOND;
+
+/// @brief The current time, inside the bus events the time of the event.
+picoseconds now();
+
+/// @brief The elapsed core clock cycles, they keep counting in sleep, but not in STOP mode.
+std::uint64_t cycles();
+
+std::uint32_t core_clock();
+
+/// @brief Runs the idle loop of the firmware until the condition is met.
+/// @param condition: evaluated at every wakeup of the firmware
+/// @param timeout: the maximum duration to run for
+/// @return true if the condition is met, false if the time ran out
+bool run_until(const std::function<bool()>& condition, picoseconds timeout = SECOND);
+
+/// @brief Runs the idle loop of the firmware for a duration.
+void run_for(picoseconds duration);
+
+/// @brief Executes code of the firmware for a number of core clock cycles, in the current context,
+///        e.g. a critical section when it's called with the interrupts disabled.
+void execute(std::uint32_t cycles);
+
+/// @brief Schedules a callback, that is executed in the context of the bus events.
+void schedule(picoseconds delay, std::function<void()> callback);
+
+/// @brief Installs the handler of an interrupt, that the firmware doesn't use, so the simulation
+///        program can preempt the firmware with its own code. The interrupt is configured with
+///        the NVIC functions, and requested with trigger_interrupt().
+void connect_handler(IRQn_Type irq, void (*handler)());
+
+/// @brief Requests an interrupt, also from the bus events, it's taken at the next register
+///        access or function call of the firmware.
+void trigger_interrupt(IRQn_Type irq);
+
+/// @brief Drives an input pin, the edges trigger the configured EXTI line.
+void set_input(GPIO_TypeDef* port, std::uint16_t pin, bool level);
+
+/// @brief The level of an output pin, the pins that aren't configured as outputs are pulled up.
+bool output(GPIO_TypeDef* port, std::uint16_t pin);
+
+/// @brief Calls the listener at every change of an output pin's level.
+void watch_output(GPIO_TypeDef* port, std::uint16_t pin, std::function<void(bool)> listener);
+
+/// @brief The faults of the clock tree, that the clock profile switching must survive.
+enum class clock_fault
+{
+    NONE,
+    PLL_LOCK,      ///< the PLL never locks
+    HSI48_READY,   ///< the HSI48 oscillator never becomes ready
+    FLASH_LATENCY, ///< the flash wait states can't be changed
+    CLOCK_SWITCH,  ///< the system clock doesn't switch to the 48 MHz sources
+};
+
+void inject_clock_fault(clock_fault fault);
+
+struct core_statistics
+{
+    std::uint64_t exceptions;     ///< the handled exceptions, including SysTick and PendSV
+    std::uint64_t stop_entries;   ///< the STOP mode entries
+    std::uint64_t error_handlers; ///< the calls of Error_Handler()
+    /// the longest window with the interrupts masked, that can span clock changes,
+    /// the sleep with masked interrupts isn't part of it, as it delays no interrupt
+    picoseconds max_masked_time;
+};
+
+const core_statistics& statistics();
+
+void clear_statistics();
+
+/// @brief The cycles that an exception handler spent, including the preempting ones.
+struct exception_cycles
+{
+    std::uint64_t count;
+    std::uint64_t total;
+    std::uint64_t max;
+};
+
+exception_cycles handler_cycles(IRQn_Type irq);
+
+void clear_handler_cycles();
+
+/// @brief Replaces the failure of the simulation at Error_Handler() calls,
+///        the hook must not return (exit the test instead).
+void on_error_handler(std::function<void()> hook);
+
+/// @brief The words of the stack area, that the stack monitor of the firmware observes.
+///        The simulated code runs on the host stack, the area is only used to exercise
+///        the watermark and canary logic.
+std::uint32_t* stack_bottom();
+std::uint32_t* stack_top();
+
+/// @brief Stops the simulation with an error message.
+[[noreturn]] void fail(const char* format, ...) __attribute__((format(printf, 1, 2)));
+} // namespace sim
+
+#endif // __SIM_SIM_HPP_
@@ -0,0 +1,17 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+/// @brief  Test double of the stm32header include, see stm32f0xx_hal.h.
+#ifndef __ST_STM32CMSIS_H_
+#define __ST_STM32CMSIS_H_
+
+#include "stm32f0xx_hal.h"
+
+#endif // __ST_STM32CMSIS_H_
@@ -0,0 +1,719 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+/// @brief  Test double of the STM32F0 HAL and CMSIS headers, limited to what the firmware uses.
+///         The peripheral registers have the layout and the names of the target's CMSIS device
+///         header stm32f072xb.h (Copyright (c) 2016 STMicroelectronics, Apache-2.0).
+///         In C++ each register is a proxy, that forwards the accesses to the peripheral models
+///         of the simulation,
+///         in C (the CubeMX generated sources) they are plain words that the models keep updated.
+#ifndef __STM32F0XX_HAL_H
+#define __STM32F0XX_HAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// the core -------------------------------------------------------------------------------------
+
+#define __CORTEX_M      0U
+#define __NVIC_PRIO_BITS 2U
+#define HSI_VALUE       8000000U
+#define HSI48_VALUE     48000000U
+
+#define __weak     __attribute__((weak))
+#define __RAM_FUNC __attribute__((noinline))
+
+typedef enum
+{
+    NonMaskableInt_IRQn = -14,
+    HardFault_IRQn = -13,
+    SVC_IRQn = -5,
+    PendSV_IRQn = -2,
+    SysTick_IRQn = -1,
+    EXTI0_1_IRQn = 5,
+    DMA1_Channel1_IRQn = 9,
+    DMA1_Channel2_3_IRQn = 10,
+    DMA1_Channel4_5_6_7_IRQn = 11,
+    TIM2_IRQn = 15,
+    I2C1_IRQn = 23,
+    I2C2_IRQn = 24,
+} IRQn_Type;
+
+void NVIC_SetPriority(IRQn_Type IRQn, uint32_t priority);
+uint32_t NVIC_GetPriority(IRQn_Type IRQn);
+void NVIC_EnableIRQ(IRQn_Type IRQn);
+void NVIC_DisableIRQ(IRQn_Type IRQn);
+void NVIC_SetPendingIRQ(IRQn_Type IRQn);
+void NVIC_ClearPendingIRQ(IRQn_Type IRQn);
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority);
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn);
+void HAL_NVIC_DisableIRQ(IRQn_Type IRQn);
+
+void __enable_irq(void);
+void __disable_irq(void);
+uint32_t __get_PRIMASK(void);
+void __WFI(void);
+#define __DSB()    __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define __ISB()    __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define __NOP()    ((void)0)
+#define __BKPT(n)  __builtin_trap()
+
+// the peripheral registers ---------------------------------------------------------------------
+
+#ifdef __cplusplus
+}
+// the header may be included in a C linkage block
+extern "C++"
+{
+/// @brief A peripheral register, the accesses are forwarded to the peripheral models.
+template <typename T>
+struct sim_register
+{
+    volatile T value;
+
+    operator T() const volatile;
+    void operator=(T v) volatile;
+    void operator|=(T v) volatile { *this = T(*this) | v; }
+    void operator&=(T v) volatile { *this = T(*this) & v; }
+    // copying a register must go through the models too
+    sim_register& operator=(const sim_register&) = delete;
+};
+extern template struct sim_register<uint32_t>;
+#if UINTPTR_MAX != UINT32_MAX
+extern template struct sim_register<uintptr_t>;
+#endif
+typedef sim_register<uint32_t> sim_reg32;
+typedef sim_register<uintptr_t> sim_regptr;
+}
+
+extern "C"
+{
+#else
+typedef volatile uint32_t sim_reg32;
+typedef volatile uintptr_t sim_regptr;
+#endif
+
+typedef struct
+{
+    sim_reg32 CR1;
+    sim_reg32 CR2;
+    sim_reg32 OAR1;
+    sim_reg32 OAR2;
+    sim_reg32 TIMINGR;
+    sim_reg32 TIMEOUTR;
+    sim_reg32 ISR;
+    sim_reg32 ICR;
+    sim_reg32 PECR;
+    sim_reg32 RXDR;
+    sim_reg32 TXDR;
+} I2C_TypeDef;
+
+typedef struct
+{
+    sim_reg32 CCR;
+    sim_reg32 CNDTR;
+    sim_regptr CPAR;
+    sim_regptr CMAR;
+} DMA_Channel_TypeDef;
+
+typedef struct
+{
+    sim_reg32 ISR;
+    sim_reg32 IFCR;
+} DMA_TypeDef;
+
+typedef struct
+{
+    sim_reg32 MODER;
+    sim_reg32 OTYPER;
+    sim_reg32 OSPEEDR;
+    sim_reg32 PUPDR;
+    sim_reg32 IDR;
+    sim_reg32 ODR;
+    sim_reg32 BSRR;
+    sim_reg32 LCKR;
+    sim_reg32 AFR[2];
+    sim_reg32 BRR;
+} GPIO_TypeDef;
+
+typedef struct
+{
+    sim_reg32 CR;
+    sim_reg32 CFGR;
+    sim_reg32 CIR;
+    sim_reg32 APB2RSTR;
+    sim_reg32 APB1RSTR;
+    sim_reg32 AHBENR;
+    sim_reg32 APB2ENR;
+    sim_reg32 APB1ENR;
+    sim_reg32 BDCR;
+    sim_reg32 CSR;
+    sim_reg32 AHBRSTR;
+    sim_reg32 CFGR2;
+    sim_reg32 CFGR3;
+    sim_reg32 CR2;
+} RCC_TypeDef;
+
+typedef struct
+{
+    sim_reg32 ACR;
+    sim_reg32 KEYR;
+    sim_reg32 OPTKEYR;
+    sim_reg32 SR;
+    sim_reg32 CR;
+    sim_reg32 AR;
+} FLASH_TypeDef;
+
+typedef struct
+{
+    sim_reg32 CR1;
+    sim_reg32 CR2;
+    sim_reg32 SMCR;
+    sim_reg32 DIER;
+    sim_reg32 SR;
+    sim_reg32 EGR;
+    sim_reg32 CCMR1;
+    sim_reg32 CCMR2;
+    sim_reg32 CCER;
+    sim_reg32 CNT;
+    sim_reg32 PSC;
+    sim_reg32 ARR;
+} TIM_TypeDef;
+
+typedef struct
+{
+    sim_reg32 CPUID;
+    sim_reg32 ICSR;
+    sim_reg32 RESERVED0;
+    sim_reg32 AIRCR;
+    sim_reg32 SCR;
+    sim_reg32 CCR;
+} SCB_Type;
+
+typedef struct
+{
+    sim_reg32 CFGR1;
+} SYSCFG_TypeDef;
+
+typedef struct
+{
+    sim_reg32 IMR;
+    sim_reg32 EMR;
+    sim_reg32 RTSR;
+    sim_reg32 FTSR;
+    sim_reg32 SWIER;
+    sim_reg32 PR;
+} EXTI_TypeDef;
+
+extern I2C_TypeDef sim_i2c1, sim_i2c2;
+extern DMA_Channel_TypeDef sim_dma1_channel[7];
+extern DMA_TypeDef sim_dma1;
+extern GPIO_TypeDef sim_gpioa, sim_gpiob, sim_gpioc;
+extern RCC_TypeDef sim_rcc;
+extern FLASH_TypeDef sim_flash;
+extern TIM_TypeDef sim_tim2;
+extern SCB_Type sim_scb;
+extern SYSCFG_TypeDef sim_syscfg;
+extern EXTI_TypeDef sim_exti;
+
+#define I2C1          (&sim_i2c1)
+#define I2C2          (&sim_i2c2)
+#define DMA1          (&sim_dma1)
+#define DMA1_Channel1 (&sim_dma1_channel[0])
+#define DMA1_Channel2 (&sim_dma1_channel[1])
+#define DMA1_Channel3 (&sim_dma1_channel[2])
+#define DMA1_Channel4 (&sim_dma1_channel[3])
+#define DMA1_Channel5 (&sim_dma1_channel[4])
+#define GPIOA         (&sim_gpioa)
+#define GPIOB         (&sim_gpiob)
+#define GPIOC         (&sim_gpioc)
+#define RCC           (&sim_rcc)
+#define FLASH         (&sim_flash)
+#define TIM2          (&sim_tim2)
+#define SCB           (&sim_scb)
+#define SYSCFG        (&sim_syscfg)
+#define EXTI          (&sim_exti)
+
+#define I2C_CR1_PE          (1U << 0)
+#define I2C_CR1_TXIE        (1U << 1)
+#define I2C_CR1_RXIE        (1U << 2)
+#define I2C_CR1_ADDRIE      (1U << 3)
+#define I2C_CR1_NACKIE      (1U << 4)
+#define I2C_CR1_STOPIE      (1U << 5)
+#define I2C_CR1_TCIE        (1U << 6)
+#define I2C_CR1_ERRIE       (1U << 7)
+#define I2C_CR1_TXDMAEN     (1U << 14)
+#define I2C_CR1_RXDMAEN     (1U << 15)
+#define I2C_CR1_SBC         (1U << 16)
+#define I2C_CR1_NOSTRETCH   (1U << 17)
+#define I2C_CR1_WUPEN       (1U << 18)
+#define I2C_CR1_ANFOFF      (1U << 12)
+#define I2C_CR1_DNF         (0xFU << 8)
+#define I2C_CR2_SADD        (0x3FFU)
+#define I2C_CR2_RD_WRN      (1U << 10)
+#define I2C_CR2_ADD10       (1U << 11)
+#define I2C_CR2_HEAD10R     (1U << 12)
+#define I2C_CR2_NACK        (1U << 15)
+#define I2C_CR2_NBYTES      (0xFFU << 16)
+#define I2C_CR2_RELOAD      (1U << 24)
+#define I2C_CR2_AUTOEND     (1U << 25)
+#define I2C_OAR1_OA1        (0x3FFU)
+#define I2C_OAR1_OA1MODE    (1U << 10)
+#define I2C_OAR1_OA1EN      (1U << 15)
+#define I2C_ISR_TXE         (1U << 0)
+#define I2C_ISR_TXIS        (1U << 1)
+#define I2C_ISR_RXNE        (1U << 2)
+#define I2C_ISR_ADDR        (1U << 3)
+#define I2C_ISR_NACKF       (1U << 4)
+#define I2C_ISR_STOPF       (1U << 5)
+#define I2C_ISR_TC          (1U << 6)
+#define I2C_ISR_TCR         (1U << 7)
+#define I2C_ISR_BERR        (1U << 8)
+#define I2C_ISR_ARLO        (1U << 9)
+#define I2C_ISR_OVR         (1U << 10)
+#define I2C_ISR_BUSY        (1U << 15)
+#define I2C_ISR_DIR         (1U << 16)
+#define I2C_ISR_ADDCODE     (0x7FU << 17)
+#define I2C_ICR_ADDRCF      (1U << 3)
+#define I2C_ICR_NACKCF      (1U << 4)
+#define I2C_ICR_STOPCF      (1U << 5)
+#define I2C_ICR_BERRCF      (1U << 8)
+#define I2C_ICR_ARLOCF      (1U << 9)
+#define I2C_ICR_OVRCF       (1U << 10)
+#define I2C_FLAG_TXE        I2C_ISR_TXE
+#define I2C_FLAG_TXIS       I2C_ISR_TXIS
+#define I2C_FLAG_RXNE       I2C_ISR_RXNE
+#define I2C_FLAG_ADDR       I2C_ISR_ADDR
+#define I2C_FLAG_AF         I2C_ISR_NACKF
+#define I2C_FLAG_STOPF      I2C_ISR_STOPF
+#define I2C_FLAG_BERR       I2C_ISR_BERR
+#define I2C_FLAG_ARLO       I2C_ISR_ARLO
+#define I2C_FLAG_OVR        I2C_ISR_OVR
+#define I2C_FLAG_BUSY       I2C_ISR_BUSY
+#define I2C_IT_ERRI         I2C_CR1_ERRIE
+#define I2C_IT_TCI          I2C_CR1_TCIE
+#define I2C_IT_STOPI        I2C_CR1_STOPIE
+#define I2C_IT_NACKI        I2C_CR1_NACKIE
+#define I2C_IT_ADDRI        I2C_CR1_ADDRIE
+#define I2C_IT_RXI          I2C_CR1_RXIE
+#define I2C_IT_TXI          I2C_CR1_TXIE
+
+#define DMA_CCR_EN          (1U << 0)
+#define DMA_CCR_TCIE        (1U << 1)
+#define DMA_CCR_HTIE        (1U << 2)
+#define DMA_CCR_TEIE        (1U << 3)
+#define DMA_CCR_DIR         (1U << 4)
+#define DMA_CCR_CIRC        (1U << 5)
+#define DMA_CCR_PINC        (1U << 6)
+#define DMA_CCR_MINC        (1U << 7)
+#define DMA_CCR_PSIZE       (3U << 8)
+#define DMA_CCR_MSIZE       (3U << 10)
+#define DMA_CCR_PL          (3U << 12)
+#define DMA_CCR_MEM2MEM     (1U << 14)
+#define DMA_ISR_GIF1        (1U << 0)
+#define DMA_ISR_TCIF1       (1U << 1)
+#define DMA_ISR_HTIF1       (1U << 2)
+#define DMA_ISR_TEIF1       (1U << 3)
+#define DMA_IFCR_CGIF1      (1U << 0)
+
+#define RCC_CR_HSION        (1U << 0)
+#define RCC_CR_HSIRDY       (1U << 1)
+#define RCC_CR_PLLON        (1U << 24)
+#define RCC_CR_PLLRDY       (1U << 25)
+#define RCC_CFGR_PLLMUL     (0xFU << 18)
+#define RCC_CFGR_PLLSRC     (3U << 15)
+#define RCC_CR2_HSI48ON     (1U << 16)
+#define RCC_CR2_HSI48RDY    (1U << 17)
+#define RCC_CFGR_SW         (3U << 0)
+#define RCC_CFGR_SW_HSI     (0U << 0)
+#define RCC_CFGR_SW_PLL     (2U << 0)
+#define RCC_CFGR_SW_HSI48   (3U << 0)
+#define RCC_CFGR_SWS        (3U << 2)
+#define RCC_CFGR_SWS_HSI    (0U << 2)
+#define RCC_CFGR_SWS_PLL    (2U << 2)
+#define RCC_CFGR_SWS_HSI48  (3U << 2)
+#define FLASH_ACR_LATENCY   (1U << 0)
+
+#define TIM_CR1_CEN         (1U << 0)
+#define TIM_EGR_UG          (1U << 0)
+
+#define SCB_ICSR_PENDSVSET_Msk (1U << 28)
+
+#define SYSCFG_CFGR1_MEM_MODE      (3U << 0)
+#define SYSCFG_CFGR1_I2C_FMP_PB6  (1U << 16)
+#define SYSCFG_CFGR1_I2C_FMP_PB7  (1U << 17)
+#define SYSCFG_CFGR1_I2C_FMP_I2C1 (1U << 20)
+#define SYSCFG_CFGR1_I2C_FMP_I2C2 (1U << 21)
+
+// the HAL --------------------------------------------------------------------------------------
+
+#define TICK_INT_PRIORITY 2U
+
+typedef enum
+{
+    HAL_OK = 0x00U,
+    HAL_ERROR = 0x01U,
+    HAL_BUSY = 0x02U,
+    HAL_TIMEOUT = 0x03U
+} HAL_StatusTypeDef;
+
+typedef enum
+{
+    HAL_UNLOCKED = 0x00U,
+    HAL_LOCKED = 0x01U
+} HAL_LockTypeDef;
+
+extern uint32_t SystemCoreClock;
+
+void Error_Handler(void);
+
+HAL_StatusTypeDef HAL_Init(void);
+void HAL_MspInit(void);
+HAL_StatusTypeDef HAL_InitTick(uint32_t TickPriority);
+void HAL_IncTick(void);
+uint32_t HAL_GetTick(void);
+
+// RCC
+
+typedef struct
+{
+    uint32_t PLLState;
+    uint32_t PLLSource;
+    uint32_t PLLMUL;
+    uint32_t PREDIV;
+} RCC_PLLInitTypeDef;
+
+typedef struct
+{
+    uint32_t OscillatorType;
+    uint32_t HSEState;
+    uint32_t LSEState;
+    uint32_t HSIState;
+    uint32_t HSICalibrationValue;
+    uint32_t HSI14State;
+    uint32_t HSI14CalibrationValue;
+    uint32_t HSI48State;
+    uint32_t LSIState;
+    RCC_PLLInitTypeDef PLL;
+} RCC_OscInitTypeDef;
+
+typedef struct
+{
+    uint32_t ClockType;
+    uint32_t SYSCLKSource;
+    uint32_t AHBCLKDivider;
+    uint32_t APB1CLKDivider;
+} RCC_ClkInitTypeDef;
+
+typedef struct
+{
+    uint32_t PeriphClockSelection;
+    uint32_t RTCClockSelection;
+    uint32_t Usart1ClockSelection;
+    uint32_t Usart2ClockSelection;
+    uint32_t I2c1ClockSelection;
+    uint32_t CecClockSelection;
+    uint32_t UsbClockSelection;
+} RCC_PeriphCLKInitTypeDef;
+
+#define RCC_OSCILLATORTYPE_HSI     0x00000002U
+#define RCC_OSCILLATORTYPE_HSI48   0x00000020U
+#define RCC_HSI_ON                 RCC_CR_HSION
+#define RCC_HSI48_ON               RCC_CR2_HSI48ON
+#define RCC_HSICALIBRATION_DEFAULT 0x10U
+#define RCC_PLL_NONE               0x00000000U
+#define RCC_PLL_ON                 0x00000002U
+#define RCC_PLLSOURCE_HSI          (1U << 15)
+#define RCC_PLL_MUL6               (4U << 18)
+#define RCC_PREDIV_DIV1            0x00000000U
+#define RCC_CLOCKTYPE_SYSCLK       0x00000001U
+#define RCC_CLOCKTYPE_HCLK         0x00000002U
+#define RCC_CLOCKTYPE_PCLK1        0x00000004U
+#define RCC_SYSCLKSOURCE_PLLCLK    RCC_CFGR_SW_PLL
+#define RCC_SYSCLKSOURCE_HSI48     RCC_CFGR_SW_HSI48
+#define RCC_SYSCLK_DIV1            0x00000000U
+#define RCC_HCLK_DIV1              0x00000000U
+#define RCC_PERIPHCLK_I2C1         0x00000020U
+#define RCC_I2C1CLKSOURCE_HSI      0x00000000U
+#define FLASH_LATENCY_0            0x00000000U
+#define FLASH_LATENCY_1            FLASH_ACR_LATENCY
+
+HAL_StatusTypeDef HAL_RCC_OscConfig(RCC_OscInitTypeDef* RCC_OscInitStruct);
+HAL_StatusTypeDef HAL_RCC_ClockConfig(RCC_ClkInitTypeDef* RCC_ClkInitStruct, uint32_t FLatency);
+HAL_StatusTypeDef HAL_RCCEx_PeriphCLKConfig(RCC_PeriphCLKInitTypeDef* PeriphClkInit);
+uint32_t HAL_RCC_GetSysClockFreq(void);
+uint32_t HAL_RCC_GetHCLKFreq(void);
+uint32_t HAL_RCC_GetPCLK1Freq(void);
+
+// the peripheral clocks are always running in the simulation
+#define __HAL_RCC_GPIOA_CLK_ENABLE()  ((void)0)
+#define __HAL_RCC_GPIOB_CLK_ENABLE()  ((void)0)
+#define __HAL_RCC_GPIOC_CLK_ENABLE()  ((void)0)
+#define __HAL_RCC_DMA1_CLK_ENABLE()   ((void)0)
+#define __HAL_RCC_I2C1_CLK_ENABLE()   ((void)0)
+#define __HAL_RCC_I2C1_CLK_DISABLE()  ((void)0)
+#define __HAL_RCC_I2C2_CLK_ENABLE()   ((void)0)
+#define __HAL_RCC_I2C2_CLK_DISABLE()  ((void)0)
+#define __HAL_RCC_PWR_CLK_ENABLE()    ((void)0)
+#define __HAL_RCC_TIM2_CLK_ENABLE()   ((void)0)
+#define __HAL_RCC_SYSCFG_CLK_ENABLE() ((void)0)
+#define __HAL_SYSCFG_REMAPMEMORY_SRAM()                                                            \
+    (SYSCFG->CFGR1 = (SYSCFG->CFGR1 & ~SYSCFG_CFGR1_MEM_MODE) | SYSCFG_CFGR1_MEM_MODE)
+
+#define PWR_LOWPOWERREGULATOR_ON 1U
+#define PWR_STOPENTRY_WFI        1U
+void HAL_PWR_EnterSTOPMode(uint32_t Regulator, uint8_t STOPEntry);
+
+// GPIO
+
+typedef enum
+{
+    GPIO_PIN_RESET = 0U,
+    GPIO_PIN_SET
+} GPIO_PinState;
+
+typedef struct
+{
+    uint32_t Pin;
+    uint32_t Mode;
+    uint32_t Pull;
+    uint32_t Speed;
+    uint32_t Alternate;
+} GPIO_InitTypeDef;
+
+#define GPIO_PIN_0  ((uint16_t)0x0001U)
+#define GPIO_PIN_1  ((uint16_t)0x0002U)
+#define GPIO_PIN_2  ((uint16_t)0x0004U)
+#define GPIO_PIN_3  ((uint16_t)0x0008U)
+#define GPIO_PIN_4  ((uint16_t)0x0010U)
+#define GPIO_PIN_5  ((uint16_t)0x0020U)
+#define GPIO_PIN_6  ((uint16_t)0x0040U)
+#define GPIO_PIN_7  ((uint16_t)0x0080U)
+#define GPIO_PIN_8  ((uint16_t)0x0100U)
+#define GPIO_PIN_9  ((uint16_t)0x0200U)
+#define GPIO_PIN_10 ((uint16_t)0x0400U)
+#define GPIO_PIN_11 ((uint16_t)0x0800U)
+#define GPIO_PIN_12 ((uint16_t)0x1000U)
+#define GPIO_PIN_13 ((uint16_t)0x2000U)
+#define GPIO_PIN_14 ((uint16_t)0x4000U)
+#define GPIO_PIN_15 ((uint16_t)0x8000U)
+
+#define GPIO_MODE_INPUT              0x00000000U
+#define GPIO_MODE_OUTPUT_PP          0x00000001U
+#define GPIO_MODE_AF_PP              0x00000002U
+#define GPIO_MODE_AF_OD              0x00000012U
+#define GPIO_MODE_IT_RISING          0x10110000U
+#define GPIO_MODE_IT_FALLING         0x10210000U
+#define GPIO_MODE_IT_RISING_FALLING  0x10310000U
+#define GPIO_MODE_EVT_RISING         0x10120000U
+#define GPIO_NOPULL                  0x00000000U
+#define GPIO_PULLUP                  0x00000001U
+#define GPIO_SPEED_FREQ_LOW          0x00000000U
+#define GPIO_SPEED_FREQ_HIGH         0x00000003U
+#define GPIO_AF0_SPI2                0x00U
+#define GPIO_AF1_I2C1                0x01U
+#define GPIO_AF1_I2C2                0x01U
+#define GPIO_AF3_TSC                 0x03U
+
+void HAL_GPIO_Init(GPIO_TypeDef* GPIOx, GPIO_InitTypeDef* GPIO_Init);
+void HAL_GPIO_DeInit(GPIO_TypeDef* GPIOx, uint32_t GPIO_Pin);
+void HAL_GPIO_WritePin(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState);
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin);
+void HAL_GPIO_EXTI_IRQHandler(uint16_t GPIO_Pin);
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin);
+
+// DMA
+
+typedef enum
+{
+    HAL_DMA_STATE_RESET = 0x00U,
+    HAL_DMA_STATE_READY = 0x01U,
+    HAL_DMA_STATE_BUSY = 0x02U,
+} HAL_DMA_StateTypeDef;
+
+typedef struct
+{
+    uint32_t Direction;
+    uint32_t PeriphInc;
+    uint32_t MemInc;
+    uint32_t PeriphDataAlignment;
+    uint32_t MemDataAlignment;
+    uint32_t Mode;
+    uint32_t Priority;
+} DMA_InitTypeDef;
+
+typedef struct __DMA_HandleTypeDef
+{
+    DMA_Channel_TypeDef* Instance;
+    DMA_InitTypeDef Init;
+    HAL_LockTypeDef Lock;
+    volatile HAL_DMA_StateTypeDef State;
+    void* Parent;
+    void (*XferCpltCallback)(struct __DMA_HandleTypeDef* hdma);
+    void (*XferHalfCpltCallback)(struct __DMA_HandleTypeDef* hdma);
+    void (*XferErrorCallback)(struct __DMA_HandleTypeDef* hdma);
+    void (*XferAbortCallback)(struct __DMA_HandleTypeDef* hdma);
+    volatile uint32_t ErrorCode;
+    DMA_TypeDef* DmaBaseAddress;
+    uint32_t ChannelIndex;
+} DMA_HandleTypeDef;
+
+#define DMA_PERIPH_TO_MEMORY 0x00000000U
+#define DMA_MEMORY_TO_PERIPH DMA_CCR_DIR
+#define DMA_PINC_DISABLE     0x00000000U
+#define DMA_MINC_ENABLE      DMA_CCR_MINC
+#define DMA_PDATAALIGN_BYTE  0x00000000U
+#define DMA_MDATAALIGN_BYTE  0x00000000U
+#define DMA_NORMAL           0x00000000U
+#define DMA_PRIORITY_LOW     0x00000000U
+#define DMA_IT_TC            DMA_CCR_TCIE
+#define DMA_IT_HT            DMA_CCR_HTIE
+#define DMA_IT_TE            DMA_CCR_TEIE
+
+#define HAL_DMA_ERROR_NONE   0x00U
+#define HAL_DMA_ERROR_TE     0x01U
+#define HAL_DMA_ERROR_NO_XFER 0x04U
+
+#define __HAL_DMA_GET_COUNTER(__HANDLE__) ((__HANDLE__)->Instance->CNDTR)
+
+#define __HAL_LINKDMA(__HANDLE__, __PPP_DMA_FIELD__, __DMA_HANDLE__)                              \
+    do                                                                                             \
+    {                                                                                              \
+        (__HANDLE__)->__PPP_DMA_FIELD__ = &(__DMA_HANDLE__);                                      \
+        (__DMA_HANDLE__).Parent = (__HANDLE__);                                                    \
+    } while (0)
+
+HAL_StatusTypeDef HAL_DMA_Init(DMA_HandleTypeDef* hdma);
+HAL_StatusTypeDef HAL_DMA_DeInit(DMA_HandleTypeDef* hdma);
+HAL_StatusTypeDef HAL_DMA_Start_IT(DMA_HandleTypeDef* hdma, uintptr_t SrcAddress,
+                                   uintptr_t DstAddress, uint32_t DataLength);
+HAL_StatusTypeDef HAL_DMA_Abort(DMA_HandleTypeDef* hdma);
+HAL_StatusTypeDef HAL_DMA_Abort_IT(DMA_HandleTypeDef* hdma);
+void HAL_DMA_IRQHandler(DMA_HandleTypeDef* hdma);
+
+// I2C
+
+typedef struct
+{
+    uint32_t Timing;
+    uint32_t OwnAddress1;
+    uint32_t AddressingMode;
+    uint32_t DualAddressMode;
+    uint32_t OwnAddress2;
+    uint32_t OwnAddress2Masks;
+    uint32_t GeneralCallMode;
+    uint32_t NoStretchMode;
+} I2C_InitTypeDef;
+
+typedef enum
+{
+    HAL_I2C_STATE_RESET = 0x00U,
+    HAL_I2C_STATE_READY = 0x20U,
+    HAL_I2C_STATE_BUSY = 0x24U,
+    HAL_I2C_STATE_BUSY_TX = 0x21U,
+    HAL_I2C_STATE_BUSY_RX = 0x22U,
+    HAL_I2C_STATE_LISTEN = 0x28U,
+    HAL_I2C_STATE_BUSY_TX_LISTEN = 0x29U,
+    HAL_I2C_STATE_BUSY_RX_LISTEN = 0x2AU,
+    HAL_I2C_STATE_ABORT = 0x60U,
+} HAL_I2C_StateTypeDef;
+
+typedef enum
+{
+    HAL_I2C_MODE_NONE = 0x00U,
+    HAL_I2C_MODE_MASTER = 0x10U,
+    HAL_I2C_MODE_SLAVE = 0x20U,
+    HAL_I2C_MODE_MEM = 0x40U
+} HAL_I2C_ModeTypeDef;
+
+typedef struct __I2C_HandleTypeDef
+{
+    I2C_TypeDef* Instance;
+    I2C_InitTypeDef Init;
+    uint8_t* pBuffPtr;
+    uint16_t XferSize;
+    volatile uint16_t XferCount;
+    volatile uint32_t XferOptions;
+    volatile uint32_t PreviousState;
+    DMA_HandleTypeDef* hdmatx;
+    DMA_HandleTypeDef* hdmarx;
+    HAL_LockTypeDef Lock;
+    volatile HAL_I2C_StateTypeDef State;
+    volatile HAL_I2C_ModeTypeDef Mode;
+    volatile uint32_t ErrorCode;
+    volatile uint32_t AddrEventCount;
+    HAL_StatusTypeDef (*XferISR)(struct __I2C_HandleTypeDef* hi2c, uint32_t ITFlags,
+                                 uint32_t ITSources);
+} I2C_HandleTypeDef;
+
+#define I2C_ADDRESSINGMODE_7BIT    0x00000001U
+#define I2C_ADDRESSINGMODE_10BIT   0x00000002U
+#define I2C_DUALADDRESS_DISABLE    0x00000000U
+#define I2C_DUALADDRESS_ENABLE     0x00008000U
+#define I2C_OA2_NOMASK             0x00U
+#define I2C_GENERALCALL_DISABLE    0x00000000U
+#define I2C_NOSTRETCH_DISABLE      0x00000000U
+#define I2C_ANALOGFILTER_ENABLE    0x00000000U
+
+#define I2C_FIRST_FRAME            0x00000000U
+#define I2C_NEXT_FRAME             0x01000000U
+#define I2C_FIRST_AND_LAST_FRAME   0x02000000U
+#define I2C_LAST_FRAME             0x02000000U
+#define I2C_NO_OPTION_FRAME        0xFFFF0000U
+
+#define HAL_I2C_ERROR_NONE         0x00000000U
+#define HAL_I2C_ERROR_BERR         0x00000001U
+#define HAL_I2C_ERROR_ARLO         0x00000002U
+#define HAL_I2C_ERROR_AF           0x00000004U
+#define HAL_I2C_ERROR_OVR          0x00000008U
+#define HAL_I2C_ERROR_DMA          0x00000010U
+
+#define I2C_DIRECTION_TRANSMIT     0x00U
+#define I2C_DIRECTION_RECEIVE      0x01U
+
+#define __HAL_I2C_GENERATE_NACK(__HANDLE__) ((__HANDLE__)->Instance->CR2 |= I2C_CR2_NACK)
+#define __HAL_I2C_GET_FLAG(__HANDLE__, __FLAG__)                                                  \
+    ((((__HANDLE__)->Instance->ISR) & (__FLAG__)) == (__FLAG__) ? 1U : 0U)
+
+HAL_StatusTypeDef HAL_I2C_Init(I2C_HandleTypeDef* hi2c);
+void HAL_I2C_MspInit(I2C_HandleTypeDef* hi2c);
+void HAL_I2C_MspDeInit(I2C_HandleTypeDef* hi2c);
+HAL_StatusTypeDef HAL_I2CEx_ConfigAnalogFilter(I2C_HandleTypeDef* hi2c, uint32_t AnalogFilter);
+HAL_StatusTypeDef HAL_I2CEx_ConfigDigitalFilter(I2C_HandleTypeDef* hi2c, uint32_t DigitalFilter);
+void HAL_I2CEx_EnableFastModePlus(uint32_t ConfigFastModePlus);
+void HAL_I2CEx_DisableFastModePlus(uint32_t ConfigFastModePlus);
+HAL_StatusTypeDef HAL_I2C_EnableListen_IT(I2C_HandleTypeDef* hi2c);
+HAL_StatusTypeDef HAL_I2C_DisableListen_IT(I2C_HandleTypeDef* hi2c);
+HAL_StatusTypeDef HAL_I2C_Slave_Seq_Transmit_DMA(I2C_HandleTypeDef* hi2c, uint8_t* pData,
+                                                 uint16_t Size, uint32_t XferOptions);
+HAL_StatusTypeDef HAL_I2C_Slave_Seq_Receive_DMA(I2C_HandleTypeDef* hi2c, uint8_t* pData,
+                                                uint16_t Size, uint32_t XferOptions);
+void HAL_I2C_EV_IRQHandler(I2C_HandleTypeDef* hi2c);
+void HAL_I2C_ER_IRQHandler(I2C_HandleTypeDef* hi2c);
+uint32_t HAL_I2C_GetError(I2C_HandleTypeDef* hi2c);
+HAL_I2C_StateTypeDef HAL_I2C_GetState(I2C_HandleTypeDef* hi2c);
+void HAL_I2C_AddrCallback(I2C_HandleTypeDef* hi2c, uint8_t TransferDirection,
+                          uint16_t AddrMatchCode);
+void HAL_I2C_ListenCpltCallback(I2C_HandleTypeDef* hi2c);
+void HAL_I2C_SlaveTxCpltCallback(I2C_HandleTypeDef* hi2c);
+void HAL_I2C_SlaveRxCpltCallback(I2C_HandleTypeDef* hi2c);
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef* hi2c);
+void HAL_I2C_AbortCpltCallback(I2C_HandleTypeDef* hi2c);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __STM32F0XX_HAL_H
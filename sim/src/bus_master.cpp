@@ -0,0 +1,256 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+#include "sim/bus_master.hpp"
+#include "model.hpp"
+
+namespace sim
+{
+bus_master::bus_master(I2C_TypeDef* instance, std::uint32_t speed)
+    : target_(target(instance)), bit_time_(SECOND / speed)
+{
+    target_.attach([this]() { released(); });
+}
+
+void bus_master::submit(transfer t, std::function<void(const result&)> completion)
+{
+    queue_.push_back({std::move(t), std::move(completion)});
+    if (!active_)
+    {
+        active_ = true;
+        schedule(0, [this]() { begin(); });
+    }
+}
+
+bus_master::result bus_master::execute(transfer t, picoseconds timeout)
+{
+    result r{};
+    bool done = false;
+    submit(std::move(t),
+           [&](const result& res)
+           {
+               r = res;
+               done = true;
+           });
+    if (!run_until([&]() { return done; }, timeout))
+    {
+        fail("I2C transfer timed out%s", stalled() ? ", the slave stretches the clock" : "");
+    }
+    return r;
+}
+
+void bus_master::inject_error(std::uint32_t flags)
+{
+    target_.bus_error(flags);
+    if (!active_ or (current_.completion == nullptr))
+    {
+        return;
+    }
+    // the master gives up the transfer, without generating a STOP
+    generation_++;
+    stalled_ = nullptr;
+    result_.aborted = true;
+    finish();
+}
+
+void bus_master::after(unsigned bits, std::function<void()> next)
+{
+    schedule(bits * bit_time_,
+             [this, generation = generation_, next = std::move(next)]()
+             {
+                 if (generation == generation_)
+                 {
+                     next();
+                 }
+             });
+}
+
+void bus_master::when_released(std::function<void()> next)
+{
+    if (!target_.stretching())
+    {
+        next();
+        return;
+    }
+    stalled_ = std::move(next);
+    stall_start_ = now();
+}
+
+void bus_master::released()
+{
+    if (!stalled_)
+    {
+        return;
+    }
+    // the clock is released by the CPU, the master continues in its own time
+    schedule(0,
+             [this, generation = generation_]()
+             {
+                 if (!stalled_ or target_.stretching() or (generation != generation_))
+                 {
+                     return;
+                 }
+                 stats_.stretched += now() - stall_start_;
+                 auto next = std::move(stalled_);
+                 stalled_ = nullptr;
+                 next();
+             });
+}
+
+void bus_master::begin()
+{
+    if (queue_.empty())
+    {
+        active_ = false;
+        return;
+    }
+    current_ = std::move(queue_.front());
+    queue_.pop_front();
+    result_ = {};
+    result_.start = now();
+    stats_.transfers++;
+    bool read_only = current_.t.write.empty() and (current_.t.read_size > 0);
+    after(1,
+          [this, read_only]()
+          {
+              target_.start_condition();
+              send_address(read_only);
+          });
+}
+
+void bus_master::send_address(bool read)
+{
+    after(9,
+          [this, read]()
+          {
+              result_.acknowledged = target_.address_byte(current_.t.address, read);
+              if (!result_.acknowledged)
+              {
+                  stats_.nacks++;
+                  stop();
+              }
+              else if (read)
+              {
+                  read_byte(0);
+              }
+              else
+              {
+                  write_byte(0);
+              }
+          });
+}
+
+void bus_master::write_byte(std::size_t index)
+{
+    if (index == current_.t.write.size())
+    {
+        if (current_.t.read_size == 0)
+        {
+            stop();
+            return;
+        }
+        // repeated START
+        when_released(
+            [this]()
+            {
+                after(1,
+                      [this]()
+                      {
+                          target_.start_condition();
+                          send_address(true);
+                      });
+            });
+        return;
+    }
+    when_released([this, index]() { after(8, [this, index]() { acknowledge_write(index); }); });
+}
+
+void bus_master::acknowledge_write(std::size_t index)
+{
+    auto ack = target_.receive_byte(current_.t.write[index]);
+    if (!ack)
+    {
+        when_released([this, index]() { acknowledge_write(index); });
+        return;
+    }
+    after(1,
+          [this, index, ack = *ack]()
+          {
+              if (!ack)
+              {
+                  stats_.nacks++;
+                  stop();
+                  return;
+              }
+              stats_.bytes++;
+              result_.written++;
+              write_byte(index + 1);
+          });
+}
+
+void bus_master::read_byte(std::size_t index)
+{
+    when_released(
+        [this, index]()
+        {
+            auto data = target_.transmit_byte();
+            if (!data)
+            {
+                when_released([this, index]() { read_byte(index); });
+                return;
+            }
+            after(9,
+                  [this, index, data = *data]()
+                  {
+                      stats_.bytes++;
+                      result_.read.push_back(data);
+                      // the last byte is not acknowledged
+                      bool last = (index + 1) == current_.t.read_size;
+                      target_.master_ack(!last);
+                      if (last)
+                      {
+                          stop();
+                      }
+                      else
+                      {
+                          read_byte(index + 1);
+                      }
+                  });
+        });
+}
+
+void bus_master::stop()
+{
+    // the STOP condition can't be generated while the slave holds the clock low
+    when_released(
+        [this]()
+        {
+            after(1,
+                  [this]()
+                  {
+                      target_.stop_condition();
+                      finish();
+                  });
+        });
+}
+
+void bus_master::finish()
+{
+    result_.end = now();
+    auto completion = std::move(current_.completion);
+    current_.completion = nullptr;
+    if (completion)
+    {
+        completion(result_);
+    }
+    // the bus free time before the next START
+    after(1, [this]() { begin(); });
+}
+} // namespace sim
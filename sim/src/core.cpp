@@ -0,0 +1,702 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+/// @brief  The simulated Cortex-M0 core: the timeline, the NVIC, sleep and STOP mode,
+///         SysTick, and the charging of the firmware's execution.
+#include <algorithm>
+#include <array>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <queue>
+#include <vector>
+#include "model.hpp"
+
+extern "C" void i2c_hid_idle(void);
+extern "C" int sim_firmware_main(void);
+
+extern "C" void PendSV_Handler(void);
+extern "C" void SysTick_Handler(void);
+extern "C" void EXTI0_1_IRQHandler(void);
+extern "C" void DMA1_Channel2_3_IRQHandler(void);
+extern "C" void DMA1_Channel4_5_6_7_IRQHandler(void);
+extern "C" void I2C1_IRQHandler(void);
+extern "C" void I2C2_IRQHandler(void);
+
+namespace sim
+{
+namespace
+{
+// the costs of the firmware's execution, in core clock cycles
+constexpr std::uint32_t REGISTER_ACCESS_CYCLES = 2;
+constexpr std::uint32_t FUNCTION_CALL_CYCLES = 4;
+constexpr std::uint32_t EXCEPTION_ENTRY_CYCLES = 16;
+constexpr std::uint32_t EXCEPTION_EXIT_CYCLES = 16;
+// the pipeline refill after a branch to flash code, with the flash wait state
+constexpr std::uint32_t FLASH_WAIT_STATE_CYCLES = 1;
+
+constexpr picoseconds STOP_WAKEUP_TIME = 5 * MICROSECOND;
+// the firmware must return to its idle loop in this time
+constexpr picoseconds WATCHDOG_TIMEOUT = SECOND;
+constexpr picoseconds TIME_LIMIT = 3600 * SECOND;
+// the wakeups without sleeping, that are considered an interrupt storm
+constexpr std::uint64_t MAX_IDLE_SPINS = 1'000'000;
+
+constexpr unsigned EXCEPTIONS = 16 + 32;
+constexpr std::uint32_t THREAD_PRIORITY = 1 << __NVIC_PRIO_BITS;
+
+struct event
+{
+    picoseconds time;
+    std::uint64_t sequence;
+    std::function<void()> callback;
+};
+
+struct later
+{
+    bool operator()(const event& a, const event& b) const
+    {
+        return (a.time != b.time) ? (a.time > b.time) : (a.sequence > b.sequence);
+    }
+};
+
+struct exception_state
+{
+    void (*handler)();
+    std::function<bool()> level;
+    std::uint32_t priority;
+    bool enabled;
+    bool pending;
+    bool active;
+    exception_cycles cycles;
+};
+
+struct core_state
+{
+    std::priority_queue<event, std::vector<event>, later> events{};
+    std::uint64_t sequence{};
+    picoseconds time{};
+    // the cycles are derived from the time, since the last clock change
+    picoseconds base_time{};
+    std::uint64_t base_cycles{};
+    std::uint32_t hz{HSI_VALUE};
+    bool processing{};
+    bool in_stop{};
+    bool wakeup_request{};
+    bool primask{};
+    picoseconds masked_at{};
+    bool exiting{};
+    std::vector<unsigned> active{};
+    std::array<exception_state, EXCEPTIONS> exceptions{};
+    std::uint32_t systick_reload{};
+    std::uint32_t systick_generation{};
+    const std::function<bool()>* run_condition{};
+    picoseconds run_deadline{};
+    picoseconds last_idle{};
+    std::uint64_t idle_spins{};
+    core_statistics stats{};
+    std::function<void()> error_hook{};
+};
+
+// never destroyed, the firmware keeps running into the static destructors
+core_state& state()
+{
+    static core_state& s = *new core_state();
+    return s;
+}
+
+exception_state& exception(IRQn_Type irq)
+{
+    return state().exceptions[16 + irq];
+}
+
+using u128 = unsigned __int128;
+
+void process_events()
+{
+    auto& s = state();
+    if (s.processing)
+    {
+        return;
+    }
+    s.processing = true;
+    auto cpu_time = s.time;
+    while (!s.events.empty() and (s.events.top().time <= cpu_time))
+    {
+        auto ev = std::move(const_cast<event&>(s.events.top()));
+        s.events.pop();
+        s.time = ev.time;
+        ev.callback();
+    }
+    s.time = cpu_time;
+    s.processing = false;
+}
+
+std::uint32_t current_priority()
+{
+    auto& s = state();
+    auto priority = THREAD_PRIORITY;
+    for (auto n : s.active)
+    {
+        priority = std::min(priority, s.exceptions[n].priority);
+    }
+    return priority;
+}
+
+/// @return the exception number to take, or 0 if none preempts the current priority
+unsigned next_pending()
+{
+    auto& s = state();
+    unsigned next = 0;
+    auto priority = current_priority();
+    for (unsigned n = 0; n < EXCEPTIONS; n++)
+    {
+        auto& e = s.exceptions[n];
+        if (e.pending and e.enabled and (e.priority < priority))
+        {
+            next = n;
+            priority = e.priority;
+        }
+    }
+    return next;
+}
+
+void take(unsigned n)
+{
+    auto& s = state();
+    auto& e = s.exceptions[n];
+    if (e.handler == nullptr)
+    {
+        fail("exception %u has no handler", n);
+    }
+    e.pending = false;
+    e.active = true;
+    s.active.push_back(n);
+    s.stats.exceptions++;
+    auto start = cycles();
+    charge(EXCEPTION_ENTRY_CYCLES);
+    e.handler();
+    charge(EXCEPTION_EXIT_CYCLES);
+    s.active.pop_back();
+    e.active = false;
+    auto spent = cycles() - start;
+    e.cycles.count++;
+    e.cycles.total += spent;
+    e.cycles.max = std::max(e.cycles.max, spent);
+    // a level sensitive request that is still asserted is pending again
+    if (e.level and e.level())
+    {
+        e.pending = true;
+    }
+}
+
+void rebase()
+{
+    auto& s = state();
+    s.base_cycles = cycles();
+    s.base_time = s.time;
+}
+
+bool run_condition_met()
+{
+    auto& s = state();
+    return (s.run_condition != nullptr) and
+           ((s.time >= s.run_deadline) or (*s.run_condition)());
+}
+
+void check_time_limit()
+{
+    auto& s = state();
+    if (s.time > TIME_LIMIT)
+    {
+        fail("the simulation time limit is reached");
+    }
+}
+
+/// @brief Sleeps until an interrupt is pending, or the running condition is met.
+void masked_window_end()
+{
+    auto& s = state();
+    s.stats.max_masked_time = std::max(s.stats.max_masked_time, s.time - s.masked_at);
+}
+
+void sleep(bool stop_mode)
+{
+    auto& s = state();
+    charge(1);
+    s.last_idle = s.time;
+    if (next_pending() != 0)
+    {
+        if (++s.idle_spins > MAX_IDLE_SPINS)
+        {
+            fail("interrupt storm, the firmware doesn't get to sleep");
+        }
+        dispatch();
+        return;
+    }
+    s.idle_spins = 0;
+    if (s.primask)
+    {
+        masked_window_end();
+    }
+    if (stop_mode)
+    {
+        rebase();
+        s.in_stop = true;
+        s.wakeup_request = false;
+        s.stats.stop_entries++;
+    }
+    while ((next_pending() == 0) and !s.wakeup_request and !run_condition_met())
+    {
+        if (s.events.empty() and (s.run_condition == nullptr))
+        {
+            fail("deadlock, the firmware sleeps with nothing left to happen");
+        }
+        auto next = s.events.empty() ? s.run_deadline : s.events.top().time;
+        if (s.run_condition != nullptr)
+        {
+            next = std::min(next, s.run_deadline);
+        }
+        s.time = std::max(s.time, next);
+        check_time_limit();
+        process_events();
+    }
+    if (stop_mode)
+    {
+        s.wakeup_request = false;
+        s.time += STOP_WAKEUP_TIME;
+        process_events();
+        rcc_stop_mode_exit();
+        s.base_time = s.time;
+        s.in_stop = false;
+    }
+    s.last_idle = s.time;
+    s.masked_at = s.time;
+    dispatch();
+}
+
+void schedule_systick()
+{
+    auto& s = state();
+    auto generation = s.systick_generation;
+    picoseconds period = u128(s.systick_reload) * SECOND / s.hz;
+    schedule(period,
+             [generation]()
+             {
+                 auto& s = state();
+                 if (generation != s.systick_generation)
+                 {
+                     return;
+                 }
+                 // the core clock is stopped in STOP mode
+                 if (!s.in_stop)
+                 {
+                     exception(SysTick_IRQn).pending = true;
+                 }
+                 schedule_systick();
+             });
+}
+} // namespace
+
+picoseconds now()
+{
+    return state().time;
+}
+
+std::uint64_t cycles()
+{
+    auto& s = state();
+    if (s.in_stop or (s.time < s.base_time))
+    {
+        return s.base_cycles;
+    }
+    return s.base_cycles + static_cast<std::uint64_t>(u128(s.time - s.base_time) * s.hz / SECOND);
+}
+
+std::uint32_t core_clock()
+{
+    return state().hz;
+}
+
+void charge(std::uint32_t n)
+{
+    auto& s = state();
+    if (s.processing or s.in_stop)
+    {
+        return;
+    }
+    auto target = cycles() + n - s.base_cycles;
+    s.time = s.base_time + static_cast<picoseconds>((u128(target) * SECOND + s.hz - 1) / s.hz);
+    if ((s.time - s.last_idle) > WATCHDOG_TIMEOUT)
+    {
+        fail("the firmware didn't return to its idle loop in a second");
+    }
+    check_time_limit();
+    process_events();
+}
+
+void dispatch()
+{
+    auto& s = state();
+    if (s.processing or s.in_stop or s.exiting)
+    {
+        return;
+    }
+    while (!s.primask)
+    {
+        auto n = next_pending();
+        if (n == 0)
+        {
+            return;
+        }
+        take(n);
+    }
+}
+
+void update_interrupts()
+{
+    for (auto& e : state().exceptions)
+    {
+        if (e.level and !e.active and e.level())
+        {
+            e.pending = true;
+        }
+    }
+}
+
+void connect_interrupt(IRQn_Type irq, std::function<bool()> level)
+{
+    exception(irq).level = std::move(level);
+}
+
+void set_pending(IRQn_Type irq)
+{
+    exception(irq).pending = true;
+}
+
+void set_core_clock(std::uint32_t hz)
+{
+    rebase();
+    state().hz = hz;
+}
+
+bool stopped()
+{
+    return state().in_stop;
+}
+
+void stop_wakeup()
+{
+    state().wakeup_request = true;
+}
+
+void systick_config(std::uint32_t reload)
+{
+    auto& s = state();
+    s.systick_reload = reload;
+    s.systick_generation++;
+    schedule_systick();
+}
+
+void enter_stop()
+{
+    sleep(true);
+}
+
+bool run_until(const std::function<bool()>& condition, picoseconds timeout)
+{
+    auto& s = state();
+    auto* outer_condition = s.run_condition;
+    auto outer_deadline = s.run_deadline;
+    s.run_condition = &condition;
+    s.run_deadline = s.time + timeout;
+    while (!condition() and (s.time < s.run_deadline))
+    {
+        i2c_hid_idle();
+    }
+    s.run_condition = outer_condition;
+    s.run_deadline = outer_deadline;
+    return condition();
+}
+
+void run_for(picoseconds duration)
+{
+    run_until([]() { return false; }, duration);
+}
+
+void execute(std::uint32_t n)
+{
+    charge(n);
+    dispatch();
+}
+
+void schedule(picoseconds delay, std::function<void()> callback)
+{
+    auto& s = state();
+    s.events.push({now() + delay, s.sequence++, std::move(callback)});
+}
+
+void connect_handler(IRQn_Type irq, void (*handler)())
+{
+    auto& e = exception(irq);
+    if (e.handler != nullptr)
+    {
+        fail("the handler of interrupt %d is already connected", irq);
+    }
+    e.handler = handler;
+}
+
+void trigger_interrupt(IRQn_Type irq)
+{
+    set_pending(irq);
+}
+
+const core_statistics& statistics()
+{
+    return state().stats;
+}
+
+void clear_statistics()
+{
+    state().stats = {};
+}
+
+exception_cycles handler_cycles(IRQn_Type irq)
+{
+    return exception(irq).cycles;
+}
+
+void clear_handler_cycles()
+{
+    for (auto& e : state().exceptions)
+    {
+        e.cycles = {};
+    }
+}
+
+void on_error_handler(std::function<void()> hook)
+{
+    state().error_hook = std::move(hook);
+}
+
+void fail(const char* format, ...)
+{
+    std::fflush(stdout);
+    std::va_list args;
+    va_start(args, format);
+    std::fprintf(stderr, "simulation failed at %.3f us: ",
+                 static_cast<double>(state().time) / MICROSECOND);
+    std::vfprintf(stderr, format, args);
+    std::fputc('\n', stderr);
+    va_end(args);
+    std::_Exit(EXIT_FAILURE);
+}
+} // namespace sim
+
+using namespace sim;
+
+// the register proxies of the HAL header
+
+template <typename T>
+sim_register<T>::operator T() const volatile
+{
+    charge(REGISTER_ACCESS_CYCLES);
+    auto value = static_cast<T>(peripheral_read(this));
+    dispatch();
+    return value;
+}
+
+template <typename T>
+void sim_register<T>::operator=(T v) volatile
+{
+    charge(REGISTER_ACCESS_CYCLES);
+    peripheral_write(this, v);
+    dispatch();
+}
+
+template struct sim_register<uint32_t>;
+#if UINTPTR_MAX != UINT32_MAX
+template struct sim_register<uintptr_t>;
+#endif
+
+// the CMSIS core functions
+
+extern "C" void __enable_irq(void)
+{
+    charge(1);
+    if (state().primask)
+    {
+        masked_window_end();
+    }
+    state().primask = false;
+    dispatch();
+}
+
+extern "C" void __disable_irq(void)
+{
+    charge(1);
+    if (!state().primask)
+    {
+        state().masked_at = state().time;
+    }
+    state().primask = true;
+}
+
+extern "C" uint32_t __get_PRIMASK(void)
+{
+    charge(1);
+    return state().primask;
+}
+
+extern "C" void __WFI(void)
+{
+    sleep(false);
+}
+
+extern "C" void NVIC_SetPriority(IRQn_Type IRQn, uint32_t priority)
+{
+    charge(REGISTER_ACCESS_CYCLES);
+    exception(IRQn).priority = priority & (THREAD_PRIORITY - 1);
+    dispatch();
+}
+
+extern "C" uint32_t NVIC_GetPriority(IRQn_Type IRQn)
+{
+    charge(REGISTER_ACCESS_CYCLES);
+    return exception(IRQn).priority;
+}
+
+extern "C" void NVIC_EnableIRQ(IRQn_Type IRQn)
+{
+    charge(REGISTER_ACCESS_CYCLES);
+    exception(IRQn).enabled = true;
+    update_interrupts();
+    dispatch();
+}
+
+extern "C" void NVIC_DisableIRQ(IRQn_Type IRQn)
+{
+    charge(REGISTER_ACCESS_CYCLES);
+    exception(IRQn).enabled = false;
+}
+
+extern "C" void NVIC_SetPendingIRQ(IRQn_Type IRQn)
+{
+    charge(REGISTER_ACCESS_CYCLES);
+    exception(IRQn).pending = true;
+    dispatch();
+}
+
+extern "C" void NVIC_ClearPendingIRQ(IRQn_Type IRQn)
+{
+    charge(REGISTER_ACCESS_CYCLES);
+    exception(IRQn).pending = false;
+}
+
+// the handlers, that the simulated firmware defines
+
+static void connect_handlers()
+{
+    auto& s = state();
+    s.exceptions[16 + PendSV_IRQn].handler = PendSV_Handler;
+    s.exceptions[16 + SysTick_IRQn].handler = SysTick_Handler;
+    s.exceptions[16 + EXTI0_1_IRQn].handler = EXTI0_1_IRQHandler;
+    s.exceptions[16 + DMA1_Channel2_3_IRQn].handler = DMA1_Channel2_3_IRQHandler;
+    s.exceptions[16 + DMA1_Channel4_5_6_7_IRQn].handler = DMA1_Channel4_5_6_7_IRQHandler;
+    s.exceptions[16 + I2C1_IRQn].handler = I2C1_IRQHandler;
+    s.exceptions[16 + I2C2_IRQn].handler = I2C2_IRQHandler;
+    // the system exceptions can't be disabled
+    for (unsigned n = 0; n < 16; n++)
+    {
+        s.exceptions[n].enabled = true;
+    }
+}
+
+extern "C" void Error_Handler(void)
+{
+    auto& s = state();
+    s.stats.error_handlers++;
+    if (s.error_hook)
+    {
+        s.error_hook();
+    }
+    fail("Error_Handler() was called");
+}
+
+// the stack area, painted like the startup code does
+static constexpr std::size_t STACK_WORDS = 1024;
+extern "C" alignas(8) uint32_t sim_stack_bottom[STACK_WORDS];
+alignas(8) uint32_t sim_stack_bottom[STACK_WORDS];
+__asm__(".globl sim_stack_top\n"
+        ".set sim_stack_top, sim_stack_bottom + 4096\n");
+static_assert(STACK_WORDS * sizeof(uint32_t) == 4096);
+extern "C" uint32_t sim_stack_top[];
+
+// the vector table is only copied, the RAM code region is placed by ramfunc.ld
+extern "C" const uint32_t g_pfnVectors[48];
+const uint32_t g_pfnVectors[48]{};
+
+uint32_t* sim::stack_bottom()
+{
+    return sim_stack_bottom;
+}
+
+uint32_t* sim::stack_top()
+{
+    return sim_stack_top;
+}
+
+// the function calls of the instrumented sources
+
+// the generated Error_Handler() of main.c is renamed, as it halts in an endless loop
+extern "C" void cubemx_error_handler(void);
+
+// the functions of .RamFunc, that are executed from SRAM without wait states
+extern "C" const uint8_t sim_ramfunc_start[];
+extern "C" const uint8_t sim_ramfunc_end[];
+
+static __attribute__((no_instrument_function)) std::uint32_t flash_wait_cycles(const void* address)
+{
+    auto* code = static_cast<const uint8_t*>(address);
+    if (((sim_flash.ACR.value & FLASH_ACR_LATENCY) == 0) or
+        ((code >= sim_ramfunc_start) and (code < sim_ramfunc_end)))
+    {
+        return 0;
+    }
+    return FLASH_WAIT_STATE_CYCLES;
+}
+
+extern "C" __attribute__((no_instrument_function)) void __cyg_profile_func_enter(void* fn,
+                                                                                 void* call_site)
+{
+    auto& s = state();
+    if (fn == reinterpret_cast<void*>(cubemx_error_handler))
+    {
+        Error_Handler();
+    }
+    if (s.processing or s.exiting)
+    {
+        return;
+    }
+    // both the call and the return branch to the code at the addresses
+    charge(FUNCTION_CALL_CYCLES + flash_wait_cycles(fn) + flash_wait_cycles(call_site));
+    dispatch();
+}
+
+extern "C" __attribute__((no_instrument_function)) void __cyg_profile_func_exit(void*, void*) {}
+
+int main()
+{
+    std::fill(std::begin(sim_stack_bottom), std::end(sim_stack_bottom), 0xC5C5C5C5);
+    std::atexit([]() { state().exiting = true; });
+    connect_handlers();
+    init_peripherals();
+    return sim_firmware_main();
+}
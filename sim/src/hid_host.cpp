@@ -0,0 +1,204 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+#include "sim/hid_host.hpp"
+#include <algorithm>
+
+namespace sim
+{
+namespace
+{
+enum opcode : std::uint8_t
+{
+    RESET = 0x1,
+    GET_REPORT = 0x2,
+    SET_REPORT = 0x3,
+    SET_POWER = 0x8,
+};
+
+void append16(std::vector<std::uint8_t>& v, std::uint16_t value)
+{
+    v.push_back(value & 0xFF);
+    v.push_back(value >> 8);
+}
+
+std::uint16_t get16(const std::vector<std::uint8_t>& v, std::size_t offset)
+{
+    return v[offset] | (v[offset + 1] << 8);
+}
+} // namespace
+
+hid_host::hid_host(bus_master& bus, std::uint8_t address, std::uint16_t hid_descriptor_register,
+                   GPIO_TypeDef* interrupt_port, std::uint16_t interrupt_pin)
+    : bus_(bus), address_(address), hid_descriptor_register_(hid_descriptor_register),
+      interrupt_port_(interrupt_port), interrupt_pin_(interrupt_pin)
+{
+    watch_output(interrupt_port_, interrupt_pin_, [this](bool level) { interrupt_changed(level); });
+}
+
+void hid_host::connect()
+{
+    std::vector<std::uint8_t> reg;
+    append16(reg, hid_descriptor_register_);
+    auto r = bus_.execute({address_, reg, 30});
+    if (!r.acknowledged or (r.read.size() != 30) or (get16(r.read, 0) != 30))
+    {
+        fail("the HID descriptor can't be read");
+    }
+    auto* fields = reinterpret_cast<std::uint16_t*>(&descriptor_);
+    for (std::size_t i = 0; i < sizeof(descriptor_) / sizeof(std::uint16_t); i++)
+    {
+        fields[i] = get16(r.read, 2 * i);
+    }
+    connected_ = true;
+    if (!reset())
+    {
+        fail("the device didn't complete the reset");
+    }
+}
+
+std::vector<std::uint8_t> hid_host::read_report_descriptor()
+{
+    std::vector<std::uint8_t> reg;
+    append16(reg, descriptor_.wReportDescRegister);
+    return bus_.execute({address_, reg, descriptor_.wReportDescLength}).read;
+}
+
+std::vector<std::uint8_t> hid_host::command(std::uint8_t opcode, report_type type,
+                                            std::uint8_t id)
+{
+    std::vector<std::uint8_t> data;
+    append16(data, descriptor_.wCommandRegister);
+    data.push_back((static_cast<std::uint8_t>(type) << 4) | (id & 0xF));
+    data.push_back(opcode);
+    return data;
+}
+
+bool hid_host::reset(picoseconds timeout)
+{
+    reset_done_ = false;
+    auto r = bus_.execute({address_, command(RESET, {}, 0), 0});
+    if (r.written != 4)
+    {
+        return false;
+    }
+    // the line may have been asserted already
+    read_input();
+    return run_until([this]() { return reset_done_; }, timeout);
+}
+
+std::vector<std::uint8_t> hid_host::get_report(report_type type, std::uint8_t id,
+                                               std::size_t size)
+{
+    auto data = command(GET_REPORT, type, id);
+    append16(data, descriptor_.wDataRegister);
+    auto r = bus_.execute({address_, data, size ? (2 + size) : descriptor_.wMaxInputLength});
+    if ((r.read.size() < 2) or (get16(r.read, 0) <= 2) or (get16(r.read, 0) > r.read.size()))
+    {
+        return {};
+    }
+    return {r.read.begin() + 2, r.read.begin() + get16(r.read, 0)};
+}
+
+bool hid_host::set_report(report_type type, std::span<const std::uint8_t> report)
+{
+    auto data = command(SET_REPORT, type, report.empty() ? 0 : report[0]);
+    append16(data, descriptor_.wDataRegister);
+    append16(data, 2 + report.size());
+    data.insert(data.end(), report.begin(), report.end());
+    auto size = data.size();
+    return bus_.execute({address_, std::move(data), 0}).written == size;
+}
+
+bool hid_host::output_report(std::span<const std::uint8_t> report)
+{
+    std::vector<std::uint8_t> data;
+    append16(data, descriptor_.wOutputRegister);
+    append16(data, 2 + report.size());
+    data.insert(data.end(), report.begin(), report.end());
+    auto size = data.size();
+    return bus_.execute({address_, std::move(data), 0}).written == size;
+}
+
+bool hid_host::set_power(bool on)
+{
+    auto data = command(SET_POWER, {}, 0);
+    data[2] = on ? 0 : 1;
+    return bus_.execute({address_, data, 0}).written == data.size();
+}
+
+void hid_host::interrupt_changed(bool level)
+{
+    // active low
+    if (!level)
+    {
+        asserted_at_ = now();
+        read_input();
+    }
+}
+
+void hid_host::read_input()
+{
+    if (!connected_ or reading_ or !interrupt_asserted())
+    {
+        return;
+    }
+    reading_ = true;
+    schedule(response_delay_,
+             [this]()
+             {
+                 // the level is sampled again when the host gets to serve it
+                 if (!interrupt_asserted())
+                 {
+                     reading_ = false;
+                     return;
+                 }
+                 bus_.submit({address_, {}, descriptor_.wMaxInputLength},
+                             [this](const bus_master::result& r) { input_read(r); });
+             });
+}
+
+void hid_host::input_read(const bus_master::result& r)
+{
+    reading_ = false;
+    if (!r.aborted and (r.read.size() >= 2))
+    {
+        auto length = get16(r.read, 0);
+        if (length == 0)
+        {
+            // the completion of a reset, or a spurious read
+            if (!reset_done_)
+            {
+                reset_done_ = true;
+            }
+            else
+            {
+                stats_.empty_reads++;
+            }
+        }
+        else if ((length > 2) and (length <= r.read.size()))
+        {
+            stats_.inputs++;
+            stats_.input_bytes += length - 2;
+            stats_.max_response = std::max(stats_.max_response, r.start - asserted_at_);
+            if (input_handler_)
+            {
+                input_handler_({r.read.data() + 2, length - 2u});
+            }
+        }
+    }
+    // the line stays asserted while there are more reports
+    if (interrupt_asserted())
+    {
+        asserted_at_ = now();
+        read_input();
+    }
+}
+} // namespace sim
@@ -0,0 +1,107 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+/// @brief  The interface between the simulated core and the peripheral models.
+#ifndef __SIM_MODEL_HPP_
+#define __SIM_MODEL_HPP_
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include "sim/sim.hpp"
+
+namespace sim
+{
+/// @brief A peripheral, that owns a range of the register address space.
+///        The models keep the value member of their registers up to date,
+///        as the C sources of the firmware read them directly.
+class peripheral_model
+{
+  public:
+    virtual std::uintptr_t read(const volatile void* reg) = 0;
+    virtual void write(volatile void* reg, std::uintptr_t value) = 0;
+
+  protected:
+    void map(volatile void* base, std::size_t size);
+    ~peripheral_model() = default;
+};
+
+/// @brief Accesses a register through its model, without charging the CPU, for the DMA.
+std::uintptr_t peripheral_read(const volatile void* reg);
+void peripheral_write(volatile void* reg, std::uintptr_t value);
+
+/// @brief Constructs the peripheral models, and resets the registers.
+void init_peripherals();
+
+// the core, see core.cpp
+
+/// @brief Advances the time with the execution of CPU cycles, and processes the due events.
+void charge(std::uint32_t cycles);
+
+/// @brief Enters the pending interrupts that preempt the current execution priority.
+void dispatch();
+
+/// @brief Samples the interrupt request lines of the peripherals, to be called
+///        whenever a model changed its request state.
+void update_interrupts();
+
+/// @brief Sets the level sensitive interrupt request line of a peripheral.
+void connect_interrupt(IRQn_Type irq, std::function<bool()> level);
+
+void set_pending(IRQn_Type irq);
+
+/// @brief Changes the rate of the core clock, following the system clock switch.
+void set_core_clock(std::uint32_t hz);
+
+/// @brief Whether the MCU is in STOP mode, with the clocks stopped.
+bool stopped();
+
+/// @brief A wakeup capable peripheral requests the exit from STOP mode.
+void stop_wakeup();
+
+/// @brief Restarts the SysTick timer with a reload value in core clock cycles.
+void systick_config(std::uint32_t reload);
+
+void enter_stop();
+
+// the peripherals, see peripherals.cpp
+
+/// @brief The EXTI line of a pin is connected to the selected port.
+void exti_select(unsigned line, GPIO_TypeDef* port);
+
+/// @brief The RCC switches to HSI, and stops the 48 MHz oscillators at STOP mode exit.
+void rcc_stop_mode_exit();
+
+/// @brief The I2C peripheral model on the slave side of a bus.
+class i2c_target
+{
+  public:
+    virtual void start_condition() = 0;
+    /// @return true if the address is acknowledged
+    virtual bool address_byte(std::uint8_t address, bool read) = 0;
+    /// @return the transmitted byte, or nothing while the clock is stretched
+    virtual std::optional<std::uint8_t> transmit_byte() = 0;
+    virtual void master_ack(bool ack) = 0;
+    /// @return the acknowledge of the byte, or nothing while the clock is stretched
+    virtual std::optional<bool> receive_byte(std::uint8_t data) = 0;
+    virtual bool stretching() const = 0;
+    virtual void stop_condition() = 0;
+    virtual void bus_error(std::uint32_t flags) = 0;
+    /// @brief The callback is invoked when the peripheral releases the stretched clock.
+    virtual void attach(std::function<void()> released) = 0;
+
+  protected:
+    ~i2c_target() = default;
+};
+
+i2c_target& target(I2C_TypeDef* instance);
+} // namespace sim
+
+#endif // __SIM_MODEL_HPP_
@@ -0,0 +1,1039 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+/// @brief  The peripheral models: I2C slave, DMA, GPIO with EXTI, RCC, FLASH, TIM2 and SCB.
+///         Only the behavior that the firmware relies on is modelled.
+#include <array>
+#include <vector>
+#include "model.hpp"
+
+I2C_TypeDef sim_i2c1, sim_i2c2;
+DMA_Channel_TypeDef sim_dma1_channel[7];
+DMA_TypeDef sim_dma1;
+GPIO_TypeDef sim_gpioa, sim_gpiob, sim_gpioc;
+RCC_TypeDef sim_rcc;
+FLASH_TypeDef sim_flash;
+TIM_TypeDef sim_tim2;
+SCB_Type sim_scb;
+SYSCFG_TypeDef sim_syscfg;
+EXTI_TypeDef sim_exti;
+
+namespace sim
+{
+namespace
+{
+struct region
+{
+    std::uintptr_t begin;
+    std::uintptr_t end;
+    peripheral_model* model;
+};
+
+std::vector<region>& regions()
+{
+    static auto& r = *new std::vector<region>();
+    return r;
+}
+
+peripheral_model& find(const volatile void* reg)
+{
+    auto address = reinterpret_cast<std::uintptr_t>(reg);
+    for (auto& r : regions())
+    {
+        if ((address >= r.begin) and (address < r.end))
+        {
+            return *r.model;
+        }
+    }
+    fail("access of an unmodelled register at %p", const_cast<const void*>(reg));
+}
+
+clock_fault active_fault = clock_fault::NONE;
+
+/// @brief Registers that read back what was written.
+class memory_model : public peripheral_model
+{
+  public:
+    template <typename T>
+    memory_model(T& regs)
+    {
+        map(&regs, sizeof(T));
+    }
+
+    std::uintptr_t read(const volatile void* reg) override
+    {
+        return static_cast<const volatile sim_reg32*>(reg)->value;
+    }
+
+    void write(volatile void* reg, std::uintptr_t value) override
+    {
+        static_cast<volatile sim_reg32*>(reg)->value = value;
+    }
+};
+
+class flash_model : public memory_model
+{
+  public:
+    flash_model() : memory_model(sim_flash) {}
+
+    void write(volatile void* reg, std::uintptr_t value) override
+    {
+        if ((reg == &sim_flash.ACR) and (active_fault == clock_fault::FLASH_LATENCY))
+        {
+            value = (value & ~FLASH_ACR_LATENCY) | (sim_flash.ACR.value & FLASH_ACR_LATENCY);
+        }
+        memory_model::write(reg, value);
+    }
+};
+
+class scb_model : public memory_model
+{
+  public:
+    scb_model() : memory_model(sim_scb) {}
+
+    void write(volatile void* reg, std::uintptr_t value) override
+    {
+        if (reg == &sim_scb.ICSR)
+        {
+            if (value & SCB_ICSR_PENDSVSET_Msk)
+            {
+                set_pending(PendSV_IRQn);
+            }
+            return;
+        }
+        memory_model::write(reg, value);
+    }
+};
+
+/// @brief The counter of TIM2, clocked by the core clock without prescaling.
+class tim_model : public memory_model
+{
+  public:
+    tim_model() : memory_model(sim_tim2) {}
+
+    std::uintptr_t read(const volatile void* reg) override
+    {
+        if ((reg == &sim_tim2.CNT) and (sim_tim2.CR1.value & TIM_CR1_CEN))
+        {
+            sim_tim2.CNT.value = static_cast<std::uint32_t>(cycles() - offset_);
+        }
+        return memory_model::read(reg);
+    }
+
+    void write(volatile void* reg, std::uintptr_t value) override
+    {
+        if (reg == &sim_tim2.EGR)
+        {
+            if (value & TIM_EGR_UG)
+            {
+                offset_ = cycles();
+                sim_tim2.CNT.value = 0;
+            }
+            return;
+        }
+        if (reg == &sim_tim2.CR1)
+        {
+            if ((value & TIM_CR1_CEN) and !(sim_tim2.CR1.value & TIM_CR1_CEN))
+            {
+                offset_ = cycles() - sim_tim2.CNT.value;
+            }
+            else if (!(value & TIM_CR1_CEN) and (sim_tim2.CR1.value & TIM_CR1_CEN))
+            {
+                sim_tim2.CNT.value = static_cast<std::uint32_t>(cycles() - offset_);
+            }
+        }
+        if (reg == &sim_tim2.CNT)
+        {
+            offset_ = cycles() - static_cast<std::uint32_t>(value);
+        }
+        memory_model::write(reg, value);
+    }
+
+  private:
+    std::uint64_t offset_{};
+};
+
+/// @brief The system clock sources, with the start up times of the oscillators.
+class rcc_model : public memory_model
+{
+  public:
+    static constexpr picoseconds PLL_LOCK_TIME = 200 * MICROSECOND;
+    static constexpr picoseconds HSI48_STARTUP_TIME = 6 * MICROSECOND;
+
+    rcc_model() : memory_model(sim_rcc) { sim_rcc.CR.value = RCC_CR_HSION | RCC_CR_HSIRDY; }
+
+    void write(volatile void* reg, std::uintptr_t value) override
+    {
+        if (reg == &sim_rcc.CR)
+        {
+            auto old = sim_rcc.CR.value;
+            constexpr std::uint32_t READ_ONLY = RCC_CR_HSIRDY | RCC_CR_PLLRDY;
+            sim_rcc.CR.value = (value & ~READ_ONLY) | (old & READ_ONLY);
+            if ((value & RCC_CR_PLLON) and !(old & RCC_CR_PLLON))
+            {
+                start(pll_generation_, RCC_CR_PLLON, PLL_LOCK_TIME,
+                      active_fault == clock_fault::PLL_LOCK);
+            }
+            else if (!(value & RCC_CR_PLLON) and (old & RCC_CR_PLLON))
+            {
+                if (source_selected(RCC_CFGR_SWS_PLL))
+                {
+                    // the system clock source can't be stopped
+                    sim_rcc.CR.value |= RCC_CR_PLLON;
+                }
+                else
+                {
+                    pll_generation_++;
+                    sim_rcc.CR.value &= ~RCC_CR_PLLRDY;
+                }
+            }
+            return;
+        }
+        if (reg == &sim_rcc.CR2)
+        {
+            auto old = sim_rcc.CR2.value;
+            sim_rcc.CR2.value = (value & ~RCC_CR2_HSI48RDY) | (old & RCC_CR2_HSI48RDY);
+            if ((value & RCC_CR2_HSI48ON) and !(old & RCC_CR2_HSI48ON))
+            {
+                start(hsi48_generation_, RCC_CR2_HSI48ON, HSI48_STARTUP_TIME,
+                      active_fault == clock_fault::HSI48_READY);
+            }
+            else if (!(value & RCC_CR2_HSI48ON) and (old & RCC_CR2_HSI48ON))
+            {
+                if (source_selected(RCC_CFGR_SWS_HSI48))
+                {
+                    sim_rcc.CR2.value |= RCC_CR2_HSI48ON;
+                }
+                else
+                {
+                    hsi48_generation_++;
+                    sim_rcc.CR2.value &= ~RCC_CR2_HSI48RDY;
+                }
+            }
+            return;
+        }
+        if (reg == &sim_rcc.CFGR)
+        {
+            sim_rcc.CFGR.value = (value & ~RCC_CFGR_SWS) | (sim_rcc.CFGR.value & RCC_CFGR_SWS);
+            switch_clock();
+            return;
+        }
+        memory_model::write(reg, value);
+    }
+
+    void stop_mode_exit()
+    {
+        pll_generation_++;
+        hsi48_generation_++;
+        sim_rcc.CFGR.value &= ~(RCC_CFGR_SW | RCC_CFGR_SWS);
+        sim_rcc.CR.value &= ~(RCC_CR_PLLON | RCC_CR_PLLRDY);
+        sim_rcc.CR2.value &= ~(RCC_CR2_HSI48ON | RCC_CR2_HSI48RDY);
+        set_core_clock(HSI_VALUE);
+    }
+
+  private:
+    static bool source_selected(std::uint32_t sws)
+    {
+        return (sim_rcc.CFGR.value & RCC_CFGR_SWS) == sws;
+    }
+
+    void start(unsigned& generation, std::uint32_t on_bit, picoseconds startup, bool faulty)
+    {
+        auto gen = ++generation;
+        if (faulty)
+        {
+            return;
+        }
+        schedule(startup,
+                 [this, &generation, gen, on_bit]()
+                 {
+                     if (gen != generation)
+                     {
+                         return;
+                     }
+                     if (on_bit == RCC_CR_PLLON)
+                     {
+                         sim_rcc.CR.value |= RCC_CR_PLLRDY;
+                     }
+                     else
+                     {
+                         sim_rcc.CR2.value |= RCC_CR2_HSI48RDY;
+                     }
+                     switch_clock();
+                 });
+    }
+
+    static std::uint32_t pll_frequency()
+    {
+        auto cfgr = sim_rcc.CFGR.value;
+        auto mul = std::min<std::uint32_t>(((cfgr & RCC_CFGR_PLLMUL) >> 18) + 2, 16);
+        auto prediv = (sim_rcc.CFGR2.value & 0xF) + 1;
+        switch ((cfgr & RCC_CFGR_PLLSRC) >> 15)
+        {
+        case 0:
+            return HSI_VALUE / 2 * mul;
+        case 3:
+            return HSI48_VALUE / prediv * mul;
+        default:
+            return HSI_VALUE / prediv * mul;
+        }
+    }
+
+    /// @brief The switch to the selected source takes place once it's ready.
+    void switch_clock()
+    {
+        auto sw = sim_rcc.CFGR.value & RCC_CFGR_SW;
+        std::uint32_t hz = HSI_VALUE;
+        bool ready = true;
+        if (sw == RCC_CFGR_SW_PLL)
+        {
+            ready = sim_rcc.CR.value & RCC_CR_PLLRDY;
+            hz = pll_frequency();
+        }
+        else if (sw == RCC_CFGR_SW_HSI48)
+        {
+            ready = sim_rcc.CR2.value & RCC_CR2_HSI48RDY;
+            hz = HSI48_VALUE;
+        }
+        if ((sw != RCC_CFGR_SW_HSI) and (active_fault == clock_fault::CLOCK_SWITCH))
+        {
+            ready = false;
+        }
+        if (!ready or source_selected(sw << 2))
+        {
+            return;
+        }
+        sim_rcc.CFGR.value = (sim_rcc.CFGR.value & ~RCC_CFGR_SWS) | (sw << 2);
+        set_core_clock(hz);
+    }
+
+    unsigned pll_generation_{};
+    unsigned hsi48_generation_{};
+};
+
+class exti_model : public memory_model
+{
+  public:
+    exti_model() : memory_model(sim_exti)
+    {
+        connect_interrupt(EXTI0_1_IRQn, []()
+                          { return (sim_exti.PR.value & sim_exti.IMR.value & 0x3) != 0; });
+    }
+
+    void write(volatile void* reg, std::uintptr_t value) override
+    {
+        if (reg == &sim_exti.PR)
+        {
+            sim_exti.PR.value &= ~value;
+            return;
+        }
+        memory_model::write(reg, value);
+        update_interrupts();
+    }
+
+    void select(unsigned line, GPIO_TypeDef* port) { ports_[line] = port; }
+
+    void edge(GPIO_TypeDef* port, unsigned line, bool rising)
+    {
+        std::uint32_t bit = 1 << line;
+        auto trigger = rising ? sim_exti.RTSR.value : sim_exti.FTSR.value;
+        if ((ports_[line] != port) or !(trigger & bit) or !(sim_exti.IMR.value & bit))
+        {
+            return;
+        }
+        sim_exti.PR.value |= bit;
+        update_interrupts();
+    }
+
+  private:
+    std::array<GPIO_TypeDef*, 16> ports_{};
+};
+
+class gpio_model : public memory_model
+{
+  public:
+    gpio_model(GPIO_TypeDef& regs, exti_model& exti)
+        : memory_model(regs), regs_(regs), exti_(exti)
+    {}
+
+    std::uintptr_t read(const volatile void* reg) override
+    {
+        if (reg == &regs_.IDR)
+        {
+            regs_.IDR.value = input_data();
+        }
+        return memory_model::read(reg);
+    }
+
+    void write(volatile void* reg, std::uintptr_t value) override
+    {
+        auto old_levels = levels();
+        if (reg == &regs_.ODR)
+        {
+            regs_.ODR.value = value & 0xFFFF;
+        }
+        else if (reg == &regs_.BSRR)
+        {
+            regs_.ODR.value = (regs_.ODR.value & ~(value >> 16)) | (value & 0xFFFF);
+        }
+        else if (reg == &regs_.BRR)
+        {
+            regs_.ODR.value = regs_.ODR.value & ~value;
+        }
+        else
+        {
+            memory_model::write(reg, value);
+        }
+        regs_.IDR.value = input_data();
+        auto changed = old_levels ^ levels();
+        for (auto& l : listeners_)
+        {
+            if (changed & l.pin)
+            {
+                l.callback(level(l.pin));
+            }
+        }
+    }
+
+    /// @brief The level of a pin on the board, a pin that isn't an output is pulled up,
+    ///        like the interrupt line by the host.
+    bool level(std::uint16_t pin) const { return levels() & pin; }
+
+    void set_input(std::uint16_t pin, bool level)
+    {
+        auto old = inputs_;
+        inputs_ = level ? (inputs_ | pin) : (inputs_ & ~pin);
+        regs_.IDR.value = input_data();
+        for (unsigned line = 0; line < 16; line++)
+        {
+            if ((old ^ inputs_) & (1 << line))
+            {
+                exti_.edge(&regs_, line, level);
+            }
+        }
+    }
+
+    void watch(std::uint16_t pin, std::function<void(bool)> listener)
+    {
+        listeners_.push_back({pin, std::move(listener)});
+    }
+
+  private:
+    struct listener
+    {
+        std::uint16_t pin;
+        std::function<void(bool)> callback;
+    };
+
+    std::uint32_t output_mask() const
+    {
+        std::uint32_t mask = 0;
+        for (unsigned pin = 0; pin < 16; pin++)
+        {
+            if (((regs_.MODER.value >> (2 * pin)) & 3) == GPIO_MODE_OUTPUT_PP)
+            {
+                mask |= 1 << pin;
+            }
+        }
+        return mask;
+    }
+
+    std::uint32_t input_data() const
+    {
+        auto mask = output_mask();
+        return (regs_.ODR.value & mask) | (inputs_ & ~mask);
+    }
+
+    std::uint32_t levels() const
+    {
+        auto mask = output_mask();
+        return (regs_.ODR.value & mask) | (~mask & 0xFFFF);
+    }
+
+    GPIO_TypeDef& regs_;
+    exti_model& exti_;
+    std::uint32_t inputs_{};
+    std::vector<listener> listeners_{};
+};
+
+/// @brief The DMA1 controller, transferring single bytes on the requests of the peripherals.
+/// @note  The bus cycles that the transfers steal from the CPU aren't charged.
+class dma_model : public peripheral_model
+{
+  public:
+    static constexpr unsigned CHANNELS = 7;
+
+    dma_model()
+    {
+        map(&sim_dma1, sizeof(sim_dma1));
+        map(sim_dma1_channel, sizeof(sim_dma1_channel));
+        connect_interrupt(DMA1_Channel2_3_IRQn, [this]() { return requesting_interrupt(1, 2); });
+        connect_interrupt(DMA1_Channel4_5_6_7_IRQn,
+                          [this]() { return requesting_interrupt(3, 6); });
+    }
+
+    void connect(unsigned channel, std::function<bool()> request)
+    {
+        channels_[channel].request = std::move(request);
+    }
+
+    std::uintptr_t read(const volatile void* reg) override
+    {
+        if (reg == &sim_dma1.ISR)
+        {
+            return sim_dma1.ISR.value;
+        }
+        if (reg == &sim_dma1.IFCR)
+        {
+            return 0;
+        }
+        for (auto& ch : sim_dma1_channel)
+        {
+            if ((reg == &ch.CPAR) or (reg == &ch.CMAR))
+            {
+                return static_cast<const volatile sim_regptr*>(reg)->value;
+            }
+        }
+        return static_cast<const volatile sim_reg32*>(reg)->value;
+    }
+
+    void write(volatile void* reg, std::uintptr_t value) override
+    {
+        if (reg == &sim_dma1.IFCR)
+        {
+            for (unsigned i = 0; i < CHANNELS; i++)
+            {
+                std::uint32_t clear = (value >> (4 * i)) & 0xF;
+                if (clear & DMA_IFCR_CGIF1)
+                {
+                    clear = 0xF;
+                }
+                auto flags = (sim_dma1.ISR.value >> (4 * i)) & 0xF & ~clear;
+                // the global flag is the sum of the others
+                flags = (flags & 0xE) ? (flags | DMA_ISR_GIF1) : 0;
+                sim_dma1.ISR.value = (sim_dma1.ISR.value & ~(0xF << (4 * i))) | (flags << (4 * i));
+            }
+            update_interrupts();
+            return;
+        }
+        if (reg == &sim_dma1.ISR)
+        {
+            return;
+        }
+        for (unsigned i = 0; i < CHANNELS; i++)
+        {
+            auto& ch = sim_dma1_channel[i];
+            bool enabled = ch.CCR.value & DMA_CCR_EN;
+            if (reg == &ch.CCR)
+            {
+                ch.CCR.value = value;
+                if ((value & DMA_CCR_EN) and !enabled)
+                {
+                    channels_[i].memory = ch.CMAR.value;
+                    channels_[i].peripheral = ch.CPAR.value;
+                    channels_[i].length = ch.CNDTR.value;
+                    channels_[i].index = 0;
+                    service();
+                }
+                update_interrupts();
+            }
+            else if (reg == &ch.CNDTR)
+            {
+                if (!enabled)
+                {
+                    ch.CNDTR.value = value & 0xFFFF;
+                }
+            }
+            else if (reg == &ch.CPAR)
+            {
+                ch.CPAR.value = value;
+            }
+            else if (reg == &ch.CMAR)
+            {
+                ch.CMAR.value = value;
+            }
+        }
+    }
+
+    /// @brief Transfers while the enabled channels have their requests asserted.
+    void service()
+    {
+        if (servicing_)
+        {
+            // called back from the peripheral at a transfer
+            again_ = true;
+            return;
+        }
+        servicing_ = true;
+        do
+        {
+            again_ = false;
+            for (unsigned i = 0; i < CHANNELS; i++)
+            {
+                auto& ch = sim_dma1_channel[i];
+                while ((ch.CCR.value & DMA_CCR_EN) and (ch.CNDTR.value > 0) and
+                       channels_[i].request and channels_[i].request())
+                {
+                    transfer(i);
+                }
+            }
+        } while (again_);
+        servicing_ = false;
+        update_interrupts();
+    }
+
+  private:
+    struct channel
+    {
+        std::function<bool()> request;
+        std::uintptr_t memory;
+        std::uintptr_t peripheral;
+        std::uint32_t length;
+        std::uint32_t index;
+    };
+
+    bool requesting_interrupt(unsigned first, unsigned last) const
+    {
+        for (unsigned i = first; i <= last; i++)
+        {
+            auto flags = sim_dma1.ISR.value >> (4 * i);
+            auto ccr = sim_dma1_channel[i].CCR.value;
+            if (((flags & DMA_ISR_TCIF1) and (ccr & DMA_CCR_TCIE)) or
+                ((flags & DMA_ISR_HTIF1) and (ccr & DMA_CCR_HTIE)) or
+                ((flags & DMA_ISR_TEIF1) and (ccr & DMA_CCR_TEIE)))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void transfer(unsigned i)
+    {
+        auto& ch = sim_dma1_channel[i];
+        auto& state = channels_[i];
+        auto* memory = reinterpret_cast<std::uint8_t*>(state.memory) +
+                       ((ch.CCR.value & DMA_CCR_MINC) ? state.index : 0);
+        auto* peripheral = reinterpret_cast<volatile void*>(state.peripheral);
+        if (ch.CCR.value & DMA_CCR_DIR)
+        {
+            peripheral_write(peripheral, *memory);
+        }
+        else
+        {
+            *memory = static_cast<std::uint8_t>(peripheral_read(peripheral));
+        }
+        state.index++;
+        ch.CNDTR.value = ch.CNDTR.value - 1;
+        std::uint32_t flags = 0;
+        if ((state.length - ch.CNDTR.value) == (state.length / 2))
+        {
+            flags |= DMA_ISR_HTIF1;
+        }
+        if (ch.CNDTR.value == 0)
+        {
+            flags |= DMA_ISR_TCIF1;
+        }
+        if (flags)
+        {
+            sim_dma1.ISR.value |= (flags | DMA_ISR_GIF1) << (4 * i);
+        }
+    }
+
+    std::array<channel, CHANNELS> channels_{};
+    bool servicing_{};
+    bool again_{};
+};
+
+/// @brief The slave mode of the I2C peripheral, in 7-bit addressing, with clock stretching.
+class i2c_model : public peripheral_model, public i2c_target
+{
+  public:
+    i2c_model(I2C_TypeDef& regs, IRQn_Type irq, dma_model& dma, unsigned tx_channel,
+              unsigned rx_channel, bool wakeup_capable)
+        : regs_(regs), dma_(dma), wakeup_capable_(wakeup_capable)
+    {
+        map(&regs, sizeof(regs));
+        regs_.ISR.value = I2C_ISR_TXE;
+        connect_interrupt(irq, [this]() { return requesting_interrupt(); });
+        dma_.connect(tx_channel,
+                     [this]()
+                     {
+                         return (regs_.CR1.value & I2C_CR1_TXDMAEN) and
+                                (regs_.ISR.value & I2C_ISR_TXIS);
+                     });
+        dma_.connect(rx_channel,
+                     [this]()
+                     {
+                         return (regs_.CR1.value & I2C_CR1_RXDMAEN) and
+                                (regs_.ISR.value & I2C_ISR_RXNE);
+                     });
+    }
+
+    std::uintptr_t read(const volatile void* reg) override
+    {
+        if (reg == &regs_.RXDR)
+        {
+            auto data = regs_.RXDR.value;
+            regs_.ISR.value &= ~I2C_ISR_RXNE;
+            if (waiting_rx_)
+            {
+                waiting_rx_ = false;
+                release();
+            }
+            changed();
+            return data;
+        }
+        return static_cast<const volatile sim_reg32*>(reg)->value;
+    }
+
+    void write(volatile void* reg, std::uintptr_t value) override
+    {
+        if (reg == &regs_.CR1)
+        {
+            bool disabled = (regs_.CR1.value & I2C_CR1_PE) and !(value & I2C_CR1_PE);
+            regs_.CR1.value = value;
+            if (disabled)
+            {
+                reset();
+            }
+        }
+        else if (reg == &regs_.ISR)
+        {
+            // writing TXE flushes the transmit data register
+            if (value & I2C_ISR_TXE)
+            {
+                regs_.ISR.value |= I2C_ISR_TXE;
+            }
+        }
+        else if (reg == &regs_.ICR)
+        {
+            clear(value);
+        }
+        else if (reg == &regs_.TXDR)
+        {
+            if (regs_.ISR.value & I2C_ISR_TXE)
+            {
+                regs_.TXDR.value = value & 0xFF;
+                regs_.ISR.value &= ~(I2C_ISR_TXE | I2C_ISR_TXIS);
+                if (waiting_tx_)
+                {
+                    waiting_tx_ = false;
+                    release();
+                }
+            }
+        }
+        else if (reg != &regs_.RXDR)
+        {
+            static_cast<volatile sim_reg32*>(reg)->value = value;
+        }
+        changed();
+    }
+
+    void start_condition() override
+    {
+        if (regs_.CR1.value & I2C_CR1_PE)
+        {
+            regs_.ISR.value |= I2C_ISR_BUSY;
+        }
+    }
+
+    bool address_byte(std::uint8_t address, bool read) override
+    {
+        auto oar1 = regs_.OAR1.value;
+        if (!(regs_.CR1.value & I2C_CR1_PE) or !(oar1 & I2C_OAR1_OA1EN) or
+            (oar1 & I2C_OAR1_OA1MODE) or (((oar1 >> 1) & 0x7F) != address))
+        {
+            addressed_ = false;
+            return false;
+        }
+        if (stopped())
+        {
+            // only the HSI clocked I2C1 can detect its address in STOP mode
+            if (!wakeup_capable_ or !(regs_.CR1.value & I2C_CR1_WUPEN))
+            {
+                return false;
+            }
+            stop_wakeup();
+        }
+        addressed_ = true;
+        transmitting_ = read;
+        auto isr = regs_.ISR.value & ~(I2C_ISR_DIR | I2C_ISR_ADDCODE);
+        regs_.ISR.value = isr | I2C_ISR_ADDR | (read ? I2C_ISR_DIR : 0) | (address << 17);
+        regs_.CR2.value &= ~I2C_CR2_NACK;
+        changed();
+        return true;
+    }
+
+    std::optional<std::uint8_t> transmit_byte() override
+    {
+        if (!addressed_ or !transmitting_)
+        {
+            // nobody drives the data line
+            return 0xFF;
+        }
+        if (stretching())
+        {
+            return std::nullopt;
+        }
+        if (regs_.ISR.value & I2C_ISR_TXE)
+        {
+            regs_.ISR.value |= I2C_ISR_TXIS;
+            waiting_tx_ = true;
+            changed();
+            return std::nullopt;
+        }
+        auto data = static_cast<std::uint8_t>(regs_.TXDR.value);
+        // the next byte is requested as soon as this one is shifted out
+        regs_.ISR.value |= I2C_ISR_TXE | I2C_ISR_TXIS;
+        changed();
+        return data;
+    }
+
+    void master_ack(bool ack) override
+    {
+        if (!ack and addressed_ and transmitting_)
+        {
+            regs_.ISR.value = (regs_.ISR.value & ~I2C_ISR_TXIS) | I2C_ISR_NACKF;
+            changed();
+        }
+    }
+
+    std::optional<bool> receive_byte(std::uint8_t data) override
+    {
+        if (!addressed_ or transmitting_)
+        {
+            return false;
+        }
+        if (stretching())
+        {
+            return std::nullopt;
+        }
+        if (regs_.ISR.value & I2C_ISR_RXNE)
+        {
+            // the clock is stretched before the acknowledge, until the data is read
+            waiting_rx_ = true;
+            return std::nullopt;
+        }
+        if (regs_.CR2.value & I2C_CR2_NACK)
+        {
+            regs_.CR2.value &= ~I2C_CR2_NACK;
+            return false;
+        }
+        regs_.RXDR.value = data;
+        regs_.ISR.value |= I2C_ISR_RXNE;
+        changed();
+        return true;
+    }
+
+    bool stretching() const override
+    {
+        return addressed_ and ((regs_.ISR.value & I2C_ISR_ADDR) or waiting_tx_ or waiting_rx_);
+    }
+
+    void stop_condition() override
+    {
+        if (!(regs_.CR1.value & I2C_CR1_PE))
+        {
+            return;
+        }
+        regs_.ISR.value &= ~I2C_ISR_BUSY;
+        if (addressed_)
+        {
+            regs_.ISR.value |= I2C_ISR_STOPF;
+            regs_.CR2.value &= ~I2C_CR2_NACK;
+            addressed_ = false;
+            waiting_tx_ = false;
+            waiting_rx_ = false;
+        }
+        changed();
+    }
+
+    void bus_error(std::uint32_t flags) override
+    {
+        regs_.ISR.value |= flags & (I2C_ISR_BERR | I2C_ISR_ARLO | I2C_ISR_OVR);
+        addressed_ = false;
+        waiting_tx_ = false;
+        waiting_rx_ = false;
+        changed();
+    }
+
+    void attach(std::function<void()> released) override { released_ = std::move(released); }
+
+  private:
+    bool requesting_interrupt() const
+    {
+        auto isr = regs_.ISR.value;
+        auto cr1 = regs_.CR1.value;
+        return ((isr & I2C_ISR_TXIS) and (cr1 & I2C_CR1_TXIE)) or
+               ((isr & I2C_ISR_RXNE) and (cr1 & I2C_CR1_RXIE)) or
+               ((isr & I2C_ISR_ADDR) and (cr1 & I2C_CR1_ADDRIE)) or
+               ((isr & I2C_ISR_NACKF) and (cr1 & I2C_CR1_NACKIE)) or
+               ((isr & I2C_ISR_STOPF) and (cr1 & I2C_CR1_STOPIE)) or
+               ((isr & (I2C_ISR_BERR | I2C_ISR_ARLO | I2C_ISR_OVR)) and (cr1 & I2C_CR1_ERRIE));
+    }
+
+    void clear(std::uint32_t flags)
+    {
+        if ((flags & I2C_ICR_ADDRCF) and (regs_.ISR.value & I2C_ISR_ADDR))
+        {
+            regs_.ISR.value &= ~I2C_ISR_ADDR;
+            if (transmitting_ and (regs_.ISR.value & I2C_ISR_TXE))
+            {
+                regs_.ISR.value |= I2C_ISR_TXIS;
+            }
+            release();
+        }
+        regs_.ISR.value &= ~(flags & (I2C_ICR_NACKCF | I2C_ICR_STOPCF | I2C_ICR_BERRCF |
+                                      I2C_ICR_ARLOCF | I2C_ICR_OVRCF));
+    }
+
+    /// @brief Disabling the peripheral resets its state machine and flags.
+    void reset()
+    {
+        regs_.ISR.value = I2C_ISR_TXE;
+        regs_.CR2.value &= ~I2C_CR2_NACK;
+        bool stalled = stretching();
+        addressed_ = false;
+        waiting_tx_ = false;
+        waiting_rx_ = false;
+        if (stalled)
+        {
+            release();
+        }
+    }
+
+    void release()
+    {
+        if (released_)
+        {
+            released_();
+        }
+    }
+
+    void changed()
+    {
+        dma_.service();
+        update_interrupts();
+    }
+
+    I2C_TypeDef& regs_;
+    dma_model& dma_;
+    std::function<void()> released_{};
+    const bool wakeup_capable_;
+    bool addressed_{};
+    bool transmitting_{};
+    bool waiting_tx_{};
+    bool waiting_rx_{};
+};
+
+struct peripherals
+{
+    dma_model dma{};
+    // the address match of I2C1 can wake up from STOP mode
+    i2c_model i2c1{sim_i2c1, I2C1_IRQn, dma, 1, 2, true};
+    i2c_model i2c2{sim_i2c2, I2C2_IRQn, dma, 3, 4, false};
+    exti_model exti{};
+    gpio_model gpioa{sim_gpioa, exti};
+    gpio_model gpiob{sim_gpiob, exti};
+    gpio_model gpioc{sim_gpioc, exti};
+    rcc_model rcc{};
+    flash_model flash{};
+    tim_model tim2{};
+    scb_model scb{};
+    memory_model syscfg{sim_syscfg};
+
+    gpio_model& gpio(GPIO_TypeDef* port)
+    {
+        if (port == &sim_gpioa)
+        {
+            return gpioa;
+        }
+        if (port == &sim_gpiob)
+        {
+            return gpiob;
+        }
+        if (port != &sim_gpioc)
+        {
+            fail("unknown GPIO port");
+        }
+        return gpioc;
+    }
+};
+
+peripherals* models = nullptr;
+
+peripherals& get()
+{
+    if (models == nullptr)
+    {
+        fail("the peripherals aren't initialized");
+    }
+    return *models;
+}
+} // namespace
+
+void peripheral_model::map(volatile void* base, std::size_t size)
+{
+    auto begin = reinterpret_cast<std::uintptr_t>(base);
+    regions().push_back({begin, begin + size, this});
+}
+
+std::uintptr_t peripheral_read(const volatile void* reg)
+{
+    return find(reg).read(reg);
+}
+
+void peripheral_write(volatile void* reg, std::uintptr_t value)
+{
+    find(reg).write(reg, value);
+}
+
+void init_peripherals()
+{
+    // never destroyed, like the register blocks
+    models = new peripherals();
+}
+
+void exti_select(unsigned line, GPIO_TypeDef* port)
+{
+    get().exti.select(line, port);
+}
+
+void rcc_stop_mode_exit()
+{
+    get().rcc.stop_mode_exit();
+}
+
+i2c_target& target(I2C_TypeDef* instance)
+{
+    return (instance == &sim_i2c1) ? get().i2c1 : get().i2c2;
+}
+
+void set_input(GPIO_TypeDef* port, std::uint16_t pin, bool level)
+{
+    get().gpio(port).set_input(pin, level);
+}
+
+bool output(GPIO_TypeDef* port, std::uint16_t pin)
+{
+    return get().gpio(port).level(pin);
+}
+
+void watch_output(GPIO_TypeDef* port, std::uint16_t pin, std::function<void(bool)> listener)
+{
+    get().gpio(port).watch(pin, std::move(listener));
+}
+
+void inject_clock_fault(clock_fault fault)
+{
+    active_fault = fault;
+}
+} // namespace sim
@@ -0,0 +1,209 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+/// @brief  Calls every libcall of cortex_m0_atomic.cpp, for 1, 2 and 4 byte values,
+///         the build renames them to libcall_<operation>_<size>, as the host compiler inlines
+///         the __atomic builtins instead of calling them. For each:
+///         - the returned value, and the value left in memory
+///         - the bytes next to the value aren't touched
+///         - the interrupts are enabled again after the call
+///         compare_exchange is checked both when it succeeds, and when it fails, where the
+///         current value is written back to the expected one, and the memory is unchanged.
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include "sim/firmware.hpp"
+
+using namespace sim;
+
+#define ATOMIC_LIBCALL_DECLARATIONS(SIZE, TYPE)                                                    \
+    extern "C" TYPE libcall_load_##SIZE(const volatile void* ptr, int memorder);                   \
+    extern "C" void libcall_store_##SIZE(volatile void* ptr, TYPE value, int memorder);            \
+    extern "C" TYPE libcall_exchange_##SIZE(volatile void* ptr, TYPE value, int memorder);         \
+    extern "C" bool libcall_compare_exchange_##SIZE(volatile void* ptr, void* expected,            \
+                                                    TYPE desired, bool weak,                       \
+                                                    int success_memorder, int failure_memorder);   \
+    extern "C" TYPE libcall_fetch_add_##SIZE(volatile void* ptr, TYPE value, int memorder);        \
+    extern "C" TYPE libcall_fetch_sub_##SIZE(volatile void* ptr, TYPE value, int memorder);        \
+    extern "C" TYPE libcall_fetch_and_##SIZE(volatile void* ptr, TYPE value, int memorder);        \
+    extern "C" TYPE libcall_fetch_or_##SIZE(volatile void* ptr, TYPE value, int memorder);         \
+    extern "C" TYPE libcall_fetch_xor_##SIZE(volatile void* ptr, TYPE value, int memorder);
+
+ATOMIC_LIBCALL_DECLARATIONS(1, unsigned char)
+ATOMIC_LIBCALL_DECLARATIONS(2, unsigned short)
+ATOMIC_LIBCALL_DECLARATIONS(4, unsigned int)
+
+#undef ATOMIC_LIBCALL_DECLARATIONS
+
+namespace
+{
+/// @brief The libcalls of one value size.
+template <typename T>
+struct libcalls
+{
+    T (*load)(const volatile void*, int);
+    void (*store)(volatile void*, T, int);
+    T (*exchange)(volatile void*, T, int);
+    bool (*compare_exchange)(volatile void*, void*, T, bool, int, int);
+    T (*fetch_add)(volatile void*, T, int);
+    T (*fetch_sub)(volatile void*, T, int);
+    T (*fetch_and)(volatile void*, T, int);
+    T (*fetch_or)(volatile void*, T, int);
+    T (*fetch_xor)(volatile void*, T, int);
+};
+
+#define ATOMIC_LIBCALLS(SIZE)                                                                      \
+    {                                                                                              \
+        libcall_load_##SIZE, libcall_store_##SIZE, libcall_exchange_##SIZE,                        \
+            libcall_compare_exchange_##SIZE, libcall_fetch_add_##SIZE, libcall_fetch_sub_##SIZE,   \
+            libcall_fetch_and_##SIZE, libcall_fetch_or_##SIZE, libcall_fetch_xor_##SIZE            \
+    }
+
+constexpr libcalls<unsigned char> LIBCALLS_1 = ATOMIC_LIBCALLS(1);
+constexpr libcalls<unsigned short> LIBCALLS_2 = ATOMIC_LIBCALLS(2);
+constexpr libcalls<unsigned int> LIBCALLS_4 = ATOMIC_LIBCALLS(4);
+
+#undef ATOMIC_LIBCALLS
+
+constexpr std::uint8_t GUARD = 0xa5;
+
+/// @brief The value under test, between guard bytes that the libcalls mustn't touch.
+template <typename T>
+struct guarded
+{
+    std::uint8_t before[sizeof(T)];
+    alignas(T) volatile T value;
+    std::uint8_t after[sizeof(T)];
+};
+
+template <typename T>
+class atomic_libcalls_test
+{
+  public:
+    explicit atomic_libcalls_test(const libcalls<T>& calls) : calls_(calls) {}
+
+    void run()
+    {
+        // a pattern that differs in every byte, and its complement
+        constexpr T ones = std::numeric_limits<T>::max();
+        constexpr T pattern = static_cast<T>(0x5a3c1e0fu & ones);
+        constexpr T other = static_cast<T>(~pattern);
+
+        reset(pattern);
+        check("load", calls_.load(&g_.value, __ATOMIC_SEQ_CST), pattern, pattern);
+
+        reset(pattern);
+        calls_.store(&g_.value, other, __ATOMIC_SEQ_CST);
+        check("store", other, other, other);
+
+        reset(pattern);
+        check("exchange", calls_.exchange(&g_.value, other, __ATOMIC_SEQ_CST), pattern, other);
+
+        reset(pattern);
+        check("fetch_add", calls_.fetch_add(&g_.value, 3, __ATOMIC_SEQ_CST), pattern,
+              static_cast<T>(pattern + 3));
+        // wraps around at the width of the value
+        reset(ones);
+        check("fetch_add wrap", calls_.fetch_add(&g_.value, 2, __ATOMIC_SEQ_CST), ones, T{1});
+
+        reset(pattern);
+        check("fetch_sub", calls_.fetch_sub(&g_.value, 3, __ATOMIC_SEQ_CST), pattern,
+              static_cast<T>(pattern - 3));
+        reset(T{1});
+        check("fetch_sub wrap", calls_.fetch_sub(&g_.value, 2, __ATOMIC_SEQ_CST), T{1}, ones);
+
+        reset(pattern);
+        check("fetch_and", calls_.fetch_and(&g_.value, 0x0f0f0f0fu & ones, __ATOMIC_SEQ_CST),
+              pattern, static_cast<T>(pattern & 0x0f0f0f0fu));
+
+        reset(pattern);
+        check("fetch_or", calls_.fetch_or(&g_.value, 0x80808080u & ones, __ATOMIC_SEQ_CST),
+              pattern, static_cast<T>(pattern | 0x80808080u));
+
+        reset(pattern);
+        check("fetch_xor", calls_.fetch_xor(&g_.value, ones, __ATOMIC_SEQ_CST), pattern, other);
+
+        // success: the desired value is stored, expected is left alone
+        reset(pattern);
+        T expected = pattern;
+        bool exchanged = calls_.compare_exchange(&g_.value, &expected, other, false,
+                                                 __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+        check("compare_exchange", exchanged, true, other);
+        if (expected != pattern)
+        {
+            fail("%zu byte compare_exchange: expected is modified on success", sizeof(T));
+        }
+
+        // failure: the memory is left alone, the current value is written to expected
+        for (bool weak : {false, true})
+        {
+            reset(pattern);
+            expected = other;
+            exchanged = calls_.compare_exchange(&g_.value, &expected, T{0}, weak,
+                                                __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+            check(weak ? "compare_exchange weak failure" : "compare_exchange failure",
+                  exchanged, false, pattern);
+            if (expected != pattern)
+            {
+                fail("%zu byte compare_exchange: the current value isn't written back to "
+                     "expected on failure: %#x instead of %#x",
+                     sizeof(T), static_cast<unsigned>(expected), static_cast<unsigned>(pattern));
+            }
+        }
+        std::printf("%zu byte libcalls: OK\n", sizeof(T));
+    }
+
+  private:
+    void reset(T value)
+    {
+        std::memset(g_.before, GUARD, sizeof(g_.before));
+        std::memset(g_.after, GUARD, sizeof(g_.after));
+        g_.value = value;
+    }
+
+    template <typename TResult>
+    void check(const char* name, TResult result, TResult expected_result, T expected_value)
+    {
+        if (result != expected_result)
+        {
+            fail("%zu byte %s: returned %#x instead of %#x", sizeof(T), name,
+                 static_cast<unsigned>(result), static_cast<unsigned>(expected_result));
+        }
+        if (g_.value != expected_value)
+        {
+            fail("%zu byte %s: left %#x instead of %#x", sizeof(T), name,
+                 static_cast<unsigned>(g_.value), static_cast<unsigned>(expected_value));
+        }
+        for (std::size_t i = 0; i < sizeof(T); i++)
+        {
+            if ((g_.before[i] != GUARD) or (g_.after[i] != GUARD))
+            {
+                fail("%zu byte %s: the neighboring bytes are overwritten", sizeof(T), name);
+            }
+        }
+        if (__get_PRIMASK() != 0)
+        {
+            fail("%zu byte %s: the interrupts are left disabled", sizeof(T), name);
+        }
+    }
+
+    const libcalls<T>& calls_;
+    guarded<T> g_{};
+};
+} // namespace
+
+extern "C" void test_i2c_hid_device()
+{
+    atomic_libcalls_test<unsigned char>(LIBCALLS_1).run();
+    atomic_libcalls_test<unsigned short>(LIBCALLS_2).run();
+    atomic_libcalls_test<unsigned int>(LIBCALLS_4).run();
+    std::exit(EXIT_SUCCESS);
+}
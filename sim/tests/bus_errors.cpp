@@ -0,0 +1,202 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+/// @brief  Breaks transfers with each error that the slave detects, without a STOP condition:
+///         - in the middle of an input report read, the report and the interrupt line are kept,
+///           and the host's next read receives the report
+///         - in the middle of an output report write, the next write is accepted
+///         - each error is counted by its type, and the recovery takes microseconds
+///         - on the idle bus, there is no transfer to end, and the next input report is read
+#include <cstdio>
+#include <cstdlib>
+#include "sim/firmware.hpp"
+#include "st/timestamp.hpp"
+
+using namespace sim;
+
+namespace
+{
+using app = hid::demo_app;
+using counter = app::perf_counter;
+
+constexpr picoseconds RESPONSE_DELAY = 100 * MICROSECOND;
+// the address and the first byte of the transfer, at 400 kHz
+constexpr picoseconds INTO_TRANSFER = 30 * MICROSECOND;
+// the host reacts to the error after this time
+constexpr picoseconds HOST_RETRY_DELAY = 20 * MICROSECOND;
+constexpr std::uint32_t MAX_RECOVERY_US = 20;
+
+struct error_case
+{
+    const char* name;
+    std::uint32_t flag;
+    counter count;
+};
+constexpr error_case ERRORS[]{
+    {"bus error", I2C_ISR_BERR, counter::I2C_BUS_ERRORS},
+    {"arbitration loss", I2C_ISR_ARLO, counter::I2C_ARBITRATION_LOSSES},
+    {"overrun", I2C_ISR_OVR, counter::I2C_OVERRUNS},
+};
+
+class bus_errors_test
+{
+  public:
+    bus_errors_test()
+        : bus_(I2C2, 400'000),
+          host_(bus_, DEVICE_ADDRESS, HID_DESCRIPTOR_REGISTER, EXT_RESET_GPIO_Port, EXT_RESET_Pin)
+    {
+        host_.on_input(
+            [this](std::span<const std::uint8_t> report)
+            {
+                if (report[0] == app::keys_report::ID)
+                {
+                    received_++;
+                }
+            });
+    }
+
+    void run()
+    {
+        if (!set_i2c_bus_speed(st::i2c_speed::FAST))
+        {
+            fail("the bus speed can't be set");
+        }
+        host_.connect();
+        host_.set_response_delay(RESPONSE_DELAY);
+
+        for (auto& error : ERRORS)
+        {
+            break_input_read(error);
+            break_output_write(error);
+            break_idle_bus(error);
+        }
+        std::exit(EXIT_SUCCESS);
+    }
+
+  private:
+    void break_input_read(const error_case& error)
+    {
+        clear_counters(host_);
+        received_ = 0;
+        pressed_ = !pressed_;
+        set_input(B1_GPIO_Port, B1_Pin, pressed_);
+        if (!run_until([this]() { return host_.interrupt_asserted(); }, MILLISECOND))
+        {
+            fail("%s: the interrupt line isn't asserted", error.name);
+        }
+        run_for(RESPONSE_DELAY + INTO_TRANSFER);
+        if (bus_.idle())
+        {
+            fail("%s: the input report isn't being read", error.name);
+        }
+        bus_.inject_error(error.flag);
+
+        // the host is yet to retry, the device waits with the report
+        run_for(HOST_RETRY_DELAY);
+        if (!host_.interrupt_asserted() or (received_ != 0))
+        {
+            fail("%s: the interrupt line isn't kept asserted", error.name);
+        }
+        if (!run_until([this]() { return bus_.idle() and !host_.interrupt_asserted(); },
+                       10 * MILLISECOND) or
+            (received_ != 1))
+        {
+            fail("%s: the input report isn't received after the recovery", error.name);
+        }
+        check_counters(error, "input read");
+    }
+
+    void break_output_write(const error_case& error)
+    {
+        clear_counters(host_);
+        std::vector<std::uint8_t> data;
+        auto output_register = host_.hid_descriptor().wOutputRegister;
+        data.push_back(output_register & 0xff);
+        data.push_back(output_register >> 8);
+        data.push_back(2 + frame_.size());
+        data.push_back(0);
+        data.insert(data.end(), frame_.begin(), frame_.end());
+        bool aborted = false;
+        bus_.submit({DEVICE_ADDRESS, std::move(data), 0},
+                    [&](const bus_master::result& r) { aborted = r.aborted; });
+        run_for(INTO_TRANSFER);
+        bus_.inject_error(error.flag);
+        if (!aborted)
+        {
+            fail("%s: the output report write isn't aborted", error.name);
+        }
+        run_for(HOST_RETRY_DELAY);
+
+        if (!host_.output_report(frame_))
+        {
+            fail("%s: the output report isn't accepted after the recovery", error.name);
+        }
+        check_counters(error, "output write");
+    }
+
+    void break_idle_bus(const error_case& error)
+    {
+        clear_counters(host_);
+        received_ = 0;
+        if (!bus_.idle() or host_.interrupt_asserted())
+        {
+            fail("%s: the bus isn't idle", error.name);
+        }
+        bus_.inject_error(error.flag);
+        run_for(HOST_RETRY_DELAY);
+
+        pressed_ = !pressed_;
+        set_input(B1_GPIO_Port, B1_Pin, pressed_);
+        if (!run_until([this]() { return received_ == 1; }, 10 * MILLISECOND) or
+            !run_until([this]() { return bus_.idle() and !host_.interrupt_asserted(); },
+                       10 * MILLISECOND))
+        {
+            fail("%s: the input report isn't received after an error on the idle bus",
+                 error.name);
+        }
+        check_counters(error, "idle bus");
+    }
+
+    void check_counters(const error_case& error, const char* transfer)
+    {
+        auto cycles = read_counter(host_, counter::I2C_MAX_RECOVERY_CYCLES);
+        auto recovery_us = st::timestamp::to_us(cycles);
+        std::printf("%s in %s: %u bus errors, %u arbitration losses, %u overruns, "
+                    "recovery %u cycles (%u us)\n",
+                    error.name, transfer, read_counter(host_, counter::I2C_BUS_ERRORS),
+                    read_counter(host_, counter::I2C_ARBITRATION_LOSSES),
+                    read_counter(host_, counter::I2C_OVERRUNS), cycles, recovery_us);
+        for (auto& other : ERRORS)
+        {
+            auto expected = (other.count == error.count) ? 1u : 0u;
+            if (read_counter(host_, other.count) != expected)
+            {
+                fail("%s in %s: the %ss aren't counted", error.name, transfer, other.name);
+            }
+        }
+        if ((cycles == 0) or (recovery_us > MAX_RECOVERY_US))
+        {
+            fail("%s in %s: the recovery isn't measured", error.name, transfer);
+        }
+    }
+
+    bus_master bus_;
+    hid_host host_;
+    std::array<std::uint8_t, sizeof(app::raw_out_report)> frame_{app::raw_out_report::ID};
+    unsigned received_{};
+    bool pressed_{};
+};
+} // namespace
+
+extern "C" void test_i2c_hid_device()
+{
+    static bus_errors_test test;
+    test.run();
+}
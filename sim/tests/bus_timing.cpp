@@ -0,0 +1,112 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+/// @brief  Changes the bus timing while the host writes back-to-back transfers.
+///         A critical section of the firmware delays the interrupt of the slave, so the STOP
+///         of the first transfer and the address of the next one are handled together.
+///         The pending timing change must not drop the next transfer, and it's applied
+///         once the bus is idle.
+#include <cstdio>
+#include <cstdlib>
+#include "sim/firmware.hpp"
+
+using namespace sim;
+
+namespace
+{
+constexpr unsigned ROUNDS = 20;
+// longer than the rest of the first transfer and the address of the next one at 400 kHz
+constexpr picoseconds MASKED_TIME = 200 * MICROSECOND;
+
+class bus_timing_test
+{
+  public:
+    bus_timing_test()
+        : bus_(I2C2, 400'000),
+          host_(bus_, DEVICE_ADDRESS, HID_DESCRIPTOR_REGISTER, EXT_RESET_GPIO_Port, EXT_RESET_Pin)
+    {}
+
+    void run()
+    {
+        host_.connect();
+        for (unsigned round = 0; round < ROUNDS; round++)
+        {
+            // the timing is only changed in the peripheral, the bus keeps its clock
+            auto speed = (round % 2) ? st::i2c_speed::FAST : st::i2c_speed::FAST_PLUS;
+            std::uint32_t timingr = I2C2->TIMINGR;
+            if (!set_i2c_bus_speed(speed))
+            {
+                fail("the bus speed can't be set");
+            }
+            back_to_back(round);
+            if (I2C2->TIMINGR == timingr)
+            {
+                fail("round %u: the timing isn't applied on the idle bus", round);
+            }
+        }
+        std::printf("%u rounds of back-to-back transfers with a pending timing change\n",
+                    ROUNDS);
+        std::exit(EXIT_SUCCESS);
+    }
+
+  private:
+    void back_to_back(unsigned round)
+    {
+        // SET_POWER ON
+        auto command = host_.hid_descriptor().wCommandRegister;
+        bus_master::transfer set_power{DEVICE_ADDRESS,
+                                       {static_cast<std::uint8_t>(command),
+                                        static_cast<std::uint8_t>(command >> 8), 0x00, 0x08},
+                                       0};
+        std::array<bus_master::result, 2> results{};
+        unsigned completed = 0;
+        auto starts = get_i2c_slave().stats().starts;
+        for (auto& result : results)
+        {
+            bus_.submit(set_power, [&](const bus_master::result& r)
+                        {
+                            result = r;
+                            completed++;
+                        });
+        }
+
+        // the first transfer is addressed, then the firmware masks the interrupts
+        if (!run_until([&]() { return get_i2c_slave().stats().starts > starts; },
+                       MILLISECOND))
+        {
+            fail("round %u: the first transfer doesn't start", round);
+        }
+        auto cycles = static_cast<std::uint32_t>(MASKED_TIME * core_clock() / SECOND);
+        at_transport_priority([cycles]() { execute(cycles); });
+
+        if (!run_until([&]() { return completed == results.size(); }, 10 * MILLISECOND))
+        {
+            fail("round %u: the transfers don't complete", round);
+        }
+        for (auto& result : results)
+        {
+            if (!result.acknowledged or (result.written != set_power.write.size()))
+            {
+                fail("round %u: a transfer was dropped, %zu of %zu bytes written", round,
+                     result.written, set_power.write.size());
+            }
+        }
+    }
+
+    bus_master bus_;
+    hid_host host_;
+};
+} // namespace
+
+extern "C" void test_i2c_hid_device()
+{
+    static bus_timing_test test;
+    test.run();
+}
@@ -0,0 +1,221 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+/// @brief  Serves input reports with the I2C_HID_IDLE_CLOCK_SCALING configuration:
+///         - the host reacts to the interrupt line with a fixed delay, that the device spends
+///           mostly at the idle clock, the latency histogram must still show the delay
+///           in timestamp cycles
+///         - each fault of the clock tree makes the raise to the active profile fail,
+///           the reports are served from HSI instead, and the failures are counted
+///         - once the fault is gone, the clock is raised again
+///         The device boots onto the run profile, HSI48 without waiting for the PLL lock.
+#include <cstdio>
+#include <cstdlib>
+#include "sim/firmware.hpp"
+#include "st/clock_profile.hpp"
+
+using namespace sim;
+
+namespace
+{
+using app = hid::demo_app;
+using counter = app::perf_counter;
+
+constexpr auto RUN_CLOCK_PROFILE = st::clock_profile::I2C_HID_CLOCK_PROFILE;
+constexpr unsigned REPORTS = 10;
+// the bus is idle between the reports, so each one starts at the idle clock
+constexpr picoseconds REPORT_INTERVAL = 5 * MILLISECOND;
+constexpr std::uint32_t RESPONSE_DELAY_US = 400;
+// the address of the read transfer, and the raise of the clock until it's serviced
+constexpr std::uint32_t MAX_READ_START_US = 500;
+// from the reset to the start of the test, less than the 200 us PLL lock time
+constexpr std::uint32_t MAX_HSI48_BOOT_US = 100;
+
+struct fault_case
+{
+    const char* name;
+    clock_fault fault;
+};
+constexpr fault_case FAULTS[]{
+    {(RUN_CLOCK_PROFILE == st::clock_profile::PLL) ? "PLL lock" : "HSI48 ready",
+     (RUN_CLOCK_PROFILE == st::clock_profile::PLL) ? clock_fault::PLL_LOCK
+                                                   : clock_fault::HSI48_READY},
+    {"flash latency", clock_fault::FLASH_LATENCY},
+    {"clock switch", clock_fault::CLOCK_SWITCH},
+};
+
+class clock_scaling_test
+{
+  public:
+    clock_scaling_test()
+        : bus_(I2C2, 100'000),
+          host_(bus_, DEVICE_ADDRESS, HID_DESCRIPTOR_REGISTER, EXT_RESET_GPIO_Port, EXT_RESET_Pin)
+    {
+        host_.on_input(
+            [this](std::span<const std::uint8_t> report)
+            {
+                if (report[0] == app::keys_report::ID)
+                {
+                    received_++;
+                }
+            });
+    }
+
+    void run()
+    {
+        check_boot();
+        // the timing has to meet the bus specification with the idle clock as well
+        if (!set_i2c_bus_speed(st::i2c_speed::STANDARD))
+        {
+            fail("the bus speed can't be set");
+        }
+        host_.connect();
+        host_.set_response_delay(RESPONSE_DELAY_US * MICROSECOND);
+
+        check_latency();
+        for (auto& fault : FAULTS)
+        {
+            check_fallback(fault);
+        }
+        std::exit(EXIT_SUCCESS);
+    }
+
+  private:
+    void check_boot()
+    {
+        auto boot_us = static_cast<std::uint32_t>(now() / MICROSECOND);
+        std::printf("boot: %u us\n", boot_us);
+        if (st::system_clock::current() != RUN_CLOCK_PROFILE)
+        {
+            fail("the device doesn't boot onto the run profile");
+        }
+        if ((RUN_CLOCK_PROFILE == st::clock_profile::HSI48) and (boot_us > MAX_HSI48_BOOT_US))
+        {
+            fail("the boot onto HSI48 takes %u us", boot_us);
+        }
+    }
+
+    void check_latency()
+    {
+        clear_latency();
+        clear_counters(host_);
+        serve_reports("latency");
+
+        auto latency = read_latency();
+        using histogram = st::interrupt_latency::histogram;
+        auto first = histogram::bucket_of(st::timestamp::from_us(RESPONSE_DELAY_US));
+        auto last =
+            histogram::bucket_of(st::timestamp::from_us(RESPONSE_DELAY_US + MAX_READ_START_US));
+        std::uint32_t in_range = 0;
+        std::uint32_t total = 0;
+        for (std::size_t i = 0; i < st::interrupt_latency::BUCKETS; i++)
+        {
+            total += latency.assert_to_read.counts[i];
+            if ((i >= first) and (i <= last))
+            {
+                in_range += latency.assert_to_read.counts[i];
+            }
+        }
+        std::printf("latency: %u of %u interrupt line reactions in buckets %zu-%zu at %u Hz, "
+                    "%u clock raises\n",
+                    in_range, total, first, last, latency.clock_hz,
+                    read_counter(host_, counter::CLOCK_RAISES));
+        if (latency.clock_hz != st::timestamp::FREQUENCY)
+        {
+            fail("the latency isn't reported in timestamp cycles");
+        }
+        if ((total < REPORTS) or (in_range != total))
+        {
+            fail("the latency of the host's reaction isn't measured");
+        }
+    }
+
+    void check_fallback(const fault_case& fault)
+    {
+        clear_counters(host_);
+        // the faults hit the raise from the idle clock, with zero flash wait states
+        if (!run_until([]() { return core_clock() == HSI_VALUE; }, MILLISECOND))
+        {
+            fail("the clock isn't lowered while idle");
+        }
+        inject_clock_fault(fault.fault);
+        serve_reports(fault.name);
+        auto faults = read_counter(host_, counter::CLOCK_FAULTS);
+        auto raises = read_counter(host_, counter::CLOCK_RAISES);
+        std::printf("%s fault: %u clock faults, %u clock raises, at %u Hz\n", fault.name, faults,
+                    raises, core_clock());
+        if ((faults < REPORTS) or (raises != 0) or (core_clock() != HSI_VALUE))
+        {
+            fail("%s: the clock doesn't fall back to HSI", fault.name);
+        }
+
+        inject_clock_fault(clock_fault::NONE);
+        clear_counters(host_);
+        serve_reports(fault.name);
+        faults = read_counter(host_, counter::CLOCK_FAULTS);
+        raises = read_counter(host_, counter::CLOCK_RAISES);
+        if ((faults != 0) or (raises < REPORTS))
+        {
+            fail("%s: the clock isn't raised after the fault", fault.name);
+        }
+    }
+
+    /// @brief Each button edge sends a report, while the bus is idle.
+    void serve_reports(const char* name)
+    {
+        received_ = 0;
+        for (unsigned i = 0; i < REPORTS; i++)
+        {
+            pressed_ = !pressed_;
+            set_input(B1_GPIO_Port, B1_Pin, pressed_);
+            run_for(REPORT_INTERVAL);
+        }
+        if (!run_until([this]() { return bus_.idle() and !host_.interrupt_asserted(); },
+                       100 * MILLISECOND) or
+            (received_ != REPORTS))
+        {
+            fail("%s: %u of %u reports received", name, received_, REPORTS);
+        }
+    }
+
+    void clear_latency()
+    {
+        std::array<std::uint8_t, sizeof(app::latency_report)> report{app::latency_report::ID};
+        if (!host_.set_report(hid_host::report_type::FEATURE, report))
+        {
+            fail("the latency can't be cleared");
+        }
+    }
+
+    st::interrupt_latency read_latency()
+    {
+        auto report = host_.get_report(hid_host::report_type::FEATURE, app::latency_report::ID,
+                                       sizeof(app::latency_report));
+        if (report.size() != sizeof(app::latency_report))
+        {
+            fail("the latency report can't be read");
+        }
+        st::interrupt_latency latency;
+        std::memcpy(&latency, report.data() + 1, sizeof(latency));
+        return latency;
+    }
+
+    bus_master bus_;
+    hid_host host_;
+    unsigned received_{};
+    bool pressed_{};
+};
+} // namespace
+
+extern "C" void test_i2c_hid_device()
+{
+    static clock_scaling_test test;
+    test.run();
+}
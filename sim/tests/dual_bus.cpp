@@ -0,0 +1,90 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+/// @brief  Serves a host on each bus of the I2C_HID_DUAL_BUS configuration:
+///         - both devices run in Fast-mode, I2C1 with the HSI kernel clock
+///         - both devices complete the reset, with their own interrupt line
+///         - each device counts the transfers of its own bus
+///         - the counters of the shared resources are only reported by the first device
+#include <cstdio>
+#include <cstdlib>
+#include "sim/firmware.hpp"
+
+using namespace sim;
+
+namespace
+{
+using app = hid::demo_app;
+using counter = app::perf_counter;
+
+class dual_bus_test
+{
+  public:
+    dual_bus_test()
+        : bus_{bus_master(I2C2, 400'000), bus_master(I2C1, 400'000)},
+          host_{hid_host(bus_[0], DEVICE_ADDRESS, HID_DESCRIPTOR_REGISTER, EXT_RESET_GPIO_Port,
+                         EXT_RESET_Pin),
+                hid_host(bus_[1], DEVICE_ADDRESS, HID_DESCRIPTOR_REGISTER, GPIOC, GPIO_PIN_4)}
+    {}
+
+    void run()
+    {
+        for (std::size_t bus = 0; bus < host_.size(); bus++)
+        {
+            if (!set_i2c_bus_speed(st::i2c_speed::FAST, bus))
+            {
+                fail("bus %zu: the bus speed can't be set", bus);
+            }
+        }
+        for (auto& host : host_)
+        {
+            host.connect();
+        }
+
+        // a different number of transfers on each bus
+        std::array<std::uint32_t, 2> transfers{};
+        for (std::size_t bus = 0; bus < host_.size(); bus++)
+        {
+            auto before = read_counter(host_[bus], counter::I2C_WRITE_TRANSFERS);
+            for (std::size_t i = 0; i < (4 + 2 * bus); i++)
+            {
+                if (!host_[bus].set_power(true))
+                {
+                    fail("bus %zu: the command isn't accepted", bus);
+                }
+            }
+            transfers[bus] = read_counter(host_[bus], counter::I2C_WRITE_TRANSFERS) - before;
+        }
+        std::printf("write transfers counted: %u on I2C2, %u on I2C1\n", transfers[0],
+                    transfers[1]);
+        if ((transfers[1] - transfers[0]) != 2)
+        {
+            fail("the transfers aren't counted by the device of their bus");
+        }
+
+        if ((read_counter(host_[0], counter::I2C_IRQ_MAX_CYCLES) == 0) or
+            (read_counter(host_[1], counter::I2C_IRQ_MAX_CYCLES) != 0))
+        {
+            fail("the shared counters aren't only reported by the first device");
+        }
+        std::exit(EXIT_SUCCESS);
+    }
+
+  private:
+    std::array<bus_master, 2> bus_;
+    std::array<hid_host, 2> host_;
+};
+} // namespace
+
+extern "C" void test_i2c_hid_device()
+{
+    static dual_bus_test test;
+    test.run();
+}
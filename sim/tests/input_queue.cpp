@@ -0,0 +1,143 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+/// @brief  Stresses the input report queue with button edges:
+///         - a sustained rate close to the bus capacity, with a fast host
+///         - bursts of the queue's capacity, with a slow host
+///         - bursts beyond the capacity, where the drops must be accounted for
+///         Each edge toggles the caps lock key, so every received report must alternate.
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include "sim/firmware.hpp"
+
+using namespace sim;
+
+namespace
+{
+using app = hid::demo_app;
+using counter = app::perf_counter;
+
+constexpr auto CAPS_LOCK =
+    static_cast<std::uint8_t>(hid::page::keyboard_keypad::KEYBOARD_CAPS_LOCK);
+
+class input_queue_test
+{
+  public:
+    input_queue_test()
+        : bus_(I2C2, 400'000),
+          host_(bus_, DEVICE_ADDRESS, HID_DESCRIPTOR_REGISTER, EXT_RESET_GPIO_Port, EXT_RESET_Pin)
+    {
+        host_.on_input([this](std::span<const std::uint8_t> report) { input(report); });
+    }
+
+    void run()
+    {
+        if (!set_i2c_bus_speed(st::i2c_speed::FAST))
+        {
+            fail("the bus speed can't be set");
+        }
+        host_.connect();
+
+        // 1000 edges/s, the host reads about 1190 keyboard reports/s at 400 kHz
+        clear_counters(host_);
+        edges(500, MILLISECOND, 0);
+        check_lossless("sustained");
+
+        // the host reacts 5 ms late, so each burst fills up the queue
+        host_.set_response_delay(5 * MILLISECOND);
+        clear_counters(host_);
+        for (int i = 0; i < 20; i++)
+        {
+            edges(app::INPUT_QUEUE_SIZE, 50 * MICROSECOND, 20 * MILLISECOND);
+        }
+        check_lossless("burst");
+        if (read_counter(host_, counter::INPUT_QUEUE_HIGH_WATERMARK) != app::INPUT_QUEUE_SIZE)
+        {
+            fail("the bursts didn't fill the queue");
+        }
+
+        // twice the capacity: everything beyond it is dropped, and counted
+        clear_counters(host_);
+        edges(2 * app::INPUT_QUEUE_SIZE, 50 * MICROSECOND, 20 * MILLISECOND);
+        auto drops = read_counter(host_, counter::INPUT_QUEUE_DROPS) +
+                     read_counter(host_, counter::DEFERRED_WORK_DROPS);
+        std::printf("overflow: %u edges, %u reports, %u drops\n", edges_, received_, drops);
+        if ((drops == 0) or ((received_ + drops) != edges_))
+        {
+            fail("the overflowing reports aren't accounted for");
+        }
+        std::exit(EXIT_SUCCESS);
+    }
+
+  private:
+    void input(std::span<const std::uint8_t> report)
+    {
+        if (report[0] != app::keys_report::ID)
+        {
+            return;
+        }
+        bool pressed = std::find(report.begin() + 1, report.end(), CAPS_LOCK) != report.end();
+        if (pressed == last_pressed_)
+        {
+            out_of_order_++;
+        }
+        last_pressed_ = pressed;
+        received_++;
+    }
+
+    /// @brief Toggles the button a number of times, then waits for the reports to arrive.
+    void edges(unsigned count, picoseconds interval, picoseconds settle)
+    {
+        for (unsigned i = 0; i < count; i++)
+        {
+            button_ = !button_;
+            edges_++;
+            set_input(B1_GPIO_Port, B1_Pin, button_);
+            run_for(interval);
+        }
+        run_for(settle);
+        if (!run_until([this]() { return bus_.idle() and !host_.interrupt_asserted(); },
+                       100 * MILLISECOND))
+        {
+            fail("the reports don't drain");
+        }
+    }
+
+    void check_lossless(const char* name)
+    {
+        auto drops = read_counter(host_, counter::INPUT_QUEUE_DROPS);
+        auto high_watermark = read_counter(host_, counter::INPUT_QUEUE_HIGH_WATERMARK);
+        std::printf("%s: %u edges, %u reports, %u drops, high watermark %u\n", name, edges_,
+                    received_, drops, high_watermark);
+        if ((received_ != edges_) or (drops != 0) or (out_of_order_ != 0))
+        {
+            fail("%s: %u reports lost, %u out of order", name, edges_ - received_,
+                 out_of_order_);
+        }
+        edges_ = 0;
+        received_ = 0;
+    }
+
+    bus_master bus_;
+    hid_host host_;
+    unsigned edges_{};
+    unsigned received_{};
+    unsigned out_of_order_{};
+    bool button_{};
+    bool last_pressed_{};
+};
+} // namespace
+
+extern "C" void test_i2c_hid_device()
+{
+    static input_queue_test test;
+    test.run();
+}
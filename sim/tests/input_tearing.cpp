@@ -0,0 +1,143 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+/// @brief  Keeps changing the input reports while the transport sends them:
+///         mouse motion of varying size arrives faster than the host reads the reports,
+///         the button toggles the caps lock key, and the host reads the mouse state with
+///         GET_REPORT in between. Every motion event moves as much on X as on -Y, so a report
+///         that the application modified during its transfer would break the symmetry.
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include "sim/firmware.hpp"
+
+using namespace sim;
+
+namespace
+{
+using app = hid::demo_app;
+
+constexpr picoseconds MEASUREMENT = 200 * MILLISECOND;
+constexpr picoseconds MOTION_INTERVAL = 50 * MICROSECOND;
+constexpr picoseconds BUTTON_INTERVAL = 2300 * MICROSECOND;
+constexpr picoseconds GET_REPORT_INTERVAL = 5 * MILLISECOND;
+// the motion accumulated during a report's transfer must not saturate the report
+constexpr int MAX_STEP = 3;
+
+constexpr auto CAPS_LOCK =
+    static_cast<std::uint8_t>(hid::page::keyboard_keypad::KEYBOARD_CAPS_LOCK);
+
+class input_tearing_test
+{
+  public:
+    input_tearing_test()
+        : bus_(I2C2, 400'000),
+          host_(bus_, DEVICE_ADDRESS, HID_DESCRIPTOR_REGISTER, EXT_RESET_GPIO_Port, EXT_RESET_Pin)
+    {
+        host_.on_input([this](std::span<const std::uint8_t> report) { input(report); });
+    }
+
+    void run()
+    {
+        if (!set_i2c_bus_speed(st::i2c_speed::FAST))
+        {
+            fail("the bus speed can't be set");
+        }
+        host_.connect();
+
+        auto& application = app::instance();
+        auto end = now() + MEASUREMENT;
+        auto next_button = now();
+        auto next_get_report = now();
+        for (int step = 1; now() < end; step = (step % MAX_STEP) + 1)
+        {
+            sent_motion_ += step;
+            at_transport_priority([&]() { application.mouse_motion(step, -step); });
+            if (now() >= next_button)
+            {
+                pressed_ = !pressed_;
+                set_input(B1_GPIO_Port, B1_Pin, pressed_);
+                next_button = now() + BUTTON_INTERVAL;
+            }
+            if (now() >= next_get_report)
+            {
+                auto report = host_.get_report(hid_host::report_type::INPUT,
+                                               app::mouse_report::ID, sizeof(app::mouse_report));
+                check_mouse(report, "GET_REPORT");
+                snapshots_++;
+                next_get_report = now() + GET_REPORT_INTERVAL;
+            }
+            run_for(MOTION_INTERVAL);
+        }
+        if (!run_until([this]() { return received_motion_ == sent_motion_; },
+                       10 * MILLISECOND))
+        {
+            fail("the motion isn't delivered, %ld of %ld", received_motion_, sent_motion_);
+        }
+
+        std::printf("%lu mouse reports, %lu keyboard reports and %lu mouse snapshots "
+                    "without tearing\n",
+                    mouse_reports_, keyboard_reports_, snapshots_);
+        std::exit(EXIT_SUCCESS);
+    }
+
+  private:
+    void check_mouse(std::span<const std::uint8_t> report, const char* source)
+    {
+        if (report.size() != sizeof(app::mouse_report))
+        {
+            fail("%s: unexpected mouse report size %zu", source, report.size());
+        }
+        auto x = static_cast<std::int8_t>(report[2]);
+        auto y = static_cast<std::int8_t>(report[3]);
+        if ((x < 0) or (y != -x))
+        {
+            fail("%s: torn mouse report %d, %d", source, x, y);
+        }
+    }
+
+    void input(std::span<const std::uint8_t> report)
+    {
+        if (report[0] == app::mouse_report::ID)
+        {
+            check_mouse(report, "input report");
+            received_motion_ += static_cast<std::int8_t>(report[2]);
+            mouse_reports_++;
+        }
+        else if (report[0] == app::keys_report::ID)
+        {
+            // the caps lock state alternates, the drops of a full queue are both edges
+            bool pressed = std::find(report.begin() + 1, report.end(), CAPS_LOCK) != report.end();
+            if ((keyboard_reports_ > 0) and (pressed == keyboard_pressed_))
+            {
+                fail("the keyboard report doesn't alternate");
+            }
+            keyboard_pressed_ = pressed;
+            keyboard_reports_++;
+        }
+    }
+
+    bus_master bus_;
+    hid_host host_;
+    long sent_motion_{};
+    long received_motion_{};
+    unsigned long mouse_reports_{};
+    unsigned long keyboard_reports_{};
+    unsigned long snapshots_{};
+    bool pressed_{};
+    bool keyboard_pressed_{};
+};
+} // namespace
+
+extern "C" void test_i2c_hid_device()
+{
+    static input_tearing_test test;
+    test.run();
+}
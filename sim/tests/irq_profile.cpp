@@ -0,0 +1,174 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+/// @brief  Checks the interrupt priority plan, and the residency profile of the vectors:
+///         - the NVIC holds the priorities of irq_priorities.h
+///         - with I2C_HID_IRQ_PROFILE, the residencies that the firmware reports are within
+///           the handler cycles that the simulation measures, and the worst case I2C entry
+///           delay is the longest DMA residency, as no other vector is at the same or higher level
+///         - without it, the profile counters stay zero
+#include <cstdio>
+#include <cstdlib>
+#include "irq_priorities.h"
+#include "sim/firmware.hpp"
+
+using namespace sim;
+
+namespace
+{
+using app = hid::demo_app;
+using counter = app::perf_counter;
+
+constexpr picoseconds MEASUREMENT = 50 * MILLISECOND;
+
+struct vector_priority
+{
+    IRQn_Type irq;
+    std::uint32_t priority;
+};
+constexpr vector_priority PLAN[]{
+    {I2C2_IRQn, IRQ_PRIORITY_I2C_HID},
+    {DMA1_Channel4_5_6_7_IRQn, IRQ_PRIORITY_I2C_HID_DMA},
+    {EXTI0_1_IRQn, IRQ_PRIORITY_BUTTON},
+    {SysTick_IRQn, IRQ_PRIORITY_TICK},
+    {PendSV_IRQn, IRQ_PRIORITY_DEFERRED_WORK},
+};
+
+struct vector_profile
+{
+    const char* name;
+    IRQn_Type irq;
+    counter max_cycles;
+};
+constexpr vector_profile PROFILES[]{
+    {"I2C", I2C2_IRQn, counter::I2C_IRQ_MAX_CYCLES},
+    {"DMA", DMA1_Channel4_5_6_7_IRQn, counter::DMA_IRQ_MAX_CYCLES},
+    {"button", EXTI0_1_IRQn, counter::BUTTON_IRQ_MAX_CYCLES},
+    {"deferred work", PendSV_IRQn, counter::DEFERRED_WORK_MAX_CYCLES},
+};
+
+class irq_profile_test
+{
+  public:
+    irq_profile_test()
+        : bus_(I2C2, 400'000),
+          host_(bus_, DEVICE_ADDRESS, HID_DESCRIPTOR_REGISTER, EXT_RESET_GPIO_Port, EXT_RESET_Pin)
+    {
+        host_.on_input([this](std::span<const std::uint8_t> report) { input(report); });
+    }
+
+    void run()
+    {
+        for (auto& plan : PLAN)
+        {
+            if (NVIC_GetPriority(plan.irq) != plan.priority)
+            {
+                fail("interrupt %d has priority %u instead of %u", plan.irq,
+                     NVIC_GetPriority(plan.irq), plan.priority);
+            }
+        }
+        if (!set_i2c_bus_speed(st::i2c_speed::FAST))
+        {
+            fail("the bus speed can't be set");
+        }
+        host_.connect();
+
+        // the simulation measures a superset of what the firmware does after its clearing
+        clear_handler_cycles();
+        clear_counters(host_);
+        generate_load();
+
+        auto counters = read_counters();
+        std::printf("%-14s %16s %16s\n", "vector", "profile (cycles)", "handler (cycles)");
+        for (auto& profile : PROFILES)
+        {
+            auto reported = counters[static_cast<std::size_t>(profile.max_cycles)];
+            auto measured = handler_cycles(profile.irq).max;
+            std::printf("%-14s %16u %16llu\n", profile.name, reported,
+                        static_cast<unsigned long long>(measured));
+#if I2C_HID_IRQ_PROFILE
+            if ((reported == 0) or (reported > measured))
+            {
+                fail("the %s residency isn't measured in the handler", profile.name);
+            }
+#else
+            if (reported != 0)
+            {
+                fail("the %s residency is measured without the profile", profile.name);
+            }
+#endif
+        }
+        auto worst_delay = counters[static_cast<std::size_t>(counter::I2C_IRQ_WORST_DELAY_CYCLES)];
+        std::printf("worst case I2C entry delay: %u cycles\n", worst_delay);
+        if (worst_delay != counters[static_cast<std::size_t>(counter::DMA_IRQ_MAX_CYCLES)])
+        {
+            fail("the I2C entry delay isn't bounded by the DMA vector of its level");
+        }
+        std::exit(EXIT_SUCCESS);
+    }
+
+  private:
+    void input(std::span<const std::uint8_t> report)
+    {
+        if (report[0] == app::keys_report::ID)
+        {
+            // each edge of the button produces a report
+            pressed_ = !pressed_;
+            set_input(B1_GPIO_Port, B1_Pin, pressed_);
+        }
+    }
+
+    /// @brief Runs every profiled vector: the button edges go through the deferred work,
+    ///        the raw stream frames are received with DMA.
+    void generate_load()
+    {
+        pressed_ = !pressed_;
+        set_input(B1_GPIO_Port, B1_Pin, pressed_);
+        auto end = now() + MEASUREMENT;
+        std::array<std::uint8_t, sizeof(app::raw_out_report)> frame{app::raw_out_report::ID};
+        while (now() < end)
+        {
+            if (!host_.output_report(frame))
+            {
+                fail("the output report isn't accepted");
+            }
+            run_for(MILLISECOND);
+        }
+        if (!run_until([this]() { return bus_.idle(); }, 10 * MILLISECOND))
+        {
+            fail("the bus doesn't become idle");
+        }
+    }
+
+    /// @brief Reads all counters with a single report, so they are consistent with each other.
+    std::array<std::uint32_t, app::counters::size() / sizeof(std::uint32_t)> read_counters()
+    {
+        auto report = host_.get_report(hid_host::report_type::FEATURE, app::counters_report::ID,
+                                       sizeof(app::counters_report));
+        if (report.size() != (1 + app::counters::size()))
+        {
+            fail("the counters report can't be read");
+        }
+        std::array<std::uint32_t, app::counters::size() / sizeof(std::uint32_t)> counters;
+        std::memcpy(counters.data(), report.data() + 1, app::counters::size());
+        return counters;
+    }
+
+    bus_master bus_;
+    hid_host host_;
+    bool pressed_{};
+};
+} // namespace
+
+extern "C" void test_i2c_hid_device()
+{
+    static irq_profile_test test;
+    test.run();
+}
@@ -0,0 +1,145 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+/// @brief  Compares the longest interrupt disabled window, that the I2C_HID_LOCK_PROFILE
+///         configuration reports, with the longest window that the simulated core observes.
+///         The idle loop of the I2C_HID_IDLE_CLOCK_SCALING configuration switches the clock
+///         with the interrupts masked, and sleeps that way, the window must be measured without
+///         the sleep, and attributed to the idle loop. The window spans both clock frequencies,
+///         so they are compared in time.
+#include <cstdio>
+#include <cstdlib>
+#include "sim/firmware.hpp"
+#include "st/timestamp.hpp"
+
+using namespace sim;
+
+extern "C" void i2c_hid_idle();
+
+namespace
+{
+using app = hid::demo_app;
+using counter = app::perf_counter;
+
+constexpr picoseconds MEASUREMENT = 50 * MILLISECOND;
+// the timestamp reads and the recording, that are outside of the measured window,
+// at the idle clock
+constexpr picoseconds LOCK_OVERHEAD = 64 * SECOND / HSI_VALUE;
+// the timestamps advance in steps of the idle clock
+constexpr picoseconds TIMESTAMP_RESOLUTION = SECOND / HSI_VALUE;
+// the return address of the idle loop's lock is in the first part of the function
+constexpr std::uint32_t IDLE_LOOP_SIZE = 0x400;
+
+class lock_profile_test
+{
+  public:
+    lock_profile_test()
+        : bus_(I2C2, 100'000),
+          host_(bus_, DEVICE_ADDRESS, HID_DESCRIPTOR_REGISTER, EXT_RESET_GPIO_Port, EXT_RESET_Pin)
+    {
+        host_.on_input([this](std::span<const std::uint8_t> report) { input(report); });
+    }
+
+    void run()
+    {
+        // the timing has to meet the bus specification with the idle clock as well
+        if (!set_i2c_bus_speed(st::i2c_speed::STANDARD))
+        {
+            fail("the bus speed can't be set");
+        }
+        host_.connect();
+
+        // the simulation observes a superset of the windows after the firmware's clearing
+        clear_statistics();
+        clear_counters(host_);
+        generate_load();
+
+        // the lock of the counters report records its window after reading the profile
+        auto observed = statistics().max_masked_time;
+        auto report = host_.get_report(hid_host::report_type::FEATURE, app::counters_report::ID,
+                                       sizeof(app::counters_report));
+        auto max_cycles = counter_value(report, counter::LOCK_MAX_CYCLES);
+        auto call_site = counter_value(report, counter::LOCK_MAX_CALL_SITE);
+        auto idle_offset = call_site - static_cast<std::uint32_t>(
+                                           reinterpret_cast<std::uintptr_t>(&i2c_hid_idle));
+        auto reported = static_cast<picoseconds>(max_cycles) * SECOND / st::timestamp::FREQUENCY;
+        std::printf("longest window: %u cycles (%.3f us) reported, %.3f us observed, "
+                    "at i2c_hid_idle+0x%x\n",
+                    max_cycles, static_cast<double>(reported) / MICROSECOND,
+                    static_cast<double>(observed) / MICROSECOND, idle_offset);
+
+        if ((reported > (observed + TIMESTAMP_RESOLUTION)) or
+            ((reported + LOCK_OVERHEAD) < observed))
+        {
+            fail("the reported window doesn't match the observed one");
+        }
+        if (idle_offset >= IDLE_LOOP_SIZE)
+        {
+            fail("the longest window isn't attributed to the idle loop");
+        }
+        std::exit(EXIT_SUCCESS);
+    }
+
+  private:
+    static std::uint32_t counter_value(const std::vector<std::uint8_t>& report, counter c)
+    {
+        if (report.size() != (1 + app::counters::size()))
+        {
+            fail("the counters report can't be read");
+        }
+        std::uint32_t value;
+        std::memcpy(&value, report.data() + 1 + static_cast<std::size_t>(c) * sizeof(value),
+                    sizeof(value));
+        return value;
+    }
+
+    void input(std::span<const std::uint8_t> report)
+    {
+        if (report[0] == app::keys_report::ID)
+        {
+            // each edge of the button produces a report
+            pressed_ = !pressed_;
+            set_input(B1_GPIO_Port, B1_Pin, pressed_);
+        }
+    }
+
+    /// @brief The button edges post deferred work, the raw stream frames update the atomics of
+    ///        the stream, and the bus becomes idle between the frames, so the clock is lowered.
+    void generate_load()
+    {
+        pressed_ = !pressed_;
+        set_input(B1_GPIO_Port, B1_Pin, pressed_);
+        auto end = now() + MEASUREMENT;
+        std::array<std::uint8_t, sizeof(app::raw_out_report)> frame{app::raw_out_report::ID};
+        while (now() < end)
+        {
+            if (!host_.output_report(frame))
+            {
+                fail("the output report isn't accepted");
+            }
+            run_for(MILLISECOND);
+        }
+        if (!run_until([this]() { return bus_.idle(); }, 10 * MILLISECOND))
+        {
+            fail("the bus doesn't become idle");
+        }
+    }
+
+    bus_master bus_;
+    hid_host host_;
+    bool pressed_{};
+};
+} // namespace
+
+extern "C" void test_i2c_hid_device()
+{
+    static lock_profile_test test;
+    test.run();
+}
@@ -0,0 +1,176 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+/// @brief  Reads past the end of the data that the device sends: an input report, a GET_REPORT
+///         response, and an input read without a pending report. For each read:
+///         - the bytes past the length are served as zero padding, without a NACK or an error
+///         - the padding is counted, with the padding transfers
+///         - the interrupts of the read don't depend on the number of padding bytes
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include "sim/firmware.hpp"
+
+using namespace sim;
+
+namespace
+{
+using app = hid::demo_app;
+using counter = app::perf_counter;
+
+constexpr std::uint8_t GET_REPORT = 0x02;
+constexpr std::size_t SHORT_OVER_READ = 8;
+constexpr std::size_t LONG_OVER_READ = 200;
+
+class over_read_test
+{
+  public:
+    over_read_test()
+        : bus_(I2C2, 400'000),
+          host_(bus_, DEVICE_ADDRESS, HID_DESCRIPTOR_REGISTER, EXT_RESET_GPIO_Port, EXT_RESET_Pin)
+    {}
+
+    void run()
+    {
+        if (!set_i2c_bus_speed(st::i2c_speed::FAST))
+        {
+            fail("the bus speed can't be set");
+        }
+        host_.connect();
+        // the test reads the input reports itself, once the host read the initial ones
+        run_for(MILLISECOND);
+        if (!run_until([this]() { return bus_.idle() and !host_.interrupt_asserted(); },
+                       10 * MILLISECOND))
+        {
+            fail("the input reports aren't read after the reset");
+        }
+        host_.set_response_delay(SECOND);
+
+        for (auto extra : {SHORT_OVER_READ, LONG_OVER_READ})
+        {
+            interrupts_[0].push_back(over_read_input(extra));
+            interrupts_[1].push_back(over_read_get_report(extra));
+            interrupts_[2].push_back(over_read_empty(extra));
+        }
+        for (auto& read : interrupts_)
+        {
+            if (read[0] != read[1])
+            {
+                fail("the padding costs interrupts: %llu for %zu bytes, %llu for %zu bytes",
+                     static_cast<unsigned long long>(read[0]), SHORT_OVER_READ,
+                     static_cast<unsigned long long>(read[1]), LONG_OVER_READ);
+            }
+        }
+        std::exit(EXIT_SUCCESS);
+    }
+
+  private:
+    std::uint64_t over_read_input(std::size_t extra)
+    {
+        pressed_ = !pressed_;
+        set_input(B1_GPIO_Port, B1_Pin, pressed_);
+        if (!run_until([this]() { return host_.interrupt_asserted(); }, MILLISECOND))
+        {
+            fail("the input report isn't signalled");
+        }
+        auto interrupts = over_read("input report", {}, host_.hid_descriptor().wMaxInputLength,
+                                    extra, app::keys_report::ID);
+        if (host_.interrupt_asserted())
+        {
+            fail("the input report isn't completed by the over-read");
+        }
+        return interrupts;
+    }
+
+    std::uint64_t over_read_get_report(std::size_t extra)
+    {
+        auto& d = host_.hid_descriptor();
+        std::vector<std::uint8_t> command{
+            static_cast<std::uint8_t>(d.wCommandRegister),
+            static_cast<std::uint8_t>(d.wCommandRegister >> 8),
+            static_cast<std::uint8_t>(
+                (static_cast<std::uint8_t>(hid_host::report_type::INPUT) << 4) |
+                app::keys_report::ID),
+            GET_REPORT,
+            static_cast<std::uint8_t>(d.wDataRegister),
+            static_cast<std::uint8_t>(d.wDataRegister >> 8),
+        };
+        return over_read("GET_REPORT", std::move(command), 2 + sizeof(app::keys_report), extra,
+                         app::keys_report::ID);
+    }
+
+    std::uint64_t over_read_empty(std::size_t extra)
+    {
+        return over_read("empty input", {}, 2, extra, 0);
+    }
+
+    /// @param size: the bytes that the device sends, with the length
+    /// @param extra: the bytes read beyond that
+    /// @return the I2C and DMA interrupts of the transfer
+    std::uint64_t over_read(const char* name, std::vector<std::uint8_t> command,
+                            std::size_t size, std::size_t extra, std::uint8_t id)
+    {
+        clear_counters(host_);
+        clear_handler_cycles();
+        auto r = bus_.execute({DEVICE_ADDRESS, std::move(command), size + extra});
+        auto interrupts =
+            handler_cycles(I2C2_IRQn).count + handler_cycles(DMA1_Channel4_5_6_7_IRQn).count;
+
+        auto length = static_cast<std::size_t>(r.read[0] | (r.read[1] << 8));
+        if (length == 0)
+        {
+            // an empty input read is only the length
+            length = 2;
+        }
+        if ((r.read.size() != (size + extra)) or (length > size) or
+            ((id != 0) and (r.read[2] != id)))
+        {
+            fail("%s: the report isn't read", name);
+        }
+        auto padding =
+            std::count(r.read.begin() + length, r.read.end(), std::uint8_t{}) ==
+            static_cast<std::ptrdiff_t>(r.read.size() - length);
+
+        auto counters = read_counters(host_);
+        auto value = [&counters](counter c) { return counters[static_cast<std::size_t>(c)]; };
+        auto padding_bytes = value(counter::I2C_PADDING_BYTES);
+        auto padding_sends = value(counter::I2C_DUMMY_SENDS);
+        auto nacks = value(counter::I2C_NACKS);
+        auto errors = value(counter::I2C_BUS_ERRORS) + value(counter::I2C_ARBITRATION_LOSSES) +
+                      value(counter::I2C_OVERRUNS);
+        std::printf("%s of %zu bytes, read %zu: %u padding bytes in %u padding transfers, "
+                    "%u NACKs, %u errors, %llu interrupts\n",
+                    name, length, r.read.size(), padding_bytes, padding_sends, nacks, errors,
+                    static_cast<unsigned long long>(interrupts));
+        // the padding includes the byte loaded to the transmit data register when the host NACKs
+        if (!padding or (padding_bytes != (r.read.size() - length + 1)) or (padding_sends != 1))
+        {
+            fail("%s: the over-read isn't padded", name);
+        }
+        if (!r.acknowledged or r.aborted or (nacks != 0) or (errors != 0) or
+            (statistics().error_handlers != 0))
+        {
+            fail("%s: the over-read fails", name);
+        }
+        return interrupts;
+    }
+
+    bus_master bus_;
+    hid_host host_;
+    std::array<std::vector<std::uint64_t>, 3> interrupts_{};
+    bool pressed_{};
+};
+} // namespace
+
+extern "C" void test_i2c_hid_device()
+{
+    static over_read_test test;
+    test.run();
+}
@@ -0,0 +1,157 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+/// @brief  Exhausts the report pool of a firmware, that has fewer blocks than the input queue:
+///         - a burst of button edges with a slow host takes every block, the edges beyond that
+///           are dropped, and counted
+///         - the mouse motion during the exhaustion accumulates, and is delivered afterwards
+///         - a GET_REPORT snapshot without a free block is answered with an empty report
+///         - once the reports are sent, every block is returned, and the next burst is lossless
+#include <cstdio>
+#include <cstdlib>
+#include "sim/firmware.hpp"
+
+using namespace sim;
+
+namespace
+{
+using app = hid::demo_app;
+using counter = app::perf_counter;
+
+static_assert(app::REPORT_BLOCK_COUNT < app::INPUT_QUEUE_SIZE);
+
+constexpr int MOTION_STEP = 5;
+constexpr int MOTION_EVENTS = 20;
+
+class report_pool_test
+{
+  public:
+    report_pool_test()
+        : bus_(I2C2, 400'000),
+          host_(bus_, DEVICE_ADDRESS, HID_DESCRIPTOR_REGISTER, EXT_RESET_GPIO_Port, EXT_RESET_Pin)
+    {
+        host_.on_input([this](std::span<const std::uint8_t> report) { input(report); });
+    }
+
+    void run()
+    {
+        if (!set_i2c_bus_speed(st::i2c_speed::FAST))
+        {
+            fail("the bus speed can't be set");
+        }
+        host_.connect();
+
+        // the host reacts late, so the queued reports hold their blocks
+        host_.set_response_delay(5 * MILLISECOND);
+        clear_counters(host_);
+        edges(app::INPUT_QUEUE_SIZE);
+        auto& application = app::instance();
+        for (int i = 0; i < MOTION_EVENTS; i++)
+        {
+            sent_motion_ += MOTION_STEP;
+            at_transport_priority([&]() { application.mouse_motion(MOTION_STEP, 0); });
+        }
+        auto snapshot = host_.get_report(hid_host::report_type::INPUT, app::mouse_report::ID,
+                                         sizeof(app::mouse_report));
+        if (!snapshot.empty())
+        {
+            fail("the snapshot is sent without a free block");
+        }
+        drain();
+
+        auto queue_drops = read_counter(host_, counter::INPUT_QUEUE_DROPS);
+        auto drops = queue_drops + read_counter(host_, counter::DEFERRED_WORK_DROPS);
+        auto failures = read_counter(host_, counter::REPORT_POOL_FAILURES);
+        auto high_watermark = read_counter(host_, counter::REPORT_POOL_HIGH_WATERMARK);
+        std::printf("exhaustion: %u edges, %u keyboard reports, %u drops, %u allocation failures, "
+                    "high watermark %u of %zu blocks, motion %ld of %ld\n",
+                    edges_, received_, drops, failures, high_watermark, app::REPORT_BLOCK_COUNT,
+                    received_motion_, sent_motion_);
+        if ((drops == 0) or ((received_ + drops) != edges_))
+        {
+            fail("the dropped reports aren't accounted for");
+        }
+        // the mouse report and the snapshot fail to allocate as well
+        if ((failures <= queue_drops) or (high_watermark != app::REPORT_BLOCK_COUNT))
+        {
+            fail("the pool wasn't exhausted");
+        }
+        if (received_motion_ != sent_motion_)
+        {
+            fail("the motion isn't delivered");
+        }
+
+        // with everything sent, clearing the statistics leaves the blocks in use as watermark
+        clear_counters(host_);
+        if (read_counter(host_, counter::REPORT_POOL_HIGH_WATERMARK) != 0)
+        {
+            fail("blocks are leaked");
+        }
+        edges_ = 0;
+        received_ = 0;
+        edges(app::REPORT_BLOCK_COUNT);
+        drain();
+        std::printf("recovery: %u edges, %u keyboard reports\n", edges_, received_);
+        if ((received_ != edges_) or (read_counter(host_, counter::REPORT_POOL_FAILURES) != 0))
+        {
+            fail("the pool doesn't recover");
+        }
+        std::exit(EXIT_SUCCESS);
+    }
+
+  private:
+    void input(std::span<const std::uint8_t> report)
+    {
+        if (report[0] == app::keys_report::ID)
+        {
+            received_++;
+        }
+        else if (report[0] == app::mouse_report::ID)
+        {
+            received_motion_ += static_cast<std::int8_t>(report[2]);
+        }
+    }
+
+    void edges(unsigned count)
+    {
+        for (unsigned i = 0; i < count; i++)
+        {
+            button_ = !button_;
+            edges_++;
+            set_input(B1_GPIO_Port, B1_Pin, button_);
+            run_for(50 * MICROSECOND);
+        }
+    }
+
+    void drain()
+    {
+        if (!run_until(
+                [this]() { return bus_.idle() and !host_.interrupt_asserted(); },
+                100 * MILLISECOND))
+        {
+            fail("the reports don't drain");
+        }
+    }
+
+    bus_master bus_;
+    hid_host host_;
+    unsigned edges_{};
+    unsigned received_{};
+    long sent_motion_{};
+    long received_motion_{};
+    bool button_{};
+};
+} // namespace
+
+extern "C" void test_i2c_hid_device()
+{
+    static report_pool_test test;
+    test.run();
+}
@@ -0,0 +1,137 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+/// @brief  Races the seqlock of the input report state: a writer in thread mode modifies
+///         the value word by word, while an interrupt at the priority of the transport reads it
+///         at an interval that drifts across the writer's loop. Every word of a consistent value
+///         is equal, the same value without the seqlock shows that the reads did hit
+///         the writer in the middle of its modifications.
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include "hid/seqlock.hpp"
+#include "irq_priorities.h"
+#include "sim/firmware.hpp"
+
+using namespace sim;
+
+namespace
+{
+constexpr IRQn_Type READER_IRQ = TIM2_IRQn;
+constexpr picoseconds READ_INTERVAL = 2900 * NANOSECOND;
+constexpr picoseconds MEASUREMENT = 20 * MILLISECOND;
+
+using value = std::array<std::uint32_t, 8>;
+
+struct race_stats
+{
+    std::uint64_t reads;
+    std::uint64_t reads_during_modify;
+    std::uint64_t torn_snapshots;
+    std::uint64_t torn_unprotected;
+};
+
+hid::seqlock<value> shared{};
+value unprotected{};
+race_stats stats{};
+bool reading = false;
+
+// each word is written by a call, where the reader can preempt the writer
+void store_word(value& v, std::size_t index, std::uint32_t word)
+{
+    v[index] = word;
+}
+
+bool consistent(const value& v)
+{
+    for (auto word : v)
+    {
+        if (word != v[0])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void reader_handler()
+{
+    value snapshot;
+    auto version = shared.read(snapshot);
+    value copy = unprotected;
+    stats.reads++;
+    // an odd version is read while the writer modifies the other copy
+    stats.reads_during_modify += version & 1;
+    stats.torn_snapshots += !consistent(snapshot);
+    stats.torn_unprotected += !consistent(copy);
+}
+
+void request_read()
+{
+    if (reading)
+    {
+        trigger_interrupt(READER_IRQ);
+        schedule(READ_INTERVAL, request_read);
+    }
+}
+
+class seqlock_race_test
+{
+  public:
+    void run()
+    {
+        connect_handler(READER_IRQ, reader_handler);
+        NVIC_SetPriority(READER_IRQ, IRQ_PRIORITY_I2C_HID);
+        NVIC_EnableIRQ(READER_IRQ);
+
+        reading = true;
+        schedule(READ_INTERVAL, request_read);
+        auto end = now() + MEASUREMENT;
+        for (std::uint32_t n = 1; now() < end; n++)
+        {
+            shared.modify(
+                [n](value& v)
+                {
+                    for (std::size_t i = 0; i < v.size(); i++)
+                    {
+                        store_word(v, i, n);
+                    }
+                });
+            for (std::size_t i = 0; i < unprotected.size(); i++)
+            {
+                store_word(unprotected, i, n);
+            }
+        }
+        reading = false;
+
+        std::printf("%llu reads, %llu during a modification, torn: %llu with the seqlock, "
+                    "%llu without\n",
+                    static_cast<unsigned long long>(stats.reads),
+                    static_cast<unsigned long long>(stats.reads_during_modify),
+                    static_cast<unsigned long long>(stats.torn_snapshots),
+                    static_cast<unsigned long long>(stats.torn_unprotected));
+        if ((stats.reads_during_modify == 0) or (stats.torn_unprotected == 0))
+        {
+            fail("the reads didn't preempt the writer");
+        }
+        if (stats.torn_snapshots != 0)
+        {
+            fail("a torn snapshot was read");
+        }
+        std::exit(EXIT_SUCCESS);
+    }
+};
+} // namespace
+
+extern "C" void test_i2c_hid_device()
+{
+    static seqlock_race_test test;
+    test.run();
+}
@@ -0,0 +1,92 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+/// @brief  Grows the stack usage in the painted stack area, that the idle loop scans:
+///         - the peak usage and the free RAM reported by the counters follow each new depth
+///         - a stack reaching down to the canary, but not into it, is only reported
+///         - overwriting a word of the canary stops the firmware at the next idle loop pass
+#include <cstdio>
+#include <cstdlib>
+#include "sim/firmware.hpp"
+
+using namespace sim;
+
+namespace
+{
+using app = hid::demo_app;
+using counter = app::perf_counter;
+
+constexpr std::uint32_t USED = 0xDEADBEEF;
+constexpr std::size_t CANARY_BYTES = I2C_HID_STACK_CANARY_WORDS * sizeof(std::uint32_t);
+// a full scan takes a chunk per idle loop pass, the tick wakes the core every millisecond
+constexpr picoseconds SCAN_TIME = 100 * MILLISECOND;
+// the canary is checked before every scan step
+constexpr picoseconds CANARY_DETECTION = 2 * MILLISECOND;
+
+class stack_canary_test
+{
+  public:
+    stack_canary_test()
+        : bus_(I2C2, 400'000),
+          host_(bus_, DEVICE_ADDRESS, HID_DESCRIPTOR_REGISTER, EXT_RESET_GPIO_Port, EXT_RESET_Pin)
+    {}
+
+    void run()
+    {
+        if (!set_i2c_bus_speed(st::i2c_speed::FAST))
+        {
+            fail("the bus speed can't be set");
+        }
+        host_.connect();
+
+        auto area = static_cast<std::size_t>(stack_top() - stack_bottom()) * sizeof(std::uint32_t);
+        check_usage(0, area);
+        check_usage(1024, area);
+        check_usage(2048, area);
+        // the deepest usage that leaves the canary intact
+        check_usage(area - CANARY_BYTES, area);
+
+        on_error_handler(
+            []()
+            {
+                std::printf("the overwritten canary stopped the firmware\n");
+                std::exit(EXIT_SUCCESS);
+            });
+        stack_bottom()[I2C_HID_STACK_CANARY_WORDS - 1] = USED;
+        run_for(CANARY_DETECTION);
+        fail("the overwritten canary isn't detected");
+    }
+
+  private:
+    /// @brief Marks the top of the stack area as used, like the deepest call chain would.
+    void check_usage(std::size_t bytes, std::size_t area)
+    {
+        std::fill(stack_top() - bytes / sizeof(std::uint32_t), stack_top(), USED);
+        run_for(SCAN_TIME);
+
+        auto peak = read_counter(host_, counter::STACK_PEAK_BYTES);
+        auto free = read_counter(host_, counter::STACK_FREE_BYTES);
+        std::printf("%zu bytes used: %u bytes peak, %u bytes free\n", bytes, peak, free);
+        if ((peak != bytes) or (free != (area - bytes)))
+        {
+            fail("the stack usage isn't measured");
+        }
+    }
+
+    bus_master bus_;
+    hid_host host_;
+};
+} // namespace
+
+extern "C" void test_i2c_hid_device()
+{
+    static stack_canary_test test;
+    test.run();
+}
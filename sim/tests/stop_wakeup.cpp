@@ -0,0 +1,86 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+/// @brief  Wakes the device up from STOP mode with transfers on I2C1, and compares the
+///         longest wakeup time, that the device reports, with the clock stretching that the
+///         host observes at the address of each transfer.
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include "sim/firmware.hpp"
+
+using namespace sim;
+
+namespace
+{
+using app = hid::demo_app;
+using counter = app::perf_counter;
+
+constexpr unsigned WAKEUPS = 10;
+// the STOP mode exit of the simulated core, before the firmware continues
+constexpr std::uint32_t REGULATOR_WAKEUP_US = 5;
+
+class stop_wakeup_test
+{
+  public:
+    stop_wakeup_test()
+        : bus_(I2C1, 100'000),
+          host_(bus_, DEVICE_ADDRESS, HID_DESCRIPTOR_REGISTER, EXT_RESET_GPIO_Port, EXT_RESET_Pin)
+    {}
+
+    void run()
+    {
+        host_.connect();
+        clear_counters(host_);
+
+        picoseconds max_stretched = 0;
+        for (unsigned i = 0; i < WAKEUPS; i++)
+        {
+            run_for(5 * MILLISECOND);
+            bus_.clear_stats();
+            if (!host_.set_power(true))
+            {
+                fail("the device doesn't wake up");
+            }
+            max_stretched = std::max(max_stretched, bus_.stats().stretched);
+        }
+        // the counters are read by transfers that wake up the device too,
+        // they are stretched for the preparation of the report as well
+        auto stop_entries = read_counter(host_, counter::STOP_ENTRIES);
+        auto max_wakeup_us = read_counter(host_, counter::MAX_WAKEUP_US);
+
+        auto stretched_us = static_cast<std::uint32_t>(max_stretched / MICROSECOND);
+        std::printf("%u STOP entries, longest wakeup %u us, longest clock stretching %u us\n",
+                    stop_entries, max_wakeup_us, stretched_us);
+        if (stop_entries < WAKEUPS)
+        {
+            fail("the device didn't enter STOP mode while the bus was idle");
+        }
+        // the stretching also includes the regulator's wakeup, that the timer can't measure,
+        // and both parts of the measurement are truncated to microseconds
+        if ((max_wakeup_us > stretched_us) or
+            ((stretched_us - max_wakeup_us) > (REGULATOR_WAKEUP_US + 2)))
+        {
+            fail("the wakeup time doesn't cover the servicing of the address");
+        }
+        std::exit(EXIT_SUCCESS);
+    }
+
+  private:
+    bus_master bus_;
+    hid_host host_;
+};
+} // namespace
+
+extern "C" void test_i2c_hid_device()
+{
+    static stop_wakeup_test test;
+    test.run();
+}
@@ -1,42 +1,64 @@
 // https://stackoverflow.com/questions/74333402/how-to-implement-atomic-operations-on-multi-core-cortex-m0-m0-no-swp-no-ldr
 // https://stackoverflow.com/questions/71626597/what-are-the-various-ways-to-disable-and-re-enable-interrupts-in-stm32-microcont
-#include "st/stm32cmsis.h"
-
-class interrupt_lock
-{
-    uint32_t priomask_;
-
-  public:
-    interrupt_lock()
-    {
-        priomask_ = __get_PRIMASK();
-        __disable_irq();
-    }
-
-    ~interrupt_lock()
-    {
-        if (priomask_ == 0)
-        {
-            __enable_irq();
-        }
-    }
-};
+#include "st/atomic_ops.hpp"
 
 #if __CORTEX_M < 3
-extern "C" bool __atomic_compare_exchange_4(volatile void* ptr, void* expected,
-                                            unsigned int desired, [[maybe_unused]] bool weak,
-                                            [[maybe_unused]] int success_memorder,
-                                            [[maybe_unused]] int failure_memorder)
-{
-    interrupt_lock lock;
-    unsigned int value = *(volatile unsigned int*)ptr;
-    if (value == *(unsigned int*)expected)
-    {
-        *(volatile unsigned int*)ptr = desired;
-        return true;
+// the libcalls that the compiler emits for std::atomic operations it can't inline,
+// each one is a single short critical section, instead of a compare-exchange retry loop,
+// which is attributed to the caller of the libcall when the locks are profiled
+#define CALLER __builtin_return_address(0)
+#define CORTEX_M0_ATOMIC_LIBCALLS(SIZE, TYPE)                                                      \
+    extern "C" TYPE __atomic_load_##SIZE(const volatile void* ptr,                                 \
+                                         [[maybe_unused]] int memorder)                            \
+    {                                                                                              \
+        return st::atomic_ops<TYPE>::load(ptr);                                                    \
+    }                                                                                              \
+    extern "C" void __atomic_store_##SIZE(volatile void* ptr, TYPE value,                          \
+                                          [[maybe_unused]] int memorder)                           \
+    {                                                                                              \
+        st::atomic_ops<TYPE>::store(ptr, value);                                                   \
+    }                                                                                              \
+    extern "C" TYPE __atomic_exchange_##SIZE(volatile void* ptr, TYPE value,                       \
+                                             [[maybe_unused]] int memorder)                        \
+    {                                                                                              \
+        return st::atomic_ops<TYPE>::exchange(ptr, value, CALLER);                                 \
+    }                                                                                              \
+    extern "C" bool __atomic_compare_exchange_##SIZE(                                              \
+        volatile void* ptr, void* expected, TYPE desired, [[maybe_unused]] bool weak,              \
+        [[maybe_unused]] int success_memorder, [[maybe_unused]] int failure_memorder)              \
+    {                                                                                              \
+        return st::atomic_ops<TYPE>::compare_exchange(ptr, expected, desired, CALLER);             \
+    }                                                                                              \
+    extern "C" TYPE __atomic_fetch_add_##SIZE(volatile void* ptr, TYPE value,                      \
+                                              [[maybe_unused]] int memorder)                       \
+    {                                                                                              \
+        return st::atomic_ops<TYPE>::fetch_add(ptr, value, CALLER);                                \
+    }                                                                                              \
+    extern "C" TYPE __atomic_fetch_sub_##SIZE(volatile void* ptr, TYPE value,                      \
+                                              [[maybe_unused]] int memorder)                       \
+    {                                                                                              \
+        return st::atomic_ops<TYPE>::fetch_sub(ptr, value, CALLER);                                \
+    }                                                                                              \
+    extern "C" TYPE __atomic_fetch_and_##SIZE(volatile void* ptr, TYPE value,                      \
+                                              [[maybe_unused]] int memorder)                       \
+    {                                                                                              \
+        return st::atomic_ops<TYPE>::fetch_and(ptr, value, CALLER);                                \
+    }                                                                                              \
+    extern "C" TYPE __atomic_fetch_or_##SIZE(volatile void* ptr, TYPE value,                       \
+                                             [[maybe_unused]] int memorder)                        \
+    {                                                                                              \
+        return st::atomic_ops<TYPE>::fetch_or(ptr, value, CALLER);                                 \
+    }                                                                                              \
+    extern "C" TYPE __atomic_fetch_xor_##SIZE(volatile void* ptr, TYPE value,                      \
+                                              [[maybe_unused]] int memorder)                       \
+    {                                                                                              \
+        return st::atomic_ops<TYPE>::fetch_xor(ptr, value, CALLER);                                \
     }
-    *(unsigned int*)expected = value;
-    return false;
-}
 
-#endif
\ No newline at end of file
+CORTEX_M0_ATOMIC_LIBCALLS(1, unsigned char)
+CORTEX_M0_ATOMIC_LIBCALLS(2, unsigned short)
+CORTEX_M0_ATOMIC_LIBCALLS(4, unsigned int)
+
+#undef CORTEX_M0_ATOMIC_LIBCALLS
+#undef CALLER
+#endif
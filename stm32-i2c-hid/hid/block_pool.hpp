@@ -0,0 +1,122 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+#ifndef __HID_BLOCK_POOL_HPP_
+#define __HID_BLOCK_POOL_HPP_
+
+#include <array>
+#include <cstdint>
+
+namespace hid
+{
+/// @brief Placeholder lock, for pools that are only used from a single interrupt priority level.
+struct unlocked
+{};
+
+/// @brief Pool of fixed size memory blocks, with O(1) allocation and deallocation,
+///        so that different users of report buffers can share a single RAM budget.
+///        The free blocks are chained by their indexes, in a separate array.
+/// @tparam BLOCK_SIZE: the size of a block, typically the largest report it has to hold
+/// @tparam BLOCK_COUNT: the number of blocks
+/// @tparam TLock: scoped lock type, that protects the pool when it's used from different
+///                interrupt priorities (demo_app::report_pool_lock), the default is only safe
+///                when all users run at the same priority level
+template <std::size_t BLOCK_SIZE, std::size_t BLOCK_COUNT, typename TLock = unlocked>
+class block_pool
+{
+    static_assert((BLOCK_SIZE > 0) and (BLOCK_COUNT > 0) and (BLOCK_COUNT < UINT8_MAX));
+    using index_type = std::uint8_t;
+    static constexpr index_type NONE = UINT8_MAX;
+    // keeps every block word aligned
+    static constexpr std::size_t STRIDE = (BLOCK_SIZE + sizeof(std::uint32_t) - 1) &
+                                          ~(sizeof(std::uint32_t) - 1);
+
+  public:
+    struct statistics
+    {
+        std::uint16_t in_use;
+        std::uint16_t high_watermark;
+        std::uint32_t failures;
+    };
+
+    static constexpr std::size_t block_size() { return BLOCK_SIZE; }
+    static constexpr std::size_t block_count() { return BLOCK_COUNT; }
+
+    constexpr block_pool()
+    {
+        for (std::size_t i = 0; i < BLOCK_COUNT; i++)
+        {
+            next_[i] = (i + 1) < BLOCK_COUNT ? (i + 1) : NONE;
+        }
+    }
+
+    block_pool(const block_pool&) = delete;
+    block_pool& operator=(const block_pool&) = delete;
+
+    /// @brief Takes a block from the pool.
+    /// @return the block of block_size() bytes, or nullptr if all blocks are in use
+    std::uint8_t* allocate()
+    {
+        [[maybe_unused]] TLock lock;
+        auto index = free_;
+        if (index == NONE)
+        {
+            stats_.failures++;
+            return nullptr;
+        }
+        free_ = next_[index];
+        stats_.in_use++;
+        if (stats_.in_use > stats_.high_watermark)
+        {
+            stats_.high_watermark = stats_.in_use;
+        }
+        return blocks_[index].data();
+    }
+
+    /// @brief Returns a block to the pool.
+    /// @param block: a block returned by allocate()
+    void deallocate(const std::uint8_t* block)
+    {
+        [[maybe_unused]] TLock lock;
+        auto index = index_of(block);
+        next_[index] = free_;
+        free_ = index;
+        stats_.in_use--;
+    }
+
+    /// @brief Checks whether the data is located in one of the blocks.
+    bool owns(const std::uint8_t* data) const
+    {
+        return (data >= blocks_.front().data()) and (data < (blocks_.back().data() + STRIDE));
+    }
+
+    const statistics& stats() const { return stats_; }
+    void reset_stats()
+    {
+        [[maybe_unused]] TLock lock;
+        stats_.high_watermark = stats_.in_use;
+        stats_.failures = 0;
+    }
+
+  private:
+    index_type index_of(const std::uint8_t* block) const
+    {
+        return static_cast<index_type>((block - blocks_.front().data()) / STRIDE);
+    }
+
+    alignas(std::uint32_t) std::array<std::array<std::uint8_t, STRIDE>, BLOCK_COUNT> blocks_{};
+    std::array<index_type, BLOCK_COUNT> next_{};
+    index_type free_{};
+    statistics stats_{};
+};
+
+} // namespace hid
+
+#endif // __HID_BLOCK_POOL_HPP_
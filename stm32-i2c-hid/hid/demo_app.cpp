@@ -8,13 +8,25 @@
 ///         If a copy of the MPL was not distributed with this file, You can obtain one at
 ///         https://mozilla.org/MPL/2.0/.
 ///
+#include <limits>
+#include <utility>
 #include "hid/demo_app.hpp"
 
 extern void set_led(bool on);
+extern void read_transport_counters(std::size_t bus, hid::demo_app::counters& counters);
+extern void clear_transport_counters(std::size_t bus);
+extern void read_interrupt_latency(std::size_t bus, const std::span<uint8_t>& data);
+extern void clear_interrupt_latency(std::size_t bus);
 
 using namespace hid;
 
-demo_app& demo_app::instance()
+template <typename T>
+static constexpr T saturate(int value)
+{
+    return std::clamp<int>(value, std::numeric_limits<T>::min(), std::numeric_limits<T>::max());
+}
+
+demo_app& demo_app::instance(std::size_t index)
 {
     using namespace hid::rdf;
     using namespace hid::page;
@@ -31,7 +43,11 @@ demo_app& demo_app::instance()
         collection::application(
             hid::app::opaque::report_descriptor<raw_in_report>(custom_page::IN_DATA),
 
-            hid::app::opaque::report_descriptor<raw_out_report>(custom_page::OUT_DATA)
+            hid::app::opaque::report_descriptor<raw_out_report>(custom_page::OUT_DATA),
+
+            hid::app::opaque::report_descriptor<counters_report>(custom_page::COUNTERS),
+
+            hid::app::opaque::report_descriptor<latency_report>(custom_page::LATENCY)
         )
     );
     // clang-format on
@@ -45,12 +61,26 @@ demo_app& demo_app::instance()
                                      { return most < current; })
             ->value_unsigned() == report_ids::MAX);
     static_assert(rp.max_input_size == sizeof(raw_in_report));
+    static_assert(report_pool::block_size() >= rp.max_input_size);
     static_assert(rp.max_output_size == sizeof(raw_out_report));
-    static_assert(rp.max_feature_size == 0);
+    static_assert(rp.max_feature_size ==
+                  std::max(sizeof(counters_report), sizeof(latency_report)));
+    static_assert(sizeof(counters_report::data) ==
+                  (sizeof(uint32_t) * static_cast<std::size_t>(perf_counter::COUNT)));
     static_assert(rp.max_report_id() == report_ids::MAX);
 
-    static demo_app app(rp);
-    return app;
+    // the opaque report size is a build parameter, it must fit in the memory
+    // and in a single DMA transfer (the length header is added by the transport)
+    static_assert((sizeof(demo_app) * INSTANCE_COUNT) <= RAM_BUDGET);
+    static_assert((rp.max_input_size + sizeof(uint16_t)) <= UINT16_MAX);
+    static_assert((rp.max_output_size + sizeof(uint16_t)) <= UINT16_MAX);
+
+    // all instances share the report protocol, and are served on different buses
+    static auto apps = []<std::size_t... I>(std::index_sequence<I...>)
+    {
+        return std::array<demo_app, INSTANCE_COUNT>{demo_app(rp, I)...};
+    }(std::make_index_sequence<INSTANCE_COUNT>());
+    return apps[index];
 }
 
 void demo_app::start([[maybe_unused]] protocol prot)
@@ -58,53 +88,270 @@ void demo_app::start([[maybe_unused]] protocol prot)
     receive_report(&_raw_out_buffer);
 }
 
-void demo_app::stop() {}
+void demo_app::stop()
+{
+    _input_queue.clear();
+    release_block(_snapshot_block);
+    release_block(_mouse_block);
+    _mouse_motion = {};
+    // the stopped transport no longer reads the frame in flight
+    _raw_stream.reset();
+    _raw_stream.frame_sent();
+}
 
 void demo_app::button_state_change(bool pressed)
 {
-    _keys_buffer.set_key_state(page::keyboard_keypad::KEYBOARD_CAPS_LOCK, pressed);
+    _keys.modify([pressed](keys_report& report)
+                 { report.set_key_state(page::keyboard_keypad::KEYBOARD_CAPS_LOCK, pressed); });
+
+    // a copy of the report is queued, so that the key state can keep changing
+    // while the previous reports are waiting for the host
+    queue_report(report_data(_keys.latest()));
+}
+
+result demo_app::queue_report(const std::span<const uint8_t>& data)
+{
+    if (!_input_queue.push(data))
+    {
+        return result::BUSY;
+    }
+    send_queued_report();
+    return result::OK;
+}
 
-    if (send_report(&_keys_buffer) != result::OK)
+void demo_app::send_queued_report()
+{
+    auto data = _input_queue.front();
+    if (!data.empty())
     {
-        // TODO deal with BUSY scenario
+        // when BUSY, the report stays queued until in_report_sent() is called
+        send_input_report(data);
     }
 }
 
-void demo_app::set_report([[maybe_unused]] report::type type, const std::span<const uint8_t>& data)
+void demo_app::mouse_motion(int dx, int dy, int wheel)
 {
-    // only output reports provided
-    assert(type == report::type::OUTPUT);
+    _mouse_motion.x = saturate<int16_t>(_mouse_motion.x + dx);
+    _mouse_motion.y = saturate<int16_t>(_mouse_motion.y + dy);
+    _mouse_motion.wheel = saturate<int16_t>(_mouse_motion.wheel + wheel);
 
-    // data[0] is the report ID only if report IDs are used
-    if (data[0] == kb_leds_report::ID)
+    send_mouse_report();
+}
+
+void demo_app::send_mouse_report()
+{
+    if ((_mouse_block != nullptr) or
+        ((_mouse_motion.x == 0) and (_mouse_motion.y == 0) and (_mouse_motion.wheel == 0)))
+    {
+        return;
+    }
+    // without a free block, the motion keeps accumulating until in_report_sent()
+    auto* block = _report_pool.allocate();
+    if (block == nullptr)
+    {
+        return;
+    }
+
+    // the report carries as much of the accumulated motion as fits,
+    // the remainder is sent in the next report
+    _mouse_state.modify(
+        [this](mouse_report& report)
+        {
+            report.x = saturate<int8_t>(_mouse_motion.x);
+            report.y = saturate<int8_t>(_mouse_motion.y);
+            report.wheel_y = saturate<int8_t>(_mouse_motion.wheel);
+        });
+
+    // like the keyboard's, the sent report is a copy of the state,
+    // that stays stable during the transfer (the mouse_latency benchmark measures the cost)
+    auto* sent = new (block) mouse_report(_mouse_state.latest());
+    if (send_input_report(report_data(*sent)) == result::OK)
+    {
+        _mouse_block = block;
+        _mouse_motion.x -= sent->x;
+        _mouse_motion.y -= sent->y;
+        _mouse_motion.wheel -= sent->wheel_y;
+    }
+    else
     {
-        auto* out_report = reinterpret_cast<const kb_leds_report*>(data.data());
+        _report_pool.deallocate(block);
+    }
+}
 
-        // use num_lock and caps_lock flag
-        set_led(out_report->leds.test(page::leds::CAPS_LOCK));
+void demo_app::in_report_sent(const std::span<const uint8_t>& data)
+{
+    if (data.data() == _mouse_block)
+    {
+        release_block(_mouse_block);
+    }
+    // the queue slot is only released once the transport is done with it
+    else if (data.data() == _input_queue.front().data())
+    {
+        _input_queue.pop();
     }
-    else // if (data[0] == _raw_out_buffer.id())
+    else if (data.data() == _snapshot_block)
     {
-        // TODO: deal with custom data
+        release_block(_snapshot_block);
     }
+    else if (_raw_stream.owns(data.data()))
+    {
+        _raw_stream.frame_sent();
+    }
+    send_queued_report();
+    send_mouse_report();
+    send_stream_frame();
+}
 
-    receive_report(&_raw_out_buffer);
+void demo_app::send_stream_frame()
+{
+    auto* frame = _raw_stream.peek();
+    if ((frame != nullptr) and (send_input_report(report_data(*frame)) == result::OK))
+    {
+        _raw_stream.commit(frame);
+    }
 }
 
-void demo_app::get_report(report::selector select,
-                          [[maybe_unused]] const std::span<uint8_t>& buffer)
+void demo_app::release_block(const uint8_t*& block)
+{
+    if (block != nullptr)
+    {
+        _report_pool.deallocate(block);
+        block = nullptr;
+    }
+}
+
+result demo_app::send_input_report(const std::span<const uint8_t>& data)
+{
+    auto res = send_report(data);
+    if (res == result::BUSY)
+    {
+        _counters.increment(perf_counter::SEND_BUSY);
+    }
+    return res;
+}
+
+void demo_app::get_counters()
+{
+    read_transport_counters(_index, _counters);
+    _counters.set(perf_counter::INPUT_QUEUE_HIGH_WATERMARK, _input_queue.high_watermark());
+    _counters.set(perf_counter::INPUT_QUEUE_DROPS, _input_queue.drop_count());
+    _counters.set(perf_counter::REPORT_POOL_HIGH_WATERMARK, _report_pool.stats().high_watermark);
+    _counters.set(perf_counter::REPORT_POOL_FAILURES, _report_pool.stats().failures);
+
+    auto bytes = _counters.bytes();
+    std::copy(bytes.begin(), bytes.end(), _counters_buffer.data.begin());
+    send_report(&_counters_buffer);
+}
+
+void demo_app::set_counters([[maybe_unused]] const std::span<const uint8_t>& data)
+{
+    // any content clears the counters
+    clear_transport_counters(_index);
+    _input_queue.reset_stats();
+    _report_pool.reset_stats();
+    _counters.clear();
+}
+
+void demo_app::get_latency()
+{
+    read_interrupt_latency(_index, _latency_buffer.data);
+    send_report(&_latency_buffer);
+}
+
+void demo_app::set_latency([[maybe_unused]] const std::span<const uint8_t>& data)
+{
+    // any content clears the histograms
+    clear_interrupt_latency(_index);
+}
+
+void demo_app::set_keyboard_leds(const std::span<const uint8_t>& data)
+{
+    auto* out_report = reinterpret_cast<const kb_leds_report*>(data.data());
+
+    // use num_lock and caps_lock flag
+    set_led(out_report->leds.test(page::leds::CAPS_LOCK));
+}
+
+void demo_app::set_raw_data(const std::span<const uint8_t>& data)
 {
-    if (select == _keys_buffer.selector())
+    // the demo loops the stream data back to the host
+    _raw_stream.frame_received(*reinterpret_cast<const raw_out_report*>(data.data()),
+                               [this](const std::span<const uint8_t>& payload)
+                               {
+                                   if (_raw_stream.writable() < payload.size())
+                                   {
+                                       return false;
+                                   }
+                                   _raw_stream.write(payload);
+                                   return true;
+                               });
+    send_stream_frame();
+}
+
+constexpr demo_app::report_handler_table demo_app::make_report_handler_table()
+{
+    struct entry
+    {
+        report::type type;
+        uint8_t id;
+        report_handlers handlers;
+    };
+    using type = report::type;
+    // a new report only needs a new entry here
+    // clang-format off
+    constexpr entry entries[] = {
+        {type::INPUT,   report_ids::KEYBOARD, {&demo_app::get_snapshot<&demo_app::_keys>}},
+        {type::INPUT,   report_ids::MOUSE,    {&demo_app::get_snapshot<&demo_app::_mouse_state>}},
+        {type::INPUT,   report_ids::OPAQUE,   {&demo_app::get_buffer<&demo_app::_raw_in_buffer>}},
+        {type::OUTPUT,  report_ids::KEYBOARD, {nullptr, &demo_app::set_keyboard_leds}},
+        {type::OUTPUT,  report_ids::OPAQUE,   {nullptr, &demo_app::set_raw_data}},
+        {type::FEATURE, report_ids::COUNTERS, {&demo_app::get_counters, &demo_app::set_counters}},
+        {type::FEATURE, report_ids::LATENCY,  {&demo_app::get_latency, &demo_app::set_latency}},
+    };
+    // clang-format on
+
+    report_handler_table table{};
+    for (auto& e : entries)
+    {
+        table[static_cast<std::size_t>(e.type) - static_cast<std::size_t>(type::INPUT)][e.id] =
+            e.handlers;
+    }
+    return table;
+}
+
+const demo_app::report_handlers& demo_app::report_handler(report::type type, uint8_t id)
+{
+    static constexpr auto table = make_report_handler_table();
+    static constexpr report_handlers none{};
+
+    auto type_index =
+        static_cast<std::size_t>(type) - static_cast<std::size_t>(report::type::INPUT);
+    if ((type_index >= table.size()) or (id >= table[type_index].size()))
     {
-        send_report(&_keys_buffer);
+        return none;
     }
-    else if (select == _mouse_buffer.selector())
+    return table[type_index][id];
+}
+
+void demo_app::set_report(report::type type, const std::span<const uint8_t>& data)
+{
+    // data[0] is the report ID only if report IDs are used
+    auto handler = report_handler(type, data[0]).set;
+    if (handler != nullptr)
     {
-        send_report(&_mouse_buffer);
+        (this->*handler)(data);
     }
-    else if (select == _raw_in_buffer.selector())
+
+    receive_report(&_raw_out_buffer);
+}
+
+void demo_app::get_report(report::selector select,
+                          [[maybe_unused]] const std::span<uint8_t>& buffer)
+{
+    auto handler = report_handler(select.type(), select.id()).get;
+    if (handler != nullptr)
     {
-        send_report(&_raw_in_buffer);
+        (this->*handler)();
     }
     else
     {
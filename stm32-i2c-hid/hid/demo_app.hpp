@@ -11,10 +11,26 @@
 #ifndef __HID_DEMO_APP_HPP_
 #define __HID_DEMO_APP_HPP_
 
+#include <algorithm>
+#include <cstddef>
+#include <new>
 #include "hid/app/keyboard.hpp"
 #include "hid/app/mouse.hpp"
 #include "hid/app/opaque.hpp"
 #include "hid/application.hpp"
+#include "hid/block_pool.hpp"
+#include "hid/perf_counters.hpp"
+#include "hid/raw_stream.hpp"
+#include "hid/report_queue.hpp"
+#include "hid/seqlock.hpp"
+
+#ifndef HID_OPAQUE_REPORT_SIZE
+#define HID_OPAQUE_REPORT_SIZE 32
+#endif
+
+#ifndef HID_DEMO_APP_INSTANCES
+#define HID_DEMO_APP_INSTANCES 1
+#endif
 
 namespace hid
 {
@@ -25,12 +41,14 @@ enum class custom_page : std::uint8_t
     APPLICATION = 0x0001,
     IN_DATA = 0x0002,
     OUT_DATA = 0x0003,
+    COUNTERS = 0x0004,
+    LATENCY = 0x0005,
 };
 template <>
 struct info<custom_page>
 {
     constexpr static page_id_t page_id = 0xff01;
-    constexpr static usage_id_t max_usage_id = 3;
+    constexpr static usage_id_t max_usage_id = 5;
     constexpr static const char* name = "vendor";
 };
 } // namespace page
@@ -42,32 +60,213 @@ class demo_app : public hid::application
         KEYBOARD = 1,
         MOUSE = 2,
         OPAQUE = 3,
-        MAX = OPAQUE
+        COUNTERS = 4,
+        LATENCY = 5,
+        MAX = LATENCY
     };
 
   public:
-    static demo_app& instance();
+    /// @brief The number of application instances, one for each HID device (I2C bus).
+    static constexpr std::size_t INSTANCE_COUNT = HID_DEMO_APP_INSTANCES;
+
+    static demo_app& instance(std::size_t index = 0);
+
+    std::size_t index() const { return _index; }
 
     void button_state_change(bool pressed);
 
+    /// @brief Reports relative pointer motion. While a mouse report is in flight,
+    ///        the deltas are accumulated (with saturation), and sent together
+    ///        as soon as the previous report is read by the host.
+    /// @note  Expected to be called from the same interrupt priority as the transport.
+    void mouse_motion(int dx, int dy, int wheel = 0);
+
     using keys_report = app::keyboard::keys_input_report<report_ids::KEYBOARD>;
     using kb_leds_report = app::keyboard::output_report<report_ids::KEYBOARD>;
     using mouse_report = app::mouse::report<report_ids::MOUSE>;
-    using raw_in_report = app::opaque::report<32, report::type::INPUT, report_ids::OPAQUE>;
-    using raw_out_report = app::opaque::report<32, report::type::OUTPUT, report_ids::OPAQUE>;
+    static constexpr std::size_t OPAQUE_REPORT_SIZE = HID_OPAQUE_REPORT_SIZE;
+    using raw_in_report =
+        app::opaque::report<OPAQUE_REPORT_SIZE, report::type::INPUT, report_ids::OPAQUE>;
+    using raw_out_report =
+        app::opaque::report<OPAQUE_REPORT_SIZE, report::type::OUTPUT, report_ids::OPAQUE>;
+
+    /// @brief The share of the 16 kB SRAM that the application's buffers may occupy.
+    static constexpr std::size_t RAM_BUDGET = 8 * 1024;
+
+    /// @brief The queued input reports, the mouse report in flight and the GET_REPORT snapshots
+    ///        share a pool of blocks, each fitting the largest input report. By default,
+    ///        there are enough blocks for all of them at once. The pool is locked,
+    ///        so the queue's producer and consumer may run in different interrupt contexts.
+    static constexpr std::size_t REPORT_BLOCK_SIZE =
+        std::max({sizeof(keys_report), sizeof(mouse_report), sizeof(raw_in_report)});
+    static constexpr std::size_t INPUT_QUEUE_SIZE = 8;
+#ifdef HID_DEMO_APP_REPORT_BLOCKS
+    static constexpr std::size_t REPORT_BLOCK_COUNT = HID_DEMO_APP_REPORT_BLOCKS;
+#else
+    static constexpr std::size_t REPORT_BLOCK_COUNT = INPUT_QUEUE_SIZE + 2;
+#endif
+    /// @brief Masks the interrupts while the report pool is modified. It's implemented by the port
+    ///        (with st::interrupt_lock), in the state storage, so the application stays portable.
+    class report_pool_lock
+    {
+      public:
+        report_pool_lock();
+        ~report_pool_lock();
+        report_pool_lock(const report_pool_lock&) = delete;
+        report_pool_lock& operator=(const report_pool_lock&) = delete;
+
+        alignas(std::uintptr_t) std::byte state[4 * sizeof(std::uintptr_t)];
+    };
+    using report_pool = block_pool<REPORT_BLOCK_SIZE, REPORT_BLOCK_COUNT, report_pool_lock>;
+    using input_queue = report_queue<INPUT_QUEUE_SIZE, report_pool>;
+
+    using stream = raw_stream<raw_in_report, raw_out_report>;
+
+    /// @brief The counters of the vendor feature report, in the order of the report fields.
+    ///        New counters can be added before COUNT, the report size follows.
+    enum class perf_counter : uint8_t
+    {
+        I2C_WRITE_TRANSFERS,
+        I2C_READ_TRANSFERS,
+        I2C_BYTES_WRITTEN,
+        I2C_BYTES_READ,
+        I2C_NACKS,
+        I2C_DUMMY_SENDS,
+        I2C_MAX_CALLBACK_CYCLES,
+        SEND_BUSY,
+        INPUT_QUEUE_HIGH_WATERMARK,
+        INPUT_QUEUE_DROPS,
+        I2C_PADDING_BYTES,
+        STOP_ENTRIES,
+        MAX_WAKEUP_US,
+        DEFERRED_WORK_MAX_PENDING,
+        DEFERRED_WORK_DROPS,
+        I2C_IRQ_MAX_CYCLES,
+        DMA_IRQ_MAX_CYCLES,
+        BUTTON_IRQ_MAX_CYCLES,
+        DEFERRED_WORK_MAX_CYCLES,
+        I2C_IRQ_WORST_DELAY_CYCLES,
+        LOCK_MAX_CYCLES,
+        LOCK_MAX_CALL_SITE,
+        REPORT_POOL_HIGH_WATERMARK,
+        REPORT_POOL_FAILURES,
+        STACK_PEAK_BYTES,
+        STACK_FREE_BYTES,
+        RAM_CODE_BYTES,
+        CLOCK_RAISES,
+        MAX_CLOCK_RAISE_US,
+        I2C_BUS_ERRORS,
+        I2C_ARBITRATION_LOSSES,
+        I2C_OVERRUNS,
+        I2C_MAX_RECOVERY_CYCLES,
+        CLOCK_FAULTS,
+        COUNT
+    };
+    using counters = perf_counters<perf_counter>;
+    /// @brief The host reads the counters with GET_REPORT, and clears them with SET_REPORT.
+    using counters_report =
+        app::opaque::report<counters::size(), report::type::FEATURE, report_ids::COUNTERS>;
+    /// @brief The host reads the interrupt line latency histograms with GET_REPORT,
+    ///        and clears them with SET_REPORT. The port defines their layout
+    ///        (st::interrupt_latency), the size of which is checked there.
+    /// a header, and two histograms of 16 buckets
+    static constexpr std::size_t LATENCY_SIZE = 8 + 2 * 16 * sizeof(uint32_t);
+    using latency_report =
+        app::opaque::report<LATENCY_SIZE, report::type::FEATURE, report_ids::LATENCY>;
+
+    const input_queue& pending_inputs() const { return _input_queue; }
+    const stream& raw_data_stream() const { return _raw_stream; }
 
   private:
-    keys_report _keys_buffer;
-    mouse_report _mouse_buffer;
+    /// the latest state of the input reports, the host reads a snapshot with GET_REPORT
+    seqlock<keys_report> _keys;
+    seqlock<mouse_report> _mouse_state;
     raw_in_report _raw_in_buffer;
     raw_out_report _raw_out_buffer;
+    report_pool _report_pool;
+    input_queue _input_queue;
+    const uint8_t* _snapshot_block{};
+    const uint8_t* _mouse_block{};
+    stream _raw_stream;
+    counters _counters;
+    counters_report _counters_buffer;
+    latency_report _latency_buffer;
+    struct
+    {
+        int16_t x;
+        int16_t y;
+        int16_t wheel;
+    } _mouse_motion{};
+    const std::size_t _index;
 
-    constexpr explicit demo_app(const hid::report_protocol& rp) : application(rp) {}
+    constexpr demo_app(const hid::report_protocol& rp, std::size_t index)
+        : application(rp), _input_queue(_report_pool), _index(index)
+    {}
 
     void start(protocol prot) override;
     void stop() override;
     void set_report(report::type type, const std::span<const uint8_t>& data) override;
     void get_report(report::selector select, const std::span<uint8_t>& buffer) override;
+    void in_report_sent(const std::span<const uint8_t>& data) override;
+
+    template <typename T>
+    static std::span<const uint8_t> report_data(const T& report)
+    {
+        return {reinterpret_cast<const uint8_t*>(&report), sizeof(report)};
+    }
+    result queue_report(const std::span<const uint8_t>& data);
+    void send_queued_report();
+    void send_mouse_report();
+    void send_stream_frame();
+    result send_input_report(const std::span<const uint8_t>& data);
+
+    using get_handler = void (demo_app::*)();
+    using set_handler = void (demo_app::*)(const std::span<const uint8_t>& data);
+    struct report_handlers
+    {
+        get_handler get{};
+        set_handler set{};
+    };
+    /// @brief The report handlers, indexed by report type and report ID.
+    using report_handler_table = std::array<std::array<report_handlers, report_ids::MAX + 1>, 3>;
+    static constexpr report_handler_table make_report_handler_table();
+    static const report_handlers& report_handler(report::type type, uint8_t id);
+
+    template <auto BUFFER>
+    void get_buffer()
+    {
+        send_report(&(this->*BUFFER));
+    }
+    template <auto STATE>
+    void get_snapshot()
+    {
+        using report_type = std::remove_cvref_t<decltype((this->*STATE).latest())>;
+        auto* block = _report_pool.allocate();
+        if (block == nullptr)
+        {
+            send_report({}, report::type::INPUT);
+            return;
+        }
+        // the writer might be preempted in the middle of an update,
+        // the snapshot is consistent regardless, and stays stable during the transfer
+        auto* snapshot = new (block) report_type;
+        (this->*STATE).read(*snapshot);
+        if (send_report(report_data(*snapshot)) == result::OK)
+        {
+            _snapshot_block = block;
+        }
+        else
+        {
+            _report_pool.deallocate(block);
+        }
+    }
+    void release_block(const uint8_t*& block);
+    void get_counters();
+    void get_latency();
+    void set_keyboard_leds(const std::span<const uint8_t>& data);
+    void set_raw_data(const std::span<const uint8_t>& data);
+    void set_counters(const std::span<const uint8_t>& data);
+    void set_latency(const std::span<const uint8_t>& data);
 };
 
 } // namespace hid
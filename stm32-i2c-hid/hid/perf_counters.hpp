@@ -0,0 +1,66 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+#ifndef __HID_PERF_COUNTERS_HPP_
+#define __HID_PERF_COUNTERS_HPP_
+
+#include <array>
+#include <cstdint>
+#include <span>
+
+namespace hid
+{
+/// @brief Block of 32-bit counters, indexed by an enumeration.
+///        The block can be extended by adding new enumerators before COUNT,
+///        the size of the block (and of the report carrying it) follows.
+/// @tparam TIndex: the counter enumeration, with the number of counters as COUNT
+template <typename TIndex>
+class perf_counters
+{
+    static constexpr std::size_t COUNT = static_cast<std::size_t>(TIndex::COUNT);
+
+  public:
+    static constexpr std::size_t size() { return COUNT * sizeof(std::uint32_t); }
+
+    constexpr perf_counters() = default;
+
+    void increment(TIndex index) { at(index)++; }
+    void add(TIndex index, std::uint32_t value) { at(index) += value; }
+    void set(TIndex index, std::uint32_t value) { at(index) = value; }
+    void set_max(TIndex index, std::uint32_t value)
+    {
+        if (value > at(index))
+        {
+            at(index) = value;
+        }
+    }
+    std::uint32_t operator[](TIndex index) const
+    {
+        return values_[static_cast<std::size_t>(index)];
+    }
+
+    void clear() { values_ = {}; }
+
+    /// @brief The counters in little-endian byte order (the native order of the target).
+    std::span<const std::uint8_t, size()> bytes() const
+    {
+        return std::span<const std::uint8_t, size()>(
+            reinterpret_cast<const std::uint8_t*>(values_.data()), size());
+    }
+
+  private:
+    std::uint32_t& at(TIndex index) { return values_[static_cast<std::size_t>(index)]; }
+
+    std::array<std::uint32_t, COUNT> values_{};
+};
+
+} // namespace hid
+
+#endif // __HID_PERF_COUNTERS_HPP_
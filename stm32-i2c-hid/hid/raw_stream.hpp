@@ -0,0 +1,245 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+#ifndef __HID_RAW_STREAM_HPP_
+#define __HID_RAW_STREAM_HPP_
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+namespace hid
+{
+/// @brief Windowed byte stream over a pair of opaque input and output reports.
+///        Every report carries a frame header followed by the payload:
+///        | seq | ack | flags | length | payload... |
+///        - seq: the sequence number of the data frame (modulo 256)
+///        - ack: cumulative acknowledgement, the next sequence number expected from the peer
+///        - flags: see @ref frame_flags
+///        - length: the number of valid payload bytes, zero for acknowledgement-only frames
+///        Up to WINDOW input frames may be unacknowledged at a time, so the device can keep
+///        its interrupt line asserted back-to-back, while the host acknowledges in its
+///        output reports.
+/// @tparam TInReport: the opaque input report type
+/// @tparam TOutReport: the opaque output report type
+/// @tparam WINDOW: the maximal number of unacknowledged input frames, a power of two,
+///                so the frames keep their slots when the sequence numbers wrap around
+template <typename TInReport, typename TOutReport, std::size_t WINDOW = 4>
+class raw_stream
+{
+    static_assert((WINDOW > 0) and ((WINDOW & (WINDOW - 1)) == 0) and (WINDOW < 128));
+
+  public:
+    struct header
+    {
+        std::uint8_t seq;
+        std::uint8_t ack;
+        std::uint8_t flags;
+        std::uint8_t length;
+    };
+    enum frame_flags : std::uint8_t
+    {
+        RESEND = 0x01, // go back to the first unacknowledged frame
+        RESET = 0x02,  // restart the stream in both directions
+    };
+    static constexpr std::size_t TX_PAYLOAD_SIZE = sizeof(TInReport::data) - sizeof(header);
+    static constexpr std::size_t RX_PAYLOAD_SIZE = sizeof(TOutReport::data) - sizeof(header);
+    static_assert((TX_PAYLOAD_SIZE > 0) and (RX_PAYLOAD_SIZE > 0));
+    static_assert((TX_PAYLOAD_SIZE <= UINT8_MAX) and (RX_PAYLOAD_SIZE <= UINT8_MAX));
+
+    struct statistics
+    {
+        std::uint32_t frames_sent{};
+        std::uint32_t frames_received{};
+        std::uint32_t retransmits{};
+        std::uint32_t bytes_acked{};
+        std::uint32_t bytes_received{};
+    };
+
+    constexpr raw_stream() = default;
+
+    /// @brief Splits the data into frames, as long as there is space in the window.
+    /// @param data: the data to transmit
+    /// @return the number of bytes accepted
+    std::size_t write(std::span<const std::uint8_t> data)
+    {
+        std::size_t written = 0;
+        if (reset_pending_)
+        {
+            return written;
+        }
+        while (!data.empty() and (unacked() < WINDOW))
+        {
+            auto size = std::min(data.size(), TX_PAYLOAD_SIZE);
+            auto& frame = window_[next_seq_ % WINDOW];
+            frame_header(frame) = {next_seq_, 0, 0, static_cast<std::uint8_t>(size)};
+            std::memcpy(frame.data.data() + sizeof(header), data.data(), size);
+            next_seq_++;
+            data = data.subspan(size);
+            written += size;
+        }
+        return written;
+    }
+
+    /// @brief The number of bytes that can be written before the window fills up.
+    std::size_t writable() const
+    {
+        return reset_pending_ ? 0 : (WINDOW - unacked()) * TX_PAYLOAD_SIZE;
+    }
+
+    /// @brief Selects the next frame to transmit, without changing the stream state.
+    /// @return the frame to send, or nullptr if there is nothing to send
+    const TInReport* peek()
+    {
+        if (in_flight_ != nullptr)
+        {
+            return nullptr;
+        }
+        if (send_seq_ != next_seq_)
+        {
+            return &window_[send_seq_ % WINDOW];
+        }
+        if (ack_pending_)
+        {
+            frame_header(ack_frame_) = {send_seq_, 0, 0, 0};
+            return &ack_frame_;
+        }
+        return nullptr;
+    }
+
+    /// @brief Updates the stream state once the frame returned by @ref peek was accepted
+    ///        by the transport.
+    void commit(const TInReport* frame)
+    {
+        // the latest acknowledgement is piggybacked on every frame
+        frame_header(*const_cast<TInReport*>(frame)).ack = rx_expected_;
+        ack_pending_ = false;
+        in_flight_ = frame;
+        if (frame != &ack_frame_)
+        {
+            if (static_cast<std::uint8_t>(send_seq_ - acked_seq_) < sent_seq_span_)
+            {
+                stats_.retransmits++;
+            }
+            send_seq_++;
+            if (static_cast<std::uint8_t>(send_seq_ - acked_seq_) > sent_seq_span_)
+            {
+                sent_seq_span_ = send_seq_ - acked_seq_;
+            }
+        }
+        stats_.frames_sent++;
+    }
+
+    /// @brief Checks whether the report data belongs to this stream.
+    bool owns(const std::uint8_t* data) const
+    {
+        return (data == reinterpret_cast<const std::uint8_t*>(&ack_frame_)) or
+               ((data >= reinterpret_cast<const std::uint8_t*>(window_.data())) and
+                (data < reinterpret_cast<const std::uint8_t*>(window_.data() + WINDOW)));
+    }
+
+    /// @brief Releases the transport after the frame in flight was read by the host.
+    void frame_sent()
+    {
+        in_flight_ = nullptr;
+        reset_pending_ = false;
+    }
+
+    /// @brief Processes a received output report.
+    /// @param report: the output report
+    /// @param sink: callable receiving the in-order payload, returning false
+    ///              when it cannot take it (the frame is then left unacknowledged)
+    template <typename TSink>
+    void frame_received(const TOutReport& report, TSink&& sink)
+    {
+        auto& hdr = frame_header(report);
+        if (hdr.flags & RESET)
+        {
+            reset();
+            return;
+        }
+        stats_.frames_received++;
+
+        // cumulative acknowledgement frees the window
+        auto acked = static_cast<std::uint8_t>(hdr.ack - acked_seq_);
+        if ((acked > 0) and (acked <= sent_seq_span_))
+        {
+            for (auto seq = acked_seq_; seq != hdr.ack; seq++)
+            {
+                stats_.bytes_acked += frame_header(window_[seq % WINDOW]).length;
+            }
+            acked_seq_ = hdr.ack;
+            sent_seq_span_ -= acked;
+        }
+        if (hdr.flags & RESEND)
+        {
+            send_seq_ = acked_seq_;
+        }
+
+        if (hdr.length > 0)
+        {
+            // duplicates and out of order frames only trigger a new acknowledgement
+            if ((hdr.seq == rx_expected_) and (hdr.length <= RX_PAYLOAD_SIZE) and
+                sink(std::span<const std::uint8_t>(report.data.data() + sizeof(header),
+                                                   hdr.length)))
+            {
+                rx_expected_++;
+                stats_.bytes_received += hdr.length;
+            }
+            ack_pending_ = true;
+        }
+    }
+
+    /// @brief Restarts the stream in both directions. A frame in flight is still read
+    ///        by the transport, so the window is only reused after @ref frame_sent.
+    void reset()
+    {
+        acked_seq_ = 0;
+        next_seq_ = 0;
+        send_seq_ = 0;
+        sent_seq_span_ = 0;
+        rx_expected_ = 0;
+        ack_pending_ = false;
+        reset_pending_ = in_flight_ != nullptr;
+    }
+
+    const statistics& stats() const { return stats_; }
+
+  private:
+    template <typename TReport>
+    static header& frame_header(TReport& report)
+    {
+        return *reinterpret_cast<header*>(report.data.data());
+    }
+    template <typename TReport>
+    static const header& frame_header(const TReport& report)
+    {
+        return *reinterpret_cast<const header*>(report.data.data());
+    }
+    std::size_t unacked() const { return static_cast<std::uint8_t>(next_seq_ - acked_seq_); }
+
+    std::array<TInReport, WINDOW> window_{};
+    TInReport ack_frame_{};
+    const TInReport* in_flight_{};
+    std::uint8_t acked_seq_{};
+    std::uint8_t next_seq_{};
+    std::uint8_t send_seq_{};
+    std::uint8_t sent_seq_span_{};
+    std::uint8_t rx_expected_{};
+    bool ack_pending_{};
+    bool reset_pending_{};
+    statistics stats_{};
+};
+
+} // namespace hid
+
+#endif // __HID_RAW_STREAM_HPP_
@@ -0,0 +1,137 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+#ifndef __HID_REPORT_QUEUE_HPP_
+#define __HID_REPORT_QUEUE_HPP_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+namespace hid
+{
+/// @brief Fixed capacity single-producer, single-consumer ring of pending reports.
+///        The producer only writes the tail index, the consumer only writes the head index,
+///        so the two sides can run in different interrupt contexts without any locking.
+///        The indexes are free-running, and only naturally atomic loads and stores are used
+///        on them, as Cortex-M0 has no exclusive access instructions.
+///        Each side must be used from a single context.
+///        The reports are copied to blocks of a pool, that is shared with other report buffers,
+///        the pool has to be locked if its users run in different contexts.
+/// @tparam CAPACITY: the maximal number of queued reports, must be a power of two
+/// @tparam TPool: the block_pool type, its block size is the maximal size of a single report
+template <std::size_t CAPACITY, typename TPool>
+class report_queue
+{
+    static_assert((CAPACITY > 1) and ((CAPACITY & (CAPACITY - 1)) == 0) and
+                  (CAPACITY <= (UINT16_MAX / 2)));
+    static constexpr std::size_t MAX_SIZE = TPool::block_size();
+    static_assert(MAX_SIZE <= UINT16_MAX);
+
+    using index_type = std::uint16_t;
+
+  public:
+    constexpr report_queue(TPool& pool) : pool_(pool) {}
+
+    static constexpr std::size_t capacity() { return CAPACITY; }
+
+    /// @brief Producer side: stores a copy of the report at the end of the queue.
+    /// @param data: the report data
+    /// @return true if the report was queued, false if it was dropped due to the queue
+    ///         or the pool being full
+    bool push(const std::span<const std::uint8_t>& data)
+    {
+        auto tail = tail_.load(std::memory_order_relaxed);
+        index_type used = tail - head_.load(std::memory_order_acquire);
+        std::uint8_t* block;
+        if ((used >= CAPACITY) or (data.size() > MAX_SIZE) or
+            ((block = pool_.allocate()) == nullptr))
+        {
+            drops_++;
+            return false;
+        }
+        std::memcpy(block, data.data(), data.size());
+        slots_[tail % CAPACITY] = {block, static_cast<index_type>(data.size())};
+        tail_.store(tail + 1, std::memory_order_release);
+
+        used++;
+        if (used > high_watermark_)
+        {
+            high_watermark_ = used;
+        }
+        return true;
+    }
+
+    /// @brief Consumer side: accesses the oldest queued report, without removing it.
+    /// @return the oldest report, or an empty span when the queue is empty
+    std::span<const std::uint8_t> front() const
+    {
+        auto head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire))
+        {
+            return {};
+        }
+        auto& slot = slots_[head % CAPACITY];
+        return {slot.data, slot.size};
+    }
+
+    /// @brief Consumer side: releases the oldest queued report, and its pool block.
+    void pop()
+    {
+        auto head = head_.load(std::memory_order_relaxed);
+        if (head != tail_.load(std::memory_order_acquire))
+        {
+            pool_.deallocate(slots_[head % CAPACITY].data);
+            head_.store(head + 1, std::memory_order_release);
+        }
+    }
+
+    /// @brief Consumer side: discards all queued reports.
+    void clear()
+    {
+        while (!empty())
+        {
+            pop();
+        }
+    }
+
+    bool empty() const { return size() == 0; }
+    std::size_t size() const
+    {
+        return static_cast<index_type>(tail_.load(std::memory_order_acquire) -
+                                       head_.load(std::memory_order_acquire));
+    }
+    std::size_t high_watermark() const { return high_watermark_; }
+    std::size_t drop_count() const { return drops_; }
+    void reset_stats()
+    {
+        high_watermark_ = 0;
+        drops_ = 0;
+    }
+
+  private:
+    struct slot
+    {
+        std::uint8_t* data;
+        index_type size;
+    };
+    TPool& pool_;
+    std::array<slot, CAPACITY> slots_{};
+    std::atomic<index_type> head_{};
+    std::atomic<index_type> tail_{};
+    index_type high_watermark_{};
+    std::uint32_t drops_{};
+};
+
+} // namespace hid
+
+#endif // __HID_REPORT_QUEUE_HPP_
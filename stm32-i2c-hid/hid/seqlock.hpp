@@ -0,0 +1,80 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+#ifndef __HID_SEQLOCK_HPP_
+#define __HID_SEQLOCK_HPP_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace hid
+{
+/// @brief Versioned value with a single writer, that readers can take consistent snapshots of
+///        from any interrupt context, without the writer ever disabling interrupts.
+///        The value is stored twice, and the sequence counter selects the copy that
+///        isn't being modified (a latched sequence lock), so a reader preempting the writer
+///        doesn't need to wait for it, it reads the other, complete copy.
+///        Only naturally atomic loads and stores are used, as Cortex-M0 has no exclusive access
+///        instructions.
+/// @tparam T: the value type, must be trivially copyable
+template <typename T>
+class seqlock
+{
+  public:
+    constexpr seqlock() = default;
+
+    /// @brief Writer side: modifies both copies of the value, one after the other.
+    /// @param modifier: callable that performs the same modification on the passed value
+    template <typename TModifier>
+    void modify(TModifier&& modifier)
+    {
+        auto seq = seq_.load(std::memory_order_relaxed);
+        // readers switch to the second copy while the first is modified
+        seq_.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        modifier(copies_[0]);
+        seq_.store(seq + 2, std::memory_order_release);
+        modifier(copies_[1]);
+    }
+
+    /// @brief Writer side: replaces the value.
+    void store(const T& value)
+    {
+        modify([&value](T& copy) { copy = value; });
+    }
+
+    /// @brief Writer side: the current value, only consistent when accessed by the writer.
+    const T& latest() const { return copies_[1]; }
+
+    /// @brief Reader side: copies a consistent snapshot of the value.
+    /// @param snapshot: the destination of the copy
+    /// @return the version of the snapshot
+    std::uint32_t read(T& snapshot) const
+    {
+        std::uint32_t seq;
+        do
+        {
+            seq = seq_.load(std::memory_order_acquire);
+            snapshot = copies_[seq & 1];
+            std::atomic_thread_fence(std::memory_order_acquire);
+            // only retries when the writer preempted the reader, and modified the copy being read
+        } while (seq_.load(std::memory_order_relaxed) != seq);
+        return seq;
+    }
+
+  private:
+    std::array<T, 2> copies_{};
+    std::atomic<std::uint32_t> seq_{};
+};
+
+} // namespace hid
+
+#endif // __HID_SEQLOCK_HPP_
@@ -1,21 +1,237 @@
 extern "C"
 {
 #include "i2c_hid_config.h"
+#include "irq_priorities.h"
 #include "main.h"
 }
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <initializer_list>
+#include <new>
+#include <utility>
 #include "hid/demo_app.hpp"
 #include "i2c/hid/device.hpp"
+#include "st/clock_profile.hpp"
+#include "st/deferred_work.hpp"
+#include "st/i2c_timing.hpp"
+#include "st/interrupt_lock.hpp"
+#include "st/isr_trace.hpp"
+#include "st/stack_monitor.hpp"
+#if I2C_HID_LL_SLAVE
+#include "st/ll_i2c_slave.hpp"
+using i2c_slave_driver = st::ll_i2c_slave;
+#else
 #include "st/hal_i2c_slave.hpp"
+using i2c_slave_driver = st::hal_i2c_slave;
+#endif
 
+extern I2C_HandleTypeDef hi2c1;
 extern I2C_HandleTypeDef hi2c2;
 
-st::hal_i2c_slave& get_i2c_slave()
+#ifndef I2C_HID_CLOCK_PROFILE
+#define I2C_HID_CLOCK_PROFILE PLL
+#endif
+
+// the system clock while the HID slaves are active
+constexpr auto RUN_CLOCK_PROFILE = st::clock_profile::I2C_HID_CLOCK_PROFILE;
+static_assert(RUN_CLOCK_PROFILE != st::clock_profile::HSI, "the transport needs a 48 MHz clock");
+#if I2C_HID_IDLE_CLOCK_SCALING
+// the system clock while all HID buses are idle
+constexpr auto IDLE_CLOCK_PROFILE = st::clock_profile::HSI;
+#else
+constexpr auto IDLE_CLOCK_PROFILE = RUN_CLOCK_PROFILE;
+#endif
+
+// I2C1 is clocked from HSI (that allows it to wake the MCU up from STOP mode),
+// I2C2 is clocked from PCLK1, so it follows the system clock profile
+constexpr uint32_t I2C1_KERNEL_CLOCK_HZ = HSI_VALUE;
+constexpr uint32_t I2C2_KERNEL_CLOCK_HZ = st::frequency(RUN_CLOCK_PROFILE);
+constexpr uint32_t I2C2_IDLE_KERNEL_CLOCK_HZ = st::frequency(IDLE_CLOCK_PROFILE);
+#if defined(SYSCFG_CFGR1_I2C_FMP_I2C1)
+constexpr uint32_t I2C1_FAST_MODE_PLUS = SYSCFG_CFGR1_I2C_FMP_I2C1;
+#else
+constexpr uint32_t I2C1_FAST_MODE_PLUS = 0;
+#endif
+#if defined(SYSCFG_CFGR1_I2C_FMP_I2C2)
+constexpr uint32_t I2C2_FAST_MODE_PLUS = SYSCFG_CFGR1_I2C_FMP_I2C2;
+#else
+constexpr uint32_t I2C2_FAST_MODE_PLUS = 0;
+#endif
+
+// the edge times depend on the pull-up resistors and the bus capacitance,
+// Fast-mode Plus needs strong pull-ups to meet the data valid time limit
+constexpr st::i2c_timing::bus i2c_bus(uint32_t kernel_clock_hz, st::i2c_speed speed)
+{
+    switch (speed)
+    {
+    case st::i2c_speed::STANDARD:
+        return {kernel_clock_hz, speed, 1000, 100};
+    case st::i2c_speed::FAST:
+        return {kernel_clock_hz, speed, 300, 100};
+    default:
+        return {kernel_clock_hz, speed, 50, 10};
+    }
+}
+
+constexpr st::i2c_timing i2c_timing(uint32_t kernel_clock_hz, st::i2c_speed speed)
+{
+    return st::i2c_timing::calculate(i2c_bus(kernel_clock_hz, speed));
+}
+
+constexpr bool i2c_timings_comply(uint32_t kernel_clock_hz, uint32_t idle_kernel_clock_hz)
+{
+    for (auto speed : {st::i2c_speed::STANDARD, st::i2c_speed::FAST, st::i2c_speed::FAST_PLUS})
+    {
+        auto timing = i2c_timing(kernel_clock_hz, speed);
+        // a transfer starts with the idle kernel clock, and continues with the run one:
+        // the data setup and hold times (the only timings of slave mode) must meet the spec
+        // with both
+        if (!timing.complies(i2c_bus(kernel_clock_hz, speed)) or
+            !timing.meets_spec(i2c_bus(idle_kernel_clock_hz, speed)))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+static_assert(i2c_timings_comply(I2C1_KERNEL_CLOCK_HZ, I2C1_KERNEL_CLOCK_HZ));
+static_assert(i2c_timings_comply(I2C2_KERNEL_CLOCK_HZ, I2C2_IDLE_KERNEL_CLOCK_HZ));
+// a failed clock switch leaves the system running from HSI
+static_assert(i2c_timings_comply(I2C2_KERNEL_CLOCK_HZ, HSI_VALUE));
+
+// replace the CubeMX generated timings, they are applied when the slave address is set
+#if I2C_HID_LOW_POWER || I2C_HID_DUAL_BUS
+static void i2c1_init()
+{
+    MX_I2C1_Init();
+    hi2c1.Init.Timing = i2c_timing(I2C1_KERNEL_CLOCK_HZ, st::i2c_speed::STANDARD).timingr();
+}
+#endif
+
+#if !I2C_HID_LOW_POWER
+static void i2c2_init()
+{
+    MX_I2C2_Init();
+    hi2c2.Init.Timing = i2c_timing(I2C2_KERNEL_CLOCK_HZ, st::i2c_speed::STANDARD).timingr();
+}
+#endif
+
+struct hid_bus
 {
-    static st::hal_i2c_slave slave{hi2c2, &MX_I2C2_Init, EXT_RESET_GPIO_Port, EXT_RESET_Pin};
-    return slave;
+    I2C_HandleTypeDef& handle;
+    void (*init)();
+    uint32_t kernel_clock_hz;
+    uint32_t idle_kernel_clock_hz;
+    uint32_t fast_mode_plus;
+    GPIO_TypeDef* interrupt_port;
+    uint16_t interrupt_pin;
+    IRQn_Type event_irq;
+    IRQn_Type dma_irq;
+};
+
+#if I2C_HID_LOW_POWER && I2C_HID_DUAL_BUS
+#error "STOP mode requires all HID slaves to be wakeup capable, only I2C1 is"
+#endif
+#if I2C_HID_LOW_POWER && I2C_HID_IDLE_CLOCK_SCALING
+#error "the system clock is stopped in STOP mode, scaling it down is redundant"
+#endif
+
+// each bus serves its own HID device, with the demo application instance of the same index
+static const hid_bus hid_buses[] = {
+#if I2C_HID_LOW_POWER
+    // I2C1 is the only instance that can wake the MCU up from STOP mode
+    {hi2c1, &i2c1_init, I2C1_KERNEL_CLOCK_HZ, I2C1_KERNEL_CLOCK_HZ, I2C1_FAST_MODE_PLUS,
+     EXT_RESET_GPIO_Port, EXT_RESET_Pin, I2C1_IRQn, DMA1_Channel2_3_IRQn},
+#else
+    {hi2c2, &i2c2_init, I2C2_KERNEL_CLOCK_HZ, I2C2_IDLE_KERNEL_CLOCK_HZ, I2C2_FAST_MODE_PLUS,
+     EXT_RESET_GPIO_Port, EXT_RESET_Pin, I2C2_IRQn, DMA1_Channel4_5_6_7_IRQn},
+#endif
+#if I2C_HID_DUAL_BUS
+    // PB6 (SCL) and PB7 (SDA), with the interrupt line on PC4
+    {hi2c1, &i2c1_init, I2C1_KERNEL_CLOCK_HZ, I2C1_KERNEL_CLOCK_HZ, I2C1_FAST_MODE_PLUS, GPIOC,
+     GPIO_PIN_4, I2C1_IRQn, DMA1_Channel2_3_IRQn},
+#endif
+};
+constexpr std::size_t HID_BUS_COUNT = sizeof(hid_buses) / sizeof(hid_buses[0]);
+static_assert(HID_BUS_COUNT <= hid::demo_app::INSTANCE_COUNT);
+
+/// @brief Masks the interrupts of a HID slave's bus for the lifetime of the object,
+///        so that deferred work can call the application of that bus, while the
+///        other interrupts (and the other bus) are still serviced.
+class bus_interrupt_lock
+{
+  public:
+    bus_interrupt_lock(std::size_t bus) : bus_(hid_buses[bus])
+    {
+        NVIC_DisableIRQ(bus_.event_irq);
+        NVIC_DisableIRQ(bus_.dma_irq);
+    }
+    ~bus_interrupt_lock()
+    {
+        NVIC_EnableIRQ(bus_.dma_irq);
+        NVIC_EnableIRQ(bus_.event_irq);
+    }
+
+  private:
+    const hid_bus& bus_;
+};
+
+static st::deferred_work<8> deferred_work;
+
+i2c_slave_driver& get_i2c_slave(std::size_t bus = 0)
+{
+    static auto slaves = []<std::size_t... I>(std::index_sequence<I...>)
+    {
+        return std::array<i2c_slave_driver, HID_BUS_COUNT>{
+            i2c_slave_driver{hid_buses[I].handle, hid_buses[I].init, hid_buses[I].interrupt_port,
+                             hid_buses[I].interrupt_pin}...};
+    }(std::make_index_sequence<HID_BUS_COUNT>());
+    return slaves[bus];
 }
 
-i2c::hid::device& get_device()
+/// @return the slave driver of the HID bus that the handle belongs to,
+///         or nullptr if the I2C peripheral serves something else
+static i2c_slave_driver* hid_slave(const I2C_HandleTypeDef* hi2c)
+{
+    for (std::size_t i = 0; i < HID_BUS_COUNT; i++)
+    {
+        if (hi2c == &hid_buses[i].handle)
+        {
+            return &get_i2c_slave(i);
+        }
+    }
+    return nullptr;
+}
+
+/// @brief Changes the speed of a HID slave's bus.
+/// @return false if the speed cannot be reached with the I2C kernel clock
+bool set_i2c_bus_speed(st::i2c_speed speed, std::size_t bus = 0)
+{
+    auto& config = hid_buses[bus];
+    auto timing = i2c_timing(config.kernel_clock_hz, speed);
+    // the timing must also hold when the kernel clock slows down with the idle profile
+    if (!timing.valid or !timing.meets_spec(i2c_bus(config.idle_kernel_clock_hz, speed)))
+    {
+        return false;
+    }
+    // the Fast-mode Plus drive capability of the pins is required above 400 kHz
+    if (config.fast_mode_plus != 0)
+    {
+        if (speed == st::i2c_speed::FAST_PLUS)
+        {
+            HAL_I2CEx_EnableFastModePlus(config.fast_mode_plus);
+        }
+        else
+        {
+            HAL_I2CEx_DisableFastModePlus(config.fast_mode_plus);
+        }
+    }
+    get_i2c_slave(bus).set_timing(timing.timingr());
+    return true;
+}
+
+i2c::hid::device& get_device(std::size_t bus = 0)
 {
     // vendor and product ID are inherited from USB
     // version indicates product HW / SW version
@@ -36,50 +252,399 @@ i2c::hid::device& get_device()
     };
 #endif
 
-    static i2c::hid::device dev(hid::demo_app::instance(), product_info, get_i2c_slave(),
-                                bus_address, hid_desc_address);
-    return dev;
+    static auto devices = []<std::size_t... I>(std::index_sequence<I...>)
+    {
+        return std::array<i2c::hid::device, HID_BUS_COUNT>{
+            i2c::hid::device{hid::demo_app::instance(I), product_info, get_i2c_slave(I),
+                             bus_address, hid_desc_address}...};
+    }(std::make_index_sequence<HID_BUS_COUNT>());
+    return devices[bus];
+}
+
+// functions executed from RAM, see STM32F072RBTx_FLASH.ld
+extern "C" uint8_t _sramfunc[];
+extern "C" uint8_t _eramfunc[];
+
+#if I2C_HID_RAMFUNC
+// the system exceptions and the STM32F072 interrupts
+constexpr std::size_t VECTOR_COUNT = 16 + 32;
+extern "C" const uint32_t g_pfnVectors[];
+__attribute__((section(".ram_vector"))) static uint32_t ram_vectors[VECTOR_COUNT];
+
+// Cortex-M0 has no VTOR, the vector table is relocated by mapping SRAM to address 0,
+// so the vectors are fetched without the flash wait state too
+static void remap_vector_table()
+{
+    std::copy_n(g_pfnVectors, VECTOR_COUNT, ram_vectors);
+    __DSB();
+    __HAL_RCC_SYSCFG_CLK_ENABLE();
+    __HAL_SYSCFG_REMAPMEMORY_SRAM();
+    __ISB();
+}
+#endif
+
+static uint32_t clock_faults = 0;
+
+/// @brief Selects the system clock profile, a failed switch leaves the system running from HSI.
+static bool select_clock_profile(st::clock_profile profile)
+{
+    if (st::system_clock::select(profile))
+    {
+        return true;
+    }
+    clock_faults++;
+    return false;
 }
 
 extern "C" void create_i2c_hid_device()
 {
-    get_device();
+#if I2C_HID_RAMFUNC
+    remap_vector_table();
+#endif
+    // the clock switching measures its timeouts with the timestamp
+    st::timestamp::init();
+    {
+        // SystemClock_Config() boots onto the run profile, this only switches to it
+        // if the generated code was replaced by CubeMX without the HSI48 branch,
+        // without the interrupts reading the timestamps in the middle of the switch
+        st::interrupt_lock lock;
+        select_clock_profile(RUN_CLOCK_PROFILE);
+    }
+    st::isr_trace::init();
+    irq_priorities_apply();
+    for (std::size_t i = 0; i < HID_BUS_COUNT; i++)
+    {
+        get_device(i);
+    }
 }
 
 extern "C" __weak void test_i2c_hid_device() {}
 
+extern "C" void i2c_hid_deferred_work()
+{
+    deferred_work.run();
+}
+
+#if I2C_HID_LOW_POWER
+static struct
+{
+    uint32_t stop_entries;
+    uint32_t max_wakeup_us;
+    // the wakeup by an address match, that is measured until the address is serviced
+    uint32_t clock_restore_us;
+    uint32_t clock_restored_at;
+    bool address_wakeup;
+} low_power_stats{};
+#endif
+
+#if I2C_HID_IDLE_CLOCK_SCALING
+static struct
+{
+    uint32_t raises;
+    uint32_t max_raise_us;
+} clock_scaling_stats{};
+
+static bool hid_buses_idle()
+{
+    for (std::size_t i = 0; i < HID_BUS_COUNT; i++)
+    {
+        if (!get_i2c_slave(i).bus_idle())
+        {
+            return false;
+        }
+    }
+    return true;
+}
+#endif
+
+/// @brief Raises the system clock to the run profile at the start of a transfer,
+///        the I2C slave stretches the clock until then.
+static void bus_activity()
+{
+#if I2C_HID_LOW_POWER
+    // the host's clock is stretched from the address match until it's serviced here
+    if (low_power_stats.address_wakeup)
+    {
+        low_power_stats.address_wakeup = false;
+        uint32_t wakeup_us =
+            low_power_stats.clock_restore_us +
+            st::timestamp::to_us(st::timestamp::now() - low_power_stats.clock_restored_at);
+        if (wakeup_us > low_power_stats.max_wakeup_us)
+        {
+            low_power_stats.max_wakeup_us = wakeup_us;
+        }
+    }
+#elif I2C_HID_IDLE_CLOCK_SCALING
+    if (st::system_clock::current() == RUN_CLOCK_PROFILE)
+    {
+        return;
+    }
+    auto start = st::timestamp::now();
+    if (!select_clock_profile(RUN_CLOCK_PROFILE))
+    {
+        // the transfer is served from HSI, the next one tries again
+        return;
+    }
+    uint32_t raise_us = st::timestamp::to_us(st::timestamp::now() - start);
+    if (raise_us > clock_scaling_stats.max_raise_us)
+    {
+        clock_scaling_stats.max_raise_us = raise_us;
+    }
+    clock_scaling_stats.raises++;
+#endif
+}
+
+#ifndef I2C_HID_STACK_CANARY_WORDS
+#define I2C_HID_STACK_CANARY_WORDS 8
+#endif
+
+// the region painted by the startup code, see STM32F072RBTx_FLASH.ld
+extern "C" uint32_t _end[];
+extern "C" uint32_t _estack[];
+static st::stack_monitor<I2C_HID_STACK_CANARY_WORDS> stack_monitor{_end, _estack};
+
+extern "C" void i2c_hid_idle()
+{
+    // the stack is scanned at the lowest priority, a chunk before each sleep
+    if (!stack_monitor.step())
+    {
+        // the stack is about to overwrite the static data
+        Error_Handler();
+    }
+
+#if I2C_HID_LOW_POWER
+    // the wakeup interrupt is only serviced once the system clock is restored,
+    // the I2C slave stretches the clock until then
+    st::interrupt_lock lock;
+    if (get_i2c_slave().bus_idle())
+    {
+        // HAL_I2C_Init() clears the wakeup enable
+        hid_buses[0].handle.Instance->CR1 |= I2C_CR1_WUPEN;
+        lock.sleep([]() { HAL_PWR_EnterSTOPMode(PWR_LOWPOWERREGULATOR_ON, PWR_STOPENTRY_WFI); });
+
+        // the system runs from HSI after STOP mode, the timer doesn't count in STOP mode,
+        // so the wakeup is measured from the exit, and finished by the address interrupt
+        auto start = st::timestamp::now();
+        st::timestamp::rate_changed(HSI_VALUE);
+        select_clock_profile(RUN_CLOCK_PROFILE);
+        low_power_stats.clock_restored_at = st::timestamp::now();
+        low_power_stats.clock_restore_us =
+            st::timestamp::to_us(low_power_stats.clock_restored_at - start);
+        low_power_stats.address_wakeup = hid_buses[0].handle.Instance->ISR & I2C_ISR_ADDR;
+        low_power_stats.stop_entries++;
+    }
+    else
+    {
+        lock.sleep([]() { __WFI(); });
+    }
+#elif I2C_HID_IDLE_CLOCK_SCALING
+    // the system clock is lowered while no transfer is ongoing, the address match raises it
+    st::interrupt_lock lock;
+    if (hid_buses_idle())
+    {
+        select_clock_profile(IDLE_CLOCK_PROFILE);
+    }
+    lock.sleep([]() { __WFI(); });
+#else
+    __WFI();
+#endif
+}
+
 void set_led(bool value)
 {
     HAL_GPIO_WritePin(GPIOC, LD3_Pin, (GPIO_PinState)(value));
 }
 
+// the report pool is shared by the transport's and the application's interrupt contexts
+using report_pool_lock = hid::demo_app::report_pool_lock;
+static_assert((sizeof(st::interrupt_lock) <= sizeof(report_pool_lock::state)) and
+              (alignof(st::interrupt_lock) <= alignof(report_pool_lock)));
+
+report_pool_lock::report_pool_lock()
+{
+    // the lock windows are attributed to the pool operation
+    new (state) st::interrupt_lock(__builtin_return_address(0));
+}
+
+report_pool_lock::~report_pool_lock()
+{
+    std::launder(reinterpret_cast<st::interrupt_lock*>(state))->~interrupt_lock();
+}
+
+void read_transport_counters(std::size_t bus, hid::demo_app::counters& counters)
+{
+    using counter = hid::demo_app::perf_counter;
+    auto& stats = get_i2c_slave(bus).stats();
+    counters.set(counter::I2C_WRITE_TRANSFERS, stats.write_transfers);
+    counters.set(counter::I2C_READ_TRANSFERS, stats.read_transfers);
+    counters.set(counter::I2C_BYTES_WRITTEN, stats.bytes_written);
+    counters.set(counter::I2C_BYTES_READ, stats.bytes_read);
+    counters.set(counter::I2C_NACKS, stats.nacks);
+    counters.set(counter::I2C_DUMMY_SENDS, stats.dummy_sends);
+    counters.set(counter::I2C_PADDING_BYTES, stats.padding_bytes);
+    counters.set(counter::I2C_MAX_CALLBACK_CYCLES, stats.max_callback_cycles);
+    counters.set(counter::I2C_BUS_ERRORS, stats.bus_errors);
+    counters.set(counter::I2C_ARBITRATION_LOSSES, stats.arbitration_losses);
+    counters.set(counter::I2C_OVERRUNS, stats.overruns);
+    counters.set(counter::I2C_MAX_RECOVERY_CYCLES, stats.max_recovery_cycles);
+    // the rest is shared by the devices of all buses, only the first device reports it
+    if (bus != 0)
+    {
+        return;
+    }
+    counters.set(counter::DEFERRED_WORK_MAX_PENDING, deferred_work.stats().max_pending);
+    counters.set(counter::DEFERRED_WORK_DROPS, deferred_work.stats().drops);
+    counters.set(counter::I2C_IRQ_MAX_CYCLES, irq_profile_max_cycles(IRQ_VECTOR_I2C_HID));
+    counters.set(counter::DMA_IRQ_MAX_CYCLES, irq_profile_max_cycles(IRQ_VECTOR_I2C_HID_DMA));
+    counters.set(counter::BUTTON_IRQ_MAX_CYCLES, irq_profile_max_cycles(IRQ_VECTOR_BUTTON));
+    counters.set(counter::DEFERRED_WORK_MAX_CYCLES,
+                 irq_profile_max_cycles(IRQ_VECTOR_DEFERRED_WORK));
+    counters.set(counter::I2C_IRQ_WORST_DELAY_CYCLES, irq_profile_worst_delay(IRQ_VECTOR_I2C_HID));
+    counters.set(counter::STACK_PEAK_BYTES, stack_monitor.peak_usage());
+    counters.set(counter::STACK_FREE_BYTES, stack_monitor.free_bytes());
+#if I2C_HID_RAMFUNC
+    counters.set(counter::RAM_CODE_BYTES, (_eramfunc - _sramfunc) + sizeof(ram_vectors));
+#else
+    counters.set(counter::RAM_CODE_BYTES, _eramfunc - _sramfunc);
+#endif
+#if I2C_HID_LOCK_PROFILE
+    {
+        st::interrupt_lock lock;
+        auto& profile = st::interrupt_lock::profile();
+        counters.set(counter::LOCK_MAX_CYCLES, profile.max_cycles);
+        counters.set(counter::LOCK_MAX_CALL_SITE, profile.max_call_site);
+    }
+#endif
+#if I2C_HID_LOW_POWER
+    counters.set(counter::STOP_ENTRIES, low_power_stats.stop_entries);
+    counters.set(counter::MAX_WAKEUP_US, low_power_stats.max_wakeup_us);
+#endif
+    counters.set(counter::CLOCK_FAULTS, clock_faults);
+#if I2C_HID_IDLE_CLOCK_SCALING
+    counters.set(counter::CLOCK_RAISES, clock_scaling_stats.raises);
+    counters.set(counter::MAX_CLOCK_RAISE_US, clock_scaling_stats.max_raise_us);
+#endif
+}
+
+void clear_transport_counters(std::size_t bus)
+{
+    get_i2c_slave(bus).reset_stats();
+    if (bus != 0)
+    {
+        return;
+    }
+    deferred_work.reset_stats();
+    irq_profile_clear();
+    clock_faults = 0;
+#if I2C_HID_LOCK_PROFILE
+    {
+        st::interrupt_lock lock;
+        st::interrupt_lock::profile() = {};
+    }
+#endif
+#if I2C_HID_LOW_POWER
+    low_power_stats.stop_entries = 0;
+    low_power_stats.max_wakeup_us = 0;
+#endif
+#if I2C_HID_IDLE_CLOCK_SCALING
+    clock_scaling_stats = {};
+#endif
+}
+
+void read_interrupt_latency(std::size_t bus, const std::span<uint8_t>& data)
+{
+    static_assert(sizeof(st::interrupt_latency) == hid::demo_app::LATENCY_SIZE);
+    auto& latency = get_i2c_slave(bus).latency();
+    std::memcpy(data.data(), &latency, sizeof(latency));
+}
+
+void clear_interrupt_latency(std::size_t bus)
+{
+    get_i2c_slave(bus).reset_latency();
+}
+
+static void button_state_change(std::uintptr_t pressed)
+{
+    for (std::size_t i = 0; i < HID_BUS_COUNT; i++)
+    {
+        // the application expects to run at the priority of its transport
+        bus_interrupt_lock lock{i};
+        hid::demo_app::instance(i).button_state_change(pressed);
+    }
+}
+
 extern "C" void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
 {
     if (GPIO_Pin == B1_Pin)
     {
+        // the pin is sampled in the interrupt, the report is built later
         bool pressed = HAL_GPIO_ReadPin(B1_GPIO_Port, B1_Pin);
+        deferred_work.post(&button_state_change, pressed);
+    }
+}
+
+#if I2C_HID_LL_SLAVE
+extern "C" void i2c_hid_slave_irq_handler(I2C_HandleTypeDef* hi2c)
+{
+    if (auto* slave = hid_slave(hi2c))
+    {
+        bus_activity();
+        slave->handle_irq();
+    }
+}
+
+extern "C" void i2c_hid_slave_dma_irq_handler(I2C_HandleTypeDef* hi2c)
+{
+    if (auto* slave = hid_slave(hi2c))
+    {
+        slave->handle_dma_irq();
+    }
+}
 
-        hid::demo_app::instance().button_state_change(pressed);
+#else
+// the callbacks of the I2C peripherals, that don't serve a HID bus, are ignored;
+// HAL_I2C_EV_IRQHandler() and HAL_I2C_ER_IRQHandler() that call them are left in flash:
+// the HAL sources are regenerated by CubeMX, and the linker script serves both configurations
+extern "C" ST_RAMFUNC void HAL_I2C_AddrCallback(I2C_HandleTypeDef* hi2c,
+                                                uint8_t TransferDirection, uint16_t AddrMatchCode)
+{
+    if (auto* slave = hid_slave(hi2c))
+    {
+        bus_activity();
+        slave->handle_start(static_cast<i2c::direction>(TransferDirection));
     }
 }
 
-extern "C" void HAL_I2C_AddrCallback([[maybe_unused]] I2C_HandleTypeDef* hi2c,
-                                     uint8_t TransferDirection, uint16_t AddrMatchCode)
+extern "C" ST_RAMFUNC void HAL_I2C_ListenCpltCallback(I2C_HandleTypeDef* hi2c)
 {
-    get_i2c_slave().handle_start(static_cast<i2c::direction>(TransferDirection));
+    if (auto* slave = hid_slave(hi2c))
+    {
+        slave->handle_stop();
+    }
 }
 
-extern "C" void HAL_I2C_ListenCpltCallback([[maybe_unused]] I2C_HandleTypeDef* hi2c)
+extern "C" ST_RAMFUNC void HAL_I2C_SlaveTxCpltCallback(I2C_HandleTypeDef* hi2c)
 {
-    get_i2c_slave().handle_stop();
+    if (auto* slave = hid_slave(hi2c))
+    {
+        slave->handle_tx_complete();
+    }
 }
 
-extern "C" void HAL_I2C_SlaveTxCpltCallback([[maybe_unused]] I2C_HandleTypeDef* hi2c)
+extern "C" ST_RAMFUNC void HAL_I2C_SlaveRxCpltCallback(I2C_HandleTypeDef* hi2c)
 {
-    get_i2c_slave().handle_tx_complete();
+    if (auto* slave = hid_slave(hi2c))
+    {
+        slave->handle_rx_complete();
+    }
 }
 
-extern "C" void HAL_I2C_SlaveRxCpltCallback([[maybe_unused]] I2C_HandleTypeDef* hi2c)
+// handle_error() reinitializes the peripheral with the HAL, so the recovery stays in flash
+extern "C" ST_RAMFUNC void HAL_I2C_ErrorCallback(I2C_HandleTypeDef* hi2c)
 {
-    get_i2c_slave().handle_rx_complete();
+    if (auto* slave = hid_slave(hi2c))
+    {
+        slave->handle_error(HAL_I2C_GetError(hi2c));
+    }
 }
+#endif
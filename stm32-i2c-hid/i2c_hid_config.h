@@ -1,8 +1,22 @@
 #ifndef __I2C_HID_CONFIG_H_
 #define __I2C_HID_CONFIG_H_
 
+#include "main.h"
+#include "st/ramfunc.h"
+
 void create_i2c_hid_device(void);
 
 void test_i2c_hid_device(void);
 
+/* to be called from the main loop, sleeps until the next interrupt */
+void i2c_hid_idle(void);
+
+/* to be called from PendSV_Handler(), executes the work that interrupts deferred */
+void i2c_hid_deferred_work(void);
+
+/* interrupt entry points of the register level I2C slave driver */
+ST_RAMFUNC void i2c_hid_slave_irq_handler(I2C_HandleTypeDef* hi2c);
+
+ST_RAMFUNC void i2c_hid_slave_dma_irq_handler(I2C_HandleTypeDef* hi2c);
+
 #endif // __I2C_HID_CONFIG_H_
@@ -0,0 +1,78 @@
+extern "C"
+{
+#include "irq_priorities.h"
+#include "main.h"
+}
+#include <algorithm>
+#include <array>
+#include "st/timestamp.hpp"
+
+static_assert(IRQ_PRIORITY_DEFERRED_WORK == ((1 << __NVIC_PRIO_BITS) - 1),
+              "the deferred work must run at the lowest priority");
+static_assert(IRQ_PRIORITY_TICK == TICK_INT_PRIORITY,
+              "HAL_InitTick() applies TICK_INT_PRIORITY, keep it in sync");
+
+static constexpr std::array<uint32_t, IRQ_VECTOR_COUNT> priorities{
+    IRQ_PRIORITY_I2C_HID, IRQ_PRIORITY_I2C_HID_DMA, IRQ_PRIORITY_BUTTON, IRQ_PRIORITY_TICK,
+    IRQ_PRIORITY_DEFERRED_WORK};
+
+static std::array<uint32_t, IRQ_VECTOR_COUNT> max_cycles{};
+
+extern "C" void irq_priorities_apply()
+{
+    NVIC_SetPriority(I2C1_IRQn, priorities[IRQ_VECTOR_I2C_HID]);
+    NVIC_SetPriority(I2C2_IRQn, priorities[IRQ_VECTOR_I2C_HID]);
+    NVIC_SetPriority(DMA1_Channel2_3_IRQn, priorities[IRQ_VECTOR_I2C_HID_DMA]);
+    NVIC_SetPriority(DMA1_Channel4_5_6_7_IRQn, priorities[IRQ_VECTOR_I2C_HID_DMA]);
+    NVIC_SetPriority(EXTI0_1_IRQn, priorities[IRQ_VECTOR_BUTTON]);
+    NVIC_SetPriority(SysTick_IRQn, priorities[IRQ_VECTOR_TICK]);
+    NVIC_SetPriority(PendSV_IRQn, priorities[IRQ_VECTOR_DEFERRED_WORK]);
+}
+
+#if I2C_HID_IRQ_PROFILE
+extern "C" uint32_t irq_profile_enter()
+{
+    return st::timestamp::now();
+}
+
+extern "C" void irq_profile_exit(enum irq_vector vector, uint32_t start)
+{
+    // each vector only updates its own maximum, with a single word store
+    uint32_t cycles = st::timestamp::now() - start;
+    max_cycles[vector] = std::max(max_cycles[vector], cycles);
+}
+#endif
+
+extern "C" uint32_t irq_profile_max_cycles(enum irq_vector vector)
+{
+    return max_cycles[vector];
+}
+
+extern "C" uint32_t irq_profile_worst_delay(enum irq_vector vector)
+{
+    // the vector waits for the one handler of its level that is being executed,
+    // and it can be preempted by each of the higher levels
+    uint32_t same_level = 0;
+    uint32_t higher_levels = 0;
+    for (std::size_t i = 0; i < IRQ_VECTOR_COUNT; i++)
+    {
+        if (i == vector)
+        {
+            continue;
+        }
+        if (priorities[i] == priorities[vector])
+        {
+            same_level = std::max(same_level, max_cycles[i]);
+        }
+        else if (priorities[i] < priorities[vector])
+        {
+            higher_levels += max_cycles[i];
+        }
+    }
+    return same_level + higher_levels;
+}
+
+extern "C" void irq_profile_clear()
+{
+    max_cycles = {};
+}
@@ -0,0 +1,64 @@
+#ifndef __IRQ_PRIORITIES_H_
+#define __IRQ_PRIORITIES_H_
+
+#include <stdint.h>
+
+/* the interrupt vectors of the firmware, grouped by their role */
+enum irq_vector
+{
+    IRQ_VECTOR_I2C_HID,       /* I2C event and error of the HID slaves */
+    IRQ_VECTOR_I2C_HID_DMA,   /* DMA channels of the HID slaves */
+    IRQ_VECTOR_BUTTON,        /* EXTI of the user button */
+    IRQ_VECTOR_TICK,          /* SysTick, the HAL time base */
+    IRQ_VECTOR_DEFERRED_WORK, /* PendSV, executing the work deferred by the others */
+    IRQ_VECTOR_COUNT
+};
+
+/* the priority plan, a lower value preempts a higher one (Cortex-M0 has 4 levels):
+ * - the I2C slaves and their DMA channels both enter the HID transport and the application,
+ *   so they share the highest level, and never preempt each other
+ * - the button only samples the pin, and can be preempted by the I2C slaves
+ * - the HAL time base is only used for timeouts
+ * - the deferred work runs below all interrupts, and can be preempted by any of them */
+#define IRQ_PRIORITY_I2C_HID       0
+#define IRQ_PRIORITY_I2C_HID_DMA   IRQ_PRIORITY_I2C_HID
+#define IRQ_PRIORITY_BUTTON        1
+#define IRQ_PRIORITY_TICK          2
+#define IRQ_PRIORITY_DEFERRED_WORK 3
+
+/* applies the priority plan, overriding the CubeMX generated priorities,
+ * needs to be called again when an I2C slave's MSP is reinitialized */
+void irq_priorities_apply(void);
+
+#ifndef I2C_HID_IRQ_PROFILE
+#define I2C_HID_IRQ_PROFILE 0
+#endif
+
+/* measures the residency of an interrupt vector, to be called at the entry and the exit
+ * of the handler, the residency includes the time spent in nested interrupts,
+ * when I2C_HID_IRQ_PROFILE is disabled, the measurement compiles to nothing */
+#if I2C_HID_IRQ_PROFILE
+uint32_t irq_profile_enter(void);
+void irq_profile_exit(enum irq_vector vector, uint32_t start);
+#else
+static inline uint32_t irq_profile_enter(void)
+{
+    return 0;
+}
+static inline void irq_profile_exit(enum irq_vector vector, uint32_t start)
+{
+    (void)vector;
+    (void)start;
+}
+#endif
+
+/* the longest measured residency of a vector, in timestamp cycles, 0 without the profile */
+uint32_t irq_profile_max_cycles(enum irq_vector vector);
+
+/* the worst case delay of entering a vector, in timestamp cycles, derived from the measurements:
+ * the longest residency of any other vector at the same level, and of each higher level one */
+uint32_t irq_profile_worst_delay(enum irq_vector vector);
+
+void irq_profile_clear(void);
+
+#endif // __IRQ_PRIORITIES_H_
@@ -0,0 +1,107 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+#ifndef __ST_ATOMIC_OPS_HPP_
+#define __ST_ATOMIC_OPS_HPP_
+
+#include <atomic>
+#include "st/interrupt_lock.hpp"
+
+namespace st
+{
+/// @brief Read-modify-write operations for cores without exclusive access instructions
+///        (Cortex-M0), each executed in a single critical section.
+///        Aligned loads and stores of up to 4 bytes are single instructions, so they don't lock.
+/// @tparam T: the value type, of 1, 2 or 4 bytes
+///        The optional call site attributes the critical section to the caller of a wrapper,
+///        when profiling the interrupt locks.
+/// @tparam TLock: interrupt_lock, or no_interrupt_lock when the value is only accessed
+///                from a single interrupt priority level
+template <typename T, typename TLock = interrupt_lock>
+struct atomic_ops
+{
+    static_assert((sizeof(T) == 1) or (sizeof(T) == 2) or (sizeof(T) == 4));
+
+    static T load(const volatile void* ptr)
+    {
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+        T value = *static_cast<const volatile T*>(ptr);
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+        return value;
+    }
+
+    static void store(volatile void* ptr, T value)
+    {
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+        *static_cast<volatile T*>(ptr) = value;
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+    }
+
+    static T exchange(volatile void* ptr, T value, const void* call_site = nullptr)
+    {
+        return modify(ptr, [value](T) { return value; }, call_site);
+    }
+
+    static bool compare_exchange(volatile void* ptr, void* expected, T desired,
+                                 const void* call_site = nullptr)
+    {
+        [[maybe_unused]] TLock lock{call_site};
+        auto* p = static_cast<volatile T*>(ptr);
+        T value = *p;
+        if (value == *static_cast<T*>(expected))
+        {
+            *p = desired;
+            return true;
+        }
+        *static_cast<T*>(expected) = value;
+        return false;
+    }
+
+    static T fetch_add(volatile void* ptr, T value, const void* call_site = nullptr)
+    {
+        return modify(ptr, [value](T old) { return old + value; }, call_site);
+    }
+    static T fetch_sub(volatile void* ptr, T value, const void* call_site = nullptr)
+    {
+        return modify(ptr, [value](T old) { return old - value; }, call_site);
+    }
+    static T fetch_and(volatile void* ptr, T value, const void* call_site = nullptr)
+    {
+        return modify(ptr, [value](T old) { return old & value; }, call_site);
+    }
+    static T fetch_or(volatile void* ptr, T value, const void* call_site = nullptr)
+    {
+        return modify(ptr, [value](T old) { return old | value; }, call_site);
+    }
+    static T fetch_xor(volatile void* ptr, T value, const void* call_site = nullptr)
+    {
+        return modify(ptr, [value](T old) { return old ^ value; }, call_site);
+    }
+
+  private:
+    /// @return the value before the modification
+    template <typename TOperation>
+    static T modify(volatile void* ptr, TOperation operation, const void* call_site)
+    {
+        [[maybe_unused]] TLock lock{call_site};
+        auto* p = static_cast<volatile T*>(ptr);
+        T old = *p;
+        *p = operation(old);
+        return old;
+    }
+};
+
+/// @brief Atomic operations on values only accessed from a single interrupt priority level.
+template <typename T>
+using isr_atomic_ops = atomic_ops<T, no_interrupt_lock>;
+
+} // namespace st
+
+#endif // __ST_ATOMIC_OPS_HPP_
@@ -0,0 +1,171 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+#ifndef __ST_CLOCK_PROFILE_HPP_
+#define __ST_CLOCK_PROFILE_HPP_
+
+#include <cstdint>
+#include "st/stm32hal.h"
+#include "st/timestamp.hpp"
+
+namespace st
+{
+/// @brief System clock sources, with the AHB and APB clocks undivided.
+enum class clock_profile : std::uint8_t
+{
+    HSI,   ///< 8 MHz HSI, the idle profile
+    PLL,   ///< 48 MHz from HSI multiplied by the PLL, as configured by CubeMX
+    HSI48, ///< 48 MHz HSI48, ready in a few microseconds instead of the PLL lock time
+};
+
+constexpr std::uint32_t frequency(clock_profile profile)
+{
+    return (profile == clock_profile::HSI) ? HSI_VALUE : 48'000'000;
+}
+
+/// @brief Switches the system clock between the profiles at register level, and keeps
+///        the flash wait states, SystemCoreClock, the HAL time base and the timestamps
+///        consistent with it. The PLL configuration is left as SystemClock_Config() set it up.
+/// @note  HSI stays enabled in all profiles, as it's the kernel clock of I2C1.
+class system_clock
+{
+  public:
+    static clock_profile current()
+    {
+        switch (RCC->CFGR & RCC_CFGR_SWS)
+        {
+        case RCC_CFGR_SWS_PLL:
+            return clock_profile::PLL;
+        case RCC_CFGR_SWS_HSI48:
+            return clock_profile::HSI48;
+        default:
+            return clock_profile::HSI;
+        }
+    }
+
+    /// @brief Selects the system clock profile, the unused 48 MHz oscillators are stopped.
+    ///        When the oscillator doesn't become ready, or the flash wait states or the switch
+    ///        don't take effect in time, the system clock falls back to HSI.
+    /// @return true if the profile is selected, false if the system runs from HSI instead
+    /// @note  Must not be preempted by another call, or by code reading the timestamps.
+    ///        The timestamp has to be initialized, as it measures the timeouts.
+    static bool select(clock_profile profile)
+    {
+        if (current() == profile)
+        {
+            return true;
+        }
+        bool selected = switch_to(profile);
+        if (!selected and (current() != clock_profile::HSI))
+        {
+            // HSI is always ready
+            switch_to(clock_profile::HSI);
+        }
+
+        auto active = current();
+        if (active != clock_profile::PLL)
+        {
+            RCC->CR &= ~RCC_CR_PLLON;
+        }
+        if (active != clock_profile::HSI48)
+        {
+            RCC->CR2 &= ~RCC_CR2_HSI48ON;
+        }
+        auto hz = frequency(active);
+        // the wait states are decreased after slowing down, extra ones only cost speed
+        if (hz <= FLASH_ZERO_WAIT_STATE_MAX_HZ)
+        {
+            set_flash_latency(0);
+        }
+
+        // SystemCoreClockUpdate() doesn't recognize HSI48 as system clock
+        SystemCoreClock = hz;
+        HAL_InitTick(TICK_INT_PRIORITY);
+        return selected;
+    }
+
+  private:
+    static constexpr std::uint32_t FLASH_ZERO_WAIT_STATE_MAX_HZ = 24'000'000;
+    // twice the maximal PLL lock time and HSI48 startup time of the datasheet
+    static constexpr std::uint32_t PLL_LOCK_TIMEOUT_US = 400;
+    static constexpr std::uint32_t HSI48_READY_TIMEOUT_US = 12;
+    // the flash wait states and the clock switch take effect within a few cycles
+    static constexpr std::uint32_t REGISTER_TIMEOUT_US = 10;
+
+    static_assert((timestamp::FREQUENCY % frequency(clock_profile::HSI)) == 0);
+
+    /// @return false if the switch didn't complete in time
+    static bool switch_to(clock_profile profile)
+    {
+        // the wait states are increased before speeding up
+        if ((frequency(profile) > FLASH_ZERO_WAIT_STATE_MAX_HZ) and
+            !set_flash_latency(FLASH_ACR_LATENCY))
+        {
+            return false;
+        }
+
+        uint32_t sw = RCC_CFGR_SW_HSI;
+        uint32_t sws = RCC_CFGR_SWS_HSI;
+        if (profile == clock_profile::PLL)
+        {
+            RCC->CR |= RCC_CR_PLLON;
+            if (!wait_for([]() { return (RCC->CR & RCC_CR_PLLRDY) != 0; }, PLL_LOCK_TIMEOUT_US))
+            {
+                return false;
+            }
+            sw = RCC_CFGR_SW_PLL;
+            sws = RCC_CFGR_SWS_PLL;
+        }
+        else if (profile == clock_profile::HSI48)
+        {
+            RCC->CR2 |= RCC_CR2_HSI48ON;
+            if (!wait_for([]() { return (RCC->CR2 & RCC_CR2_HSI48RDY) != 0; },
+                          HSI48_READY_TIMEOUT_US))
+            {
+                return false;
+            }
+            sw = RCC_CFGR_SW_HSI48;
+            sws = RCC_CFGR_SWS_HSI48;
+        }
+        RCC->CFGR = (RCC->CFGR & ~RCC_CFGR_SW) | sw;
+        if (!wait_for([sws]() { return (RCC->CFGR & RCC_CFGR_SWS) == sws; },
+                      REGISTER_TIMEOUT_US))
+        {
+            return false;
+        }
+        timestamp::rate_changed(frequency(profile));
+        return true;
+    }
+
+    static bool set_flash_latency(uint32_t latency)
+    {
+        FLASH->ACR = (FLASH->ACR & ~FLASH_ACR_LATENCY) | latency;
+        return wait_for([latency]() { return (FLASH->ACR & FLASH_ACR_LATENCY) == latency; },
+                        REGISTER_TIMEOUT_US);
+    }
+
+    /// @brief Polls the condition until it's met, or the timeout elapses.
+    template <typename TCondition>
+    static bool wait_for(TCondition&& condition, uint32_t timeout_us)
+    {
+        auto start = timestamp::now();
+        while (!condition())
+        {
+            if ((timestamp::now() - start) > timestamp::from_us(timeout_us))
+            {
+                return condition();
+            }
+        }
+        return true;
+    }
+};
+} // namespace st
+
+#endif // __ST_CLOCK_PROFILE_HPP_
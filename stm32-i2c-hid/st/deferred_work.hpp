@@ -0,0 +1,101 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+#ifndef __ST_DEFERRED_WORK_HPP_
+#define __ST_DEFERRED_WORK_HPP_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include "st/interrupt_lock.hpp"
+
+namespace st
+{
+/// @brief Queue of work items that interrupt handlers post, to be executed later
+///        from the PendSV exception, which needs to be set to the lowest interrupt priority.
+///        The items are executed in posting order, and the idle loop only sleeps
+///        once all of them are done, as PendSV tail-chains the posting interrupt.
+/// @tparam CAPACITY: the maximum number of pending items, must be a power of 2
+template <std::size_t CAPACITY>
+class deferred_work
+{
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0);
+    using index_type = std::uint8_t;
+    static_assert(CAPACITY < (1 << (8 * sizeof(index_type))));
+
+  public:
+    /// @brief Work item, a function with a single word of context.
+    using handler = void (*)(std::uintptr_t arg);
+
+    struct statistics
+    {
+        std::uint32_t max_pending;
+        std::uint32_t drops;
+    };
+
+    constexpr deferred_work() = default;
+
+    /// @brief Producer side: schedules a work item, callable from any interrupt priority.
+    /// @return false if the item was dropped due to the queue being full
+    bool post(handler fn, std::uintptr_t arg = 0)
+    {
+        {
+            // producers can preempt each other, the lock is held for a few instructions only
+            interrupt_lock lock;
+            auto tail = tail_.load(std::memory_order_relaxed);
+            index_type pending = tail - head_.load(std::memory_order_acquire);
+            if (pending >= CAPACITY)
+            {
+                stats_.drops++;
+                return false;
+            }
+            items_[tail % CAPACITY] = {fn, arg};
+            tail_.store(tail + 1, std::memory_order_release);
+
+            pending++;
+            if (pending > stats_.max_pending)
+            {
+                stats_.max_pending = pending;
+            }
+        }
+        SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+        return true;
+    }
+
+    /// @brief Consumer side: executes all pending items, to be called from PendSV_Handler().
+    void run()
+    {
+        auto head = head_.load(std::memory_order_relaxed);
+        while (head != tail_.load(std::memory_order_acquire))
+        {
+            auto item = items_[head % CAPACITY];
+            head_.store(++head, std::memory_order_release);
+            item.fn(item.arg);
+        }
+    }
+
+    const statistics& stats() const { return stats_; }
+    void reset_stats() { stats_ = {}; }
+
+  private:
+    struct item
+    {
+        handler fn;
+        std::uintptr_t arg;
+    };
+
+    std::array<item, CAPACITY> items_{};
+    std::atomic<index_type> head_{};
+    std::atomic<index_type> tail_{};
+    statistics stats_{};
+};
+} // namespace st
+
+#endif // __ST_DEFERRED_WORK_HPP_
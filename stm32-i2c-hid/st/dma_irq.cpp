@@ -0,0 +1,31 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+#include "st/dma_irq.h"
+
+extern "C" void dma_shared_irq_handler(DMA_HandleTypeDef* const* handles, unsigned count)
+{
+    // the channels of a vector may belong to different DMA controllers
+    DMA_TypeDef* dma = nullptr;
+    uint32_t flags = 0;
+    for (unsigned i = 0; i < count; i++)
+    {
+        auto* handle = handles[i];
+        if (handle->DmaBaseAddress != dma)
+        {
+            dma = handle->DmaBaseAddress;
+            flags = dma->ISR;
+        }
+        if (flags & (DMA_ISR_GIF1 << handle->ChannelIndex))
+        {
+            HAL_DMA_IRQHandler(handle);
+        }
+    }
+}
@@ -0,0 +1,32 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+#ifndef __ST_DMA_IRQ_H_
+#define __ST_DMA_IRQ_H_
+
+#include "st/ramfunc.h"
+#include "st/stm32hal.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/// @brief Services the DMA channels sharing an interrupt vector: the interrupt flags are read once,
+///        and only the channels with pending flags are passed to HAL_DMA_IRQHandler().
+/// @param handles: the DMA handles of the channels that share the vector
+/// @param count: the number of handles
+ST_RAMFUNC void dma_shared_irq_handler(DMA_HandleTypeDef* const* handles, unsigned count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __ST_DMA_IRQ_H_
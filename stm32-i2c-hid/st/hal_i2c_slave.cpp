@@ -9,22 +9,28 @@
 ///         https://mozilla.org/MPL/2.0/.
 ///
 #include "st/hal_i2c_slave.hpp"
+#include <utility>
+#include "st/isr_trace.hpp"
 
 namespace st
 {
+// repeated by the TX DMA channel without memory increment
+static const uint8_t PADDING = 0;
+static constexpr uint16_t PADDING_SIZE = UINT16_MAX;
+
 hal_i2c_slave::hal_i2c_slave(I2C_HandleTypeDef& handle, void (*const i2c_slave_init_fn)(void),
                              GPIO_TypeDef* interrupt_out_port, uint16_t interrupt_out_pin)
     : handle_(&handle),
       interrupt_out_port_(interrupt_out_port),
       interrupt_out_pin_(interrupt_out_pin)
 {
-    static const GPIO_InitTypeDef GPIO_InitStruct = {
+    GPIO_InitTypeDef GPIO_InitStruct = {
         .Pin = interrupt_out_pin_,
         .Mode = GPIO_MODE_OUTPUT_PP,
         .Pull = GPIO_PULLUP,
     };
     set_pin_interrupt(false);
-    HAL_GPIO_Init(interrupt_out_port_, const_cast<GPIO_InitTypeDef*>(&GPIO_InitStruct));
+    HAL_GPIO_Init(interrupt_out_port_, &GPIO_InitStruct);
     i2c_slave_init_fn();
 }
 
@@ -40,11 +46,19 @@ void hal_i2c_slave::set_slave_address(i2c::address slave_addr)
         handle_->Init.OwnAddress1 <<= 1;
         handle_->Init.AddressingMode = I2C_ADDRESSINGMODE_7BIT;
     }
+    timing_changed_ = false;
     HAL_I2C_Init(handle_);
 }
 
+void hal_i2c_slave::set_timing(uint32_t timingr)
+{
+    handle_->Init.Timing = timingr;
+    timing_changed_ = true;
+}
+
 void hal_i2c_slave::set_pin_interrupt(bool asserted)
 {
+    latency_meter_.line_changed(asserted);
     // active low logic
     HAL_GPIO_WritePin(interrupt_out_port_, interrupt_out_pin_,
                       static_cast<GPIO_PinState>(!asserted));
@@ -68,17 +82,59 @@ void hal_i2c_slave::stop_listen([[maybe_unused]] i2c::address slave_addr)
 
 void hal_i2c_slave::nack()
 {
+    stats_.nacks++;
     __HAL_I2C_GENERATE_NACK(handle_);
 }
 
 void hal_i2c_slave::send_dummy()
 {
-    HAL_I2C_Slave_Seq_Transmit_IT(handle_, (uint8_t*)&handle_->ErrorCode,
-                                  sizeof(handle_->ErrorCode), I2C_NEXT_FRAME);
+    stats_.dummy_sends++;
+    if (padding_)
+    {
+        // the whole padding was read, start over
+        stats_.padding_bytes += PADDING_SIZE;
+    }
+    // the DMA keeps sending the same byte until the master ends the read,
+    // so over-reads don't cost an interrupt every few bytes
+    set_tx_memory_increment(false);
+    padding_ = true;
+    HAL_I2C_Slave_Seq_Transmit_DMA(handle_, const_cast<uint8_t*>(&PADDING), PADDING_SIZE,
+                                   I2C_NEXT_FRAME);
+}
+
+void hal_i2c_slave::set_tx_memory_increment(bool enabled)
+{
+    // the channel configuration can only be changed while it's disabled
+    auto* channel = handle_->hdmatx->Instance;
+    channel->CCR &= ~DMA_CCR_EN;
+    if (enabled)
+    {
+        channel->CCR |= DMA_CCR_MINC;
+    }
+    else
+    {
+        channel->CCR &= ~DMA_CCR_MINC;
+    }
+}
+
+void hal_i2c_slave::end_padding()
+{
+    if (padding_)
+    {
+        padding_ = false;
+        set_tx_memory_increment(true);
+    }
+}
+
+size_t hal_i2c_slave::tx_remaining() const
+{
+    // all data was sent once padding started
+    return padding_ ? 0 : __HAL_DMA_GET_COUNTER(handle_->hdmatx);
 }
 
 void hal_i2c_slave::send(const std::span<const uint8_t>& a)
 {
+    end_padding();
     first_size_ = a.size();
     second_size_ = 0;
     second_data_ = nullptr;
@@ -88,6 +144,7 @@ void hal_i2c_slave::send(const std::span<const uint8_t>& a)
 
 void hal_i2c_slave::send(const std::span<const uint8_t>& a, const std::span<const uint8_t>& b)
 {
+    end_padding();
     first_size_ = a.size();
     second_size_ = b.size();
     second_data_ = (second_size_ > 0) ? const_cast<uint8_t*>(b.data()) : nullptr;
@@ -113,6 +170,13 @@ void hal_i2c_slave::receive(const std::span<uint8_t>& a, const std::span<uint8_t
 
 void hal_i2c_slave::handle_start(i2c::direction dir)
 {
+    isr_trace::scope trace{isr_trace::START, dir};
+    statistics::callback_timer timer{stats_};
+    stats_.starts++;
+    if (dir == i2c::direction::READ)
+    {
+        latency_meter_.read_started();
+    }
     bool success = has_module();
     if (success)
     {
@@ -126,13 +190,14 @@ void hal_i2c_slave::handle_start(i2c::direction dir)
             }
             if (dir == i2c::direction::WRITE)
             {
-                size -= __HAL_DMA_GET_COUNTER(handle_->hdmatx);
+                size -= tx_remaining();
             }
             else
             {
                 size -= __HAL_DMA_GET_COUNTER(handle_->hdmarx);
             }
         }
+        trace.set_size(size);
         success = on_start(dir, size);
     }
     if (!success)
@@ -151,6 +216,9 @@ void hal_i2c_slave::handle_start(i2c::direction dir)
 
 void hal_i2c_slave::handle_tx_complete()
 {
+    isr_trace::scope trace{isr_trace::TX_COMPLETE, i2c::direction::READ};
+    statistics::callback_timer timer{stats_};
+    stats_.tx_completes++;
     if (second_data_ != nullptr)
     {
         auto* data = second_data_;
@@ -165,6 +233,9 @@ void hal_i2c_slave::handle_tx_complete()
 
 void hal_i2c_slave::handle_rx_complete()
 {
+    isr_trace::scope trace{isr_trace::RX_COMPLETE, i2c::direction::WRITE};
+    statistics::callback_timer timer{stats_};
+    stats_.rx_completes++;
     if (second_data_ != nullptr)
     {
         auto* data = second_data_;
@@ -179,28 +250,97 @@ void hal_i2c_slave::handle_rx_complete()
 
 void hal_i2c_slave::handle_stop()
 {
+    auto dir = std::exchange(last_dir_, std::nullopt);
+    isr_trace::scope trace{isr_trace::STOP, dir.value_or(i2c::direction::WRITE)};
+    statistics::callback_timer timer{stats_};
+    stats_.stops++;
     if (has_module())
     {
-        size_t size = first_size_;
-        if (size > 0)
+        if (dir)
         {
-            if (second_data_ == nullptr)
+            size_t size = first_size_;
+            if (size > 0)
             {
-                size += second_size_;
+                if (second_data_ == nullptr)
+                {
+                    size += second_size_;
+                }
+                if (*dir == i2c::direction::WRITE)
+                {
+                    size -= __HAL_DMA_GET_COUNTER(handle_->hdmarx);
+                }
+                else
+                {
+                    size -= tx_remaining();
+                }
             }
-            if (last_dir_ == i2c::direction::WRITE)
+            if (*dir == i2c::direction::WRITE)
             {
-                size -= __HAL_DMA_GET_COUNTER(handle_->hdmarx);
+                stats_.write_transfers++;
+                stats_.bytes_written += size;
             }
             else
             {
-                size -= __HAL_DMA_GET_COUNTER(handle_->hdmatx);
+                stats_.read_transfers++;
+                stats_.bytes_read += size;
             }
+            if (padding_)
+            {
+                stats_.padding_bytes += PADDING_SIZE - __HAL_DMA_GET_COUNTER(handle_->hdmatx);
+                end_padding();
+            }
+            trace.set_size(size);
+            on_stop(*dir, size);
         }
-        on_stop(last_dir_, size);
         first_size_ = 0;
         second_size_ = 0;
 
+        // disabling the peripheral would drop the address of a transfer that already started,
+        // so the timing is only changed while the bus is idle
+        if (timing_changed_ and !__HAL_I2C_GET_FLAG(handle_, I2C_FLAG_BUSY))
+        {
+            timing_changed_ = false;
+            HAL_I2C_Init(handle_);
+        }
+        start_listen();
+    }
+}
+
+void hal_i2c_slave::handle_error(uint32_t error_code)
+{
+    // the master ending a read with NACK is reported as acknowledge failure, the STOP follows
+    if ((error_code & (HAL_I2C_ERROR_BERR | HAL_I2C_ERROR_ARLO | HAL_I2C_ERROR_OVR)) == 0)
+    {
+        return;
+    }
+    auto dir = std::exchange(last_dir_, std::nullopt);
+    isr_trace::scope trace{isr_trace::ERROR, dir.value_or(i2c::direction::WRITE)};
+    statistics::recovery_timer timer{stats_};
+    stats_.count_errors(error_code & HAL_I2C_ERROR_BERR, error_code & HAL_I2C_ERROR_ARLO,
+                        error_code & HAL_I2C_ERROR_OVR);
+
+    HAL_DMA_Abort(handle_->hdmatx);
+    HAL_DMA_Abort(handle_->hdmarx);
+    end_padding();
+    if (has_module())
+    {
+        // the broken transfer ends as an empty one, so the pending input report
+        // and the interrupt line are kept for the host's next attempt,
+        // an error on the idle bus has no transfer to end
+        if (dir)
+        {
+            on_stop(*dir, 0);
+        }
+        first_size_ = 0;
+        second_size_ = 0;
+        second_data_ = nullptr;
+    }
+    // the STOP of the broken transfer may never come, the peripheral is reset instead,
+    // which releases the bus lines and applies a pending timing change as well
+    timing_changed_ = false;
+    HAL_I2C_Init(handle_);
+    if (has_module())
+    {
         start_listen();
     }
 }
@@ -11,7 +11,11 @@
 #ifndef __HAL_I2C_SLAVE_HPP_
 #define __HAL_I2C_SLAVE_HPP_
 
+#include <optional>
 #include "i2c/slave.hpp"
+#include "st/i2c_slave_statistics.hpp"
+#include "st/interrupt_latency_meter.hpp"
+#include "st/ramfunc.h"
 #include "st/stm32hal.h"
 
 namespace st
@@ -19,17 +23,40 @@ namespace st
 class hal_i2c_slave : public i2c::slave
 {
   public:
+    using statistics = i2c_slave_statistics;
+
     hal_i2c_slave(I2C_HandleTypeDef& handle, void (*i2c_slave_init_fn)(void),
                   GPIO_TypeDef* interrupt_out_port, uint16_t interrupt_out_pin);
 
-    void handle_start(i2c::direction dir);
-    void handle_tx_complete();
-    void handle_rx_complete();
-    void handle_stop();
+    ST_RAMFUNC void handle_start(i2c::direction dir);
+    ST_RAMFUNC void handle_tx_complete();
+    ST_RAMFUNC void handle_rx_complete();
+    ST_RAMFUNC void handle_stop();
+    /// @brief Recovers from a bus error, an arbitration loss or an overrun, to be called from
+    ///        HAL_I2C_ErrorCallback(): the slave listens again, without waiting for a STOP.
+    /// @param error_code: the HAL I2C error code
+    void handle_error(uint32_t error_code);
+
+    /// @brief Changes the bus timing (the contents of I2C_TIMINGR), the new value is applied
+    ///        when the bus is idle, at the end of the current or next transfer.
+    void set_timing(uint32_t timingr);
+
+    /// @brief Checks whether there is any ongoing transfer on the bus.
+    bool bus_idle() const { return (handle_->Instance->ISR & I2C_ISR_BUSY) == 0; }
+
+    const statistics& stats() const { return stats_; }
+    void reset_stats() { stats_ = {}; }
+
+    /// @brief The host's reaction times to the interrupt line.
+    const interrupt_latency& latency() { return latency_meter_.latency(); }
+    void reset_latency() { latency_meter_.clear(); }
 
   private:
     void nack();
     void send_dummy();
+    void set_tx_memory_increment(bool enabled);
+    void end_padding();
+    size_t tx_remaining() const;
     void set_pin_interrupt(bool asserted) override;
     void send(const std::span<const uint8_t>& a) override;
     void send(const std::span<const uint8_t>& a, const std::span<const uint8_t>& b) override;
@@ -46,7 +73,12 @@ class hal_i2c_slave : public i2c::slave
     size_t second_size_{};
     uint8_t* second_data_{};
     uint16_t interrupt_out_pin_;
-    i2c::direction last_dir_{};
+    // the direction of the transfer in progress, empty while the bus is idle
+    std::optional<i2c::direction> last_dir_{};
+    bool timing_changed_{};
+    bool padding_{};
+    statistics stats_{};
+    interrupt_latency_meter latency_meter_{};
 };
 } // namespace st
 
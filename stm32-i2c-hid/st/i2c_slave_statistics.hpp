@@ -0,0 +1,86 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+#ifndef __I2C_SLAVE_STATISTICS_HPP_
+#define __I2C_SLAVE_STATISTICS_HPP_
+
+#include <cstdint>
+#include "st/timestamp.hpp"
+
+namespace st
+{
+/// @brief Transfer path statistics of the I2C slave drivers, to measure the throughput
+///        on the target without external bus analyzer.
+struct i2c_slave_statistics
+{
+    uint32_t starts{};
+    uint32_t stops{};
+    uint32_t tx_completes{};
+    uint32_t rx_completes{};
+    uint32_t read_transfers{};
+    uint32_t write_transfers{};
+    uint32_t bytes_read{};
+    uint32_t bytes_written{};
+    uint32_t nacks{};
+    uint32_t dummy_sends{};
+    uint32_t padding_bytes{};
+    uint32_t max_callback_cycles{};
+    uint32_t bus_errors{};
+    uint32_t arbitration_losses{};
+    uint32_t overruns{};
+    uint32_t max_recovery_cycles{};
+
+    void count_errors(bool bus_error, bool arbitration_loss, bool overrun)
+    {
+        bus_errors += bus_error;
+        arbitration_losses += arbitration_loss;
+        overruns += overrun;
+    }
+
+    /// @brief Keeps the longest duration of a scope, in @ref timestamp cycles.
+    class max_cycles_timer
+    {
+      public:
+        explicit max_cycles_timer(uint32_t& max_cycles)
+            : max_cycles_(max_cycles), start_(timestamp::now())
+        {}
+        ~max_cycles_timer()
+        {
+            uint32_t cycles = timestamp::now() - start_;
+            if (cycles > max_cycles_)
+            {
+                max_cycles_ = cycles;
+            }
+        }
+
+      private:
+        uint32_t& max_cycles_;
+        uint32_t start_;
+    };
+
+    /// @brief Measures the duration of a transfer callback.
+    struct callback_timer : max_cycles_timer
+    {
+        explicit callback_timer(i2c_slave_statistics& stats)
+            : max_cycles_timer(stats.max_callback_cycles)
+        {}
+    };
+
+    /// @brief Measures the duration of the recovery from a bus error.
+    struct recovery_timer : max_cycles_timer
+    {
+        explicit recovery_timer(i2c_slave_statistics& stats)
+            : max_cycles_timer(stats.max_recovery_cycles)
+        {}
+    };
+};
+} // namespace st
+
+#endif // __I2C_SLAVE_STATISTICS_HPP_
@@ -0,0 +1,309 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+#ifndef __ST_I2C_TIMING_HPP_
+#define __ST_I2C_TIMING_HPP_
+
+#include <cstdint>
+
+namespace st
+{
+/// @brief I2C bus speed modes, with the frequency in Hz as value.
+enum class i2c_speed : std::uint32_t
+{
+    STANDARD = 100'000,
+    FAST = 400'000,
+    FAST_PLUS = 1'000'000,
+};
+
+/// @brief Contents of the I2C_TIMINGR register, and its calculation
+///        following the I2C-bus specification (UM10204) timing limits,
+///        with the analog filter enabled and the digital filter disabled.
+struct i2c_timing
+{
+    std::uint8_t presc{};
+    std::uint8_t scldel{};
+    std::uint8_t sdadel{};
+    std::uint8_t sclh{};
+    std::uint8_t scll{};
+    bool valid{};
+
+    constexpr std::uint32_t timingr() const
+    {
+        return (static_cast<std::uint32_t>(presc) << 28) |
+               (static_cast<std::uint32_t>(scldel) << 20) |
+               (static_cast<std::uint32_t>(sdadel) << 16) |
+               (static_cast<std::uint32_t>(sclh) << 8) | scll;
+    }
+
+    static constexpr i2c_timing from_timingr(std::uint32_t value)
+    {
+        return {static_cast<std::uint8_t>((value >> 28) & 0xf),
+                static_cast<std::uint8_t>((value >> 20) & 0xf),
+                static_cast<std::uint8_t>((value >> 16) & 0xf),
+                static_cast<std::uint8_t>((value >> 8) & 0xff),
+                static_cast<std::uint8_t>(value & 0xff), true};
+    }
+
+    /// @brief I2C-bus specification limits of a speed mode, in ns.
+    struct spec
+    {
+        std::uint32_t hddat_min;
+        std::uint32_t vddat_max;
+        std::uint32_t sudat_min;
+        std::uint32_t low_min;
+        std::uint32_t high_min;
+        std::uint32_t rise_max;
+        std::uint32_t fall_max;
+
+        static constexpr spec of(i2c_speed speed)
+        {
+            switch (speed)
+            {
+            case i2c_speed::STANDARD:
+                return {0, 3450, 250, 4700, 4000, 1000, 300};
+            case i2c_speed::FAST:
+                return {0, 900, 100, 1300, 600, 300, 300};
+            default:
+                return {0, 450, 50, 500, 260, 120, 120};
+            }
+        }
+    };
+
+    /// @brief The timing parameters of the bus, in ns.
+    struct bus
+    {
+        std::uint32_t clock_hz;
+        i2c_speed speed;
+        std::uint32_t rise_ns;
+        std::uint32_t fall_ns;
+
+        constexpr std::uint32_t clock_period() const
+        {
+            return (1'000'000'000 + clock_hz / 2) / clock_hz;
+        }
+        constexpr std::uint32_t bus_period() const
+        {
+            return 1'000'000'000 / static_cast<std::uint32_t>(speed);
+        }
+        // the bus frequency is allowed to be down to 80% of the nominal
+        constexpr std::uint32_t bus_period_max() const
+        {
+            return 1'000'000'000 / (static_cast<std::uint32_t>(speed) * 8 / 10);
+        }
+        // RM0091 26.4.5: tf(max) + tHD;DAT(min) - tAF(min) - 3 * tI2CCLK <= tSDADEL
+        constexpr std::uint32_t sdadel_min() const
+        {
+            auto s = spec::of(speed);
+            auto delay = ANALOG_FILTER_DELAY_MIN + 3 * clock_period();
+            return ((fall_ns + s.hddat_min) > delay) ? (fall_ns + s.hddat_min - delay) : 0;
+        }
+        // RM0091 26.4.5: tSDADEL <= tVD;DAT(max) - tAF(max) - 4 * tI2CCLK,
+        // when the kernel clock is too slow even for a zero delay, that is the closest to the limit
+        constexpr std::uint32_t sdadel_max() const
+        {
+            auto s = spec::of(speed);
+            auto delay = ANALOG_FILTER_DELAY_MAX + 4 * clock_period();
+            return (s.vddat_max > delay) ? (s.vddat_max - delay) : 0;
+        }
+        constexpr std::uint32_t scldel_min() const { return rise_ns + spec::of(speed).sudat_min; }
+        constexpr std::uint32_t sync_delay() const
+        {
+            return ANALOG_FILTER_DELAY_MIN + 2 * clock_period();
+        }
+        // the edges are measured between 30% and 70%, the line spends at least 2/5 of that
+        // between its driven level and the nearer threshold (exponential rise, linear fall)
+        constexpr std::uint32_t rise_to_threshold() const { return rise_ns * 2 / 5; }
+        constexpr std::uint32_t fall_to_threshold() const { return fall_ns * 2 / 5; }
+    };
+
+    static constexpr std::uint32_t ANALOG_FILTER_DELAY_MIN = 50;
+    static constexpr std::uint32_t ANALOG_FILTER_DELAY_MAX = 260;
+
+    constexpr std::uint32_t prescaled_period(const bus& b) const
+    {
+        return (presc + 1) * b.clock_period();
+    }
+    constexpr std::uint32_t data_setup_time(const bus& b) const
+    {
+        return (scldel + 1) * prescaled_period(b);
+    }
+    constexpr std::uint32_t data_hold_time(const bus& b) const
+    {
+        return sdadel * prescaled_period(b);
+    }
+    // SCL is low from its fall through 30% until its rise through 30%
+    constexpr std::uint32_t low_time(const bus& b) const
+    {
+        return (scll + 1) * prescaled_period(b) + b.sync_delay() + b.rise_to_threshold();
+    }
+    // SCL is high from its rise through 70% until its fall through 70%
+    constexpr std::uint32_t high_time(const bus& b) const
+    {
+        return (sclh + 1) * prescaled_period(b) + b.sync_delay() + b.fall_to_threshold();
+    }
+    constexpr std::uint32_t period(const bus& b) const
+    {
+        return low_time(b) + high_time(b) + b.rise_ns + b.fall_ns;
+    }
+
+    /// @brief Verifies that the timing meets the I2C-bus specification limits for the given bus.
+    constexpr bool meets_spec(const bus& b) const
+    {
+        auto s = spec::of(b.speed);
+        return valid and (b.rise_ns <= s.rise_max) and (b.fall_ns <= s.fall_max) and
+               (data_setup_time(b) >= b.scldel_min()) and
+               (data_hold_time(b) >= b.sdadel_min()) and
+               (data_hold_time(b) <= b.sdadel_max()) and (low_time(b) >= s.low_min) and
+               (high_time(b) >= s.high_min);
+    }
+
+    /// @brief Verifies that the timing meets the I2C-bus specification, and the resulting
+    ///        frequency is between 80% and 100% of the nominal.
+    constexpr bool complies(const bus& b) const
+    {
+        return meets_spec(b) and (period(b) >= b.bus_period()) and
+               (period(b) <= b.bus_period_max());
+    }
+
+    /// @brief Calculates the timing that gets closest to the nominal bus frequency
+    ///        while meeting the I2C-bus specification.
+    /// @param b: the bus parameters
+    /// @return the calculated timing, with valid == false if no compliant timing exists
+    static constexpr i2c_timing calculate(const bus& b)
+    {
+        auto s = spec::of(b.speed);
+        i2c_timing best{};
+        if ((b.rise_ns > s.rise_max) or (b.fall_ns > s.fall_max))
+        {
+            return best;
+        }
+        std::uint32_t best_error = UINT32_MAX;
+
+        for (std::uint8_t presc = 0; presc < 16; presc++)
+        {
+            i2c_timing t{};
+            t.presc = presc;
+            t.valid = true;
+
+            // the smallest data setup and hold delays that meet the spec
+            for (t.scldel = 0; (t.scldel < 16) and (t.data_setup_time(b) < b.scldel_min());
+                 t.scldel++)
+            {
+            }
+            for (t.sdadel = 0; (t.sdadel < 16) and (t.data_hold_time(b) < b.sdadel_min());
+                 t.sdadel++)
+            {
+            }
+            if ((t.scldel == 16) or (t.sdadel == 16) or (t.data_hold_time(b) > b.sdadel_max()))
+            {
+                continue;
+            }
+
+            for (unsigned scll = 0; scll < 256; scll++)
+            {
+                t.scll = scll;
+                if (t.low_time(b) < s.low_min)
+                {
+                    continue;
+                }
+                t.sclh = 0;
+                if (t.period(b) > b.bus_period_max())
+                {
+                    break;
+                }
+                for (unsigned sclh = 0; sclh < 256; sclh++)
+                {
+                    t.sclh = sclh;
+                    if (t.high_time(b) < s.high_min)
+                    {
+                        continue;
+                    }
+                    auto tscl = t.period(b);
+                    if (tscl > b.bus_period_max())
+                    {
+                        break;
+                    }
+                    if (tscl < b.bus_period())
+                    {
+                        continue;
+                    }
+                    auto error = tscl - b.bus_period();
+                    if (error < best_error)
+                    {
+                        best_error = error;
+                        best = t;
+                    }
+                    break;
+                }
+            }
+        }
+        return best;
+    }
+
+    static constexpr i2c_timing calculate(std::uint32_t clock_hz, i2c_speed speed,
+                                          std::uint32_t rise_ns, std::uint32_t fall_ns)
+    {
+        return calculate(bus{clock_hz, speed, rise_ns, fall_ns});
+    }
+};
+
+// reference values from the CubeMX generated code
+static_assert(i2c_timing::from_timingr(0x10A35D83)
+                  .meets_spec({48'000'000, i2c_speed::STANDARD, 100, 10}));
+// reference values from the tables of RM0091 26.4.10, with the edge times of the bus limits
+// (the Fast-mode Plus values of the 8 MHz table are for 500 kHz)
+static_assert(i2c_timing::from_timingr(0x10420F13)
+                  .meets_spec({8'000'000, i2c_speed::STANDARD, 1000, 300}));
+static_assert(i2c_timing::from_timingr(0x00310309)
+                  .meets_spec({8'000'000, i2c_speed::FAST, 300, 300}));
+static_assert(i2c_timing::from_timingr(0x00100306)
+                  .meets_spec({8'000'000, i2c_speed::FAST_PLUS, 120, 120}));
+static_assert(i2c_timing::from_timingr(0x30420F13)
+                  .meets_spec({16'000'000, i2c_speed::STANDARD, 1000, 300}));
+static_assert(i2c_timing::from_timingr(0x10320309)
+                  .meets_spec({16'000'000, i2c_speed::FAST, 300, 300}));
+static_assert(i2c_timing::from_timingr(0x00200204)
+                  .meets_spec({16'000'000, i2c_speed::FAST_PLUS, 120, 120}));
+static_assert(i2c_timing::from_timingr(0xB0420F13)
+                  .meets_spec({48'000'000, i2c_speed::STANDARD, 1000, 300}));
+static_assert(i2c_timing::from_timingr(0x50330309)
+                  .meets_spec({48'000'000, i2c_speed::FAST, 300, 300}));
+// the data hold time of 0 ns covers a fall time of up to 113 ns
+static_assert(i2c_timing::from_timingr(0x50100103)
+                  .meets_spec({48'000'000, i2c_speed::FAST_PLUS, 120, 100}));
+
+// a compliant timing exists at the same kernel clocks
+static_assert(i2c_timing::calculate(8'000'000, i2c_speed::STANDARD, 1000, 300)
+                  .complies({8'000'000, i2c_speed::STANDARD, 1000, 300}));
+static_assert(i2c_timing::calculate(8'000'000, i2c_speed::FAST, 300, 300)
+                  .complies({8'000'000, i2c_speed::FAST, 300, 300}));
+// at 8 MHz, the synchronization leaves room for the 1 MHz period only with faster edges
+static_assert(i2c_timing::calculate(8'000'000, i2c_speed::FAST_PLUS, 50, 50)
+                  .complies({8'000'000, i2c_speed::FAST_PLUS, 50, 50}));
+static_assert(i2c_timing::calculate(16'000'000, i2c_speed::STANDARD, 1000, 300)
+                  .complies({16'000'000, i2c_speed::STANDARD, 1000, 300}));
+static_assert(i2c_timing::calculate(16'000'000, i2c_speed::FAST, 300, 300)
+                  .complies({16'000'000, i2c_speed::FAST, 300, 300}));
+static_assert(i2c_timing::calculate(16'000'000, i2c_speed::FAST_PLUS, 120, 120)
+                  .complies({16'000'000, i2c_speed::FAST_PLUS, 120, 120}));
+static_assert(i2c_timing::calculate(48'000'000, i2c_speed::STANDARD, 1000, 300)
+                  .complies({48'000'000, i2c_speed::STANDARD, 1000, 300}));
+static_assert(i2c_timing::calculate(48'000'000, i2c_speed::FAST, 300, 300)
+                  .complies({48'000'000, i2c_speed::FAST, 300, 300}));
+static_assert(i2c_timing::calculate(48'000'000, i2c_speed::FAST_PLUS, 120, 120)
+                  .complies({48'000'000, i2c_speed::FAST_PLUS, 120, 120}));
+// edges slower than the limits of the speed mode can't comply
+static_assert(!i2c_timing::calculate(48'000'000, i2c_speed::FAST_PLUS, 300, 120).valid);
+static_assert(!i2c_timing::calculate(48'000'000, i2c_speed::FAST, 300, 1000).valid);
+
+} // namespace st
+
+#endif // __ST_I2C_TIMING_HPP_
@@ -0,0 +1,74 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+#ifndef __ST_INTERRUPT_LATENCY_METER_HPP_
+#define __ST_INTERRUPT_LATENCY_METER_HPP_
+
+#include "st/latency_histogram.hpp"
+#include "st/timestamp.hpp"
+
+namespace st
+{
+/// @brief Measures how fast the host reacts to the interrupt line of the I2C slave.
+class interrupt_latency_meter
+{
+  public:
+    /// @brief To be called when the interrupt line changes state.
+    void line_changed(bool asserted)
+    {
+        auto now = timestamp::now();
+        if (asserted)
+        {
+            if (!asserted_)
+            {
+                asserted_ = true;
+                reading_ = false;
+                assert_time_ = now;
+            }
+        }
+        else if (asserted_)
+        {
+            asserted_ = false;
+            if (reading_)
+            {
+                latency_.read_to_deassert.add(now - read_time_);
+            }
+        }
+    }
+
+    /// @brief To be called when a read transfer starts.
+    void read_started()
+    {
+        // only the first read after the assertion is the host's reaction
+        if (asserted_ and !reading_)
+        {
+            reading_ = true;
+            read_time_ = timestamp::now();
+            latency_.assert_to_read.add(read_time_ - assert_time_);
+        }
+    }
+
+    const interrupt_latency& latency()
+    {
+        latency_.clock_hz = timestamp::frequency();
+        return latency_;
+    }
+    void clear() { latency_.clear(); }
+
+  private:
+    interrupt_latency latency_{};
+    uint32_t assert_time_{};
+    uint32_t read_time_{};
+    bool asserted_{};
+    bool reading_{};
+};
+} // namespace st
+
+#endif // __ST_INTERRUPT_LATENCY_METER_HPP_
@@ -0,0 +1,137 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+#ifndef __ST_INTERRUPT_LOCK_HPP_
+#define __ST_INTERRUPT_LOCK_HPP_
+
+#include "st/stm32cmsis.h"
+
+#ifndef I2C_HID_LOCK_PROFILE
+#define I2C_HID_LOCK_PROFILE 0
+#endif
+
+#if I2C_HID_LOCK_PROFILE
+#include "st/timestamp.hpp"
+#endif
+
+namespace st
+{
+/// @brief The longest interrupt disabled window, and where it was entered from.
+struct interrupt_lock_profile
+{
+    uint32_t max_cycles;
+    uintptr_t max_call_site;
+    uint32_t windows;
+
+    void record(uint32_t cycles, uintptr_t call_site)
+    {
+        windows++;
+        if (cycles > max_cycles)
+        {
+            max_cycles = cycles;
+            max_call_site = call_site;
+        }
+    }
+};
+
+/// @brief Masks all interrupts for the lifetime of the object, and restores the previous state.
+///        Can be nested, and used from any context.
+///        When I2C_HID_LOCK_PROFILE is enabled, the outermost locks measure how long
+///        the interrupts are disabled, and the longest window is kept with its call site.
+///        Code masking the interrupts directly with __disable_irq() isn't measured.
+class interrupt_lock
+{
+    uint32_t priomask_;
+#if I2C_HID_LOCK_PROFILE
+    uint32_t start_;
+    uintptr_t call_site_;
+#endif
+
+  public:
+#if I2C_HID_LOCK_PROFILE
+    /// @param call_site: the code location to attribute the window to,
+    ///        by default the return address of the constructor (it isn't inlined)
+    __attribute__((noinline)) explicit interrupt_lock(const void* call_site = nullptr)
+        : call_site_(reinterpret_cast<uintptr_t>(
+              (call_site != nullptr) ? call_site : __builtin_return_address(0)))
+    {
+        priomask_ = __get_PRIMASK();
+        __disable_irq();
+        start_ = timestamp::now();
+    }
+
+    ~interrupt_lock()
+    {
+        if (priomask_ == 0)
+        {
+            profile().record(timestamp::now() - start_, call_site_);
+            __enable_irq();
+        }
+    }
+
+    /// @brief Enters a sleep mode with the interrupts masked, the core wakes up at the next
+    ///        pending interrupt, which is taken once the lock is released.
+    ///        The sleep delays no interrupt, so it's left out of the measured windows.
+    /// @param enter_sleep: callable entering the sleep mode, e.g. with WFI
+    template <typename TSleep>
+    void sleep(TSleep&& enter_sleep)
+    {
+        if (priomask_ == 0)
+        {
+            profile().record(timestamp::now() - start_, call_site_);
+        }
+        enter_sleep();
+        start_ = timestamp::now();
+    }
+
+    /// @note  Only consistent when read with interrupts disabled.
+    static interrupt_lock_profile& profile()
+    {
+        static interrupt_lock_profile profile{};
+        return profile;
+    }
+#else
+    explicit interrupt_lock([[maybe_unused]] const void* call_site = nullptr)
+    {
+        priomask_ = __get_PRIMASK();
+        __disable_irq();
+    }
+
+    ~interrupt_lock()
+    {
+        if (priomask_ == 0)
+        {
+            __enable_irq();
+        }
+    }
+
+    template <typename TSleep>
+    void sleep(TSleep&& enter_sleep)
+    {
+        enter_sleep();
+    }
+#endif
+
+    interrupt_lock(const interrupt_lock&) = delete;
+    interrupt_lock& operator=(const interrupt_lock&) = delete;
+};
+
+/// @brief Replaces interrupt_lock for data that is only accessed from a single interrupt
+///        priority level, where the accesses can't preempt each other.
+class no_interrupt_lock
+{
+  public:
+    explicit no_interrupt_lock([[maybe_unused]] const void* call_site = nullptr) {}
+    no_interrupt_lock(const no_interrupt_lock&) = delete;
+    no_interrupt_lock& operator=(const no_interrupt_lock&) = delete;
+};
+} // namespace st
+
+#endif // __ST_INTERRUPT_LOCK_HPP_
@@ -0,0 +1,16 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+#include "st/isr_trace.hpp"
+
+#if I2C_HID_TRACE
+// not static, so the debugger can find it by name
+st::isr_trace::ring i2c_hid_trace;
+#endif
@@ -0,0 +1,121 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+#ifndef __ST_ISR_TRACE_HPP_
+#define __ST_ISR_TRACE_HPP_
+
+#include "i2c/slave.hpp"
+#include "st/timestamp.hpp"
+
+#ifndef I2C_HID_TRACE
+#define I2C_HID_TRACE 0
+#endif
+
+namespace st
+{
+/// @brief Compact binary trace of the I2C slave callbacks, recorded in a RAM ring buffer.
+///        The ring (the i2c_hid_trace symbol) can be dumped with a debugger,
+///        and decoded on the host with tools/decode_trace.py.
+///        When I2C_HID_TRACE is disabled, recording compiles to nothing.
+class isr_trace
+{
+  public:
+    enum event : uint8_t
+    {
+        START = 1,
+        TX_COMPLETE = 2,
+        RX_COMPLETE = 3,
+        STOP = 4,
+        ERROR = 5,
+        EXIT = 0x80, // flag for the end of the callback
+    };
+
+    struct entry
+    {
+        uint32_t timestamp;
+        uint8_t event;
+        uint8_t direction;
+        uint16_t size;
+    };
+    static_assert(sizeof(entry) == 8);
+
+    static constexpr uint32_t MAGIC = 0x54433249; // "I2CT"
+    static constexpr uint32_t CAPACITY = 64;
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0);
+
+    /// @brief The memory layout that the host decoder expects.
+    struct ring
+    {
+        uint32_t magic;
+        uint32_t capacity;
+        uint32_t clock_hz;
+        uint32_t write_index;
+        entry entries[CAPACITY];
+    };
+
+    static void record([[maybe_unused]] event ev, [[maybe_unused]] i2c::direction dir,
+                       [[maybe_unused]] size_t size = 0)
+    {
+#if I2C_HID_TRACE
+        auto& r = storage();
+        r.entries[r.write_index % CAPACITY] = {timestamp::now(), ev,
+                                               static_cast<uint8_t>(dir),
+                                               static_cast<uint16_t>(size)};
+        r.write_index++;
+#endif
+    }
+
+    /// @brief Records the entry and the exit of a callback.
+    class scope
+    {
+      public:
+        scope(event ev, i2c::direction dir, size_t size = 0) : size_(size), event_(ev), dir_(dir)
+        {
+            record(ev, dir, size);
+        }
+        ~scope() { record(static_cast<event>(event_ | EXIT), dir_, size_); }
+        void set_size(size_t size) { size_ = size; }
+        void set_direction(i2c::direction dir) { dir_ = dir; }
+
+      private:
+        size_t size_;
+        event event_;
+        i2c::direction dir_;
+    };
+
+    /// @brief Prepares the ring header, needs to be called after the timestamp is initialized.
+    static void init()
+    {
+#if I2C_HID_TRACE
+        auto& r = storage();
+        r.magic = MAGIC;
+        r.capacity = CAPACITY;
+        r.clock_hz = timestamp::frequency();
+        r.write_index = 0;
+#endif
+    }
+
+  private:
+#if I2C_HID_TRACE
+    static ring& storage();
+#endif
+};
+} // namespace st
+
+#if I2C_HID_TRACE
+extern "C" st::isr_trace::ring i2c_hid_trace;
+
+inline st::isr_trace::ring& st::isr_trace::storage()
+{
+    return i2c_hid_trace;
+}
+#endif
+
+#endif // __ST_ISR_TRACE_HPP_
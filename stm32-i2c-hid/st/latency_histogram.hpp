@@ -0,0 +1,76 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+#ifndef __ST_LATENCY_HISTOGRAM_HPP_
+#define __ST_LATENCY_HISTOGRAM_HPP_
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+
+namespace st
+{
+/// @brief Histogram of durations with logarithmic buckets.
+///        Bucket 0 counts the durations below 2^SHIFT cycles,
+///        bucket n counts [2^(SHIFT + n - 1), 2^(SHIFT + n)) cycles,
+///        the last bucket also counts everything longer.
+/// @tparam BUCKETS: the number of buckets
+/// @tparam SHIFT: the log2 of the first bucket's upper limit, in cycles
+template <std::size_t BUCKETS, unsigned SHIFT>
+struct latency_histogram
+{
+    static constexpr std::size_t bucket_of(uint32_t cycles)
+    {
+        unsigned width = std::bit_width(cycles);
+        return (width <= SHIFT) ? 0 : std::min<std::size_t>(width - SHIFT, BUCKETS - 1);
+    }
+
+    void add(uint32_t cycles) { counts[bucket_of(cycles)]++; }
+    void clear() { counts = {}; }
+
+    std::array<uint32_t, BUCKETS> counts{};
+};
+
+/// @brief The latencies of the host servicing the interrupt line of the HID over I2C device,
+///        in the layout that is reported to the host.
+struct interrupt_latency
+{
+    // 64 cycles are 1.33 us at 48 MHz, the last bucket starts at 22 ms
+    static constexpr std::size_t BUCKETS = 16;
+    static constexpr unsigned BUCKET_SHIFT = 6;
+    using histogram = latency_histogram<BUCKETS, BUCKET_SHIFT>;
+
+    uint32_t clock_hz{};
+    uint8_t bucket_shift{BUCKET_SHIFT};
+    uint8_t bucket_count{BUCKETS};
+    uint16_t reserved{};
+    /// from asserting the interrupt line to the start of the next read transfer
+    histogram assert_to_read{};
+    /// from the start of the read transfer to deasserting the interrupt line
+    histogram read_to_deassert{};
+
+    void clear()
+    {
+        assert_to_read.clear();
+        read_to_deassert.clear();
+    }
+};
+
+static_assert(interrupt_latency::histogram::bucket_of(0) == 0);
+static_assert(interrupt_latency::histogram::bucket_of(63) == 0);
+static_assert(interrupt_latency::histogram::bucket_of(64) == 1);
+static_assert(interrupt_latency::histogram::bucket_of(127) == 1);
+static_assert(interrupt_latency::histogram::bucket_of(UINT32_MAX) ==
+              (interrupt_latency::BUCKETS - 1));
+static_assert(sizeof(interrupt_latency) == (8 + 2 * 4 * interrupt_latency::BUCKETS));
+} // namespace st
+
+#endif // __ST_LATENCY_HISTOGRAM_HPP_
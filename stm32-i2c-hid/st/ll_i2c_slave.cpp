@@ -0,0 +1,435 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+#include "st/ll_i2c_slave.hpp"
+#include <utility>
+#include "st/isr_trace.hpp"
+
+namespace st
+{
+// repeated by the TX DMA channel without memory increment
+static const uint8_t PADDING = 0;
+static constexpr uint16_t PADDING_SIZE = UINT16_MAX;
+
+static constexpr uint32_t LISTEN_INTERRUPTS =
+    I2C_CR1_ADDRIE | I2C_CR1_STOPIE | I2C_CR1_NACKIE | I2C_CR1_ERRIE;
+static constexpr uint32_t TRANSFER_CONTROLS =
+    I2C_CR1_TXIE | I2C_CR1_RXIE | I2C_CR1_TXDMAEN | I2C_CR1_RXDMAEN;
+
+static inline void dma_clear_flags(DMA_HandleTypeDef* dma)
+{
+    dma->DmaBaseAddress->IFCR = DMA_IFCR_CGIF1 << dma->ChannelIndex;
+}
+
+static inline bool dma_complete(DMA_HandleTypeDef* dma, uint32_t flags)
+{
+    return (flags & (DMA_ISR_TCIF1 << dma->ChannelIndex)) != 0;
+}
+
+ll_i2c_slave::ll_i2c_slave(I2C_HandleTypeDef& handle, void (*const i2c_slave_init_fn)(void),
+                           GPIO_TypeDef* interrupt_out_port, uint16_t interrupt_out_pin)
+    : interrupt_out_port_(interrupt_out_port), interrupt_out_pin_(interrupt_out_pin)
+{
+    GPIO_InitTypeDef GPIO_InitStruct = {
+        .Pin = interrupt_out_pin_,
+        .Mode = GPIO_MODE_OUTPUT_PP,
+        .Pull = GPIO_PULLUP,
+    };
+    set_pin_interrupt(false);
+    HAL_GPIO_Init(interrupt_out_port_, &GPIO_InitStruct);
+
+    // the HAL initializes the pins, clocks and DMA channels, and links them to the handle
+    i2c_slave_init_fn();
+    i2c_ = handle.Instance;
+    tx_dma_ = handle.hdmatx;
+    rx_dma_ = handle.hdmarx;
+    timing_ = handle.Init.Timing;
+
+    tx_dma_->Instance->CPAR = reinterpret_cast<uintptr_t>(&i2c_->TXDR);
+    rx_dma_->Instance->CPAR = reinterpret_cast<uintptr_t>(&i2c_->RXDR);
+}
+
+void ll_i2c_slave::set_slave_address(i2c::address slave_addr)
+{
+    if (slave_addr.is_10bit())
+    {
+        own_address_ = I2C_OAR1_OA1EN | I2C_OAR1_OA1MODE | slave_addr.raw();
+    }
+    else
+    {
+        own_address_ = I2C_OAR1_OA1EN | (slave_addr.raw() << 1);
+    }
+}
+
+void ll_i2c_slave::apply_config()
+{
+    // disabling the peripheral also resets its state machine
+    i2c_->CR1 &= ~I2C_CR1_PE;
+    i2c_->TIMINGR = timing_;
+    i2c_->OAR1 = 0;
+    i2c_->OAR1 = own_address_;
+    i2c_->CR1 |= I2C_CR1_PE;
+    timing_changed_ = false;
+}
+
+void ll_i2c_slave::set_timing(uint32_t timingr)
+{
+    timing_ = timingr;
+    timing_changed_ = true;
+}
+
+void ll_i2c_slave::set_pin_interrupt(bool asserted)
+{
+    latency_meter_.line_changed(asserted);
+    // active low logic
+    if (asserted)
+    {
+        interrupt_out_port_->BRR = interrupt_out_pin_;
+    }
+    else
+    {
+        interrupt_out_port_->BSRR = interrupt_out_pin_;
+    }
+}
+
+void ll_i2c_slave::start_listen(i2c::address slave_addr)
+{
+    set_slave_address(slave_addr);
+    apply_config();
+    i2c_->CR1 |= LISTEN_INTERRUPTS;
+}
+
+void ll_i2c_slave::stop_listen([[maybe_unused]] i2c::address slave_addr)
+{
+    i2c_->CR1 &= ~(LISTEN_INTERRUPTS | TRANSFER_CONTROLS);
+    stop_dma();
+    i2c_->OAR1 &= ~I2C_OAR1_OA1EN;
+}
+
+void ll_i2c_slave::stop_dma()
+{
+    i2c_->CR1 &= ~TRANSFER_CONTROLS;
+    tx_dma_->Instance->CCR &= ~(DMA_CCR_EN | DMA_CCR_TCIE);
+    rx_dma_->Instance->CCR &= ~(DMA_CCR_EN | DMA_CCR_TCIE);
+    dma_clear_flags(tx_dma_);
+    dma_clear_flags(rx_dma_);
+}
+
+void ll_i2c_slave::nack()
+{
+    stats_.nacks++;
+    i2c_->CR2 |= I2C_CR2_NACK;
+    // the remaining bytes are discarded by the interrupt handler
+    rx_dma_->Instance->CCR &= ~DMA_CCR_EN;
+    i2c_->CR1 = (i2c_->CR1 & ~I2C_CR1_RXDMAEN) | I2C_CR1_RXIE;
+}
+
+void ll_i2c_slave::send_dummy()
+{
+    stats_.dummy_sends++;
+    if (padding_)
+    {
+        // the whole padding was read, start over
+        stats_.padding_bytes += PADDING_SIZE;
+    }
+    // the DMA keeps sending the same byte until the master ends the read,
+    // so over-reads don't cost an interrupt every few bytes
+    padding_ = true;
+    arm_transmit(&PADDING, PADDING_SIZE, 0);
+}
+
+void ll_i2c_slave::start_transmit(const uint8_t* data, size_t size)
+{
+    if (size == 0)
+    {
+        send_dummy();
+        return;
+    }
+    padding_ = false;
+    arm_transmit(data, size, DMA_CCR_MINC);
+}
+
+void ll_i2c_slave::arm_transmit(const uint8_t* data, size_t size, uint32_t memory_increment)
+{
+    auto* channel = tx_dma_->Instance;
+    rx_dma_->Instance->CCR &= ~DMA_CCR_EN;
+    channel->CCR &= ~DMA_CCR_EN;
+    channel->CCR = (channel->CCR & ~DMA_CCR_MINC) | memory_increment;
+    channel->CMAR = reinterpret_cast<uintptr_t>(data);
+    channel->CNDTR = size;
+    dma_clear_flags(tx_dma_);
+    channel->CCR |= DMA_CCR_TCIE | DMA_CCR_EN;
+    i2c_->CR1 = (i2c_->CR1 & ~TRANSFER_CONTROLS) | I2C_CR1_TXDMAEN;
+}
+
+void ll_i2c_slave::start_receive(uint8_t* data, size_t size)
+{
+    if (size == 0)
+    {
+        nack();
+        return;
+    }
+    auto* channel = rx_dma_->Instance;
+    tx_dma_->Instance->CCR &= ~DMA_CCR_EN;
+    channel->CCR &= ~DMA_CCR_EN;
+    channel->CMAR = reinterpret_cast<uintptr_t>(data);
+    channel->CNDTR = size;
+    dma_clear_flags(rx_dma_);
+    channel->CCR |= DMA_CCR_TCIE | DMA_CCR_EN;
+    i2c_->CR1 = (i2c_->CR1 & ~TRANSFER_CONTROLS) | I2C_CR1_RXDMAEN;
+}
+
+void ll_i2c_slave::send(const std::span<const uint8_t>& a)
+{
+    first_size_ = a.size();
+    second_size_ = 0;
+    second_data_ = nullptr;
+    start_transmit(a.data(), a.size());
+}
+
+void ll_i2c_slave::send(const std::span<const uint8_t>& a, const std::span<const uint8_t>& b)
+{
+    first_size_ = a.size();
+    second_size_ = b.size();
+    second_data_ = (second_size_ > 0) ? const_cast<uint8_t*>(b.data()) : nullptr;
+    start_transmit(a.data(), a.size());
+}
+
+void ll_i2c_slave::receive(const std::span<uint8_t>& a)
+{
+    first_size_ = a.size();
+    second_size_ = 0;
+    second_data_ = nullptr;
+    start_receive(a.data(), a.size());
+}
+
+void ll_i2c_slave::receive(const std::span<uint8_t>& a, const std::span<uint8_t>& b)
+{
+    first_size_ = a.size();
+    second_size_ = b.size();
+    second_data_ = (second_size_ > 0) ? b.data() : nullptr;
+    start_receive(a.data(), a.size());
+}
+
+size_t ll_i2c_slave::transferred_size(i2c::direction dir) const
+{
+    size_t size = first_size_;
+    if (size > 0)
+    {
+        if (second_data_ == nullptr)
+        {
+            size += second_size_;
+        }
+        if (dir == i2c::direction::WRITE)
+        {
+            size -= rx_dma_->Instance->CNDTR;
+        }
+        else if (!padding_)
+        {
+            // all data was sent once padding started
+            size -= tx_dma_->Instance->CNDTR;
+        }
+    }
+    return size;
+}
+
+void ll_i2c_slave::handle_start(i2c::direction dir)
+{
+    isr_trace::scope trace{isr_trace::START, dir};
+    statistics::callback_timer timer{stats_};
+    stats_.starts++;
+    if (dir == i2c::direction::READ)
+    {
+        latency_meter_.read_started();
+    }
+    bool success = has_module();
+    if (success)
+    {
+        last_dir_ = dir;
+        // the size of the previous (opposite direction) phase, in case of repeated start
+        size_t size = transferred_size((dir == i2c::direction::WRITE) ? i2c::direction::READ
+                                                                       : i2c::direction::WRITE);
+        trace.set_size(size);
+        success = on_start(dir, size);
+    }
+    if (!success)
+    {
+        // impossible to NACK in read direction
+        if (dir == i2c::direction::WRITE)
+        {
+            nack();
+        }
+        else
+        {
+            send_dummy();
+        }
+    }
+}
+
+void ll_i2c_slave::handle_tx_complete()
+{
+    isr_trace::scope trace{isr_trace::TX_COMPLETE, i2c::direction::READ};
+    statistics::callback_timer timer{stats_};
+    stats_.tx_completes++;
+    if (second_data_ != nullptr)
+    {
+        auto* data = second_data_;
+        second_data_ = nullptr;
+        start_transmit(data, second_size_);
+    }
+    else
+    {
+        send_dummy();
+    }
+}
+
+void ll_i2c_slave::handle_rx_complete()
+{
+    isr_trace::scope trace{isr_trace::RX_COMPLETE, i2c::direction::WRITE};
+    statistics::callback_timer timer{stats_};
+    stats_.rx_completes++;
+    if (second_data_ != nullptr)
+    {
+        auto* data = second_data_;
+        second_data_ = nullptr;
+        start_receive(data, second_size_);
+    }
+    else
+    {
+        nack();
+    }
+}
+
+void ll_i2c_slave::handle_stop()
+{
+    auto dir = std::exchange(last_dir_, std::nullopt);
+    isr_trace::scope trace{isr_trace::STOP, dir.value_or(i2c::direction::WRITE)};
+    statistics::callback_timer timer{stats_};
+    stats_.stops++;
+    stop_dma();
+    // drop the byte that was loaded for transmission, but not read by the master
+    i2c_->ISR |= I2C_ISR_TXE;
+
+    if (has_module() and dir)
+    {
+        size_t size = transferred_size(*dir);
+        if (padding_)
+        {
+            stats_.padding_bytes += PADDING_SIZE - tx_dma_->Instance->CNDTR;
+        }
+        if (*dir == i2c::direction::WRITE)
+        {
+            stats_.write_transfers++;
+            stats_.bytes_written += size;
+        }
+        else
+        {
+            stats_.read_transfers++;
+            stats_.bytes_read += size;
+        }
+        trace.set_size(size);
+        on_stop(*dir, size);
+        first_size_ = 0;
+        second_size_ = 0;
+    }
+    padding_ = false;
+    // disabling the peripheral would drop the address of the next transfer, that is pending
+    // in the same interrupt, so the timing is only changed while the bus is idle
+    if (timing_changed_ and !(i2c_->ISR & (I2C_ISR_BUSY | I2C_ISR_ADDR)))
+    {
+        apply_config();
+    }
+}
+
+void ll_i2c_slave::handle_error(uint32_t isr)
+{
+    auto dir = std::exchange(last_dir_, std::nullopt);
+    isr_trace::scope trace{isr_trace::ERROR, dir.value_or(i2c::direction::WRITE)};
+    statistics::recovery_timer timer{stats_};
+    stats_.count_errors(isr & I2C_ISR_BERR, isr & I2C_ISR_ARLO, isr & I2C_ISR_OVR);
+
+    stop_dma();
+    padding_ = false;
+    if (has_module())
+    {
+        // the broken transfer ends as an empty one, so the pending input report
+        // and the interrupt line are kept for the host's next attempt,
+        // an error on the idle bus has no transfer to end
+        if (dir)
+        {
+            on_stop(*dir, 0);
+        }
+        first_size_ = 0;
+        second_size_ = 0;
+        second_data_ = nullptr;
+    }
+    // the STOP of the broken transfer may never come, disabling the peripheral
+    // releases the bus lines and clears its flags, the listen interrupts stay enabled
+    apply_config();
+}
+
+void ll_i2c_slave::handle_irq()
+{
+    uint32_t isr = i2c_->ISR;
+
+    if (isr & (I2C_ISR_BERR | I2C_ISR_ARLO | I2C_ISR_OVR))
+    {
+        i2c_->ICR = I2C_ICR_BERRCF | I2C_ICR_ARLOCF | I2C_ICR_OVRCF;
+        handle_error(isr);
+        return;
+    }
+    if (isr & I2C_ISR_NACKF)
+    {
+        // the master ends the read with a NACK
+        i2c_->ICR = I2C_ICR_NACKCF;
+    }
+    // a STOP and the next START can be pending at the same time
+    if (isr & I2C_ISR_STOPF)
+    {
+        i2c_->ICR = I2C_ICR_STOPCF;
+        handle_stop();
+    }
+    if (isr & I2C_ISR_ADDR)
+    {
+        auto dir = (isr & I2C_ISR_DIR) ? i2c::direction::READ : i2c::direction::WRITE;
+        if (dir == i2c::direction::READ)
+        {
+            i2c_->ISR |= I2C_ISR_TXE;
+        }
+        handle_start(dir);
+        // releases the clock stretching
+        i2c_->ICR = I2C_ICR_ADDRCF;
+        return;
+    }
+
+    if ((isr & I2C_ISR_RXNE) and (i2c_->CR1 & I2C_CR1_RXIE))
+    {
+        // the byte is discarded
+        [[maybe_unused]] uint32_t data = i2c_->RXDR;
+    }
+}
+
+void ll_i2c_slave::handle_dma_irq()
+{
+    uint32_t flags = tx_dma_->DmaBaseAddress->ISR;
+    if (dma_complete(tx_dma_, flags))
+    {
+        dma_clear_flags(tx_dma_);
+        tx_dma_->Instance->CCR &= ~DMA_CCR_EN;
+        handle_tx_complete();
+    }
+    if (dma_complete(rx_dma_, flags))
+    {
+        dma_clear_flags(rx_dma_);
+        rx_dma_->Instance->CCR &= ~DMA_CCR_EN;
+        handle_rx_complete();
+    }
+}
+} // namespace st
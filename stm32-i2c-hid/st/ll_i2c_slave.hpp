@@ -0,0 +1,95 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+#ifndef __LL_I2C_SLAVE_HPP_
+#define __LL_I2C_SLAVE_HPP_
+
+#include <optional>
+#include "i2c/slave.hpp"
+#include "st/i2c_slave_statistics.hpp"
+#include "st/interrupt_latency_meter.hpp"
+#include "st/ramfunc.h"
+#include "st/stm32hal.h"
+
+namespace st
+{
+/// @brief I2C slave driver that operates the peripheral and its DMA channels
+///        through the registers, bypassing the HAL state machine in the interrupt path.
+///        The HAL is only used to initialize the peripheral, its pins, clocks and DMA channels.
+class ll_i2c_slave : public i2c::slave
+{
+  public:
+    using statistics = i2c_slave_statistics;
+
+    ll_i2c_slave(I2C_HandleTypeDef& handle, void (*i2c_slave_init_fn)(void),
+                 GPIO_TypeDef* interrupt_out_port, uint16_t interrupt_out_pin);
+
+    /// @brief To be called from the I2C peripheral's IRQ handler.
+    ST_RAMFUNC void handle_irq();
+    /// @brief To be called from the IRQ handler of the I2C peripheral's DMA channels.
+    ST_RAMFUNC void handle_dma_irq();
+
+    /// @brief Changes the bus timing (the contents of I2C_TIMINGR), the new value is applied
+    ///        when the bus is idle, at the end of the current or next transfer.
+    void set_timing(uint32_t timingr);
+
+    /// @brief Checks whether there is any ongoing transfer on the bus.
+    bool bus_idle() const { return (i2c_->ISR & I2C_ISR_BUSY) == 0; }
+
+    const statistics& stats() const { return stats_; }
+    void reset_stats() { stats_ = {}; }
+
+    /// @brief The host's reaction times to the interrupt line.
+    const interrupt_latency& latency() { return latency_meter_.latency(); }
+    void reset_latency() { latency_meter_.clear(); }
+
+  private:
+    ST_RAMFUNC void handle_start(i2c::direction dir);
+    ST_RAMFUNC void handle_tx_complete();
+    ST_RAMFUNC void handle_rx_complete();
+    ST_RAMFUNC void handle_stop();
+    void handle_error(uint32_t isr);
+    void nack();
+    void send_dummy();
+    void set_pin_interrupt(bool asserted) override;
+    void send(const std::span<const uint8_t>& a) override;
+    void send(const std::span<const uint8_t>& a, const std::span<const uint8_t>& b) override;
+    void receive(const std::span<uint8_t>& a) override;
+    void receive(const std::span<uint8_t>& a, const std::span<uint8_t>& b) override;
+    void start_transmit(const uint8_t* data, size_t size);
+    void arm_transmit(const uint8_t* data, size_t size, uint32_t memory_increment);
+    void start_receive(uint8_t* data, size_t size);
+    void stop_dma();
+    size_t transferred_size(i2c::direction dir) const;
+    void set_slave_address(i2c::address slave_addr);
+    void apply_config();
+    void start_listen(i2c::address slave_addr) override;
+    void stop_listen(i2c::address slave_addr) override;
+
+    I2C_TypeDef* i2c_;
+    DMA_HandleTypeDef* tx_dma_;
+    DMA_HandleTypeDef* rx_dma_;
+    GPIO_TypeDef* interrupt_out_port_;
+    size_t first_size_{};
+    size_t second_size_{};
+    uint8_t* second_data_{};
+    uint32_t own_address_{};
+    uint32_t timing_;
+    uint16_t interrupt_out_pin_;
+    // the direction of the transfer in progress, empty while the bus is idle
+    std::optional<i2c::direction> last_dir_{};
+    bool timing_changed_{};
+    bool padding_{};
+    statistics stats_{};
+    interrupt_latency_meter latency_meter_{};
+};
+} // namespace st
+
+#endif // __LL_I2C_SLAVE_HPP_
@@ -0,0 +1,29 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+#ifndef __ST_RAMFUNC_H_
+#define __ST_RAMFUNC_H_
+
+#ifndef I2C_HID_RAMFUNC
+#define I2C_HID_RAMFUNC 0
+#endif
+
+/// @brief Marks a function of the interrupt hot path to be executed from SRAM, without the flash
+///        wait state. The function is placed in the .RamFunc section (the same as the HAL's
+///        __RAM_FUNC), which the startup code copies along with .data.
+///        SRAM is out of the direct branch range of flash, so calls to it are long calls.
+///        Only takes effect when I2C_HID_RAMFUNC is enabled.
+#if I2C_HID_RAMFUNC
+#define ST_RAMFUNC __attribute__((section(".RamFunc"), long_call, noinline))
+#else
+#define ST_RAMFUNC
+#endif
+
+#endif // __ST_RAMFUNC_H_
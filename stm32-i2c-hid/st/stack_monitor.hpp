@@ -0,0 +1,92 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+#ifndef __ST_STACK_MONITOR_HPP_
+#define __ST_STACK_MONITOR_HPP_
+
+#include <algorithm>
+#include <cstdint>
+
+namespace st
+{
+/// @brief Measures the peak stack usage, in the RAM region that the startup code paints
+///        between the end of the static data and the initial stack pointer.
+///        The region is scanned upwards in small chunks, for the first word that isn't
+///        painted anymore, so a scan step never takes long.
+///        The lowest words of the region are a canary: once the stack reaches them,
+///        the next step is going to overwrite the static data.
+/// @tparam CANARY_WORDS: the size of the canary, 0 disables the check
+/// @tparam CHUNK_WORDS: the number of words checked in a scan step
+template <std::size_t CANARY_WORDS, std::size_t CHUNK_WORDS = 64>
+class stack_monitor
+{
+  public:
+    /// @brief The paint pattern, must match the one in the startup code.
+    static constexpr std::uint32_t PAINT = 0xC5C5C5C5;
+
+    /// @param begin: the lowest address of the painted region
+    /// @param end: the end of the painted region, the initial stack pointer
+    constexpr stack_monitor(const volatile std::uint32_t* begin, const volatile std::uint32_t* end)
+        : begin_(begin), end_(end), cursor_(begin), lowest_used_(end)
+    {}
+
+    /// @brief Continues the scan of the painted region, to be called from the lowest priority.
+    /// @return false if the canary is overwritten
+    bool step()
+    {
+        if (!canary_intact())
+        {
+            return false;
+        }
+        auto* limit = std::min(cursor_ + CHUNK_WORDS, lowest_used_);
+        while ((cursor_ < limit) and (*cursor_ == PAINT))
+        {
+            cursor_++;
+        }
+        if (cursor_ < limit)
+        {
+            // found a deeper stack use, start over to look for an even deeper one
+            lowest_used_ = cursor_;
+            cursor_ = begin_;
+        }
+        else if (cursor_ == lowest_used_)
+        {
+            cursor_ = begin_;
+        }
+        return true;
+    }
+
+    bool canary_intact() const
+    {
+        for (std::size_t i = 0; i < std::min<std::size_t>(CANARY_WORDS, end_ - begin_); i++)
+        {
+            if (begin_[i] != PAINT)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// @brief The deepest stack usage found so far, in bytes.
+    std::uint32_t peak_usage() const { return (end_ - lowest_used_) * sizeof(std::uint32_t); }
+
+    /// @brief The RAM that the stack hasn't reached so far, in bytes.
+    std::uint32_t free_bytes() const { return (lowest_used_ - begin_) * sizeof(std::uint32_t); }
+
+  private:
+    const volatile std::uint32_t* const begin_;
+    const volatile std::uint32_t* const end_;
+    const volatile std::uint32_t* cursor_;
+    const volatile std::uint32_t* lowest_used_;
+};
+} // namespace st
+
+#endif // __ST_STACK_MONITOR_HPP_
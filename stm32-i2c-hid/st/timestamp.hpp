@@ -0,0 +1,96 @@
+/// @file
+///
+/// @author Benedek Kupper
+/// @date   2024
+///
+/// @copyright
+///         This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+///         If a copy of the MPL was not distributed with this file, You can obtain one at
+///         https://mozilla.org/MPL/2.0/.
+///
+#ifndef __ST_TIMESTAMP_HPP_
+#define __ST_TIMESTAMP_HPP_
+
+#include "st/stm32hal.h"
+
+namespace st
+{
+/// @brief Free-running 32-bit timer counting core clock cycles,
+///        as the Cortex-M0 has no DWT cycle counter.
+///        TIM2 counts at the system clock, that changes with the clock profile, so its counts
+///        are scaled to cycles of FREQUENCY: the durations have the same unit,
+///        regardless of the clock profiles they span.
+class timestamp
+{
+  public:
+    /// @brief The unit of the timestamps, the fastest system clock,
+    ///        that every other system clock frequency divides.
+    static constexpr uint32_t FREQUENCY = 48'000'000;
+
+    /// @brief Starts TIM2 with the timer kernel clock, without prescaling.
+    static void init()
+    {
+        __HAL_RCC_TIM2_CLK_ENABLE();
+        TIM2->CR1 = 0;
+        TIM2->PSC = 0;
+        TIM2->ARR = UINT32_MAX;
+        TIM2->EGR = TIM_EGR_UG;
+        TIM2->CR1 = TIM_CR1_CEN;
+        epoch() = {};
+        rate_changed(HAL_RCC_GetPCLK1Freq());
+    }
+
+    /// @brief The current timestamp, in cycles of FREQUENCY.
+    static uint32_t now()
+    {
+        auto& e = epoch();
+        uint32_t generation, base, start, scale, count;
+        do
+        {
+            generation = e.generation;
+            base = e.base;
+            start = e.start;
+            scale = e.scale;
+            count = TIM2->CNT;
+            // only retries when a clock change preempted the read
+        } while (generation != e.generation);
+        return base + (count - start) * scale;
+    }
+
+    /// @brief Continues the timestamps at a new timer clock frequency,
+    ///        to be called right after the system clock changes.
+    /// @note  Must not be preempted by code reading the timestamps.
+    static void rate_changed(uint32_t timer_hz)
+    {
+        auto& e = epoch();
+        uint32_t count = TIM2->CNT;
+        e.base = e.base + (count - e.start) * e.scale;
+        e.start = count;
+        e.scale = FREQUENCY / timer_hz;
+        e.generation = e.generation + 1;
+    }
+
+    /// @brief The frequency of the timestamps.
+    static constexpr uint32_t frequency() { return FREQUENCY; }
+
+    static constexpr uint32_t to_us(uint32_t cycles) { return cycles / (FREQUENCY / 1'000'000); }
+    static constexpr uint32_t from_us(uint32_t us) { return us * (FREQUENCY / 1'000'000); }
+
+  private:
+    /// @brief The timestamp and the timer count at the last clock change.
+    struct epoch_state
+    {
+        volatile uint32_t generation;
+        volatile uint32_t base;
+        volatile uint32_t start;
+        volatile uint32_t scale;
+    };
+    static epoch_state& epoch()
+    {
+        static epoch_state epoch{};
+        return epoch;
+    }
+};
+} // namespace st
+
+#endif // __ST_TIMESTAMP_HPP_
@@ -0,0 +1,93 @@
+#!/usr/bin/env python3
+"""Decodes a RAM dump of the I2C slave callback trace (the i2c_hid_trace symbol,
+see stm32-i2c-hid/st/isr_trace.hpp), and prints latency histograms per phase.
+
+Dump the ring with the debugger, e.g. in gdb:
+    dump binary value trace.bin i2c_hid_trace
+"""
+import argparse
+import collections
+import struct
+import sys
+
+MAGIC = 0x54433249
+HEADER = struct.Struct('<IIII')
+ENTRY = struct.Struct('<IBBH')
+EXIT = 0x80
+EVENTS = {1: 'start', 2: 'tx_complete', 3: 'rx_complete', 4: 'stop', 5: 'error'}
+DIRECTIONS = {0: 'write', 1: 'read'}
+
+
+def read_entries(data):
+    magic, capacity, clock_hz, write_index = HEADER.unpack_from(data)
+    if magic != MAGIC:
+        sys.exit('not an I2C trace dump (magic 0x%08x)' % magic)
+    entries = [ENTRY.unpack_from(data, HEADER.size + i * ENTRY.size) for i in range(capacity)]
+    # the oldest entry is at the write index once the ring has wrapped around
+    count = min(write_index, capacity)
+    start = write_index - count
+    ordered = [entries[(start + i) % capacity] for i in range(count)]
+    return clock_hz, write_index, ordered
+
+
+def bucket(us):
+    """log2 bucket upper bound in us"""
+    limit = 1
+    while us >= limit:
+        limit *= 2
+    return limit
+
+
+def print_histogram(title, samples):
+    print('%s: %d samples, min %.1f us, max %.1f us, avg %.1f us' %
+          (title, len(samples), min(samples), max(samples), sum(samples) / len(samples)))
+    histogram = collections.Counter(bucket(s) for s in samples)
+    peak = max(histogram.values())
+    for limit in sorted(histogram):
+        count = histogram[limit]
+        print('  < %6d us %6d %s' % (limit, count, '#' * max(1, count * 40 // peak)))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('dump', help='binary dump of the i2c_hid_trace ring')
+    parser.add_argument('-l', '--list', action='store_true', help='list the decoded entries')
+    args = parser.parse_args()
+
+    with open(args.dump, 'rb') as f:
+        clock_hz, write_index, entries = read_entries(f.read())
+    to_us = 1e6 / clock_hz
+    print('%d entries recorded, %d available, timestamp clock %d Hz' %
+          (write_index, len(entries), clock_hz))
+
+    durations = collections.defaultdict(list)
+    intervals = collections.defaultdict(list)
+    entered = {}
+    previous = None
+    for timestamp, event, direction, size in entries:
+        name = EVENTS.get(event & ~EXIT, 'unknown(%d)' % event)
+        if args.list:
+            print('%10d %-12s %-5s %s %d' % (timestamp, name, DIRECTIONS.get(direction, '?'),
+                                            'exit ' if event & EXIT else 'enter', size))
+        if event & EXIT:
+            if name in entered:
+                # the timer wraps around at 32 bits
+                durations[name].append(((timestamp - entered.pop(name)) & 0xffffffff) * to_us)
+            continue
+        entered[name] = timestamp
+        if previous is not None:
+            intervals['%s -> %s' % (previous[0], name)].append(
+                ((timestamp - previous[1]) & 0xffffffff) * to_us)
+        previous = (name, timestamp)
+
+    print('\ncallback durations')
+    for name in sorted(durations):
+        print_histogram(name, durations[name])
+    print('\nintervals between callbacks')
+    for name in sorted(intervals):
+        print_histogram(name, intervals[name])
+
+
+if __name__ == '__main__':
+    main()